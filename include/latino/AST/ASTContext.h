@@ -29,6 +29,7 @@
 #include "latino/AST/TemplateName.h"
 #include "latino/AST/Type.h"
 #include "latino/Basic/AddressSpaces.h"
+#include "latino/Basic/ArenaPool.h"
 #include "latino/Basic/AttrKinds.h"
 #include "latino/Basic/IdentifierTable.h"
 #include "latino/Basic/LLVM.h"
@@ -89,6 +90,7 @@ class BlockExpr;
 class BuiltinTemplateDecl;
 class CharUnits;
 class ConceptDecl;
+class ConstexprEvalCache;
 class CXXABI;
 class CXXConstructorDecl;
 class CXXMethodDecl;
@@ -558,8 +560,9 @@ private:
   /// The allocator used to create AST objects.
   ///
   /// AST objects are never destructed; rather, all memory associated with the
-  /// AST objects will be released when the ASTContext itself is destroyed.
-  mutable llvm::BumpPtrAllocator BumpAlloc;
+  /// AST objects will be released when the ASTContext itself is destroyed,
+  /// back to the arena pool if there is one.
+  mutable ArenaAllocator BumpAlloc;
 
   /// Allocator for partial diagnostics.
   PartialDiagnostic::StorageAllocator DiagAllocator;
@@ -580,6 +583,7 @@ private:
   latino::PrintingPolicy PrintingPolicy;
   std::unique_ptr<interp::Context> InterpContext;
   std::unique_ptr<ParentMapContext> ParentMapCtx;
+  std::unique_ptr<ConstexprEvalCache> ConstexprEvalResults;
 
 public:
   IdentifierTable &Idents;
@@ -595,6 +599,9 @@ public:
   /// Returns the dynamic AST node parent map context.
   ParentMapContext &getParentMapContext();
 
+  /// Returns the cache of the results of calls to constexpr functions.
+  ConstexprEvalCache &getConstexprEvalCache();
+
   // A traversal scope limits the parts of the AST visible to certain analyses.
   // RecursiveASTVisitor::TraverseAST will only visit reachable nodes, and
   // getParents() will only observe reachable parent edges.
@@ -620,7 +627,7 @@ public:
   SourceManager& getSourceManager() { return SourceMgr; }
   const SourceManager& getSourceManager() const { return SourceMgr; }
 
-  llvm::BumpPtrAllocator &getAllocator() const {
+  ArenaAllocator &getAllocator() const {
     return BumpAlloc;
   }
 
@@ -641,6 +648,10 @@ public:
   /// Return the total memory used for various side tables.
   size_t getSideTableAllocatedMemory() const;
 
+  /// Record the memory held by the AST as -ftime-trace counters, if they are
+  /// being recorded.
+  void recordMemoryCounters() const;
+
   PartialDiagnostic::StorageAllocator &getDiagAllocator() {
     return DiagAllocator;
   }
@@ -1001,7 +1012,8 @@ public:
   mutable TagDecl *MSGuidTagDecl = nullptr;
 
   ASTContext(LangOptions &LOpts, SourceManager &SM, IdentifierTable &idents,
-             /*SelectorTable &sels,*/ Builtin::Context &builtins);
+             /*SelectorTable &sels,*/ Builtin::Context &builtins,
+             ArenaPool *Arenas = nullptr);
   ASTContext(const ASTContext &) = delete;
   ASTContext &operator=(const ASTContext &) = delete;
   ~ASTContext();
@@ -15,6 +15,7 @@
 #ifndef LLVM_LATINO_AST_COMMENTCOMMANDTRAITS_H
 #define LLVM_LATINO_AST_COMMENTCOMMANDTRAITS_H
 
+#include "latino/Basic/ArenaPool.h"
 #include "latino/Basic/CommentOptions.h"
 #include "latino/Basic/LLVM.h"
 #include "llvm/ADT/SmallVector.h"
@@ -133,7 +134,7 @@ public:
     KCI_Last
   };
 
-  CommandTraits(llvm::BumpPtrAllocator &Allocator,
+  CommandTraits(ArenaAllocator &Allocator,
                 const CommentOptions &CommentOptions);
 
   void registerCommentOptions(const CommentOptions &CommentOptions);
@@ -176,7 +177,7 @@ private:
   unsigned NextID;
 
   /// Allocator for CommandInfo objects.
-  llvm::BumpPtrAllocator &Allocator;
+  ArenaAllocator &Allocator;
 
   SmallVector<CommandInfo *, 4> RegisteredCommands;
 };
@@ -13,6 +13,7 @@
 #ifndef LLVM_LATINO_AST_COMMENTLEXER_H
 #define LLVM_LATINO_AST_COMMENTLEXER_H
 
+#include "latino/Basic/ArenaPool.h"
 #include "latino/Basic/Diagnostic.h"
 #include "latino/Basic/SourceManager.h"
 #include "llvm/ADT/SmallString.h"
@@ -224,7 +225,7 @@ private:
 
   /// Allocator for strings that are semantic values of tokens and have to be
   /// computed (for example, resolved decimal character references).
-  llvm::BumpPtrAllocator &Allocator;
+  ArenaAllocator &Allocator;
 
   DiagnosticsEngine &Diags;
 
@@ -345,7 +346,7 @@ private:
   void lexHTMLEndTag(Token &T);
 
 public:
-  Lexer(llvm::BumpPtrAllocator &Allocator, DiagnosticsEngine &Diags,
+  Lexer(ArenaAllocator &Allocator, DiagnosticsEngine &Diags,
         const CommandTraits &Traits, SourceLocation FileLoc,
         const char *BufferStart, const char *BufferEnd,
         bool ParseCommands = true);
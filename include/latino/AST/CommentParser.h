@@ -16,6 +16,7 @@
 #include "latino/AST/Comment.h"
 #include "latino/AST/CommentLexer.h"
 #include "latino/AST/CommentSema.h"
+#include "latino/Basic/ArenaPool.h"
 #include "latino/Basic/Diagnostic.h"
 #include "llvm/Support/Allocator.h"
 
@@ -37,7 +38,7 @@ class Parser {
   Sema &S;
 
   /// Allocator for anything that goes into AST nodes.
-  llvm::BumpPtrAllocator &Allocator;
+  ArenaAllocator &Allocator;
 
   /// Source manager for the comment being parsed.
   const SourceManager &SourceMgr;
@@ -85,7 +86,7 @@ class Parser {
   }
 
 public:
-  Parser(Lexer &L, Sema &S, llvm::BumpPtrAllocator &Allocator,
+  Parser(Lexer &L, Sema &S, ArenaAllocator &Allocator,
          const SourceManager &SourceMgr, DiagnosticsEngine &Diags,
          const CommandTraits &Traits);
 
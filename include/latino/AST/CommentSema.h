@@ -14,6 +14,7 @@
 #define LLVM_LATINO_AST_COMMENTSEMA_H
 
 #include "latino/AST/Comment.h"
+#include "latino/Basic/ArenaPool.h"
 #include "latino/Basic/Diagnostic.h"
 #include "latino/Basic/SourceLocation.h"
 #include "llvm/ADT/ArrayRef.h"
@@ -34,7 +35,7 @@ class Sema {
   void operator=(const Sema &) = delete;
 
   /// Allocator for AST nodes.
-  llvm::BumpPtrAllocator &Allocator;
+  ArenaAllocator &Allocator;
 
   /// Source manager for the comment being parsed.
   const SourceManager &SourceMgr;
@@ -69,7 +70,7 @@ class Sema {
   SmallVector<HTMLStartTagComment *, 8> HTMLOpenTags;
 
 public:
-  Sema(llvm::BumpPtrAllocator &Allocator, const SourceManager &SourceMgr,
+  Sema(ArenaAllocator &Allocator, const SourceManager &SourceMgr,
        DiagnosticsEngine &Diags, CommandTraits &Traits,
        const Preprocessor *PP);
 
@@ -0,0 +1,140 @@
+//===--- ConstexprEvalCache.h - Results of constexpr calls ------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+/// \file
+/// Defines the ConstexprEvalCache, which remembers the results of calls to
+/// constexpr functions so that the constant evaluator does not evaluate the
+/// same call twice, in this translation unit or in the AST files it imports.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LATINO_AST_CONSTEXPREVALCACHE_H
+#define LLVM_LATINO_AST_CONSTEXPREVALCACHE_H
+
+#include "latino/AST/APValue.h"
+#include "latino/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MD5.h"
+
+namespace latino {
+
+class ASTContext;
+class FunctionDecl;
+class StringLiteral;
+
+/// The results of calls to constexpr functions, keyed by the callee and the
+/// values of the arguments.
+///
+/// Only calls whose result is fully determined by the callee and the
+/// arguments can be cached: calls with integer, floating point and string
+/// literal arguments returning an integer or a floating point value. The
+/// evaluator decides which calls evaluated cleanly; the cache only stores
+/// them. Results of calls evaluated in an AST file are loaded from it the
+/// first time the callee is looked up.
+///
+/// Each result is stored with the cost of the evaluation of the call, which
+/// the evaluator still counts against -fconstexpr-steps and -fconstexpr-depth
+/// when it reuses the result.
+class ConstexprEvalCache {
+public:
+  /// The cost of the evaluation of a call.
+  struct Cost {
+    /// The number of evaluation steps the call took.
+    unsigned Steps = 0;
+    /// The number of nested calls on the deepest call stack below the call.
+    unsigned Depth = 0;
+  };
+
+  explicit ConstexprEvalCache(ASTContext &Ctx) : Ctx(Ctx) {}
+
+  /// Build the key of a call with arguments \p Args into \p Key. A pointer
+  /// into a string literal is keyed by a digest of the contents of the
+  /// literal, computed once per literal.
+  ///
+  /// \param Context distinguishes the evaluation modes whose results must
+  /// not be shared.
+  ///
+  /// \returns false if the call cannot be cached.
+  bool getKey(ArrayRef<APValue> Args, unsigned Context,
+              SmallVectorImpl<char> &Key);
+
+  /// Whether \p Value can be stored as the result of a call.
+  static bool isCacheableResult(const APValue &Value);
+
+  /// Encode a cacheable result, to be stored in an AST file.
+  static void encodeResult(const APValue &Value, SmallVectorImpl<char> &Out);
+
+  /// Decode a result encoded by encodeResult.
+  ///
+  /// \returns false if \p Data is not a valid encoding.
+  static bool decodeResult(StringRef Data, APValue &Value);
+
+  /// \returns The result of the call to \p FD with key \p Key, or null if it
+  /// was not evaluated yet. The cost of its evaluation is stored in \p C.
+  const APValue *lookup(const FunctionDecl *FD, StringRef Key, Cost &C);
+
+  /// Record the result of a call to \p FD which evaluated cleanly.
+  void insert(const FunctionDecl *FD, StringRef Key, const APValue &Value,
+              Cost C);
+
+  /// Record the result of a call to \p FD loaded from an AST file.
+  void insertLoaded(const FunctionDecl *FD, StringRef Key, APValue Value,
+                    Cost C);
+
+  /// Call \p Fn with the callee, key, result and cost of each call evaluated
+  /// in this translation unit, in the order in which they were evaluated.
+  void forEachEvaluated(llvm::function_ref<void(const FunctionDecl *, StringRef,
+                                                const APValue &, Cost)>
+                            Fn) const;
+
+  /// The number of lookups which found a result.
+  unsigned getNumHits() const { return NumHits; }
+
+  /// The number of results loaded from AST files.
+  unsigned getNumLoaded() const { return NumLoaded; }
+
+  void PrintStats() const;
+
+private:
+  struct Result {
+    StringRef Key;
+    APValue Value;
+    Cost EvalCost;
+    bool FromASTFile;
+  };
+
+  struct CalleeResults {
+    llvm::StringMap<unsigned> Index;
+    SmallVector<Result, 4> Results;
+    /// Whether the results stored in the external source were loaded.
+    bool LoadedExternal = false;
+  };
+
+  Result *find(CalleeResults &Callee, StringRef Key);
+  CalleeResults &getCallee(const FunctionDecl *FD);
+  const llvm::MD5::MD5Result &getDigest(const StringLiteral *SL);
+
+  ASTContext &Ctx;
+  llvm::MapVector<const FunctionDecl *, CalleeResults> Callees;
+  llvm::DenseMap<const StringLiteral *, llvm::MD5::MD5Result> Digests;
+
+  unsigned NumHits = 0;
+  unsigned NumMisses = 0;
+  unsigned NumEvaluated = 0;
+  unsigned NumLoaded = 0;
+};
+
+} // namespace latino
+
+#endif // LLVM_LATINO_AST_CONSTEXPREVALCACHE_H
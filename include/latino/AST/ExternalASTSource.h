@@ -44,6 +44,7 @@ class CXXCtorInitializer;
 class CXXRecordDecl;
 class DeclarationName;
 class FieldDecl;
+class FunctionDecl;
 class IdentifierInfo;
 class NamedDecl;
 // class ObjCInterfaceDecl;
@@ -219,6 +220,12 @@ public:
   /// Loads comment ranges.
   virtual void ReadComments();
 
+  /// Loads the results of the calls to \p FD which were evaluated in the
+  /// external source into the ASTContext's ConstexprEvalCache.
+  ///
+  /// The default implementation of this method is a no-op.
+  virtual void ReadConstexprEvalResults(const FunctionDecl *FD);
+
   /// Notify ExternalASTSource that we started deserialization of
   /// a decl or type so until FinishedDeserializing is called there may be
   /// decls that are initializing. Must be paired with FinishedDeserializing.
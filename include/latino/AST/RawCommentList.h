@@ -9,6 +9,7 @@
 #ifndef LLVM_LATINO_AST_RAWCOMMENTLIST_H
 #define LLVM_LATINO_AST_RAWCOMMENTLIST_H
 
+#include "latino/Basic/ArenaPool.h"
 #include "latino/Basic/CommentOptions.h"
 #include "latino/Basic/SourceLocation.h"
 #include "llvm/ADT/ArrayRef.h"
@@ -182,7 +183,7 @@ public:
   RawCommentList(SourceManager &SourceMgr) : SourceMgr(SourceMgr) {}
 
   void addComment(const RawComment &RC, const CommentOptions &CommentOpts,
-                  llvm::BumpPtrAllocator &Allocator);
+                  ArenaAllocator &Allocator);
 
   /// \returns A mapping from an offset of the start of the comment to the
   /// comment itself, or nullptr in case there are no comments in \p File.
@@ -28,6 +28,7 @@
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Support/Allocator.h"
 #include <functional>
+#include <list>
 #include <memory>
 
 namespace latino {
@@ -76,7 +77,8 @@ class AnalysisDeclContext {
 
   const Decl *const D;
 
-  std::unique_ptr<CFG> cfg, completeCFG;
+  // Shared with the CFG cache of the manager, if it keeps one.
+  std::shared_ptr<CFG> cfg, completeCFG;
   std::unique_ptr<CFGStmtMap> cfgStmtMap;
 
   CFG::BuildOptions cfgBuildOptions;
@@ -93,6 +95,8 @@ class AnalysisDeclContext {
 
   void *ManagedAnalyses = nullptr;
 
+  std::shared_ptr<CFG> buildCFG();
+
 public:
   AnalysisDeclContext(AnalysisDeclContextManager *Mgr, const Decl *D);
 
@@ -424,6 +428,24 @@ class AnalysisDeclContextManager {
   LocationContextManager LocCtxMgr;
   CFG::BuildOptions cfgBuildOptions;
 
+  // The declaration of a cached CFG and whether trivially false edges are
+  // pruned from it.
+  using CFGCacheKey = std::pair<const Decl *, bool>;
+
+  struct CachedCFG {
+    CFGCacheKey Key;
+    CFG::BuildOptions Options;
+    std::shared_ptr<CFG> TheCFG;
+  };
+
+  // The CFGs built for the contexts, the most recently used first. They
+  // outlive clear(), so a function inlined into many others is turned into a
+  // CFG only once, but only the last MaxCachedCFGs of them are kept.
+  std::list<CachedCFG> CFGCache;
+  llvm::DenseMap<CFGCacheKey, std::list<CachedCFG>::iterator> CFGCacheIndex;
+  bool CacheCFGs = false;
+  unsigned MaxCachedCFGs = 1;
+
   // Pointer to an interface that can provide function bodies for
   // declarations from external source.
   std::unique_ptr<CodeInjector> Injector;
@@ -458,6 +480,15 @@ public:
   /// \returns Whether faux bodies should be synthesized for known functions.
   bool synthesizeBodies() const { return SynthesizeBodies; }
 
+  /// Set whether the CFGs built for the contexts are kept when the contexts
+  /// are discarded, and reused by later contexts of the same declaration.
+  /// At most \p MaxCFGs of them are kept; the least recently used ones are
+  /// dropped first.
+  void setCacheCFGs(bool Cache, unsigned MaxCFGs = 256);
+
+  /// \returns Whether the CFGs of the contexts are cached.
+  bool shouldCacheCFGs() const { return CacheCFGs; }
+
   /// Obtain the beginning context of the analysis.
   ///
   /// \returns The top level stack frame for \p D.
@@ -476,12 +507,18 @@ public:
 
   BodyFarm &getBodyFarm();
 
-  /// Discard all previously created AnalysisDeclContexts.
+  /// Discard all previously created AnalysisDeclContexts. The cached CFGs
+  /// are kept.
   void clear();
 
 private:
   friend class AnalysisDeclContext;
 
+  /// \returns The CFG of \p D built with \p Options, building it only if no
+  /// context of \p D has built one with the same options yet.
+  std::shared_ptr<CFG> getCachedCFG(const Decl *D, Stmt *Body,
+                                    const CFG::BuildOptions &Options);
+
   LocationContextManager &getLocationContextManager() { return LocCtxMgr; }
 };
 
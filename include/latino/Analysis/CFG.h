@@ -1268,6 +1268,32 @@ public:
       alwaysAddMask.set();
       return *this;
     }
+
+    /// \returns Whether building a CFG with these options and with \p Other
+    /// gives the same CFG. The observer and the forced block expressions are
+    /// not compared, as they are specific to one build.
+    bool buildsSameCFGAs(const BuildOptions &Other) const {
+      return alwaysAddMask == Other.alwaysAddMask &&
+             PruneTriviallyFalseEdges == Other.PruneTriviallyFalseEdges &&
+             AddEHEdges == Other.AddEHEdges &&
+             AddInitializers == Other.AddInitializers &&
+             AddImplicitDtors == Other.AddImplicitDtors &&
+             AddLifetime == Other.AddLifetime &&
+             AddLoopExit == Other.AddLoopExit &&
+             AddTemporaryDtors == Other.AddTemporaryDtors &&
+             AddScopes == Other.AddScopes &&
+             AddStaticInitBranches == Other.AddStaticInitBranches &&
+             AddCXXNewAllocator == Other.AddCXXNewAllocator &&
+             AddCXXDefaultInitExprInCtors ==
+                 Other.AddCXXDefaultInitExprInCtors &&
+             AddCXXDefaultInitExprInAggregates ==
+                 Other.AddCXXDefaultInitExprInAggregates &&
+             AddRichCXXConstructors == Other.AddRichCXXConstructors &&
+             MarkElidedCXXConstructors == Other.MarkElidedCXXConstructors &&
+             AddVirtualBaseBranches == Other.AddVirtualBaseBranches &&
+             OmitImplicitValueInitializers ==
+                 Other.OmitImplicitValueInitializers;
+    }
   };
 
   /// Builds a CFG from an AST.
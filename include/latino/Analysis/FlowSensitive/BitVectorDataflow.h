@@ -0,0 +1,130 @@
+//===- BitVectorDataflow.h --------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// A worklist solver for dataflow analyses whose values are dense bit vectors,
+// merged with a bitwise or at the joins of the CFG.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LATINO_ANALYSIS_FLOWSENSITIVE_BITVECTORDATAFLOW_H
+#define LLVM_LATINO_ANALYSIS_FLOWSENSITIVE_BITVECTORDATAFLOW_H
+
+#include "latino/Analysis/AnalysisDeclContext.h"
+#include "latino/Analysis/CFG.h"
+#include "latino/Analysis/FlowSensitive/DataflowValues.h"
+#include "latino/Analysis/FlowSensitive/DataflowWorklist.h"
+#include "llvm/ADT/BitVector.h"
+#include <type_traits>
+#include <vector>
+
+namespace latino {
+
+/// Solves a dataflow problem over the blocks of a CFG, in the direction given
+/// by \p AnalysisDirTag. The value of each block is a vector of a fixed
+/// number of bits. The value flowing into a block is the bitwise or of the
+/// values flowing out of its neighbors, so the facts of the analysis must be
+/// encoded such that a set bit is the more conservative one, and an unset
+/// bit is what a block that was not analyzed yet contributes.
+///
+/// Blocks are visited in reverse post order for forward analyses and in post
+/// order for backward ones, so that most of them are visited once per pass
+/// over a loop. Each visit costs time linear in the number of bits, with
+/// none of the rebalancing of the immutable sets.
+template <typename AnalysisDirTag = dataflow::forward_analysis_tag>
+class BitVectorDataflow {
+  static constexpr bool IsForward =
+      std::is_same<AnalysisDirTag, dataflow::forward_analysis_tag>::value;
+
+  using WorklistTy =
+      typename std::conditional<IsForward, ForwardDataflowWorklist,
+                                BackwardDataflowWorklist>::type;
+
+  WorklistTy Worklist;
+  unsigned NumBits;
+  // The values flowing into and out of each block, by block ID.
+  std::vector<llvm::BitVector> In, Out;
+  llvm::BitVector Visited;
+  unsigned NumBlockVisits = 0;
+
+  /// \returns The neighbors a block takes its value from.
+  static CFGBlock::pred_const_range flowPredecessors(const CFGBlock *B) {
+    return IsForward ? B->preds() : B->succs();
+  }
+
+public:
+  BitVectorDataflow(const CFG &Cfg, AnalysisDeclContext &AC, unsigned NumBits)
+      : Worklist(Cfg, AC), NumBits(NumBits),
+        In(Cfg.getNumBlockIDs(), llvm::BitVector(NumBits)),
+        Out(Cfg.getNumBlockIDs(), llvm::BitVector(NumBits)),
+        Visited(Cfg.getNumBlockIDs()) {}
+
+  unsigned getNumBits() const { return NumBits; }
+
+  /// The value flowing into \p B: at its entry for a forward analysis, and at
+  /// its exit for a backward one.
+  const llvm::BitVector &getIn(const CFGBlock *B) const {
+    return In[B->getBlockID()];
+  }
+
+  /// The value flowing out of \p B.
+  const llvm::BitVector &getOut(const CFGBlock *B) const {
+    return Out[B->getBlockID()];
+  }
+
+  /// Set the value flowing out of \p B without visiting it, as for the entry
+  /// block of a forward analysis.
+  void setOut(const CFGBlock *B, const llvm::BitVector &V) {
+    assert(V.size() == NumBits && "Value of the wrong size");
+    Out[B->getBlockID()] = V;
+    Visited[B->getBlockID()] = true;
+  }
+
+  /// Schedule \p B for a visit.
+  void enqueueBlock(const CFGBlock *B) { Worklist.enqueueBlock(B); }
+
+  /// Schedule the blocks that take their value from \p B.
+  void enqueueFlowSuccessors(const CFGBlock *B) {
+    for (const CFGBlock *Succ : IsForward ? B->succs() : B->preds())
+      Worklist.enqueueBlock(Succ);
+  }
+
+  /// Visit the scheduled blocks until the values no longer change.
+  ///
+  /// \p Transfer is called as Transfer(const CFGBlock *, llvm::BitVector &)
+  /// with the value flowing into the block, which it turns into the value
+  /// flowing out of it. The blocks that take their value from a block are
+  /// scheduled after its first visit, and then whenever its value changes.
+  template <typename TransferFn> void solve(TransferFn Transfer) {
+    llvm::BitVector Value;
+    while (const CFGBlock *B = Worklist.dequeue()) {
+      unsigned ID = B->getBlockID();
+      llvm::BitVector &BlockIn = In[ID];
+      BlockIn.reset();
+      for (const CFGBlock *Pred : flowPredecessors(B))
+        if (Pred)
+          BlockIn |= Out[Pred->getBlockID()];
+
+      Value = BlockIn;
+      Transfer(B, Value);
+      ++NumBlockVisits;
+
+      if (Visited[ID] && Value == Out[ID])
+        continue;
+      Visited[ID] = true;
+      std::swap(Out[ID], Value);
+      enqueueFlowSuccessors(B);
+    }
+  }
+
+  /// \returns The number of blocks visited by solve().
+  unsigned getNumBlockVisits() const { return NumBlockVisits; }
+};
+
+} // namespace latino
+
+#endif // LLVM_LATINO_ANALYSIS_FLOWSENSITIVE_BITVECTORDATAFLOW_H
@@ -0,0 +1,123 @@
+//===- ArenaPool.h - Slab pool shared by bump allocators --------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+/// \file
+/// Defines the ArenaPool class and the ArenaAllocator used by the ASTContext
+/// and the Preprocessor.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LATINO_BASIC_ARENAPOOL_H
+#define LLVM_LATINO_BASIC_ARENAPOOL_H
+
+#include "latino/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace latino {
+
+/// A pool of memory slabs shared by the bump allocators of successive
+/// translation units.
+///
+/// When an allocator attached to the pool is destroyed, its slabs are kept
+/// and handed to the next allocator that asks for a slab of the same size,
+/// instead of being returned to the system. A process that compiles many
+/// files, such as the compile server, keeps one pool and attaches it to every
+/// compiler instance it creates.
+class ArenaPool : public llvm::ThreadSafeRefCountedBase<ArenaPool> {
+  mutable std::mutex Lock;
+
+  /// The released slabs, by size.
+  llvm::DenseMap<size_t, SmallVector<void *, 4>> FreeSlabs;
+
+  /// The largest number of bytes kept in released slabs. Slabs released
+  /// beyond it are returned to the system.
+  size_t MaxPooledBytes;
+
+  size_t BytesInUse = 0;
+  size_t PeakBytesInUse = 0;
+  size_t PooledBytes = 0;
+  uint64_t NumSlabsAllocated = 0;
+  uint64_t NumSlabsReused = 0;
+
+public:
+  explicit ArenaPool(size_t MaxPooledBytes = size_t(256) << 20)
+      : MaxPooledBytes(MaxPooledBytes) {}
+  ArenaPool(const ArenaPool &) = delete;
+  ArenaPool &operator=(const ArenaPool &) = delete;
+  ~ArenaPool();
+
+  /// Get a slab of \p Size bytes, reusing a released one if possible.
+  void *allocateSlab(size_t Size, size_t Alignment);
+
+  /// Give back a slab obtained from allocateSlab.
+  void releaseSlab(void *Slab, size_t Size, size_t Alignment);
+
+  /// Return all released slabs to the system.
+  void trim();
+
+  /// The number of bytes in slabs currently held by allocators.
+  size_t getBytesInUse() const;
+
+  /// The largest value getBytesInUse() has had.
+  size_t getPeakBytesInUse() const;
+
+  /// The number of bytes in released slabs kept for reuse.
+  size_t getPooledBytes() const;
+
+  /// The number of slabs obtained from the system.
+  uint64_t getNumSlabsAllocated() const;
+
+  /// The number of slabs handed out again after being released.
+  uint64_t getNumSlabsReused() const;
+
+  void PrintStats() const;
+};
+
+/// The slab allocator of an ArenaAllocator. It takes its slabs from an
+/// ArenaPool if one is attached, and from the heap otherwise.
+class ArenaSlabAllocator : public llvm::AllocatorBase<ArenaSlabAllocator> {
+  IntrusiveRefCntPtr<ArenaPool> Pool;
+
+public:
+  ArenaSlabAllocator() = default;
+  ArenaSlabAllocator(ArenaPool *Pool) : Pool(Pool) {}
+
+  LLVM_ATTRIBUTE_RETURNS_NONNULL void *Allocate(size_t Size,
+                                                size_t Alignment) {
+    if (Pool)
+      return Pool->allocateSlab(Size, Alignment);
+    return llvm::allocate_buffer(Size, Alignment);
+  }
+
+  // Pull in base class overloads.
+  using AllocatorBase<ArenaSlabAllocator>::Allocate;
+
+  void Deallocate(const void *Ptr, size_t Size, size_t Alignment) {
+    if (Pool)
+      return Pool->releaseSlab(const_cast<void *>(Ptr), Size, Alignment);
+    llvm::deallocate_buffer(const_cast<void *>(Ptr), Size, Alignment);
+  }
+
+  // Pull in base class overloads.
+  using AllocatorBase<ArenaSlabAllocator>::Deallocate;
+
+  void PrintStats() const {}
+};
+
+/// A bump allocator whose slabs may come from an ArenaPool.
+using ArenaAllocator = llvm::BumpPtrAllocatorImpl<ArenaSlabAllocator>;
+
+} // namespace latino
+
+#endif // LLVM_LATINO_BASIC_ARENAPOOL_H
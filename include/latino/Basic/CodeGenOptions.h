@@ -208,6 +208,11 @@ public:
   /// Output filename for the split debug info, not used in the skeleton CU.
   std::string SplitDwarfOutput;
 
+  /// The object files for partitions 1 and up of the module, when code
+  /// generation is split into partitions that run in parallel. Partition 0 is
+  /// written to the main output.
+  std::vector<std::string> ParallelCodeGenOutputs;
+
   /// The name of the relocation model to use.
   llvm::Reloc::Model RelocationModel;
 
@@ -419,6 +419,10 @@ public:
   void GetUniqueIDMapping(
                     SmallVectorImpl<const FileEntry *> &UIDToFiles) const;
 
+  /// Produce the names of every file and directory looked up so far, whether
+  /// or not it was found, as they were looked up.
+  void GetSeenPaths(SmallVectorImpl<StringRef> &Paths) const;
+
   /// Retrieve the canonical name for a given directory.
   ///
   /// This is a very expensive operation, despite its results being cached,
@@ -19,11 +19,13 @@
 #include "latino/Basic/TokenKinds.h"
 #include "llvm/ADT/DenseMapInfo.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/PointerLikeTypeTraits.h"
 #include "llvm/Support/type_traits.h"
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -500,6 +502,52 @@ class IdentifierTable {
 
   IdentifierInfoLookup* ExternalLookup;
 
+  /// Perfect hash over the keywords added by AddKeywords(), consulted before
+  /// HashTable so keyword lookups skip the general string hash and probe.
+  /// Each key hashes to a bucket, and the bucket's displacement picks a slot
+  /// that no other keyword uses.  Empty if no perfect hash could be built.
+  llvm::SmallVector<uint16_t, 0> KeywordDisplacements;
+  llvm::SmallVector<IdentifierInfo *, 0> KeywordSlots;
+  /// Bit N is set if some keyword has length N.
+  uint64_t KeywordLengths = 0;
+
+  /// Hash the length, the first eight and the last four characters of \p
+  /// Name.  Every keyword in TokenKinds.def is distinct under this key.
+  static unsigned getKeywordHash(StringRef Name) {
+    uint64_t Prefix = 0;
+    memcpy(&Prefix, Name.data(), std::min<size_t>(Name.size(), 8));
+    uint32_t Suffix = 0;
+    size_t SuffixLen = std::min<size_t>(Name.size(), 4);
+    memcpy(&Suffix, Name.data() + Name.size() - SuffixLen, SuffixLen);
+    uint64_t H = (Prefix ^ (uint64_t(Suffix) << 24) ^ Name.size()) *
+                 0x9E3779B97F4A7C15ULL;
+    return unsigned(H >> 32);
+  }
+
+  static unsigned getKeywordSlot(unsigned Hash, unsigned Displacement) {
+    unsigned H = (Hash ^ Displacement) * 0x85EBCA6BU;
+    return H ^ (H >> 16);
+  }
+
+  /// Return the keyword named \p Name, or null if it is not a keyword.
+  IdentifierInfo *lookupKeyword(StringRef Name) const {
+    if (KeywordSlots.empty() || Name.size() >= 64 ||
+        !(KeywordLengths & (uint64_t(1) << Name.size())))
+      return nullptr;
+    unsigned Hash = getKeywordHash(Name);
+    unsigned Displacement =
+        KeywordDisplacements[Hash & (KeywordDisplacements.size() - 1)];
+    IdentifierInfo *II =
+        KeywordSlots[getKeywordSlot(Hash, Displacement) &
+                     (KeywordSlots.size() - 1)];
+    if (II && II->isStr(Name))
+      return II;
+    return nullptr;
+  }
+
+  /// Build the keyword perfect hash from the keywords in HashTable.
+  void buildKeywordHash();
+
 public:
   /// Create the identifier table.
   explicit IdentifierTable(IdentifierInfoLookup *ExternalLookup = nullptr);
@@ -526,6 +574,9 @@ public:
   /// Return the identifier token info for the specified named
   /// identifier.
   IdentifierInfo &get(StringRef Name) {
+    if (IdentifierInfo *II = lookupKeyword(Name))
+      return *II;
+
     auto &Entry = *HashTable.insert(std::make_pair(Name, nullptr)).first;
 
     IdentifierInfo *&II = Entry.second;
@@ -593,6 +644,11 @@ public:
 
   iterator find(StringRef Name) const { return HashTable.find(Name); }
 
+  /// Make room for at least \p NumIdentifiers identifiers, so that the table
+  /// does not need to grow while they are added.  Existing IdentifierInfos
+  /// are kept in place.
+  void reserve(unsigned NumIdentifiers);
+
   /// Print some statistics to stderr that indicate how well the
   /// hashing is doing.
   void PrintStats() const;
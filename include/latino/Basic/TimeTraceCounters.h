@@ -0,0 +1,59 @@
+//===- TimeTraceCounters.h - Counter events for -ftime-trace ----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+/// \file
+/// Records counters, such as the bytes held by the AST and preprocessor
+/// allocators, alongside the scopes of the LLVM time trace profiler. They are
+/// written as counter ("C") events of the Chrome trace format, so a trace
+/// viewer shows how memory grows next to where the time goes.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LATINO_BASIC_TIMETRACECOUNTERS_H
+#define LLVM_LATINO_BASIC_TIMETRACECOUNTERS_H
+
+#include "latino/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include <cstdint>
+#include <utility>
+
+namespace llvm {
+class raw_pwrite_stream;
+} // namespace llvm
+
+namespace latino {
+
+/// One value of a counter sample, such as ("Allocator", 4096).
+using TimeTraceCounterValue = std::pair<StringRef, uint64_t>;
+
+/// Start recording counters on this thread. Call it right after
+/// llvm::timeTraceProfilerInitialize, so both share the same start time.
+///
+/// Samples of a counter taken less than \p TimeTraceGranularity microseconds
+/// after the previous one replace it, which bounds the size of the trace for
+/// counters sampled at every include or analysis step.
+void timeTraceCountersInitialize(unsigned TimeTraceGranularity);
+
+/// Stop recording counters on this thread and drop those recorded.
+void timeTraceCountersCleanup();
+
+/// Whether counters are being recorded on this thread.
+bool timeTraceCountersEnabled();
+
+/// Record a sample of the counter \p Name, taken now. A counter with several
+/// values is shown as a stacked graph.
+void timeTraceCounter(StringRef Name, ArrayRef<TimeTraceCounterValue> Values);
+
+/// Write the trace of llvm::timeTraceProfilerWrite to \p OS, with the
+/// counters recorded on this thread added to its events.
+void timeTraceCountersWrite(llvm::raw_pwrite_stream &OS);
+
+} // namespace latino
+
+#endif // LLVM_LATINO_BASIC_TIMETRACECOUNTERS_H
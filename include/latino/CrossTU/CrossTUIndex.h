@@ -0,0 +1,73 @@
+//===--- CrossTUIndex.h - Binary index of external definitions --*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file declares the binary form of the index that maps the lookup
+//  names of external definitions to the files that contain them. Unlike the
+//  text index, it is memory mapped and looked up in place, so opening it does
+//  not depend on the number of definitions.
+//
+//===----------------------------------------------------------------------===//
+#ifndef LLVM_LATINO_CROSSTU_CROSSTUINDEX_H
+#define LLVM_LATINO_CROSSTU_CROSSTUINDEX_H
+
+#include "latino/Basic/LLVM.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include <memory>
+#include <string>
+
+namespace llvm {
+class MemoryBuffer;
+} // namespace llvm
+
+namespace latino {
+namespace cross_tu {
+
+/// An index of external definitions in the binary format, which is an
+/// on-disk chained hash table from lookup names to file paths.
+class BinaryCrossTUIndex {
+public:
+  ~BinaryCrossTUIndex();
+
+  /// Whether the file at \p IndexPath is a binary index, rather than a text
+  /// one.
+  static bool isBinaryIndex(StringRef IndexPath);
+
+  /// Map the binary index at \p IndexPath.
+  static llvm::Expected<std::unique_ptr<BinaryCrossTUIndex>>
+  create(StringRef IndexPath);
+
+  /// Returns the path of the file that contains the definition of
+  /// \p LookupName, or None if the index has no such definition. The path
+  /// points into the mapped index.
+  llvm::Optional<StringRef> lookup(StringRef LookupName) const;
+
+  /// The number of definitions in the index.
+  unsigned size() const;
+
+  class Table;
+
+private:
+  BinaryCrossTUIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
+                     std::unique_ptr<Table> Definitions);
+
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  std::unique_ptr<Table> Definitions;
+};
+
+/// Write \p Index, as returned by parseCrossTUIndex, in the binary format
+/// to \p OS.
+void writeBinaryCrossTUIndex(const llvm::StringMap<std::string> &Index,
+                             raw_ostream &OS);
+
+} // namespace cross_tu
+} // namespace latino
+
+#endif // LLVM_LATINO_CROSSTU_CROSSTUINDEX_H
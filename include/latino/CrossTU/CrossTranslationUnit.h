@@ -16,12 +16,21 @@
 
 #include "latino/AST/ASTImporterSharedState.h"
 #include "latino/Basic/LLVM.h"
+#include "latino/CrossTU/CrossTUIndex.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/Path.h"
+#include <atomic>
+#include <future>
+#include <list>
+#include <memory>
+
+namespace llvm {
+class ThreadPool;
+} // namespace llvm
 
 namespace latino {
 class CompilerInstance;
@@ -89,6 +98,8 @@ private:
 ///
 /// The index file format is the following:
 /// each line consists of an USR and a filepath separated by a space.
+/// The BinaryCrossTUIndex holds the same mapping in a form that does not
+/// have to be parsed.
 ///
 /// \return Returns a map where the USR is the key and the filepath is the value
 ///         or an error.
@@ -166,6 +177,19 @@ public:
                                             StringRef IndexName,
                                             bool DisplayCTUProgress = false);
 
+  /// Start loading the external ASTs that contain the definitions of
+  /// \p LookupNames in the background, so that loadExternalAST finds them
+  /// loaded. This does nothing unless the 'ctu-prefetch-threads' analyzer
+  /// option is set. Only AST dumps are prefetched, and no more of them than
+  /// the import threshold still allows.
+  void prefetchExternalASTs(ArrayRef<std::string> LookupNames,
+                            StringRef CrossTUDir, StringRef IndexName);
+
+  /// \returns The number of prefetched ASTs that loadExternalAST used.
+  unsigned getNumPrefetchedASTsUsed() const {
+    return ASTStorage.getNumPrefetchedASTsUsed();
+  }
+
   /// This function merges a definition from a separate AST Unit into
   ///        the current one which was created by the compiler instance that
   ///        was passed to the constructor.
@@ -240,6 +264,17 @@ private:
     /// prefixed with CTUDir.
     LoadResultTy load(StringRef Identifier);
 
+    /// The absolute path of the AST dump or source-file \p Identifier refers
+    /// to.
+    std::string getPath(StringRef Identifier) const;
+
+    /// Whether \p Path is an AST dump, rather than a source-file.
+    static bool isDump(StringRef Path) { return Path.endswith(".ast"); }
+
+    /// Loads an AST from a pch-dump. This is safe to call from several
+    /// threads at once.
+    LoadResultTy loadFromDump(StringRef Identifier);
+
     /// Lazily initialize the invocation list information, which is needed for
     /// on-demand parsing.
     llvm::Error lazyInitInvocationList();
@@ -249,8 +284,6 @@ private:
     /// Defaults to posix.
     const llvm::sys::path::Style PathStyle = llvm::sys::path::Style::posix;
 
-    /// Loads an AST from a pch-dump.
-    LoadResultTy loadFromDump(StringRef Identifier);
     /// Loads an AST from a source-file.
     LoadResultTy loadFromSource(StringRef Identifier);
 
@@ -277,6 +310,11 @@ private:
     /// Tell that a new AST was loaded successfully.
     void indicateLoadSuccess() { ++Count; }
 
+    /// The number of ASTs that may still be loaded.
+    unsigned getNumRemaining() const {
+      return Count < Limit ? Limit - Count : 0;
+    }
+
   private:
     /// The number of ASTs actually imported.
     unsigned Count{0u};
@@ -289,6 +327,7 @@ private:
   class ASTUnitStorage {
   public:
     ASTUnitStorage(CompilerInstance &CI);
+    ~ASTUnitStorage();
     /// Loads an ASTUnit for a function.
     ///
     /// \param FunctionName USR name of the function.
@@ -318,6 +357,14 @@ private:
                                                    StringRef CrossTUDir,
                                                    StringRef IndexName);
 
+    /// Starts loading the AST dumps that contain the definitions of
+    /// \p FunctionNames on the prefetch threads.
+    void prefetchFunctions(ArrayRef<std::string> FunctionNames,
+                           StringRef CrossTUDir, StringRef IndexName);
+
+    /// \returns The number of prefetched units that were used.
+    unsigned getNumPrefetchedASTsUsed() const { return NumPrefetchedUsed; }
+
   private:
     llvm::Error ensureCTUIndexLoaded(StringRef CrossTUDir, StringRef IndexName);
     llvm::Expected<ASTUnit *> getASTUnitForFile(StringRef FileName,
@@ -331,7 +378,13 @@ private:
     NonOwningMapTy NameASTUnitMap;
 
     using IndexMapTy = BaseMapTy<std::string>;
+    /// The text index, if that is what the index file is.
     IndexMapTy NameFileMap;
+    /// The binary index, if that is what the index file is.
+    std::unique_ptr<BinaryCrossTUIndex> BinaryIndex;
+
+    /// Returns the file of \p FunctionName in the loaded index, or None.
+    llvm::Optional<StringRef> lookupIndex(StringRef FunctionName) const;
 
     /// Loads the AST based on the identifier found in the index.
     ASTLoader Loader;
@@ -341,6 +394,38 @@ private:
     /// information whether the AST to load is actually loaded or returned from
     /// cache. This information is needed to maintain the counter.
     ASTLoadGuard LoadGuard;
+
+    /// An AST dump being loaded, or loaded, ahead of its first use.
+    struct PrefetchedAST {
+      /// The loaded unit, or null if the load failed or was cancelled. A
+      /// failed load is repeated when the unit is needed, to report the
+      /// error.
+      std::future<std::unique_ptr<ASTUnit>> Unit;
+      /// Set when the unit is dropped before its load started.
+      std::shared_ptr<std::atomic<bool>> Cancelled;
+      /// The size of the AST dump, which approximates the memory it takes.
+      uint64_t Size;
+      /// The position of the file in PrefetchOrder.
+      std::list<std::string>::iterator OrderPos;
+    };
+
+    /// Takes the prefetched unit of \p FileName, waiting for its load to
+    /// finish, or returns null if it was not prefetched.
+    std::unique_ptr<ASTUnit> takePrefetchedAST(StringRef FileName);
+    /// Drops the prefetched unit of \p FileName.
+    void dropPrefetchedAST(StringRef FileName);
+
+    llvm::StringMap<PrefetchedAST> PrefetchedASTs;
+    /// The files of PrefetchedASTs, the most recently requested first.
+    std::list<std::string> PrefetchOrder;
+    /// The sum of the sizes of PrefetchedASTs.
+    uint64_t PrefetchedBytes = 0;
+    /// The number of prefetched units taken by takePrefetchedAST.
+    unsigned NumPrefetchedUsed = 0;
+    const uint64_t PrefetchMemoryLimit;
+    /// Declared last, so its destructor waits for the loads that use the
+    /// members above.
+    std::unique_ptr<llvm::ThreadPool> PrefetchThreads;
   };
 
   ASTUnitStorage ASTStorage;
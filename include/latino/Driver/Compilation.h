@@ -124,6 +124,15 @@ class Compilation {
   /// Whether to keep temporary files regardless of -save-temps.
   bool ForceKeepTempFiles = false;
 
+  /// ExecuteJobsInParallel - Execute the jobs on a pool of up to
+  /// Driver::NumParallelJobs threads. A job is started once every job
+  /// producing one of its inputs, and every earlier job of the same action,
+  /// has finished. The output of each job is captured and replayed in
+  /// job-list order.
+  void ExecuteJobsInParallel(
+      const JobList &Jobs,
+      SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const;
+
 public:
   Compilation(const Driver &D, const ToolChain &DefaultToolChain,
               llvm::opt::InputArgList *Args,
@@ -271,6 +280,11 @@ public:
                       const JobAction *JA,
                       bool IssueErrors = false) const;
 
+  /// PrintCommand - Echo a command for -v or CC_PRINT_OPTIONS, if requested.
+  ///
+  /// \return false if the CC_PRINT_OPTIONS log file could not be opened.
+  bool PrintCommand(const Command &C) const;
+
   /// ExecuteCommand - Execute an actual command.
   ///
   /// \param FailingCommand - For non-zero results, this will be set to the
@@ -207,10 +207,16 @@ public:
   /// Pointer to the ExecuteCC1Tool function, if available.
   /// When the latinoDriver lib is used through clang.exe, this provides a
   /// shortcut for executing the -cc1 command-line directly, in the same
-  /// process.
-  typedef int (*CC1ToolFunc)(SmallVectorImpl<const char *> &ArgV);
+  /// process. If \p DiagOS is non-null, diagnostics are printed to it instead
+  /// of stderr.
+  typedef int (*CC1ToolFunc)(SmallVectorImpl<const char *> &ArgV,
+                             raw_ostream *DiagOS);
   CC1ToolFunc CC1Main = nullptr;
 
+  /// The maximum number of jobs Compilation::ExecuteJobs may run at the same
+  /// time, as requested with -j. One keeps the serial behavior.
+  unsigned NumParallelJobs = 1;
+
 private:
   /// Raw target triple.
   std::string TargetTriple;
@@ -18,6 +18,7 @@
 #include "llvm/Option/Option.h"
 #include "llvm/Support/Program.h"
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -201,12 +202,23 @@ public:
 
   const llvm::opt::ArgStringList &getArguments() const { return Arguments; }
 
+  /// Replace the program arguments of this command.
+  void replaceArguments(llvm::opt::ArgStringList List) {
+    Arguments = std::move(List);
+  }
+
 protected:
   /// Optionally print the filenames to be compiled
   void PrintFileNames() const;
 };
 
-/// Use the CC1 tool callback when available, to avoid creating a new process
+/// Use the CC1 tool callback when available, to avoid creating a new process.
+///
+/// When the driver may run several jobs at once (-j), each in-process cc1
+/// runs on a thread of its own with a full-size stack, and its diagnostics
+/// are written to the stderr redirection of the job, if any. The stdout of
+/// the driver is redirected while an invocation with a stdout redirection
+/// runs; one which cannot have it runs in a process of its own instead.
 class CC1Command : public Command {
 public:
   CC1Command(const Action &Source, const Tool &Creator,
@@ -221,6 +233,11 @@ public:
               bool *ExecutionFailed) const override;
 
   void setEnvironment(llvm::ArrayRef<const char *> NewEnvironment) override;
+
+  /// Held by the in-process invocation whose output goes to a file through
+  /// the stdout of the driver. Hold it to write to the stdout of the driver
+  /// while such an invocation may be running.
+  static std::mutex &getStdoutRedirectMutex();
 };
 
 /// Like Command, but with a fallback which is executed in case
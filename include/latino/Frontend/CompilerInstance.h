@@ -10,6 +10,7 @@
 #define LLVM_LATINO_FRONTEND_COMPILERINSTANCE_H_
 
 #include "latino/AST/ASTConsumer.h"
+#include "latino/Basic/ArenaPool.h"
 #include "latino/Basic/Diagnostic.h"
 #include "latino/Basic/SourceManager.h"
 #include "latino/Frontend/CompilerInvocation.h"
@@ -85,6 +86,9 @@ class CompilerInstance : public ModuleLoader {
   /// The file manager.
   IntrusiveRefCntPtr<FileManager> FileMgr;
 
+  /// The pool of slabs for the preprocessor and AST allocators.
+  IntrusiveRefCntPtr<ArenaPool> Arenas;
+
   /// The source manager.
   IntrusiveRefCntPtr<SourceManager> SourceMgr;
 
@@ -412,6 +416,22 @@ public:
   /// Replace the current file manager and virtual file system.
   void setFileManager(FileManager *Value);
 
+  /// }
+  /// @name Arena Pool
+  /// {
+
+  /// Return the pool the preprocessor and AST allocators take their slabs
+  /// from. Each instance starts with its own; a process that runs many
+  /// compilations can share one between instances.
+  ArenaPool &getArenaPool() const { return *Arenas; }
+
+  /// Replace the arena pool used by preprocessors and AST contexts created
+  /// from now on.
+  void setArenaPool(ArenaPool *Value) {
+    assert(Value && "Compiler instance needs an arena pool!");
+    Arenas = Value;
+  }
+
   /// }
   /// @name Source Manager
   /// {
@@ -654,6 +674,13 @@ public:
   /// Create the AST context.
   void createASTContext();
 
+  /// Precompile the prelude named by the preprocessor options into the
+  /// prelude cache, unless an up-to-date copy is already there, and make it
+  /// the implicit PCH include.
+  ///
+  /// \return false if the prelude could not be built.
+  bool loadPrelude();
+
   /// Create an external AST source to read a PCH file and attach it to the AST
   /// context.
   void createPCHExternalASTSource(StringRef Path, bool DisablePCHValidation,
@@ -15,6 +15,7 @@
 #define LLVM_LATINO_LEX_MACROINFO_H
 
 #include "latino/Lex/Token.h"
+#include "latino/Basic/ArenaPool.h"
 #include "latino/Basic/LLVM.h"
 #include "latino/Basic/SourceLocation.h"
 #include "llvm/ADT/ArrayRef.h"
@@ -162,7 +163,7 @@ public:
   /// Set the specified list of identifiers as the parameter list for
   /// this macro.
   void setParameterList(ArrayRef<IdentifierInfo *> List,
-                       llvm::BumpPtrAllocator &PPAllocator) {
+                       ArenaAllocator &PPAllocator) {
     assert(ParameterList == nullptr && NumParameters == 0 &&
            "Parameter list already set!");
     if (List.empty())
@@ -14,6 +14,7 @@
 #ifndef LLVM_LATINO_LEX_PREPROCESSOR_H
 #define LLVM_LATINO_LEX_PREPROCESSOR_H
 
+#include "latino/Basic/ArenaPool.h"
 #include "latino/Basic/Diagnostic.h"
 #include "latino/Basic/IdentifierTable.h"
 #include "latino/Basic/LLVM.h"
@@ -146,7 +147,7 @@ class Preprocessor {
 
   /// A BumpPtrAllocator object used to quickly allocate and release
   /// objects internal to the Preprocessor.
-  llvm::BumpPtrAllocator BP;
+  ArenaAllocator BP;
 
   /// Identifiers for builtin macros and other builtins.
   IdentifierInfo *Ident__LINE__, *Ident__FILE__;   // __LINE__, __FILE__
@@ -881,7 +882,8 @@ public:
                HeaderSearch &Headers, ModuleLoader &TheModuleLoader,
                IdentifierInfoLookup *IILookup = nullptr,
                bool OwnsHeaderSearch = false,
-               TranslationUnitKind TUKind = TU_Complete);
+               TranslationUnitKind TUKind = TU_Complete,
+               ArenaPool *Arenas = nullptr);
 
   ~Preprocessor();
 
@@ -923,7 +925,7 @@ public:
   const IdentifierTable &getIdentifierTable() const { return Identifiers; }
   // SelectorTable &getSelectorTable() { return Selectors; }
   Builtin::Context &getBuiltinInfo() { return *BuiltinInfo; }
-  llvm::BumpPtrAllocator &getPreprocessorAllocator() { return BP; }
+  ArenaAllocator &getPreprocessorAllocator() { return BP; }
 
   void setExternalSource(ExternalPreprocessorSource *Source) {
     ExternalSource = Source;
@@ -1861,6 +1863,10 @@ public:
 
   size_t getTotalMemory() const;
 
+  /// Record the memory held by the preprocessor and the source manager as
+  /// -ftime-trace counters, if they are being recorded.
+  void recordMemoryCounters() const;
+
   /// When the macro expander pastes together a comment (/##/) in Microsoft
   /// mode, this method handles updating the current state, returning the
   /// token on the next source line.
@@ -2251,9 +2257,9 @@ private:
       ModuleMap::KnownHeader &SuggestedModule, bool isAngled);
 
   // File inclusion.
-  // void HandleIncludeDirective(SourceLocation HashLoc, Token &Tok,
-  //                             const DirectoryLookup *LookupFrom = nullptr,
-  //                             const FileEntry *LookupFromFile = nullptr);
+  void HandleIncludeDirective(SourceLocation HashLoc, Token &Tok,
+                              const DirectoryLookup *LookupFrom = nullptr,
+                              const FileEntry *LookupFromFile = nullptr);
   ImportAction
   HandleHeaderIncludeOrImport(SourceLocation HashLoc, Token &IncludeTok,
                               Token &FilenameTok, SourceLocation EndLoc,
@@ -76,6 +76,14 @@ public:
   /// The implicit PCH included at the start of the translation unit, or empty.
   std::string ImplicitPCHInclude;
 
+  /// The prelude file whose declarations are made available to every
+  /// translation unit, or empty. It is precompiled on first use and
+  /// loaded as if it were the implicit PCH include.
+  std::string PreludeFile;
+
+  /// The directory in which precompiled preludes are cached.
+  std::string PreludeCachePath;
+
   /// Headers that will be converted to chained PCHs in memory.
   std::vector<std::string> ChainedIncludes;
 
@@ -223,6 +231,8 @@ public:
     ChainedIncludes.clear();
     DumpDeserializedPCHDecls = false;
     ImplicitPCHInclude.clear();
+    PreludeFile.clear();
+    PreludeCachePath.clear();
     SingleFileParseMode = false;
     LexEditorPlaceholders = true;
     RetainRemappedFileBuffers = true;
@@ -133,6 +133,9 @@ public:
   /// Loads comment ranges.
   void ReadComments() override;
 
+  /// Loads the results of the calls to \p FD evaluated in the sources.
+  void ReadConstexprEvalResults(const FunctionDecl *FD) override;
+
   /// Notify ExternalASTSource that we started deserialization of
   /// a decl or type so until FinishedDeserializing is called there may be
   /// decls that are initializing. Must be paired with FinishedDeserializing.
@@ -695,6 +695,10 @@ public:
 
       /// Record code for \#pragma float_control options.
       FLOAT_CONTROL_PRAGMA_OPTIONS = 65,
+
+      /// Record code for the results of the constexpr calls evaluated in
+      /// this AST file.
+      CONSTEXPR_EVAL_RESULTS = 66,
     };
 
     /// Record types used within a source manager block.
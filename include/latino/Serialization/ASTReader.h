@@ -13,6 +13,7 @@
 #ifndef LLVM_LATINO_SERIALIZATION_ASTREADER_H
 #define LLVM_LATINO_SERIALIZATION_ASTREADER_H
 
+#include "latino/AST/ConstexprEvalCache.h"
 #include "latino/AST/Type.h"
 #include "latino/Basic/Diagnostic.h"
 #include "latino/Basic/DiagnosticOptions.h"
@@ -908,6 +909,22 @@ private:
   /// Sema tracks these to emit deferred diags.
   SmallVector<uint64_t, 4> DeclsToCheckForDeferredDiags;
 
+  /// A result of a constexpr call evaluated in an AST file, which has not
+  /// been added to the ASTContext's ConstexprEvalCache yet.
+  struct PendingConstexprEvalResult {
+    /// The ODR hash of the definition of the callee the call evaluated.
+    unsigned ODRHash;
+    ConstexprEvalCache::Cost EvalCost;
+    std::string Key;
+    std::string Value;
+  };
+
+  /// The results of constexpr calls evaluated in the AST files, by the ID of
+  /// the callee. They are added to the cache when the callee is first looked
+  /// up in it.
+  llvm::DenseMap<serialization::DeclID,
+                 SmallVector<PendingConstexprEvalResult, 2>>
+      PendingConstexprEvalResults;
 
 public:
   struct ImportedSubmodule {
@@ -979,6 +996,16 @@ private:
   /// in the chain.
   unsigned TotalNumStatements = 0;
 
+  /// The number of function bodies whose reading was deferred until they
+  /// are used.
+  unsigned NumLazyBodies = 0;
+
+  /// The number of function bodies de-serialized from the chain.
+  unsigned NumBodiesRead = 0;
+
+  /// The number of bits of function bodies de-serialized from the chain.
+  uint64_t NumBodyBitsRead = 0;
+
   /// The number of macros de-serialized from the chain.
   unsigned NumMacrosRead = 0;
 
@@ -1767,6 +1794,13 @@ public:
     return static_cast<unsigned>(SubmodulesLoaded.size());
   }
 
+  /// Returns the number of function bodies whose reading was deferred until
+  /// they are used.
+  unsigned getNumLazyBodies() const { return NumLazyBodies; }
+
+  /// Returns the number of function bodies read from the chain.
+  unsigned getNumBodiesRead() const { return NumBodiesRead; }
+
   /// Returns the number of selectors found in the chain.
   // unsigned getTotalNumSelectors() const {
   //   return static_cast<unsigned>(SelectorsLoaded.size());
@@ -2273,6 +2307,10 @@ public:
   /// Loads comments ranges.
   void ReadComments() override;
 
+  /// Loads the results of the constexpr calls to \p FD evaluated in the AST
+  /// files.
+  void ReadConstexprEvalResults(const FunctionDecl *FD) override;
+
   /// Visit all the input files of the given module file.
   void visitInputFiles(serialization::ModuleFile &MF,
                        bool IncludeSystem, bool Complain,
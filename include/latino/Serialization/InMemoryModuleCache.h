@@ -75,6 +75,17 @@ public:
   llvm::MemoryBuffer &addBuiltPCM(llvm::StringRef Filename,
                                   std::unique_ptr<llvm::MemoryBuffer> Buffer);
 
+  /// Replace the buffer of a just-built PCM by another one holding the same
+  /// PCM, such as a read-only mapping of the file it was written to, whose
+  /// pages are shared with the other processes that read it.
+  ///
+  /// \pre state is Final.
+  /// \pre the previous buffer was not looked up yet.
+  /// \return a reference to the buffer as a convenience.
+  llvm::MemoryBuffer &
+  replaceBuiltPCM(llvm::StringRef Filename,
+                  std::unique_ptr<llvm::MemoryBuffer> Buffer);
+
   /// Try to remove a buffer from the cache.  No effect if state is Final.
   ///
   /// \pre state is Tentative/Final.
@@ -126,6 +126,7 @@ enum class ExplorationStrategyKind {
   UnexploredFirstQueue,
   UnexploredFirstLocationQueue,
   BFSBlockDFSContents,
+  CoverageFirstQueue,
 };
 
 /// Describes the kinds for high-level analyzer mode.
@@ -123,6 +123,10 @@ private:
 
   void HandleVirtualBaseBranch(const CFGBlock *B, ExplodedNode *Pred);
 
+  /// Record the size of the exploded graph as -ftime-trace counters, if they
+  /// are being recorded.
+  void recordMemoryCounters();
+
 private:
   ExplodedNode *generateCallExitBeginNode(ExplodedNode *N,
                                           const ReturnStmt *RS);
@@ -331,6 +331,10 @@ protected:
   /// A list of recently allocated nodes that can potentially be recycled.
   NodeVector ChangedNodes;
 
+  /// Recently allocated nodes that had no successor yet when they were
+  /// considered for reclamation. They are considered once more the next time.
+  NodeVector FrontierNodes;
+
   /// A list of nodes that can be reused.
   NodeVector FreeNodes;
 
@@ -342,6 +346,10 @@ protected:
   /// Counter to determine when to reclaim nodes.
   unsigned ReclaimCounter;
 
+  /// Whether the node right before a call is kept, so that the call can be
+  /// evaluated again without inlining.
+  bool KeepNodesBeforeCalls = true;
+
 public:
   ExplodedGraph();
   ~ExplodedGraph();
@@ -443,8 +451,10 @@ public:
 
   /// Enable tracking of recently allocated nodes for potential reclamation
   /// when calling reclaimRecentlyAllocatedNodes().
-  void enableNodeReclamation(unsigned Interval) {
+  void enableNodeReclamation(unsigned Interval,
+                             bool KeepNodesBeforeCalls = true) {
     ReclaimCounter = ReclaimNodeInterval = Interval;
+    this->KeepNodesBeforeCalls = KeepNodesBeforeCalls;
   }
 
   /// Reclaim "uninteresting" nodes created since the last time this method
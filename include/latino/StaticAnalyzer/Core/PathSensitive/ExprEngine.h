@@ -590,6 +590,10 @@ public:
   static std::pair<const ProgramPointTag *, const ProgramPointTag *>
     geteagerlyAssumeBinOpBifurcationTags();
 
+  /// The tag of the nodes that only clean up dead bindings and symbols. They
+  /// are not needed for the analyzer history and can be reclaimed.
+  static const ProgramPointTag *cleanupNodeTag();
+
   SVal evalMinus(SVal X) {
     return X.isValid() ? svalBuilder.evalMinus(X.castAs<NonLoc>()) : X;
   }
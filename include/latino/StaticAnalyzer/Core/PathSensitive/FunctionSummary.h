@@ -111,6 +111,14 @@ public:
     return 0;
   }
 
+  /// The basic blocks of \p D visited so far, or null if none was.
+  const llvm::SmallBitVector *getVisitedBasicBlocks(const Decl *D) const {
+    MapTy::const_iterator I = Map.find(D);
+    if (I != Map.end())
+      return &I->second.VisitedBasicBlocks;
+    return nullptr;
+  }
+
   unsigned getNumTimesInlined(const Decl* D) {
     MapTy::const_iterator I = Map.find(D);
     if (I != Map.end())
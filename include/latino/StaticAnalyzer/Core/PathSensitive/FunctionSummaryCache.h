@@ -0,0 +1,83 @@
+//===- FunctionSummaryCache.h - Summaries kept across runs ------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the on-disk cache of the results of analyzing top-level
+// functions, which lets a later analysis of the same translation unit skip
+// the functions that did not change.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LATINO_STATICANALYZER_CORE_PATHSENSITIVE_FUNCTIONSUMMARYCACHE_H
+#define LLVM_LATINO_STATICANALYZER_CORE_PATHSENSITIVE_FUNCTIONSUMMARYCACHE_H
+
+#include "latino/Basic/LLVM.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace latino {
+namespace ento {
+
+/// What the path-sensitive analysis of a top-level function found.
+struct CachedFunctionSummary {
+  /// The hash of the function and of everything it calls, which has to match
+  /// for the summary to be reused.
+  uint64_t Hash = 0;
+
+  /// The number of bug reports found by the analysis.
+  unsigned NumReports = 0;
+
+  /// The number of basic blocks of the function, and those that were visited.
+  unsigned TotalBlocks = 0;
+  std::vector<unsigned> VisitedBlocks;
+
+  /// The lookup names of the functions inlined by the analysis, and of those
+  /// among them that turned out not to be worth inlining again.
+  std::vector<std::string> InlinedCallees;
+  std::vector<std::string> NotInlinableCallees;
+};
+
+/// The summaries of the top-level functions of a translation unit, keyed by
+/// the lookup names of the functions.
+///
+/// The cache file records the analyzer configuration it was written with. A
+/// file written with a different configuration is ignored.
+class FunctionSummaryCache {
+public:
+  explicit FunctionSummaryCache(uint64_t ConfigHash) : ConfigHash(ConfigHash) {}
+
+  /// Read the summaries of \p Path. A missing file, or one written with
+  /// another configuration, results in an empty cache.
+  static llvm::Expected<FunctionSummaryCache> load(StringRef Path,
+                                                   uint64_t ConfigHash);
+
+  /// Write the summaries to \p Path. The file is replaced atomically, so
+  /// concurrent analyses of the same file never read a partial cache.
+  llvm::Error save(StringRef Path) const;
+
+  /// Returns the summary of \p Name if it was analyzed with hash \p Hash.
+  const CachedFunctionSummary *lookup(StringRef Name, uint64_t Hash) const;
+
+  void insert(StringRef Name, CachedFunctionSummary Summary) {
+    Summaries[Name] = std::move(Summary);
+  }
+
+  size_t size() const { return Summaries.size(); }
+
+private:
+  uint64_t ConfigHash;
+  llvm::StringMap<CachedFunctionSummary> Summaries;
+};
+
+} // namespace ento
+} // namespace latino
+
+#endif // LLVM_LATINO_STATICANALYZER_CORE_PATHSENSITIVE_FUNCTIONSUMMARYCACHE_H
@@ -16,6 +16,9 @@
 #include "latino/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "latino/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
 #include "latino/StaticAnalyzer/Core/PathSensitive/SimpleConstraintManager.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
 
 namespace latino {
 
@@ -49,62 +52,76 @@ public:
   }
 };
 
-class RangeTrait : public llvm::ImutContainerInfo<Range> {
-public:
-  // When comparing if one Range is less than another, we should compare
-  // the actual APSInt values instead of their pointers.  This keeps the order
-  // consistent (instead of comparing by pointer values) and can potentially
-  // be used to speed up some of the operations in RangeSet.
-  static inline bool isLess(key_type_ref lhs, key_type_ref rhs) {
-    return *lhs.first < *rhs.first ||
-           (!(*rhs.first < *lhs.first) && *lhs.second < *rhs.second);
-  }
-};
-
 /// RangeSet contains a set of ranges. If the set is empty, then
 ///  there the value of a symbol is overly constrained and there are no
 ///  possible values for that symbol.
+///
+/// The ranges are kept in a sorted array, which the factory uniques: equal
+/// sets share their storage, and comparing two sets compares two pointers.
 class RangeSet {
-  typedef llvm::ImmutableSet<Range, RangeTrait> PrimRangeSet;
-  PrimRangeSet ranges; // no need to make const, since it is an
-                       // ImmutableSet - this allows default operator=
-                       // to work.
+  using ContainerType = llvm::SmallVector<Range, 4>;
+
+  /// The uniqued storage of a set of ranges.
+  class StorageNode : public llvm::FoldingSetNode {
+  public:
+    explicit StorageNode(ContainerType Ranges) : Ranges(std::move(Ranges)) {}
+
+    const ContainerType Ranges;
+
+    static void Profile(llvm::FoldingSetNodeID &ID, ArrayRef<Range> Ranges) {
+      for (const Range &R : Ranges)
+        R.Profile(ID);
+    }
+    void Profile(llvm::FoldingSetNodeID &ID) const { Profile(ID, Ranges); }
+  };
+
+  const StorageNode *Impl;
+
+  explicit RangeSet(const StorageNode *Impl) : Impl(Impl) {}
+
 public:
-  typedef PrimRangeSet::Factory Factory;
-  typedef PrimRangeSet::iterator iterator;
+  /// Creates the storage of the sets, and owns it.
+  class Factory {
+  public:
+    RangeSet getEmptySet() { return getPersistentSet({}); }
+
+  private:
+    friend class RangeSet;
+
+    /// Returns the set of \p Ranges, which must be sorted and disjoint.
+    RangeSet getPersistentSet(ContainerType Ranges);
 
-  RangeSet(PrimRangeSet RS) : ranges(RS) {}
+    llvm::FoldingSet<StorageNode> Sets;
+    llvm::SpecificBumpPtrAllocator<StorageNode> Arena;
+  };
+
+  typedef ContainerType::const_iterator iterator;
 
   /// Create a new set with all ranges of this set and RS.
   /// Possible intersections are not checked here.
-  RangeSet addRange(Factory &F, const RangeSet &RS) {
-    PrimRangeSet Ranges(RS.ranges);
-    for (const auto &range : ranges)
-      Ranges = F.add(Ranges, range);
-    return RangeSet(Ranges);
-  }
+  RangeSet addRange(Factory &F, const RangeSet &RS) const;
 
-  iterator begin() const { return ranges.begin(); }
-  iterator end() const { return ranges.end(); }
+  iterator begin() const { return Impl->Ranges.begin(); }
+  iterator end() const { return Impl->Ranges.end(); }
 
-  bool isEmpty() const { return ranges.isEmpty(); }
+  bool isEmpty() const { return Impl->Ranges.empty(); }
 
   /// Construct a new RangeSet representing '{ [from, to] }'.
   RangeSet(Factory &F, const llvm::APSInt &from, const llvm::APSInt &to)
-      : ranges(F.add(F.getEmptySet(), Range(from, to))) {}
+      : RangeSet(F.getPersistentSet({Range(from, to)})) {}
 
   /// Construct a new RangeSet representing the given point as a range.
   RangeSet(Factory &F, const llvm::APSInt &point) : RangeSet(F, point, point) {}
 
   /// Profile - Generates a hash profile of this RangeSet for use
   ///  by FoldingSet.
-  void Profile(llvm::FoldingSetNodeID &ID) const { ranges.Profile(ID); }
+  void Profile(llvm::FoldingSetNodeID &ID) const { ID.AddPointer(Impl); }
 
   /// getConcreteValue - If a symbol is contrained to equal a specific integer
   ///  constant then this method returns that value.  Otherwise, it returns
   ///  NULL.
   const llvm::APSInt *getConcreteValue() const {
-    return ranges.isSingleton() ? ranges.begin()->getConcreteValue() : nullptr;
+    return Impl->Ranges.size() == 1 ? begin()->getConcreteValue() : nullptr;
   }
 
   /// Get a minimal value covered by the ranges in the set
@@ -113,10 +130,9 @@ public:
   const llvm::APSInt &getMaxValue() const;
 
 private:
-  void IntersectInRange(BasicValueFactory &BV, Factory &F,
-                        const llvm::APSInt &Lower, const llvm::APSInt &Upper,
-                        PrimRangeSet &newRanges, PrimRangeSet::iterator &i,
-                        PrimRangeSet::iterator &e) const;
+  void IntersectInRange(BasicValueFactory &BV, const llvm::APSInt &Lower,
+                        const llvm::APSInt &Upper, ContainerType &newRanges,
+                        iterator &i, iterator &e) const;
 
   bool pin(llvm::APSInt &Lower, llvm::APSInt &Upper) const;
 
@@ -129,9 +145,8 @@ public:
 
   void print(raw_ostream &os) const;
 
-  bool operator==(const RangeSet &other) const {
-    return ranges == other.ranges;
-  }
+  bool operator==(const RangeSet &other) const { return Impl == other.Impl; }
+  bool operator!=(const RangeSet &other) const { return Impl != other.Impl; }
 };
 
 class ConstraintRange {};
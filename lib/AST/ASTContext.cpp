@@ -21,6 +21,7 @@
 #include "latino/AST/AttrIterator.h"
 #include "latino/AST/CharUnits.h"
 #include "latino/AST/Comment.h"
+#include "latino/AST/ConstexprEvalCache.h"
 #include "latino/AST/Decl.h"
 #include "latino/AST/DeclBase.h"
 #include "latino/AST/DeclCXX.h"
@@ -64,6 +65,7 @@
 #include "latino/Basic/Specifiers.h"
 #include "latino/Basic/TargetCXXABI.h"
 #include "latino/Basic/TargetInfo.h"
+#include "latino/Basic/TimeTraceCounters.h"
 #include "latino/Basic/XRayLists.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/APSInt.h"
@@ -913,6 +915,12 @@ ParentMapContext &ASTContext::getParentMapContext() {
   return *ParentMapCtx.get();
 }
 
+ConstexprEvalCache &ASTContext::getConstexprEvalCache() {
+  if (!ConstexprEvalResults)
+    ConstexprEvalResults.reset(new ConstexprEvalCache(*this));
+  return *ConstexprEvalResults.get();
+}
+
 static const LangASMap *getAddressSpaceMap(const TargetInfo &T,
                                            const LangOptions &LOpts) {
   if (LOpts.FakeAddressSpaceMap) {
@@ -953,7 +961,7 @@ static bool isAddrSpaceMapManglingEnabled(const TargetInfo &TI,
 
 ASTContext::ASTContext(LangOptions &LOpts, SourceManager &SM,
                        IdentifierTable &idents, /*SelectorTable &sels,*/
-                       Builtin::Context &builtins)
+                       Builtin::Context &builtins, ArenaPool *Arenas)
     : ConstantArrayTypes(this_()), FunctionProtoTypes(this_()),
       TemplateSpecializationTypes(this_()),
       DependentTemplateSpecializationTypes(this_()), AutoTypes(this_()),
@@ -963,7 +971,7 @@ ASTContext::ASTContext(LangOptions &LOpts, SourceManager &SM,
       XRayFilter(new XRayFunctionFilter(LangOpts.XRayAlwaysInstrumentFiles,
                                         LangOpts.XRayNeverInstrumentFiles,
                                         LangOpts.XRayAttrListFiles, SM)),
-      PrintingPolicy(LOpts), Idents(idents), /*Selectors(sels),*/
+      BumpAlloc(Arenas), PrintingPolicy(LOpts), Idents(idents), /*Selectors(sels),*/
       BuiltinInfo(builtins), DeclarationNames(*this), Comments(SM),
       CommentCommandTraits(BumpAlloc, LOpts.CommentOpts),
       CompCategories(this_()), LastSDM(nullptr, 0) {
@@ -1075,6 +1083,9 @@ void ASTContext::PrintStats() const {
                << NumImplicitDestructors
                << " implicit destructors created\n";
 
+  if (ConstexprEvalResults)
+    ConstexprEvalResults->PrintStats();
+
   if (ExternalSource) {
     llvm::errs() << "\n";
     ExternalSource->PrintStats();
@@ -10771,6 +10782,14 @@ size_t ASTContext::getSideTableAllocatedMemory() const {
          llvm::capacity_in_bytes(VariableArrayTypes);
 }
 
+void ASTContext::recordMemoryCounters() const {
+  if (!timeTraceCountersEnabled())
+    return;
+  timeTraceCounter("AST Memory",
+                   {{"Nodes", getASTAllocatedMemory()},
+                    {"Side Tables", getSideTableAllocatedMemory()}});
+}
+
 /// getIntTypeForBitwidth -
 /// sets integer QualTy according to specified details:
 /// bitwidth, signed/unsigned.
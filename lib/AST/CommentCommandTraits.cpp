@@ -15,7 +15,7 @@ namespace comments {
 
 #include "latino/AST/CommentCommandInfo.inc"
 
-CommandTraits::CommandTraits(llvm::BumpPtrAllocator &Allocator,
+CommandTraits::CommandTraits(ArenaAllocator &Allocator,
                              const CommentOptions &CommentOptions) :
     NextID(llvm::array_lengthof(Commands)), Allocator(Allocator) {
   registerCommentOptions(CommentOptions);
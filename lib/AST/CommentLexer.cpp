@@ -37,7 +37,7 @@ static inline bool isHTMLHexCharacterReferenceCharacter(char C) {
 }
 
 static inline StringRef convertCodePointToUTF8(
-                                      llvm::BumpPtrAllocator &Allocator,
+                                      ArenaAllocator &Allocator,
                                       unsigned CodePoint) {
   char *Resolved = Allocator.Allocate<char>(UNI_MAX_UTF8_BYTES_PER_CODE_POINT);
   char *ResolvedPtr = Resolved;
@@ -738,7 +738,7 @@ void Lexer::lexHTMLEndTag(Token &T) {
   State = LS_Normal;
 }
 
-Lexer::Lexer(llvm::BumpPtrAllocator &Allocator, DiagnosticsEngine &Diags,
+Lexer::Lexer(ArenaAllocator &Allocator, DiagnosticsEngine &Diags,
              const CommandTraits &Traits, SourceLocation FileLoc,
              const char *BufferStart, const char *BufferEnd,
              bool ParseCommands)
@@ -28,7 +28,7 @@ namespace comments {
 
 /// Re-lexes a sequence of tok::text tokens.
 class TextTokenRetokenizer {
-  llvm::BumpPtrAllocator &Allocator;
+  ArenaAllocator &Allocator;
   Parser &P;
 
   /// This flag is set when there are no more tokens we can fetch from lexer.
@@ -143,7 +143,7 @@ class TextTokenRetokenizer {
   }
 
 public:
-  TextTokenRetokenizer(llvm::BumpPtrAllocator &Allocator, Parser &P):
+  TextTokenRetokenizer(ArenaAllocator &Allocator, Parser &P):
       Allocator(Allocator), P(P), NoMoreInterestingTokens(false) {
     Pos.CurToken = 0;
     addToken();
@@ -253,7 +253,7 @@ public:
   }
 };
 
-Parser::Parser(Lexer &L, Sema &S, llvm::BumpPtrAllocator &Allocator,
+Parser::Parser(Lexer &L, Sema &S, ArenaAllocator &Allocator,
                const SourceManager &SourceMgr, DiagnosticsEngine &Diags,
                const CommandTraits &Traits):
     L(L), S(S), Allocator(Allocator), SourceMgr(SourceMgr), Diags(Diags),
@@ -25,7 +25,7 @@ namespace {
 #include "latino/AST/CommentHTMLTagsProperties.inc"
 } // end anonymous namespace
 
-Sema::Sema(llvm::BumpPtrAllocator &Allocator, const SourceManager &SourceMgr,
+Sema::Sema(ArenaAllocator &Allocator, const SourceManager &SourceMgr,
            DiagnosticsEngine &Diags, CommandTraits &Traits,
            const Preprocessor *PP) :
     Allocator(Allocator), SourceMgr(SourceMgr), Diags(Diags), Traits(Traits),
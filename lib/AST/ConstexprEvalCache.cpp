@@ -0,0 +1,289 @@
+//===--- ConstexprEvalCache.cpp - Results of constexpr calls --------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the cache of the results of constexpr calls.
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/AST/ConstexprEvalCache.h"
+#include "latino/AST/ASTContext.h"
+#include "latino/AST/Decl.h"
+#include "latino/AST/Expr.h"
+#include "latino/AST/ExternalASTSource.h"
+#include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/APSInt.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace latino;
+
+namespace {
+
+/// Tags of the encoded values.
+enum ValueTag : uint8_t { VT_Int, VT_Float, VT_StringLiteral };
+
+using EndianWriter = llvm::support::endian::Writer;
+
+void writeAPInt(EndianWriter &W, const llvm::APInt &Value) {
+  W.write<uint32_t>(Value.getBitWidth());
+  for (unsigned I = 0, N = Value.getNumWords(); I != N; ++I)
+    W.write<uint64_t>(Value.getRawData()[I]);
+}
+
+void writeAPSInt(EndianWriter &W, const llvm::APSInt &Value) {
+  W.write<uint8_t>(Value.isUnsigned());
+  writeAPInt(W, Value);
+}
+
+void writeAPFloat(EndianWriter &W, const llvm::APFloat &Value) {
+  W.write<uint8_t>(
+      llvm::APFloatBase::SemanticsToEnum(Value.getSemantics()));
+  writeAPInt(W, Value.bitcastToAPInt());
+}
+
+/// Reads the values written by the writers above from the front of a buffer.
+class ValueReader {
+  StringRef Data;
+
+public:
+  explicit ValueReader(StringRef Data) : Data(Data) {}
+
+  bool atEnd() const { return Data.empty(); }
+
+  template <typename T> bool read(T &Value) {
+    if (Data.size() < sizeof(T))
+      return false;
+    Value = llvm::support::endian::read<T, llvm::support::little,
+                                        llvm::support::unaligned>(
+        Data.data());
+    Data = Data.drop_front(sizeof(T));
+    return true;
+  }
+
+  bool readAPInt(llvm::APInt &Value) {
+    uint32_t BitWidth;
+    if (!read(BitWidth) || BitWidth == 0)
+      return false;
+    SmallVector<uint64_t, 2> Words(llvm::APInt::getNumWords(BitWidth));
+    for (uint64_t &Word : Words)
+      if (!read(Word))
+        return false;
+    Value = llvm::APInt(BitWidth, Words);
+    return true;
+  }
+
+  bool readAPSInt(llvm::APSInt &Value) {
+    uint8_t IsUnsigned;
+    llvm::APInt Int;
+    if (!read(IsUnsigned) || !readAPInt(Int))
+      return false;
+    Value = llvm::APSInt(std::move(Int), IsUnsigned);
+    return true;
+  }
+
+  bool readAPFloat(llvm::APFloat &Value) {
+    uint8_t Sem;
+    llvm::APInt Bits;
+    if (!read(Sem) || Sem > llvm::APFloatBase::S_PPCDoubleDouble ||
+        !readAPInt(Bits))
+      return false;
+    const llvm::fltSemantics &Semantics = llvm::APFloatBase::EnumToSemantics(
+        static_cast<llvm::APFloatBase::Semantics>(Sem));
+    if (Bits.getBitWidth() != llvm::APFloat::getSizeInBits(Semantics))
+      return false;
+    Value = llvm::APFloat(Semantics, Bits);
+    return true;
+  }
+};
+
+/// Writes a pointer into the string literal \p SL whose contents have the
+/// digest \p Digest. The callee can only read the literal, so its contents
+/// and the position in it stand for the pointer.
+void writeStringLiteralPointer(EndianWriter &W, const APValue &Value,
+                               const StringLiteral *SL,
+                               const llvm::MD5::MD5Result &Digest) {
+  W.write<uint8_t>(VT_StringLiteral);
+  W.write<uint8_t>(SL->getKind());
+  W.write<uint8_t>(SL->getCharByteWidth());
+  W.write<uint64_t>(SL->getByteLength());
+  W.OS << StringRef(reinterpret_cast<const char *>(Digest.Bytes.data()),
+                    Digest.Bytes.size());
+  W.write<int64_t>(Value.getLValueOffset().getQuantity());
+  W.write<uint8_t>(Value.isLValueOnePastTheEnd());
+  ArrayRef<APValue::LValuePathEntry> Path = Value.getLValuePath();
+  W.write<uint32_t>(Path.size());
+  for (const APValue::LValuePathEntry &Entry : Path)
+    W.write<uint64_t>(Entry.getAsArrayIndex());
+}
+
+} // namespace
+
+bool ConstexprEvalCache::getKey(ArrayRef<APValue> Args, unsigned Context,
+                                SmallVectorImpl<char> &Key) {
+  llvm::raw_svector_ostream OS(Key);
+  EndianWriter W(OS, llvm::support::little);
+  W.write<uint32_t>(Context);
+
+  for (const APValue &Arg : Args) {
+    switch (Arg.getKind()) {
+    case APValue::Int:
+      W.write<uint8_t>(VT_Int);
+      writeAPSInt(W, Arg.getInt());
+      break;
+    case APValue::Float:
+      W.write<uint8_t>(VT_Float);
+      writeAPFloat(W, Arg.getFloat());
+      break;
+    case APValue::LValue: {
+      if (Arg.isNullPointer() || !Arg.hasLValuePath())
+        return false;
+      const auto *SL = dyn_cast_or_null<StringLiteral>(
+          Arg.getLValueBase().dyn_cast<const Expr *>());
+      if (!SL)
+        return false;
+      writeStringLiteralPointer(W, Arg, SL, getDigest(SL));
+      break;
+    }
+    default:
+      return false;
+    }
+  }
+  return true;
+}
+
+const llvm::MD5::MD5Result &
+ConstexprEvalCache::getDigest(const StringLiteral *SL) {
+  auto Inserted = Digests.try_emplace(SL);
+  if (Inserted.second) {
+    llvm::MD5 Hash;
+    Hash.update(SL->getBytes());
+    Hash.final(Inserted.first->second);
+  }
+  return Inserted.first->second;
+}
+
+bool ConstexprEvalCache::isCacheableResult(const APValue &Value) {
+  return Value.isInt() || Value.isFloat();
+}
+
+void ConstexprEvalCache::encodeResult(const APValue &Value,
+                                      SmallVectorImpl<char> &Out) {
+  assert(isCacheableResult(Value) && "result cannot be encoded");
+  llvm::raw_svector_ostream OS(Out);
+  EndianWriter W(OS, llvm::support::little);
+  if (Value.isInt()) {
+    W.write<uint8_t>(VT_Int);
+    writeAPSInt(W, Value.getInt());
+  } else {
+    W.write<uint8_t>(VT_Float);
+    writeAPFloat(W, Value.getFloat());
+  }
+}
+
+bool ConstexprEvalCache::decodeResult(StringRef Data, APValue &Value) {
+  ValueReader R(Data);
+  uint8_t Tag;
+  if (!R.read(Tag))
+    return false;
+
+  switch (Tag) {
+  case VT_Int: {
+    llvm::APSInt Int;
+    if (!R.readAPSInt(Int))
+      return false;
+    Value = APValue(std::move(Int));
+    break;
+  }
+  case VT_Float: {
+    llvm::APFloat Float(0.0);
+    if (!R.readAPFloat(Float))
+      return false;
+    Value = APValue(std::move(Float));
+    break;
+  }
+  default:
+    return false;
+  }
+  return R.atEnd();
+}
+
+ConstexprEvalCache::CalleeResults &
+ConstexprEvalCache::getCallee(const FunctionDecl *FD) {
+  FD = FD->getCanonicalDecl();
+  auto It = Callees.find(FD);
+  if (It != Callees.end() && It->second.LoadedExternal)
+    return It->second;
+
+  // Loading the results inserts them, so look the callee up again after.
+  Callees[FD].LoadedExternal = true;
+  if (ExternalASTSource *Source = Ctx.getExternalSource())
+    Source->ReadConstexprEvalResults(FD);
+  return Callees[FD];
+}
+
+ConstexprEvalCache::Result *ConstexprEvalCache::find(CalleeResults &Callee,
+                                                     StringRef Key) {
+  auto It = Callee.Index.find(Key);
+  if (It == Callee.Index.end())
+    return nullptr;
+  return &Callee.Results[It->second];
+}
+
+const APValue *ConstexprEvalCache::lookup(const FunctionDecl *FD,
+                                          StringRef Key, Cost &C) {
+  if (Result *R = find(getCallee(FD), Key)) {
+    ++NumHits;
+    C = R->EvalCost;
+    return &R->Value;
+  }
+  ++NumMisses;
+  return nullptr;
+}
+
+void ConstexprEvalCache::insert(const FunctionDecl *FD, StringRef Key,
+                                const APValue &Value, Cost C) {
+  assert(isCacheableResult(Value) && "result cannot be cached");
+  CalleeResults &Callee = getCallee(FD);
+  auto Inserted = Callee.Index.try_emplace(Key, Callee.Results.size());
+  if (!Inserted.second)
+    return;
+  Callee.Results.push_back({Inserted.first->first(), Value, C, false});
+  ++NumEvaluated;
+}
+
+void ConstexprEvalCache::insertLoaded(const FunctionDecl *FD, StringRef Key,
+                                      APValue Value, Cost C) {
+  // Results are loaded while the callee is first looked up, so do not look
+  // it up again.
+  CalleeResults &Callee = Callees[FD->getCanonicalDecl()];
+  auto Inserted = Callee.Index.try_emplace(Key, Callee.Results.size());
+  if (!Inserted.second)
+    return;
+  Callee.Results.push_back(
+      {Inserted.first->first(), std::move(Value), C, true});
+  ++NumLoaded;
+}
+
+void ConstexprEvalCache::forEachEvaluated(
+    llvm::function_ref<void(const FunctionDecl *, StringRef, const APValue &,
+                            Cost)>
+        Fn) const {
+  for (const auto &Callee : Callees)
+    for (const Result &R : Callee.second.Results)
+      if (!R.FromASTFile)
+        Fn(Callee.first, R.Key, R.Value, R.EvalCost);
+}
+
+void ConstexprEvalCache::PrintStats() const {
+  llvm::errs() << "\n*** Constexpr Evaluation Cache Stats:\n";
+  llvm::errs() << "  " << NumHits << " hits, " << NumMisses << " misses\n";
+  llvm::errs() << "  " << NumEvaluated << " results evaluated, " << NumLoaded
+               << " loaded from AST files, for " << Callees.size()
+               << " functions\n";
+}
@@ -42,6 +42,7 @@
 #include "latino/AST/Attr.h"
 #include "latino/AST/CXXInheritance.h"
 #include "latino/AST/CharUnits.h"
+#include "latino/AST/ConstexprEvalCache.h"
 #include "latino/AST/CurrentSourceLocExprScope.h"
 #include "latino/AST/Expr.h"
 #include "latino/AST/OSLog.h"
@@ -523,6 +524,10 @@ namespace {
     /// Index - The call index of this call.
     unsigned Index;
 
+    /// NestedDepth - The number of calls on the deepest call stack evaluated
+    /// below this call so far.
+    unsigned NestedDepth = 0;
+
     /// The stack of integers for tracking version numbers for temporaries.
     SmallVector<unsigned, 2> TempVersionStack = {1};
     unsigned CurTempVersion = TempVersionStack.back();
@@ -1389,6 +1394,8 @@ CallStackFrame::~CallStackFrame() {
   assert(Info.CurrentCall == this && "calls retired out of order");
   --Info.CallStackDepth;
   Info.CurrentCall = Caller;
+  if (Caller)
+    Caller->NestedDepth = std::max(Caller->NestedDepth, NestedDepth + 1);
 }
 
 static bool isRead(AccessKinds AK) {
@@ -5168,7 +5175,7 @@ static bool CheckTrivialDefaultConstructor(EvalInfo &Info, SourceLocation Loc,
 static bool CheckConstexprFunction(EvalInfo &Info, SourceLocation CallLoc,
                                    const FunctionDecl *Declaration,
                                    const FunctionDecl *Definition,
-                                   const Stmt *Body) {
+                                   bool HasBody) {
   // Potential constant expressions can contain calls to declared, but not yet
   // defined, constexpr functions.
   if (Info.checkingPotentialConstantExpression() && !Definition &&
@@ -5203,7 +5210,7 @@ static bool CheckConstexprFunction(EvalInfo &Info, SourceLocation CallLoc,
   }
 
   // Can we evaluate this function call?
-  if (Definition && Definition->isConstexpr() && Body)
+  if (Definition && Definition->isConstexpr() && HasBody)
     return true;
 
   if (Info.getLangOpts().CPlusPlus11) {
@@ -5765,7 +5772,39 @@ static bool EvaluateArgs(ArrayRef<const Expr *> Args, ArgVector &ArgValues,
   return Success;
 }
 
-/// Evaluate a function call.
+/// Build the key of a call in the ConstexprEvalCache, if its result only
+/// depends on the callee and the values of its arguments.
+static bool getEvalCacheKey(EvalInfo &Info, const FunctionDecl *Callee,
+                            const LValue *This, const LValue *ResultSlot,
+                            ArrayRef<APValue> ArgValues,
+                            SmallVectorImpl<char> &Key) {
+  if (This || ResultSlot || Info.checkingPotentialConstantExpression() ||
+      Info.checkingForUndefinedBehavior())
+    return false;
+  QualType ReturnType = Callee->getReturnType();
+  if (!ReturnType->isIntegralOrEnumerationType() &&
+      !ReturnType->isRealFloatingType())
+    return false;
+  // The mode decides which constructs evaluate, and std::is_constant_evaluated
+  // depends on the context, so only share results between identical ones.
+  unsigned Context = Info.EvalMode << 1 | Info.InConstantContext;
+  return Info.Ctx.getConstexprEvalCache().getKey(ArgValues, Context, Key);
+}
+
+/// Whether the evaluation has not noted anything which makes it not a
+/// constant expression, such that the result of a call can be cached.
+///
+/// Notes are only kept while there is none yet, and an evaluation with
+/// nowhere to put them cannot tell, so it never caches anything.
+static bool isCleanEvaluation(EvalInfo &Info) {
+  return Info.EvalStatus.Diag && Info.EvalStatus.Diag->empty() &&
+         !Info.EvalStatus.HasSideEffects &&
+         !Info.EvalStatus.HasUndefinedBehavior;
+}
+
+/// Evaluate a function call. If \p Body is null, the body of the callee is
+/// only read once the call is known not to be cached, so that bodies stored in
+/// AST files are not loaded needlessly.
 static bool HandleFunctionCall(SourceLocation CallLoc,
                                const FunctionDecl *Callee, const LValue *This,
                                ArrayRef<const Expr*> Args, const Stmt *Body,
@@ -5778,6 +5817,30 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   if (!Info.CheckCallLimit(CallLoc))
     return false;
 
+  // Reuse the result of an identical call evaluated before. It costs as many
+  // steps and as deep a call stack as evaluating the call again; if that
+  // would exceed the limits, evaluate it to diagnose them.
+  SmallString<32> CacheKey;
+  bool UseCache = getEvalCacheKey(Info, Callee, This, ResultSlot, ArgValues,
+                                  CacheKey);
+  if (UseCache) {
+    ConstexprEvalCache &Cache = Info.Ctx.getConstexprEvalCache();
+    ConstexprEvalCache::Cost Cost;
+    const APValue *Cached = Cache.lookup(Callee, CacheKey, Cost);
+    if (Cached && Cost.Steps <= Info.StepsLeft &&
+        Info.CallStackDepth + Cost.Depth <=
+            Info.getLangOpts().ConstexprCallDepth) {
+      Info.StepsLeft -= Cost.Steps;
+      Info.CurrentCall->NestedDepth =
+          std::max(Info.CurrentCall->NestedDepth, Cost.Depth + 1);
+      Result = *Cached;
+      return true;
+    }
+  }
+  bool WasClean = UseCache && isCleanEvaluation(Info);
+  size_t NumHeapAllocs = Info.HeapAllocs.size();
+  unsigned StepsLeft = Info.StepsLeft;
+
   CallStackFrame Frame(Info, CallLoc, Callee, This, ArgValues.data());
 
   // For a trivial copy or move assignment, perform an APValue copy. This is
@@ -5819,6 +5882,13 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
                                         Frame.LambdaThisCaptureField);
   }
 
+  if (!Body)
+    Body = Callee->getBody();
+  if (!Body) {
+    Info.FFDiag(CallLoc, diag::note_invalid_subexpr_in_const_expr);
+    return false;
+  }
+
   StmtResult Ret = {Result, ResultSlot};
   EvalStmtResult ESR = EvaluateStmt(Ret, Info, Body);
   if (ESR == ESR_Succeeded) {
@@ -5826,6 +5896,17 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
       return true;
     Info.FFDiag(Callee->getEndLoc(), diag::note_constexpr_no_return);
   }
+
+  // Cache the result if nothing made the call not a constant expression, and
+  // it did not leave any allocation behind.
+  if (ESR == ESR_Returned && WasClean && isCleanEvaluation(Info) &&
+      Info.HeapAllocs.size() == NumHeapAllocs &&
+      ConstexprEvalCache::isCacheableResult(Result)) {
+    ConstexprEvalCache::Cost Cost;
+    Cost.Steps = StepsLeft - Info.StepsLeft;
+    Cost.Depth = Frame.NestedDepth;
+    Info.Ctx.getConstexprEvalCache().insert(Callee, CacheKey, Result, Cost);
+  }
   return ESR == ESR_Returned;
 }
 
@@ -7326,12 +7407,16 @@ public:
                                Info.Ctx.getRecordType(DD->getParent()));
     }
 
+    // Leave the body to HandleFunctionCall, which does not need it if the
+    // result of the call is cached.
     const FunctionDecl *Definition = nullptr;
-    Stmt *Body = FD->getBody(Definition);
+    bool HasBody =
+        FD->hasBody(Definition) && !Definition->isLateTemplateParsed();
 
-    if (!CheckConstexprFunction(Info, E->getExprLoc(), FD, Definition, Body) ||
-        !HandleFunctionCall(E->getExprLoc(), Definition, This, Args, Body, Info,
-                            Result, ResultSlot))
+    if (!CheckConstexprFunction(Info, E->getExprLoc(), FD, Definition,
+                                HasBody) ||
+        !HandleFunctionCall(E->getExprLoc(), Definition, This, Args, nullptr,
+                            Info, Result, ResultSlot))
       return false;
 
     if (!CovariantAdjustmentPath.empty() &&
@@ -52,6 +52,8 @@ void ExternalASTSource::CompleteType(TagDecl *Tag) {}
 
 void ExternalASTSource::ReadComments() {}
 
+void ExternalASTSource::ReadConstexprEvalResults(const FunctionDecl *FD) {}
+
 void ExternalASTSource::StartedDeserializing() {}
 
 void ExternalASTSource::FinishedDeserializing() {}
@@ -46,6 +46,16 @@ class Boolean {
   Boolean operator-() const { return Boolean(V); }
   Boolean operator~() const { return Boolean(true); }
 
+  Boolean operator&(Boolean RHS) const { return Boolean(V && RHS.V); }
+  Boolean operator|(Boolean RHS) const { return Boolean(V || RHS.V); }
+  Boolean operator^(Boolean RHS) const { return Boolean(V != RHS.V); }
+
+  Boolean operator/(Boolean RHS) const { return *this; }
+  Boolean operator%(Boolean RHS) const { return Boolean(false); }
+
+  Boolean operator<<(unsigned RHS) const { return RHS ? Boolean(false) : *this; }
+  Boolean operator>>(unsigned RHS) const { return RHS ? Boolean(false) : *this; }
+
   explicit operator unsigned() const { return V; }
   explicit operator int64_t() const { return V; }
   explicit operator uint64_t() const { return V; }
@@ -11,6 +11,7 @@
 #include "Opcode.h"
 #include "Program.h"
 #include "latino/AST/DeclCXX.h"
+#include <cstring>
 
 using namespace latino;
 using namespace latino::interp;
@@ -18,6 +19,17 @@ using namespace latino::interp;
 using APSInt = llvm::APSInt;
 using Error = llvm::Error;
 
+/// Finds the superinstruction which runs the opcodes ending \p Prev followed
+/// by \p Op. Returns it along with the number of opcodes of \p Prev it
+/// replaces, which is zero if there is none.
+static std::pair<Opcode, unsigned> findFused(ArrayRef<Opcode> Prev,
+                                             Opcode Op) {
+#define GET_FUSE
+#include "Opcodes.inc"
+#undef GET_FUSE
+  return {Op, 0};
+}
+
 Expected<Function *> ByteCodeEmitter::compileFunc(const FunctionDecl *F) {
   // Do not try to compile undefined functions.
   if (!F->isDefined(F) || (!F->hasBody() && F->willHaveBody()))
@@ -87,6 +99,9 @@ Scope::Local ByteCodeEmitter::createLocal(Descriptor *D) {
 void ByteCodeEmitter::emitLabel(LabelTy Label) {
   const size_t Target = Code.size();
   LabelOffsets.insert({Label, Target});
+  // Jumps can land here, so nothing before can be fused with what follows.
+  LastOps.clear();
+  LastOpOffsets.clear();
   auto It = LabelRelocs.find(Label);
   if (It != LabelRelocs.end()) {
     for (unsigned Reloc : It->second) {
@@ -101,9 +116,12 @@ void ByteCodeEmitter::emitLabel(LabelTy Label) {
   }
 }
 
-int32_t ByteCodeEmitter::getOffset(LabelTy Label) {
-  // Compute the PC offset which the jump is relative to.
-  const int64_t Position = Code.size() + sizeof(Opcode) + sizeof(int32_t);
+int32_t ByteCodeEmitter::getOffset(LabelTy Label, Opcode Op) {
+  // Compute the PC offset which the jump is relative to. The opcodes of the
+  // instructions the jump is fused with are dropped.
+  const unsigned NumFused = findFused(LastOps, Op).second;
+  const int64_t Position = Code.size() - NumFused * sizeof(Opcode) +
+                           sizeof(Opcode) + sizeof(int32_t);
 
   // If target is known, compute jump offset.
   auto It = LabelOffsets.find(Label);
@@ -122,6 +140,45 @@ bool ByteCodeEmitter::bail(const SourceLocation &Loc) {
   return false;
 }
 
+bool ByteCodeEmitter::fuse(Opcode Op, const SourceInfo &SI) {
+  Opcode Fused;
+  unsigned NumPrev;
+  std::tie(Fused, NumPrev) = findFused(LastOps, Op);
+  if (NumPrev == 0)
+    return false;
+
+  // Drop the opcodes of the fused instructions, keeping their arguments in
+  // order, and write the superinstruction in place of the first opcode.
+  const unsigned First = LastOps.size() - NumPrev;
+  const unsigned Start = LastOpOffsets[First];
+  unsigned End = Start + sizeof(Opcode);
+  for (unsigned I = First, N = LastOps.size(); I < N; ++I) {
+    unsigned Begin = LastOpOffsets[I] + sizeof(Opcode);
+    unsigned Size = (I + 1 < N ? LastOpOffsets[I + 1] : Code.size()) - Begin;
+    std::memmove(Code.data() + End, Code.data() + Begin, Size);
+    End += Size;
+  }
+  Code.resize(End);
+  std::memcpy(Code.data() + Start, &Fused, sizeof(Opcode));
+
+  // Attach the superinstruction to the source of the last fused instruction
+  // which has one, since the earlier ones cannot fail.
+  SourceInfo Source = SI;
+  while (!SrcMap.empty() && SrcMap.back().first > Start) {
+    if (!Source)
+      Source = SrcMap.back().second;
+    SrcMap.pop_back();
+  }
+  if (Source)
+    SrcMap.emplace_back(Start + sizeof(Opcode), Source);
+
+  LastOps.resize(First);
+  LastOpOffsets.resize(First);
+  LastOps.push_back(Fused);
+  LastOpOffsets.push_back(Start);
+  return true;
+}
+
 template <typename... Tys>
 bool ByteCodeEmitter::emitOp(Opcode Op, const Tys &... Args, const SourceInfo &SI) {
   bool Success = true;
@@ -136,10 +193,15 @@ bool ByteCodeEmitter::emitOp(Opcode Op, const Tys &... Args, const SourceInfo &S
   };
 
   /// The opcode is followed by arguments. The source info is
-  /// attached to the address after the opcode.
-  emit(reinterpret_cast<const char *>(&Op), sizeof(Opcode));
-  if (SI)
-    SrcMap.emplace_back(Code.size(), SI);
+  /// attached to the address after the opcode. An opcode which completes a
+  /// superinstruction is fused with the instructions before it instead.
+  if (!fuse(Op, SI)) {
+    LastOps.push_back(Op);
+    LastOpOffsets.push_back(Code.size());
+    emit(reinterpret_cast<const char *>(&Op), sizeof(Opcode));
+    if (SI)
+      SrcMap.emplace_back(Code.size(), SI);
+  }
 
   /// The initializer list forces the expression to be evaluated
   /// for each argument in the variadic template, in order.
@@ -150,15 +212,15 @@ bool ByteCodeEmitter::emitOp(Opcode Op, const Tys &... Args, const SourceInfo &S
 }
 
 bool ByteCodeEmitter::jumpTrue(const LabelTy &Label) {
-  return emitJt(getOffset(Label), SourceInfo{});
+  return emitJt(getOffset(Label, OP_Jt), SourceInfo{});
 }
 
 bool ByteCodeEmitter::jumpFalse(const LabelTy &Label) {
-  return emitJf(getOffset(Label), SourceInfo{});
+  return emitJf(getOffset(Label, OP_Jf), SourceInfo{});
 }
 
 bool ByteCodeEmitter::jump(const LabelTy &Label) {
-  return emitJmp(getOffset(Label), SourceInfo{});
+  return emitJmp(getOffset(Label, OP_Jmp), SourceInfo{});
 }
 
 bool ByteCodeEmitter::fallthrough(const LabelTy &Label) {
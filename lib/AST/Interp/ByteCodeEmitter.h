@@ -92,9 +92,18 @@ private:
   std::vector<char> Code;
   /// Opcode to expression mapping.
   SourceMap SrcMap;
-
-  /// Returns the offset for a jump or records a relocation.
-  int32_t getOffset(LabelTy Label);
+  /// Opcodes and offsets of the instructions emitted since the last label,
+  /// which can be fused into superinstructions.
+  llvm::SmallVector<Opcode, 8> LastOps;
+  llvm::SmallVector<unsigned, 8> LastOpOffsets;
+
+  /// Returns the offset for a jump emitted with opcode \p Op or records a
+  /// relocation.
+  int32_t getOffset(LabelTy Label, Opcode Op);
+
+  /// Fuses the instructions before \p Op into a superinstruction if they form
+  /// one with it. The arguments of \p Op are then emitted after it.
+  bool fuse(Opcode Op, const SourceInfo &SI);
 
   /// Emits an opcode.
   template <typename... Tys>
@@ -91,21 +91,30 @@ bool ByteCodeExprGen<Emitter>::VisitCastExpr(const CastExpr *CE) {
   auto *SubExpr = CE->getSubExpr();
   switch (CE->getCastKind()) {
 
-  case CK_LValueToRValue: {
-    return dereference(
-        CE->getSubExpr(), DerefKind::Read,
-        [](PrimType) {
-          // Value loaded - nothing to do here.
-          return true;
-        },
-        [this, CE](PrimType T) {
-          // Pointer on stack - dereference it.
-          if (!this->emitLoadPop(T, CE))
-            return false;
-          return DiscardResult ? this->emitPop(T, CE) : true;
-        });
+  case CK_LValueToRValue:
+    return visitLoad(SubExpr, CE);
+
+  case CK_IntegralCast: {
+    if (DiscardResult)
+      return discard(SubExpr);
+    Optional<PrimType> From = classify(SubExpr->getType());
+    Optional<PrimType> To = classify(CE->getType());
+    if (!From || !To || *From == PT_Ptr || *To == PT_Ptr)
+      return this->bail(CE);
+    if (!visit(SubExpr))
+      return false;
+    return emitConv(*From, *To, CE);
   }
 
+  case CK_IntegralToBoolean:
+  case CK_PointerToBoolean:
+    if (DiscardResult)
+      return discard(SubExpr);
+    return visitBool(SubExpr);
+
+  case CK_NullToPointer:
+    return DiscardResult ? true : this->emitNullPtr(CE);
+
   case CK_ArrayToPointerDecay:
   case CK_AtomicToNonAtomic:
   case CK_ConstructorConversion:
@@ -137,11 +146,118 @@ bool ByteCodeExprGen<Emitter>::VisitIntegerLiteral(const IntegerLiteral *LE) {
   return this->bail(LE);
 }
 
+template <class Emitter>
+bool ByteCodeExprGen<Emitter>::VisitCharacterLiteral(
+    const CharacterLiteral *LE) {
+  if (DiscardResult)
+    return true;
+  return emitConst(LE, LE->getValue());
+}
+
+template <class Emitter>
+bool ByteCodeExprGen<Emitter>::VisitCXXBoolLiteralExpr(
+    const CXXBoolLiteralExpr *LE) {
+  if (DiscardResult)
+    return true;
+  return this->emitConstBool(LE->getValue(), LE);
+}
+
 template <class Emitter>
 bool ByteCodeExprGen<Emitter>::VisitParenExpr(const ParenExpr *PE) {
   return this->Visit(PE->getSubExpr());
 }
 
+template <class Emitter>
+bool ByteCodeExprGen<Emitter>::VisitConstantExpr(const ConstantExpr *CE) {
+  return this->Visit(CE->getSubExpr());
+}
+
+template <class Emitter>
+bool ByteCodeExprGen<Emitter>::VisitDeclRefExpr(const DeclRefExpr *DE) {
+  if (DiscardResult)
+    return true;
+
+  const ValueDecl *D = DE->getDecl();
+  if (auto *ECD = dyn_cast<EnumConstantDecl>(D)) {
+    QualType Ty = DE->getType();
+    if (Optional<PrimType> T = classify(Ty))
+      return emitConst(*T, getIntWidth(Ty), ECD->getInitVal(), DE);
+    return this->bail(DE);
+  }
+
+  // Generate a pointer to the variable, loading references.
+  if (auto *PD = dyn_cast<ParmVarDecl>(D)) {
+    auto It = this->Params.find(PD);
+    if (It == this->Params.end())
+      return this->bail(DE);
+    if (PD->getType()->isReferenceType())
+      return this->emitGetParamPtr(It->second, DE);
+    return this->emitGetPtrParam(It->second, DE);
+  }
+
+  if (auto *VD = dyn_cast<VarDecl>(D)) {
+    auto It = Locals.find(VD);
+    if (It == Locals.end())
+      return getPtrVarDecl(VD, DE);
+    if (VD->getType()->isReferenceType())
+      return this->emitGetLocalPtr(It->second.Offset, DE);
+    return this->emitGetPtrLocal(It->second.Offset, DE);
+  }
+
+  return this->bail(DE);
+}
+
+template <class Emitter>
+bool ByteCodeExprGen<Emitter>::VisitUnaryOperator(const UnaryOperator *UO) {
+  const Expr *SubExpr = UO->getSubExpr();
+
+  switch (UO->getOpcode()) {
+  case UO_PreInc:
+  case UO_PreDec:
+  case UO_PostInc:
+  case UO_PostDec:
+    return visitIncDec(UO);
+  case UO_AddrOf:
+  case UO_Deref:
+    // Both lvalues and pointers are represented as pointers.
+    return this->Visit(SubExpr);
+  case UO_Plus:
+  case UO_Extension:
+    return this->Visit(SubExpr);
+  default:
+    break;
+  }
+
+  Optional<PrimType> T = classify(UO->getType());
+  Optional<PrimType> ST = classify(SubExpr->getType());
+  if (!T || !ST)
+    return this->bail(UO);
+  if (DiscardResult)
+    return discard(SubExpr);
+
+  switch (UO->getOpcode()) {
+  case UO_Minus:
+    if (*T == PT_Ptr)
+      return this->bail(UO);
+    return visit(SubExpr) && this->emitNeg(*T, UO);
+  case UO_Not:
+    if (*T == PT_Ptr)
+      return this->bail(UO);
+    return visit(SubExpr) && this->emitComp(*T, UO);
+  case UO_LNot:
+    // Compare against zero. The result is an int in C.
+    if (!visit(SubExpr))
+      return false;
+    if (!visitZeroInitializer(*ST, SubExpr))
+      return false;
+    if (!this->emitEQ(*ST, UO))
+      return false;
+    return emitConv(PT_Bool, *T, UO);
+  default:
+    return this->bail(UO);
+  }
+}
+
 template <class Emitter>
 bool ByteCodeExprGen<Emitter>::VisitBinaryOperator(const BinaryOperator *BO) {
   const Expr *LHS = BO->getLHS();
@@ -155,6 +271,27 @@ bool ByteCodeExprGen<Emitter>::VisitBinaryOperator(const BinaryOperator *BO) {
     if (!this->Visit(RHS))
       return false;
     return true;
+  case BO_Assign:
+    if (!classify(LHS->getType()) || LHS->refersToBitField())
+      return this->bail(BO);
+    return visitUpdate(BO, LHS, [this, BO, LHS, RHS] {
+      return dereference(
+          LHS, DerefKind::Write,
+          [this, RHS](PrimType) {
+            // Value generated - it is stored by the dereference.
+            return visit(RHS);
+          },
+          [this, BO, RHS](PrimType T) {
+            // Pointer on stack - store through it.
+            if (!visit(RHS))
+              return false;
+            return DiscardResult ? this->emitStorePop(T, BO)
+                                 : this->emitStore(T, BO);
+          });
+    });
+  case BO_LAnd:
+  case BO_LOr:
+    return visitLogicalOp(BO);
   default:
     break;
   }
@@ -191,20 +328,256 @@ bool ByteCodeExprGen<Emitter>::VisitBinaryOperator(const BinaryOperator *BO) {
       return Discard(this->emitGT(*LT, BO));
     case BO_GE:
       return Discard(this->emitGE(*LT, BO));
-    case BO_Sub:
-      return Discard(this->emitSub(*T, BO));
-    case BO_Add:
-      return Discard(this->emitAdd(*T, BO));
-    case BO_Mul:
-      return Discard(this->emitMul(*T, BO));
     default:
-      return this->bail(BO);
+      // Pointer arithmetic is not supported yet.
+      if (*LT == PT_Ptr || *RT == PT_Ptr)
+        return this->bail(BO);
+      return Discard(emitBinaryOp(BO->getOpcode(), *LT, *RT, BO));
     }
   }
 
   return this->bail(BO);
 }
 
+template <class Emitter>
+bool ByteCodeExprGen<Emitter>::VisitCompoundAssignOperator(
+    const CompoundAssignOperator *CAO) {
+  const Expr *LHS = CAO->getLHS();
+  const Expr *RHS = CAO->getRHS();
+  BinaryOperatorKind Op =
+      BinaryOperator::getOpForCompoundAssignment(CAO->getOpcode());
+
+  // The LHS is converted to the computation type, combined with the RHS and
+  // the result is converted back to the type of the LHS.
+  Optional<PrimType> LT = classify(LHS->getType());
+  Optional<PrimType> RT = classify(RHS->getType());
+  Optional<PrimType> CT = classify(CAO->getComputationLHSType());
+  Optional<PrimType> ResT = classify(CAO->getComputationResultType());
+  if (!LT || !RT || !CT || !ResT || LHS->refersToBitField())
+    return this->bail(CAO);
+  if (*LT == PT_Ptr || *RT == PT_Ptr || *CT == PT_Ptr || *ResT == PT_Ptr)
+    return this->bail(CAO);
+  if (!BinaryOperator::isShiftOp(Op) && *RT != *CT)
+    return this->bail(CAO);
+
+  auto Compute = [this, CAO, RHS, Op, LT, RT, CT, ResT](PrimType) {
+    // Value of the LHS on stack - replace it with the result.
+    if (!emitConv(*LT, *CT, CAO))
+      return false;
+    if (!visit(RHS))
+      return false;
+    if (!emitBinaryOp(Op, *CT, *RT, CAO))
+      return false;
+    return emitConv(*ResT, *LT, CAO);
+  };
+
+  return visitUpdate(CAO, LHS, [this, CAO, LHS, &Compute] {
+    return dereference(LHS, DerefKind::ReadWrite, Compute,
+                       [this, CAO, &Compute](PrimType T) {
+                         // Pointer on stack - update the value it points to.
+                         if (!this->emitLoad(T, CAO))
+                           return false;
+                         if (!Compute(T))
+                           return false;
+                         return DiscardResult ? this->emitStorePop(T, CAO)
+                                              : this->emitStore(T, CAO);
+                       });
+  });
+}
+
+template <class Emitter>
+bool ByteCodeExprGen<Emitter>::VisitConditionalOperator(
+    const ConditionalOperator *CO) {
+  // Composite values would have to be initialized in place.
+  if (!classify(CO) && !CO->getType()->isVoidType())
+    return this->bail(CO);
+
+  LabelTy LabelFalse = this->getLabel();
+  LabelTy LabelEnd = this->getLabel();
+  if (!visitBool(CO->getCond()))
+    return false;
+  if (!this->jumpFalse(LabelFalse))
+    return false;
+  if (!this->Visit(CO->getTrueExpr()))
+    return false;
+  if (!this->jump(LabelEnd))
+    return false;
+  this->emitLabel(LabelFalse);
+  if (!this->Visit(CO->getFalseExpr()))
+    return false;
+  return this->fallthrough(LabelEnd);
+}
+
+template <class Emitter>
+bool ByteCodeExprGen<Emitter>::VisitCallExpr(const CallExpr *CE) {
+  // Only direct calls to functions are supported.
+  const FunctionDecl *FD = CE->getDirectCallee();
+  if (!FD || isa<CXXMethodDecl>(FD) || FD->getBuiltinID() || FD->isVariadic())
+    return this->bail(CE);
+
+  // Composite values would be returned through a pointer argument.
+  Optional<PrimType> T = classify(CE);
+  if (!T && !CE->getType()->isVoidType())
+    return this->bail(CE);
+
+  // Functions are compiled once and shared by all callers.
+  Expected<Function *> Func = P.getOrCreateFunction(FD);
+  if (!Func) {
+    llvm::consumeError(Func.takeError());
+    return this->bail(CE);
+  }
+  if (!*Func)
+    return this->emitNoCall(FD, CE);
+
+  for (unsigned I = 0, N = CE->getNumArgs(); I < N; ++I) {
+    const Expr *Arg = CE->getArg(I);
+    if (!classify(FD->getParamDecl(I)->getType()))
+      return this->bail(Arg);
+    if (!visit(Arg))
+      return false;
+  }
+
+  if (!this->emitCall(*Func, CE))
+    return false;
+  return DiscardResult && T ? this->emitPop(*T, CE) : true;
+}
+
+template <class Emitter>
+bool ByteCodeExprGen<Emitter>::VisitExpr(const Expr *E) {
+  // Expressions without bytecode fall back to the tree evaluator.
+  return this->bail(E);
+}
+
+template <class Emitter>
+bool ByteCodeExprGen<Emitter>::visitLogicalOp(const BinaryOperator *BO) {
+  Optional<PrimType> T = classify(BO->getType());
+  if (!T)
+    return this->bail(BO);
+
+  // The RHS is skipped if the LHS decides the result.
+  const bool IsAnd = BO->getOpcode() == BO_LAnd;
+  LabelTy LabelShort = this->getLabel();
+  LabelTy LabelEnd = this->getLabel();
+  if (!visitBool(BO->getLHS()))
+    return false;
+  if (!(IsAnd ? this->jumpFalse(LabelShort) : this->jumpTrue(LabelShort)))
+    return false;
+  if (!visitBool(BO->getRHS()))
+    return false;
+  if (!this->jump(LabelEnd))
+    return false;
+  this->emitLabel(LabelShort);
+  if (!this->emitConstBool(!IsAnd, BO))
+    return false;
+  if (!this->fallthrough(LabelEnd))
+    return false;
+
+  // The result is an int in C.
+  if (!emitConv(PT_Bool, *T, BO))
+    return false;
+  return DiscardResult ? this->emitPop(*T, BO) : true;
+}
+
+template <class Emitter>
+bool ByteCodeExprGen<Emitter>::visitIncDec(const UnaryOperator *UO) {
+  const Expr *SubExpr = UO->getSubExpr();
+  Optional<PrimType> T = classify(SubExpr->getType());
+  if (!T || *T == PT_Ptr || *T == PT_Bool || SubExpr->refersToBitField())
+    return this->bail(UO);
+
+  // Types narrower than int are promoted, so the update cannot overflow and
+  // the result wraps around.
+  PrimType OpT = *T;
+  if (!UO->canOverflow() && (OpT == PT_Sint8 || OpT == PT_Sint16))
+    OpT = PT_Sint32;
+
+  const bool IsInc = UO->isIncrementOp();
+  auto Step = [this, UO, OpT, IsInc](PrimType T) {
+    // Value on stack - replace it with the updated one.
+    const unsigned NumBits = getIntWidth(UO->getType());
+    if (!emitConv(T, OpT, UO))
+      return false;
+    if (!emitConst(OpT, NumBits, APInt(NumBits, 1), UO))
+      return false;
+    if (!(IsInc ? this->emitAdd(OpT, UO) : this->emitSub(OpT, UO)))
+      return false;
+    return emitConv(OpT, T, UO);
+  };
+
+  auto Update = [this, UO, SubExpr, &Step] {
+    return dereference(SubExpr, DerefKind::ReadWrite, Step,
+                       [this, UO, &Step](PrimType T) {
+                         // Pointer on stack - update the value it points to.
+                         if (!this->emitLoad(T, UO))
+                           return false;
+                         if (!Step(T))
+                           return false;
+                         return DiscardResult ? this->emitStorePop(T, UO)
+                                              : this->emitStore(T, UO);
+                       });
+  };
+
+  if (UO->isPrefix())
+    return visitUpdate(UO, SubExpr, Update);
+
+  // The value of a postfix update is the one before it, read beforehand.
+  if (DiscardResult)
+    return Update();
+  if (SubExpr->HasSideEffects(Ctx.getASTContext()))
+    return this->bail(UO);
+  if (!visitLoad(SubExpr, UO))
+    return false;
+  OptionScope<Emitter> Scope(this, /*NewDiscardResult=*/true);
+  return Update();
+}
+
+template <class Emitter>
+bool ByteCodeExprGen<Emitter>::visitUpdate(const Expr *E, const Expr *LV,
+                                           llvm::function_ref<bool()> Update) {
+  if (DiscardResult || E->isGLValue())
+    return Update();
+
+  // Read the value back, which requires the lvalue to be free of effects.
+  if (LV->HasSideEffects(Ctx.getASTContext()))
+    return this->bail(E);
+  {
+    OptionScope<Emitter> Scope(this, /*NewDiscardResult=*/true);
+    if (!Update())
+      return false;
+  }
+  return visitLoad(LV, E);
+}
+
+template <class Emitter>
+bool ByteCodeExprGen<Emitter>::emitBinaryOp(BinaryOperatorKind Op,
+                                            PrimType LT, PrimType RT,
+                                            const Expr *E) {
+  switch (Op) {
+  case BO_Add:
+    return this->emitAdd(LT, E);
+  case BO_Sub:
+    return this->emitSub(LT, E);
+  case BO_Mul:
+    return this->emitMul(LT, E);
+  case BO_Div:
+    return this->emitDiv(LT, E);
+  case BO_Rem:
+    return this->emitRem(LT, E);
+  case BO_And:
+    return this->emitBitAnd(LT, E);
+  case BO_Or:
+    return this->emitBitOr(LT, E);
+  case BO_Xor:
+    return this->emitBitXor(LT, E);
+  case BO_Shl:
+    return this->emitShl(LT, RT, E);
+  case BO_Shr:
+    return this->emitShr(LT, RT, E);
+  default:
+    return this->bail(E);
+  }
+}
+
 template <class Emitter>
 bool ByteCodeExprGen<Emitter>::discard(const Expr *E) {
   OptionScope<Emitter> Scope(this, /*discardResult=*/true);
@@ -220,12 +593,35 @@ bool ByteCodeExprGen<Emitter>::visit(const Expr *E) {
 template <class Emitter>
 bool ByteCodeExprGen<Emitter>::visitBool(const Expr *E) {
   if (Optional<PrimType> T = classify(E->getType())) {
-    return visit(E);
+    if (!visit(E))
+      return false;
+    if (*T == PT_Bool)
+      return true;
+    // Scalars are compared against zero, as in C conditions.
+    if (!visitZeroInitializer(*T, E))
+      return false;
+    return this->emitNE(*T, E);
   } else {
     return this->bail(E);
   }
 }
 
+template <class Emitter>
+bool ByteCodeExprGen<Emitter>::visitLoad(const Expr *LV, const Expr *E) {
+  return dereference(
+      LV, DerefKind::Read,
+      [](PrimType) {
+        // Value loaded - nothing to do here.
+        return true;
+      },
+      [this, E](PrimType T) {
+        // Pointer on stack - dereference it.
+        if (!this->emitLoadPop(T, E))
+          return false;
+        return DiscardResult ? this->emitPop(T, E) : true;
+      });
+}
+
 template <class Emitter>
 bool ByteCodeExprGen<Emitter>::visitZeroInitializer(PrimType T, const Expr *E) {
   switch (T) {
@@ -69,8 +69,17 @@ public:
   // Expression visitors - result returned on stack.
   bool VisitCastExpr(const CastExpr *E);
   bool VisitIntegerLiteral(const IntegerLiteral *E);
+  bool VisitCharacterLiteral(const CharacterLiteral *E);
+  bool VisitCXXBoolLiteralExpr(const CXXBoolLiteralExpr *E);
   bool VisitParenExpr(const ParenExpr *E);
+  bool VisitConstantExpr(const ConstantExpr *E);
+  bool VisitDeclRefExpr(const DeclRefExpr *E);
+  bool VisitUnaryOperator(const UnaryOperator *E);
   bool VisitBinaryOperator(const BinaryOperator *E);
+  bool VisitCompoundAssignOperator(const CompoundAssignOperator *E);
+  bool VisitConditionalOperator(const ConditionalOperator *E);
+  bool VisitCallExpr(const CallExpr *E);
+  bool VisitExpr(const Expr *E);
 
 protected:
   bool visitExpr(const Expr *E) override;
@@ -130,6 +139,9 @@ protected:
   /// Visits an expression and converts it to a boolean.
   bool visitBool(const Expr *E);
 
+  /// Visits an lvalue and loads its value.
+  bool visitLoad(const Expr *LV, const Expr *E);
+
   /// Visits an initializer for a local.
   bool visitLocalInitializer(const Expr *Init, unsigned I) {
     return visitInitializer(Init, [this, I, Init] {
@@ -167,6 +179,26 @@ private:
   /// Emits a zero initializer.
   bool visitZeroInitializer(PrimType T, const Expr *E);
 
+  /// Compiles the short-circuiting && and || operators.
+  bool visitLogicalOp(const BinaryOperator *BO);
+  /// Compiles increments and decrements.
+  bool visitIncDec(const UnaryOperator *UO);
+
+  /// Emits \p Update, which updates the lvalue \p LV and leaves a pointer to
+  /// it on the stack. If \p E is not an lvalue, as in C, the value of \p LV
+  /// is loaded after the update instead.
+  bool visitUpdate(const Expr *E, const Expr *LV,
+                   llvm::function_ref<bool()> Update);
+
+  /// Emits an arithmetic or a bitwise operation on the operands on the stack.
+  bool emitBinaryOp(BinaryOperatorKind Op, PrimType LT, PrimType RT,
+                    const Expr *E);
+
+  /// Converts the integral on the stack from one type to another.
+  bool emitConv(PrimType From, PrimType To, const Expr *E) {
+    return From == To ? true : this->emitCast(From, To, E);
+  }
+
   enum class DerefKind {
     /// Value is read and pushed to stack.
     Read,
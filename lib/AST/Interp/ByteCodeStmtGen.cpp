@@ -42,19 +42,27 @@ public:
   LoopScope(ByteCodeStmtGen<Emitter> *Ctx, LabelTy BreakLabel,
             LabelTy ContinueLabel)
       : LabelScope<Emitter>(Ctx), OldBreakLabel(Ctx->BreakLabel),
-        OldContinueLabel(Ctx->ContinueLabel) {
+        OldContinueLabel(Ctx->ContinueLabel),
+        OldBreakVarScope(Ctx->BreakVarScope),
+        OldContinueVarScope(Ctx->ContinueVarScope) {
     this->Ctx->BreakLabel = BreakLabel;
     this->Ctx->ContinueLabel = ContinueLabel;
+    this->Ctx->BreakVarScope = Ctx->VarScope;
+    this->Ctx->ContinueVarScope = Ctx->VarScope;
   }
 
   ~LoopScope() {
     this->Ctx->BreakLabel = OldBreakLabel;
     this->Ctx->ContinueLabel = OldContinueLabel;
+    this->Ctx->BreakVarScope = OldBreakVarScope;
+    this->Ctx->ContinueVarScope = OldContinueVarScope;
   }
 
 private:
   OptLabelTy OldBreakLabel;
   OptLabelTy OldContinueLabel;
+  VariableScope<Emitter> *OldBreakVarScope;
+  VariableScope<Emitter> *OldContinueVarScope;
 };
 
 // Sets the context for a switch scope, mapping labels.
@@ -68,22 +76,26 @@ public:
               LabelTy BreakLabel, OptLabelTy DefaultLabel)
       : LabelScope<Emitter>(Ctx), OldBreakLabel(Ctx->BreakLabel),
         OldDefaultLabel(this->Ctx->DefaultLabel),
-        OldCaseLabels(std::move(this->Ctx->CaseLabels)) {
+        OldCaseLabels(std::move(this->Ctx->CaseLabels)),
+        OldBreakVarScope(Ctx->BreakVarScope) {
     this->Ctx->BreakLabel = BreakLabel;
     this->Ctx->DefaultLabel = DefaultLabel;
     this->Ctx->CaseLabels = std::move(CaseLabels);
+    this->Ctx->BreakVarScope = Ctx->VarScope;
   }
 
   ~SwitchScope() {
     this->Ctx->BreakLabel = OldBreakLabel;
     this->Ctx->DefaultLabel = OldDefaultLabel;
     this->Ctx->CaseLabels = std::move(OldCaseLabels);
+    this->Ctx->BreakVarScope = OldBreakVarScope;
   }
 
 private:
   OptLabelTy OldBreakLabel;
   OptLabelTy OldDefaultLabel;
   CaseMap OldCaseLabels;
+  VariableScope<Emitter> *OldBreakVarScope;
 };
 
 } // namespace interp
@@ -120,6 +132,21 @@ bool ByteCodeStmtGen<Emitter>::visitStmt(const Stmt *S) {
     return visitReturnStmt(cast<ReturnStmt>(S));
   case Stmt::IfStmtClass:
     return visitIfStmt(cast<IfStmt>(S));
+  case Stmt::WhileStmtClass:
+    return visitWhileStmt(cast<WhileStmt>(S));
+  case Stmt::DoStmtClass:
+    return visitDoStmt(cast<DoStmt>(S));
+  case Stmt::ForStmtClass:
+    return visitForStmt(cast<ForStmt>(S));
+  case Stmt::BreakStmtClass:
+    return visitBreakStmt(cast<BreakStmt>(S));
+  case Stmt::ContinueStmtClass:
+    return visitContinueStmt(cast<ContinueStmt>(S));
+  case Stmt::SwitchStmtClass:
+    return visitSwitchStmt(cast<SwitchStmt>(S));
+  case Stmt::CaseStmtClass:
+  case Stmt::DefaultStmtClass:
+    return visitSwitchCase(cast<SwitchCase>(S));
   case Stmt::NullStmtClass:
     return true;
   default: {
@@ -224,6 +251,174 @@ bool ByteCodeStmtGen<Emitter>::visitIfStmt(const IfStmt *IS) {
   return true;
 }
 
+template <class Emitter>
+bool ByteCodeStmtGen<Emitter>::visitWhileStmt(const WhileStmt *S) {
+  // Condition variables would be destroyed on every iteration.
+  if (S->getConditionVariable())
+    return this->bail(S);
+
+  LabelTy CondLabel = this->getLabel();
+  LabelTy EndLabel = this->getLabel();
+  LoopScope<Emitter> LS(this, EndLabel, CondLabel);
+
+  this->emitLabel(CondLabel);
+  if (!this->visitBool(S->getCond()))
+    return false;
+  if (!this->jumpFalse(EndLabel))
+    return false;
+  if (!visitStmt(S->getBody()))
+    return false;
+  if (!this->jump(CondLabel))
+    return false;
+  this->emitLabel(EndLabel);
+  return true;
+}
+
+template <class Emitter>
+bool ByteCodeStmtGen<Emitter>::visitDoStmt(const DoStmt *S) {
+  LabelTy StartLabel = this->getLabel();
+  LabelTy CondLabel = this->getLabel();
+  LabelTy EndLabel = this->getLabel();
+  LoopScope<Emitter> LS(this, EndLabel, CondLabel);
+
+  this->emitLabel(StartLabel);
+  if (!visitStmt(S->getBody()))
+    return false;
+  this->emitLabel(CondLabel);
+  if (!this->visitBool(S->getCond()))
+    return false;
+  if (!this->jumpTrue(StartLabel))
+    return false;
+  this->emitLabel(EndLabel);
+  return true;
+}
+
+template <class Emitter>
+bool ByteCodeStmtGen<Emitter>::visitForStmt(const ForStmt *S) {
+  // Variables declared in the init statement live until the end of the loop.
+  BlockScope<Emitter> ForScope(this);
+  if (const Stmt *Init = S->getInit())
+    if (!visitStmt(Init))
+      return false;
+  if (S->getConditionVariable())
+    return this->bail(S);
+
+  LabelTy CondLabel = this->getLabel();
+  LabelTy IncLabel = this->getLabel();
+  LabelTy EndLabel = this->getLabel();
+  LoopScope<Emitter> LS(this, EndLabel, IncLabel);
+
+  this->emitLabel(CondLabel);
+  if (const Expr *Cond = S->getCond()) {
+    if (!this->visitBool(Cond))
+      return false;
+    if (!this->jumpFalse(EndLabel))
+      return false;
+  }
+  if (!visitStmt(S->getBody()))
+    return false;
+  this->emitLabel(IncLabel);
+  if (const Expr *Inc = S->getInc())
+    if (!this->discard(Inc))
+      return false;
+  if (!this->jump(CondLabel))
+    return false;
+  this->emitLabel(EndLabel);
+  return true;
+}
+
+template <class Emitter>
+bool ByteCodeStmtGen<Emitter>::visitBreakStmt(const BreakStmt *S) {
+  if (!BreakLabel)
+    return this->bail(S);
+  emitScopeExit(BreakVarScope);
+  return this->jump(*BreakLabel);
+}
+
+template <class Emitter>
+bool ByteCodeStmtGen<Emitter>::visitContinueStmt(const ContinueStmt *S) {
+  if (!ContinueLabel)
+    return this->bail(S);
+  emitScopeExit(ContinueVarScope);
+  return this->jump(*ContinueLabel);
+}
+
+template <class Emitter>
+bool ByteCodeStmtGen<Emitter>::visitSwitchStmt(const SwitchStmt *S) {
+  BlockScope<Emitter> SwitchBlock(this);
+  if (const Stmt *Init = S->getInit())
+    if (!visitStmt(Init))
+      return false;
+  if (const DeclStmt *CondDecl = S->getConditionVariableDeclStmt())
+    if (!visitDeclStmt(CondDecl))
+      return false;
+
+  // Evaluate the condition once, into a temporary.
+  const Expr *Cond = S->getCond();
+  Optional<PrimType> T = this->classify(Cond->getType());
+  if (!T || *T == PT_Ptr)
+    return this->bail(S);
+  unsigned CondVar = this->allocateLocalPrimitive(Cond, *T, /*IsConst=*/true);
+  if (!this->visit(Cond))
+    return false;
+  if (!this->emitSetLocal(*T, CondVar, S))
+    return false;
+
+  // Compare the condition with each case, jumping to the matching one.
+  LabelTy EndLabel = this->getLabel();
+  OptLabelTy DefaultLabel;
+  CaseMap CaseLabels;
+  for (const SwitchCase *SC = S->getSwitchCaseList(); SC;
+       SC = SC->getNextSwitchCase()) {
+    LabelTy Label = this->getLabel();
+    CaseLabels.insert({SC, Label});
+    if (isa<DefaultStmt>(SC)) {
+      DefaultLabel = Label;
+      continue;
+    }
+
+    // GNU case ranges are not supported yet.
+    const auto *CS = cast<CaseStmt>(SC);
+    if (CS->getRHS() || this->classify(CS->getLHS()->getType()) != T)
+      return this->bail(CS);
+    if (!this->emitGetLocal(*T, CondVar, CS))
+      return false;
+    if (!this->visit(CS->getLHS()))
+      return false;
+    if (!this->emitEQ(*T, CS))
+      return false;
+    if (!this->jumpTrue(Label))
+      return false;
+  }
+  if (!this->jump(DefaultLabel ? *DefaultLabel : EndLabel))
+    return false;
+
+  {
+    SwitchScope<Emitter> SS(this, std::move(CaseLabels), EndLabel,
+                            DefaultLabel);
+    if (!visitStmt(S->getBody()))
+      return false;
+  }
+  this->emitLabel(EndLabel);
+  return true;
+}
+
+template <class Emitter>
+bool ByteCodeStmtGen<Emitter>::visitSwitchCase(const SwitchCase *S) {
+  auto It = CaseLabels.find(S);
+  if (It == CaseLabels.end())
+    return this->bail(S);
+  this->emitLabel(It->second);
+  return visitStmt(S->getSubStmt());
+}
+
+template <class Emitter>
+void ByteCodeStmtGen<Emitter>::emitScopeExit(VariableScope<Emitter> *Target) {
+  for (VariableScope<Emitter> *C = this->VarScope; C && C != Target;
+       C = C->getParent())
+    C->emitDestruction();
+}
+
 template <class Emitter>
 bool ByteCodeStmtGen<Emitter>::visitVarDecl(const VarDecl *VD) {
   auto DT = VD->getType();
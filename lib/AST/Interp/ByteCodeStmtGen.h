@@ -62,6 +62,17 @@ private:
   bool visitDeclStmt(const DeclStmt *DS);
   bool visitReturnStmt(const ReturnStmt *RS);
   bool visitIfStmt(const IfStmt *IS);
+  bool visitWhileStmt(const WhileStmt *S);
+  bool visitDoStmt(const DoStmt *S);
+  bool visitForStmt(const ForStmt *S);
+  bool visitBreakStmt(const BreakStmt *S);
+  bool visitContinueStmt(const ContinueStmt *S);
+  bool visitSwitchStmt(const SwitchStmt *S);
+  bool visitSwitchCase(const SwitchCase *S);
+
+  /// Emits the destruction of the scopes nested in \p Target, before a jump
+  /// out of them.
+  void emitScopeExit(VariableScope<Emitter> *Target);
 
   /// Compiles a variable declaration.
   bool visitVarDecl(const VarDecl *VD);
@@ -79,6 +90,10 @@ private:
   OptLabelTy ContinueLabel;
   /// Default case label.
   OptLabelTy DefaultLabel;
+
+  /// Scopes enclosing the break and continue targets.
+  VariableScope<Emitter> *BreakVarScope = nullptr;
+  VariableScope<Emitter> *ContinueVarScope = nullptr;
 };
 
 extern template class ByteCodeExprGen<EvalEmitter>;
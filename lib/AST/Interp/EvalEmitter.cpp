@@ -244,6 +244,22 @@ bool EvalEmitter::emitDestroy(uint32_t I, const SourceInfo &Info) {
   return true;
 }
 
+bool EvalEmitter::emitCall(Function *Func, const SourceInfo &Info) {
+  if (!isActive())
+    return true;
+  CurrentSource = Info;
+  return ExecuteCall(Func, Pointer(), Info);
+}
+
+bool EvalEmitter::ExecuteCall(Function *F, Pointer &&This,
+                              const SourceInfo &Info) {
+  // The callee returns to the dummy frame, leaving its result on the stack.
+  if (!EnterFrame(S, OpPC, CodePtr(), F, std::move(This)))
+    return false;
+  APValue Unused;
+  return Interpret(S, Unused);
+}
+
 //===----------------------------------------------------------------------===//
 // Opcode evaluators
 //===----------------------------------------------------------------------===//
@@ -94,6 +94,19 @@ public:
   Integral operator-() const { return Integral(-V); }
   Integral operator~() const { return Integral(~V); }
 
+  Integral operator&(Integral RHS) const { return Integral(V & RHS.V); }
+  Integral operator|(Integral RHS) const { return Integral(V | RHS.V); }
+  Integral operator^(Integral RHS) const { return Integral(V ^ RHS.V); }
+
+  /// Division and remainder, defined only if RHS is not zero and the result
+  /// fits the type (-min / -1 does not).
+  Integral operator/(Integral RHS) const { return Integral(V / RHS.V); }
+  Integral operator%(Integral RHS) const { return Integral(V % RHS.V); }
+
+  /// Shifts, defined only if the amount is less than the bit width.
+  Integral operator<<(unsigned RHS) const { return Integral(V << RHS); }
+  Integral operator>>(unsigned RHS) const { return Integral(V >> RHS); }
+
   template <unsigned DstBits, bool DstSign>
   explicit operator Integral<DstBits, DstSign>() const {
     return Integral<DstBits, DstSign>(V);
@@ -135,7 +148,10 @@ public:
     return Compare(V, RHS.V);
   }
 
-  unsigned countLeadingZeros() const { return llvm::countLeadingZeros<T>(V); }
+  unsigned countLeadingZeros() const {
+    using UnsignedT = typename Repr<Bits, false>::Type;
+    return llvm::countLeadingZeros<UnsignedT>(V);
+  }
 
   Integral truncate(unsigned TruncBits) const {
     if (TruncBits >= Bits)
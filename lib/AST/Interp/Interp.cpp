@@ -22,6 +22,9 @@
 #include "latino/AST/Expr.h"
 #include "latino/AST/ExprCXX.h"
 #include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace latino;
 using namespace latino::interp;
@@ -372,6 +375,16 @@ bool CheckCallable(InterpState &S, CodePtr OpPC, Function *F) {
   return true;
 }
 
+bool CheckCallDepth(InterpState &S, CodePtr OpPC) {
+  if (S.CallStackDepth < S.getLangOpts().ConstexprCallDepth)
+    return true;
+
+  const SourceInfo &Loc = S.Current->getSource(OpPC);
+  S.FFDiag(Loc, diag::note_constexpr_depth_limit_exceeded)
+      << S.getLangOpts().ConstexprCallDepth;
+  return false;
+}
+
 bool CheckThis(InterpState &S, CodePtr OpPC, const Pointer &This) {
   if (!This.isZero())
     return true;
@@ -398,12 +411,136 @@ bool CheckPure(InterpState &S, CodePtr OpPC, const CXXMethodDecl *MD) {
   S.Note(MD->getLocation(), diag::note_declared_at);
   return false;
 }
+//===----------------------------------------------------------------------===//
+// Dispatch
+//===----------------------------------------------------------------------===//
+
+// Computed gotos, a GNU extension, let each opcode jump straight to the next
+// one instead of going back through a single switch, which gives the branch
+// predictor an indirect jump per opcode to learn from. Define the macro to 0
+// to use the switch.
+#ifndef LATINO_INTERP_THREADED_DISPATCH
+#if defined(__GNUC__)
+#define LATINO_INTERP_THREADED_DISPATCH 1
+#else
+#define LATINO_INTERP_THREADED_DISPATCH 0
+#endif
+#endif
+
+#ifdef LATINO_INTERP_PROFILE_DISPATCH
+namespace {
+/// Counts the pairs of opcodes dispatched back to back and prints the most
+/// frequent ones at exit. They are the candidates for new superinstructions.
+class DispatchProfile {
+public:
+  DispatchProfile() : Counts(NumOpcodes * NumOpcodes) {}
+  ~DispatchProfile() { print(llvm::errs()); }
+
+  /// Records a dispatch of \p Op after \p Prev, unless \p Prev is the first
+  /// opcode of an evaluation.
+  void record(unsigned Prev, Opcode Op) {
+    if (Prev < NumOpcodes)
+      ++Counts[Prev * NumOpcodes + Op];
+  }
+
+  static const unsigned NumOpcodes;
+
+private:
+  void print(llvm::raw_ostream &OS) const {
+    std::vector<std::pair<uint64_t, unsigned>> Pairs;
+    for (unsigned I = 0, N = Counts.size(); I < N; ++I)
+      if (Counts[I])
+        Pairs.emplace_back(Counts[I], I);
+    llvm::sort(Pairs, [](const std::pair<uint64_t, unsigned> &A,
+                         const std::pair<uint64_t, unsigned> &B) {
+      return A.first > B.first;
+    });
+
+    OS << "===" << std::string(73, '-') << "===\n";
+    OS << "Constexpr interpreter opcode pairs\n";
+    for (unsigned I = 0, N = std::min<size_t>(Pairs.size(), 50); I < N; ++I) {
+      OS << llvm::format("%12llu", (unsigned long long)Pairs[I].first) << "  "
+         << Names[Pairs[I].second / NumOpcodes] << " "
+         << Names[Pairs[I].second % NumOpcodes] << "\n";
+    }
+  }
+
+  static const char *const Names[];
+  std::vector<uint64_t> Counts;
+};
+
+const char *const DispatchProfile::Names[] = {
+#define GET_OPCODE_STRINGS
+#include "Opcodes.inc"
+#undef GET_OPCODE_STRINGS
+};
+
+const unsigned DispatchProfile::NumOpcodes = llvm::array_lengthof(Names);
+} // namespace
+
+static DispatchProfile &getDispatchProfile() {
+  static DispatchProfile Profile;
+  return Profile;
+}
+
+#define INTERP_PROFILE()                                                       \
+  do {                                                                         \
+    getDispatchProfile().record(PrevOp, Op);                                   \
+    PrevOp = Op;                                                               \
+  } while (0)
+#else
+#define INTERP_PROFILE()                                                       \
+  do {                                                                         \
+  } while (0)
+#endif
+
+#if LATINO_INTERP_THREADED_DISPATCH
+#define INTERP_LABEL(Op) Interp_##Op
+#define INTERP_CASE(Op) INTERP_LABEL(Op):
+#define INTERP_NEXT()                                                          \
+  do {                                                                         \
+    Op = PC.read<Opcode>();                                                    \
+    OpPC = PC;                                                                 \
+    INTERP_PROFILE();                                                          \
+    goto *Labels[Op];                                                          \
+  } while (0)
+#else
+#define INTERP_CASE(Op) case Op:
+#define INTERP_NEXT() continue
+#endif
+
+#if LATINO_INTERP_THREADED_DISPATCH
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
 bool Interpret(InterpState &S, APValue &Result) {
   CodePtr PC = S.Current->getPC();
+  CodePtr OpPC;
+  Opcode Op;
+#ifdef LATINO_INTERP_PROFILE_DISPATCH
+  unsigned PrevOp = DispatchProfile::NumOpcodes;
+#endif
+
+#if LATINO_INTERP_THREADED_DISPATCH
+  static const void *const Labels[] = {
+#define GET_INTERP_LABELS
+#include "Opcodes.inc"
+#undef GET_INTERP_LABELS
+  };
 
+  INTERP_NEXT();
+  {
+#define GET_INTERP
+#include "Opcodes.inc"
+#undef GET_INTERP
+  }
+  llvm_unreachable("every opcode dispatches to the next one");
+#else
   for (;;) {
-    auto Op = PC.read<Opcode>();
-    CodePtr OpPC = PC;
+    Op = PC.read<Opcode>();
+    OpPC = PC;
+    INTERP_PROFILE();
 
     switch (Op) {
 #define GET_INTERP
@@ -411,7 +548,12 @@ bool Interpret(InterpState &S, APValue &Result) {
 #undef GET_INTERP
     }
   }
+#endif
 }
 
+#if LATINO_INTERP_THREADED_DISPATCH
+#pragma GCC diagnostic pop
+#endif
+
 } // namespace interp
 } // namespace latino
@@ -91,8 +91,28 @@ bool CheckThis(InterpState &S, CodePtr OpPC, const Pointer &This);
 /// Checks if a method is pure virtual.
 bool CheckPure(InterpState &S, CodePtr OpPC, const CXXMethodDecl *MD);
 
+/// Checks if a call does not exceed the maximum depth of the call stack.
+bool CheckCallDepth(InterpState &S, CodePtr OpPC);
+
 template <typename T> inline bool IsTrue(const T &V) { return !V.isZero(); }
 
+/// Reports the overflow of an operation whose exact result is \p Value and
+/// whose truncated result was already pushed, stopping if required.
+inline bool HandleOverflow(InterpState &S, CodePtr OpPC, unsigned Bits,
+                           const APSInt &Value) {
+  const Expr *E = S.Current->getExpr(OpPC);
+  QualType Type = E->getType();
+  if (S.checkingForUndefinedBehavior()) {
+    auto Trunc = Value.trunc(Bits).toString(10);
+    auto Loc = E->getExprLoc();
+    S.report(Loc, diag::warn_integer_constant_overflow) << Trunc << Type;
+    return true;
+  } else {
+    S.CCEDiag(E, diag::note_constexpr_overflow) << Value << Type;
+    return S.noteUndefinedBehavior();
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // Add, Sub, Mul
 //===----------------------------------------------------------------------===//
@@ -115,17 +135,7 @@ bool AddSubMulHelper(InterpState &S, CodePtr OpPC, unsigned Bits, const T &LHS,
   APSInt Value = OpAP<APSInt>()(LHS.toAPSInt(Bits), RHS.toAPSInt(Bits));
 
   // Report undefined behaviour, stopping if required.
-  const Expr *E = S.Current->getExpr(OpPC);
-  QualType Type = E->getType();
-  if (S.checkingForUndefinedBehavior()) {
-    auto Trunc = Value.trunc(Result.bitWidth()).toString(10);
-    auto Loc = E->getExprLoc();
-    S.report(Loc, diag::warn_integer_constant_overflow) << Trunc << Type;
-    return true;
-  } else {
-    S.CCEDiag(E, diag::note_constexpr_overflow) << Value << Type;
-    return S.noteUndefinedBehavior();
-  }
+  return HandleOverflow(S, OpPC, Result.bitWidth(), Value);
 }
 
 template <PrimType Name, class T = typename PrimConv<Name>::T>
@@ -152,6 +162,107 @@ bool Mul(InterpState &S, CodePtr OpPC) {
   return AddSubMulHelper<T, T::mul, std::multiplies>(S, OpPC, Bits, LHS, RHS);
 }
 
+//===----------------------------------------------------------------------===//
+// Div, Rem
+//===----------------------------------------------------------------------===//
+
+/// Checks that the divisor of a division or a remainder is not zero.
+template <typename T> bool CheckDivisor(InterpState &S, CodePtr OpPC, T RHS) {
+  if (!RHS.isZero())
+    return true;
+  const SourceInfo &Loc = S.Current->getSource(OpPC);
+  S.FFDiag(Loc, diag::note_expr_divide_by_zero);
+  return false;
+}
+
+/// Checks if the quotient of the operands is one past the maximum.
+template <typename T> bool IsDivOverflow(const T &LHS, const T &RHS) {
+  return LHS.isSigned() && LHS.isMin() && RHS.isMinusOne();
+}
+
+template <PrimType Name, class T = typename PrimConv<Name>::T>
+bool Div(InterpState &S, CodePtr OpPC) {
+  const T &RHS = S.Stk.pop<T>();
+  const T &LHS = S.Stk.pop<T>();
+  if (!CheckDivisor(S, OpPC, RHS))
+    return false;
+  if (IsDivOverflow(LHS, RHS)) {
+    // The quotient wraps around to the minimum.
+    S.Stk.push<T>(LHS);
+    const unsigned Bits = LHS.bitWidth();
+    return HandleOverflow(S, OpPC, Bits, -LHS.toAPSInt(Bits + 1));
+  }
+  S.Stk.push<T>(LHS / RHS);
+  return true;
+}
+
+template <PrimType Name, class T = typename PrimConv<Name>::T>
+bool Rem(InterpState &S, CodePtr OpPC) {
+  const T &RHS = S.Stk.pop<T>();
+  const T &LHS = S.Stk.pop<T>();
+  if (!CheckDivisor(S, OpPC, RHS))
+    return false;
+  if (IsDivOverflow(LHS, RHS)) {
+    S.Stk.push<T>(T::zero());
+    const unsigned Bits = LHS.bitWidth();
+    return HandleOverflow(S, OpPC, Bits, -LHS.toAPSInt(Bits + 1));
+  }
+  S.Stk.push<T>(LHS % RHS);
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// BitAnd, BitOr, BitXor
+//===----------------------------------------------------------------------===//
+
+template <PrimType Name, class T = typename PrimConv<Name>::T>
+bool BitAnd(InterpState &S, CodePtr OpPC) {
+  const T &RHS = S.Stk.pop<T>();
+  const T &LHS = S.Stk.pop<T>();
+  S.Stk.push<T>(LHS & RHS);
+  return true;
+}
+
+template <PrimType Name, class T = typename PrimConv<Name>::T>
+bool BitOr(InterpState &S, CodePtr OpPC) {
+  const T &RHS = S.Stk.pop<T>();
+  const T &LHS = S.Stk.pop<T>();
+  S.Stk.push<T>(LHS | RHS);
+  return true;
+}
+
+template <PrimType Name, class T = typename PrimConv<Name>::T>
+bool BitXor(InterpState &S, CodePtr OpPC) {
+  const T &RHS = S.Stk.pop<T>();
+  const T &LHS = S.Stk.pop<T>();
+  S.Stk.push<T>(LHS ^ RHS);
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Neg, Comp
+//===----------------------------------------------------------------------===//
+
+template <PrimType Name, class T = typename PrimConv<Name>::T>
+bool Neg(InterpState &S, CodePtr OpPC) {
+  const T &Value = S.Stk.pop<T>();
+  if (!Value.isSigned() || !Value.isMin()) {
+    S.Stk.push<T>(-Value);
+    return true;
+  }
+
+  // The negation of the minimum wraps around to itself.
+  S.Stk.push<T>(Value);
+  const unsigned Bits = Value.bitWidth();
+  return HandleOverflow(S, OpPC, Bits, -Value.toAPSInt(Bits + 1));
+}
+
+template <PrimType Name, class T = typename PrimConv<Name>::T>
+bool Comp(InterpState &S, CodePtr OpPC) {
+  S.Stk.push<T>(~S.Stk.pop<T>());
+  return true;
+}
+
 //===----------------------------------------------------------------------===//
 // EQ, NE, GT, GE, LT, LE
 //===----------------------------------------------------------------------===//
@@ -800,7 +911,13 @@ inline bool Destroy(InterpState &S, CodePtr OpPC, uint32_t I) {
 template <PrimType TIn, PrimType TOut> bool Cast(InterpState &S, CodePtr OpPC) {
   using T = typename PrimConv<TIn>::T;
   using U = typename PrimConv<TOut>::T;
-  S.Stk.push<U>(U::from(S.Stk.pop<T>()));
+  // Go through the widest integer, which wraps the value modulo the width of
+  // the destination and turns it into a boolean if needed.
+  const T &Value = S.Stk.pop<T>();
+  if (T::isSigned())
+    S.Stk.push<U>(U::from(static_cast<int64_t>(Value)));
+  else
+    S.Stk.push<U>(U::from(static_cast<uint64_t>(Value)));
   return true;
 }
 
@@ -845,13 +962,14 @@ inline bool This(InterpState &S, CodePtr OpPC) {
 template <PrimType TR, PrimType TL, class T = typename PrimConv<TR>::T>
 unsigned Trunc(InterpState &S, CodePtr OpPC, unsigned Bits, const T &V) {
   // C++11 [expr.shift]p1: Shift width must be less than the bit width of
-  // the shifted type.
+  // the shifted type. When folding, the width is clamped to the last bit, as
+  // the tree-walking evaluator does.
   if (Bits > 1 && V >= T::from(Bits, V.bitWidth())) {
     const Expr *E = S.Current->getExpr(OpPC);
     const APSInt Val = V.toAPSInt();
     QualType Ty = E->getType();
     S.CCEDiag(E, diag::note_constexpr_large_shift) << Val << Ty << Bits;
-    return Bits;
+    return Bits - 1;
   } else {
     return static_cast<unsigned>(V);
   }
@@ -932,6 +1050,49 @@ inline bool NoRet(InterpState &S, CodePtr OpPC) {
   return false;
 }
 
+//===----------------------------------------------------------------------===//
+// Call, NoCall
+//===----------------------------------------------------------------------===//
+
+/// Enters the frame of a call to \p Func, whose arguments are on the stack.
+/// The frame returns to \p RetPC in the caller.
+inline bool EnterFrame(InterpState &S, CodePtr OpPC, CodePtr RetPC,
+                       Function *Func, Pointer &&This) {
+  // Arguments are not known in this mode.
+  if (S.checkingPotentialConstantExpression())
+    return false;
+  if (!CheckCallable(S, OpPC, Func) || !CheckCallDepth(S, OpPC))
+    return false;
+
+  S.CallStackDepth++;
+  S.Current = new InterpFrame(S, Func, S.Current, RetPC, std::move(This));
+  return true;
+}
+
+inline bool Call(InterpState &S, CodePtr &PC, Function *Func) {
+  // The location of an opcode is attached to the address after it, before
+  // its arguments.
+  CodePtr OpPC = PC - sizeof(Function *);
+  if (!EnterFrame(S, OpPC, PC, Func, Pointer()))
+    return false;
+
+  // Continue with the callee - its return resumes the caller.
+  PC = Func->getCodeBegin();
+  return true;
+}
+
+inline bool NoCall(InterpState &S, CodePtr OpPC, const FunctionDecl *FD) {
+  const SourceLocation &Loc = S.Current->getLocation(OpPC);
+  if (S.getLangOpts().CPlusPlus11) {
+    S.FFDiag(Loc, diag::note_constexpr_invalid_function, 1)
+        << FD->isConstexpr() << isa<CXXConstructorDecl>(FD) << FD;
+    S.Note(FD->getLocation(), diag::note_declared_at);
+  } else {
+    S.FFDiag(Loc, diag::note_invalid_subexpr_in_const_expr);
+  }
+  return false;
+}
+
 //===----------------------------------------------------------------------===//
 // NarrowPtr, ExpandPtr
 //===----------------------------------------------------------------------===//
@@ -182,7 +182,7 @@ const char *RawComment::extractBriefText(const ASTContext &Context) const {
   // Since we will be copying the resulting text, all allocations made during
   // parsing are garbage after resulting string is formed.  Thus we can use
   // a separate allocator for all temporary stuff.
-  llvm::BumpPtrAllocator Allocator;
+  ArenaAllocator Allocator;
 
   comments::Lexer L(Allocator, Context.getDiagnostics(),
                     Context.getCommentCommandTraits(),
@@ -272,7 +272,7 @@ static bool onlyWhitespaceBetween(SourceManager &SM,
 
 void RawCommentList::addComment(const RawComment &RC,
                                 const CommentOptions &CommentOpts,
-                                llvm::BumpPtrAllocator &Allocator) {
+                                ArenaAllocator &Allocator) {
   if (RC.isInvalid())
     return;
 
@@ -362,7 +362,7 @@ std::string RawComment::getFormattedText(const SourceManager &SourceMgr,
   if (CommentText.empty())
     return "";
 
-  llvm::BumpPtrAllocator Allocator;
+  ArenaAllocator Allocator;
   // We do not parse any commands, so CommentOptions are ignored by
   // comments::Lexer. Therefore, we just use default-constructed options.
   CommentOptions DefOpts;
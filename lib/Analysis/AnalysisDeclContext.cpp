@@ -45,6 +45,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/SaveAndRestore.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cassert>
 #include <memory>
 
@@ -90,6 +91,43 @@ AnalysisDeclContextManager::AnalysisDeclContextManager(
 
 void AnalysisDeclContextManager::clear() { Contexts.clear(); }
 
+void AnalysisDeclContextManager::setCacheCFGs(bool Cache, unsigned MaxCFGs) {
+  CacheCFGs = Cache;
+  MaxCachedCFGs = Cache ? std::max(MaxCFGs, 1u) : 0;
+  while (CFGCache.size() > MaxCachedCFGs) {
+    CFGCacheIndex.erase(CFGCache.back().Key);
+    CFGCache.pop_back();
+  }
+}
+
+std::shared_ptr<CFG>
+AnalysisDeclContextManager::getCachedCFG(const Decl *D, Stmt *Body,
+                                         const CFG::BuildOptions &Options) {
+  CFGCacheKey Key(D, Options.PruneTriviallyFalseEdges);
+  auto Inserted = CFGCacheIndex.try_emplace(Key);
+  if (Inserted.second) {
+    CFGCache.push_front(CachedCFG());
+    CFGCache.front().Key = Key;
+    Inserted.first->second = CFGCache.begin();
+    if (CFGCache.size() > MaxCachedCFGs) {
+      CFGCacheIndex.erase(CFGCache.back().Key);
+      CFGCache.pop_back();
+    }
+  } else {
+    CFGCache.splice(CFGCache.begin(), CFGCache, Inserted.first->second);
+  }
+
+  CachedCFG &Entry = CFGCache.front();
+  // A failed build is cached as well, as a null CFG.
+  if (Inserted.second || !Entry.Options.buildsSameCFGAs(Options)) {
+    Entry.TheCFG = CFG::buildCFG(D, Body, &D->getASTContext(), Options);
+    Entry.Options = Options;
+    Entry.Options.forcedBlkExprs = nullptr;
+    Entry.Options.Observer = nullptr;
+  }
+  return Entry.TheCFG;
+}
+
 Stmt *AnalysisDeclContext::getBody(bool &IsAutosynthesized) const {
   IsAutosynthesized = false;
   if (const auto *FD = dyn_cast<FunctionDecl>(D)) {
@@ -210,12 +248,21 @@ static void addParentsForSyntheticStmts(const CFG *TheCFG, ParentMap &PM) {
   }
 }
 
+std::shared_ptr<CFG> AnalysisDeclContext::buildCFG() {
+  // A build that is observed or that records the blocks of the forced
+  // expressions is specific to this context.
+  if (ADCMgr && ADCMgr->shouldCacheCFGs() && !cfgBuildOptions.Observer &&
+      !forcedBlkExprs)
+    return ADCMgr->getCachedCFG(D, getBody(), cfgBuildOptions);
+  return CFG::buildCFG(D, getBody(), &D->getASTContext(), cfgBuildOptions);
+}
+
 CFG *AnalysisDeclContext::getCFG() {
   if (!cfgBuildOptions.PruneTriviallyFalseEdges)
     return getUnoptimizedCFG();
 
   if (!builtCFG) {
-    cfg = CFG::buildCFG(D, getBody(), &D->getASTContext(), cfgBuildOptions);
+    cfg = buildCFG();
     // Even when the cfg is not successfully built, we don't
     // want to try building it again.
     builtCFG = true;
@@ -233,8 +280,7 @@ CFG *AnalysisDeclContext::getUnoptimizedCFG() {
   if (!builtCompleteCFG) {
     SaveAndRestore<bool> NotPrune(cfgBuildOptions.PruneTriviallyFalseEdges,
                                   false);
-    completeCFG =
-        CFG::buildCFG(D, getBody(), &D->getASTContext(), cfgBuildOptions);
+    completeCFG = buildCFG();
     // Even when the cfg is not successfully built, we don't
     // want to try building it again.
     builtCompleteCFG = true;
@@ -15,8 +15,11 @@
 #include "latino/AST/StmtVisitor.h"
 #include "latino/Analysis/AnalysisDeclContext.h"
 #include "latino/Analysis/CFG.h"
-#include "latino/Analysis/FlowSensitive/DataflowWorklist.h"
+#include "latino/Analysis/FlowSensitive/BitVectorDataflow.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/PointerUnion.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <vector>
@@ -24,6 +27,18 @@
 using namespace latino;
 
 namespace {
+/// A fact of the liveness analysis: a live expression, variable or binding.
+using LiveFact =
+    llvm::PointerUnion<const Stmt *, const VarDecl *, const BindingDecl *>;
+
+/// The effect of a block on the facts live at its exit: those in Gen become
+/// live, and those in Kill dead. Only the facts tracked by the dataflow
+/// values are listed, by index.
+struct BlockGenKill {
+  SmallVector<unsigned, 4> Gen;
+  SmallVector<unsigned, 4> Kill;
+};
+
 class LiveVariablesImpl {
 public:
   AnalysisDeclContext &analysisContext;
@@ -36,14 +51,25 @@ public:
   llvm::DenseMap<const DeclRefExpr *, unsigned> inAssignment;
   const bool killAtAssign;
 
-  LiveVariables::LivenessValues
-  merge(LiveVariables::LivenessValues valsA,
-        LiveVariables::LivenessValues valsB);
+  /// The facts tracked by the dataflow values, which are those live at the
+  /// entry of some block. Facts that only live within a block, as most
+  /// expressions do, take no room in the values of the other blocks.
+  std::vector<LiveFact> trackedFacts;
+  llvm::DenseMap<LiveFact, unsigned> factIndex;
+
+  template <typename LivenessTy>
+  void runOnBlock(const CFGBlock *block, LivenessTy &val,
+                  LiveVariables::Observer *obs);
 
   LiveVariables::LivenessValues
   runOnBlock(const CFGBlock *block, LiveVariables::LivenessValues val,
              LiveVariables::Observer *obs = nullptr);
 
+  /// Compute the effect of each block, indexing the facts it makes live.
+  std::vector<BlockGenKill> computeGenKill(const CFG &cfg);
+
+  LiveVariables::LivenessValues getLivenessValues(const llvm::BitVector &bits);
+
   void dumpBlockLiveness(const SourceManager& M);
   void dumpStmtLiveness(const SourceManager& M);
 
@@ -78,49 +104,8 @@ bool LiveVariables::LivenessValues::isLive(const VarDecl *D) const {
   return liveDecls.contains(D);
 }
 
-namespace {
-  template <typename SET>
-  SET mergeSets(SET A, SET B) {
-    if (A.isEmpty())
-      return B;
-
-    for (typename SET::iterator it = B.begin(), ei = B.end(); it != ei; ++it) {
-      A = A.add(*it);
-    }
-    return A;
-  }
-} // namespace
-
 void LiveVariables::Observer::anchor() { }
 
-LiveVariables::LivenessValues
-LiveVariablesImpl::merge(LiveVariables::LivenessValues valsA,
-                         LiveVariables::LivenessValues valsB) {
-
-  llvm::ImmutableSetRef<const Stmt *>
-    SSetRefA(valsA.liveStmts.getRootWithoutRetain(), SSetFact.getTreeFactory()),
-    SSetRefB(valsB.liveStmts.getRootWithoutRetain(), SSetFact.getTreeFactory());
-
-
-  llvm::ImmutableSetRef<const VarDecl *>
-    DSetRefA(valsA.liveDecls.getRootWithoutRetain(), DSetFact.getTreeFactory()),
-    DSetRefB(valsB.liveDecls.getRootWithoutRetain(), DSetFact.getTreeFactory());
-
-  llvm::ImmutableSetRef<const BindingDecl *>
-    BSetRefA(valsA.liveBindings.getRootWithoutRetain(), BSetFact.getTreeFactory()),
-    BSetRefB(valsB.liveBindings.getRootWithoutRetain(), BSetFact.getTreeFactory());
-
-  SSetRefA = mergeSets(SSetRefA, SSetRefB);
-  DSetRefA = mergeSets(DSetRefA, DSetRefB);
-  BSetRefA = mergeSets(BSetRefA, BSetRefB);
-
-  // asImmutableSet() canonicalizes the tree, allowing us to do an easy
-  // comparison afterwards.
-  return LiveVariables::LivenessValues(SSetRefA.asImmutableSet(),
-                                       DSetRefA.asImmutableSet(),
-                                       BSetRefA.asImmutableSet());
-}
-
 bool LiveVariables::LivenessValues::equals(const LivenessValues &V) const {
   return liveStmts == V.liveStmts && liveDecls == V.liveDecls;
 }
@@ -150,14 +135,76 @@ bool LiveVariables::isLive(const Stmt *Loc, const Stmt *S) {
 //===----------------------------------------------------------------------===//
 
 namespace {
-class TransferFunctions : public StmtVisitor<TransferFunctions> {
+/// Updates the sets of facts live at a statement, as they are recorded for
+/// the queries.
+class LiveSets {
   LiveVariablesImpl &LV;
   LiveVariables::LivenessValues &val;
+
+public:
+  LiveSets(LiveVariablesImpl &LV, LiveVariables::LivenessValues &Val)
+      : LV(LV), val(Val) {}
+
+  void add(const Stmt *S) {
+    val.liveStmts = LV.SSetFact.add(val.liveStmts, S);
+  }
+  void add(const VarDecl *D) {
+    val.liveDecls = LV.DSetFact.add(val.liveDecls, D);
+  }
+  void add(const BindingDecl *D) {
+    val.liveBindings = LV.BSetFact.add(val.liveBindings, D);
+  }
+
+  void remove(const Stmt *S) {
+    val.liveStmts = LV.SSetFact.remove(val.liveStmts, S);
+  }
+  void remove(const VarDecl *D) {
+    val.liveDecls = LV.DSetFact.remove(val.liveDecls, D);
+  }
+  void remove(const BindingDecl *D) {
+    val.liveBindings = LV.BSetFact.remove(val.liveBindings, D);
+  }
+
+  void observeStmt(LiveVariables::Observer *observer, const Stmt *S,
+                   const CFGBlock *currentBlock) {
+    if (observer)
+      observer->observeStmt(S, currentBlock, val);
+  }
+
+  void recordStmt(const Stmt *S) { LV.stmtsToLiveness[S] = val; }
+};
+
+/// Records the last update of each fact by a block, which is its effect on
+/// the facts live at the exit of the block.
+class LiveUpdates {
+  llvm::SmallDenseMap<LiveFact, bool, 16> madeLive;
+
+public:
+  void add(LiveFact F) { madeLive[F] = true; }
+  void remove(LiveFact F) { madeLive[F] = false; }
+
+  void observeStmt(LiveVariables::Observer *observer, const Stmt *S,
+                   const CFGBlock *currentBlock) {
+    assert(!observer && "Only the live sets are observed");
+  }
+
+  void recordStmt(const Stmt *S) {}
+
+  const llvm::SmallDenseMap<LiveFact, bool, 16> &getUpdates() const {
+    return madeLive;
+  }
+};
+
+template <typename LivenessTy>
+class TransferFunctions
+    : public StmtVisitor<TransferFunctions<LivenessTy>> {
+  LiveVariablesImpl &LV;
+  LivenessTy &val;
   LiveVariables::Observer *observer;
   const CFGBlock *currentBlock;
 public:
   TransferFunctions(LiveVariablesImpl &im,
-                    LiveVariables::LivenessValues &Val,
+                    LivenessTy &Val,
                     LiveVariables::Observer *Observer,
                     const CFGBlock *CurrentBlock)
   : LV(im), val(Val), observer(Observer), currentBlock(CurrentBlock) {}
@@ -203,20 +250,19 @@ static const Stmt *LookThroughStmt(const Stmt *S) {
   return S;
 }
 
-static void AddLiveStmt(llvm::ImmutableSet<const Stmt *> &Set,
-                        llvm::ImmutableSet<const Stmt *>::Factory &F,
-                        const Stmt *S) {
-  Set = F.add(Set, LookThroughStmt(S));
+template <typename LivenessTy>
+static void AddLiveStmt(LivenessTy &Val, const Stmt *S) {
+  Val.add(LookThroughStmt(S));
 }
 
-void TransferFunctions::Visit(Stmt *S) {
-  if (observer)
-    observer->observeStmt(S, currentBlock, val);
+template <typename LivenessTy>
+void TransferFunctions<LivenessTy>::Visit(Stmt *S) {
+  val.observeStmt(observer, S, currentBlock);
 
-  StmtVisitor<TransferFunctions>::Visit(S);
+  StmtVisitor<TransferFunctions<LivenessTy>>::Visit(S);
 
   if (isa<Expr>(S)) {
-    val.liveStmts = LV.SSetFact.remove(val.liveStmts, S);
+    val.remove(S);
   }
 
   // Mark all children expressions live.
@@ -233,7 +279,7 @@ void TransferFunctions::Visit(Stmt *S) {
       // Include the implicit "this" pointer as being live.
       CXXMemberCallExpr *CE = cast<CXXMemberCallExpr>(S);
       if (Expr *ImplicitObj = CE->getImplicitObjectArgument()) {
-        AddLiveStmt(val.liveStmts, LV.SSetFact, ImplicitObj);
+        AddLiveStmt(val, ImplicitObj);
       }
       break;
     }
@@ -250,7 +296,7 @@ void TransferFunctions::Visit(Stmt *S) {
       if (const VarDecl *VD = dyn_cast<VarDecl>(DS->getSingleDecl())) {
         for (const VariableArrayType* VA = FindVA(VD->getType());
              VA != nullptr; VA = FindVA(VA->getElementType())) {
-          AddLiveStmt(val.liveStmts, LV.SSetFact, VA->getSizeExpr());
+          AddLiveStmt(val, VA->getSizeExpr());
         }
       }
       break;
@@ -263,7 +309,7 @@ void TransferFunctions::Visit(Stmt *S) {
       if (OpaqueValueExpr *OV = dyn_cast<OpaqueValueExpr>(child))
         child = OV->getSourceExpr();
       child = child->IgnoreParens();
-      val.liveStmts = LV.SSetFact.add(val.liveStmts, child);
+      val.add(child);
       return;
     }
 
@@ -284,28 +330,28 @@ void TransferFunctions::Visit(Stmt *S) {
       // If one of the branches is an expression rather than a compound
       // statement, it will be bad if we mark it as live at the terminator
       // of the if-statement (i.e., immediately after the condition expression).
-      AddLiveStmt(val.liveStmts, LV.SSetFact, cast<IfStmt>(S)->getCond());
+      AddLiveStmt(val, cast<IfStmt>(S)->getCond());
       return;
     }
     case Stmt::WhileStmtClass: {
       // If the loop body is an expression rather than a compound statement,
       // it will be bad if we mark it as live at the terminator of the loop
       // (i.e., immediately after the condition expression).
-      AddLiveStmt(val.liveStmts, LV.SSetFact, cast<WhileStmt>(S)->getCond());
+      AddLiveStmt(val, cast<WhileStmt>(S)->getCond());
       return;
     }
     case Stmt::DoStmtClass: {
       // If the loop body is an expression rather than a compound statement,
       // it will be bad if we mark it as live at the terminator of the loop
       // (i.e., immediately after the condition expression).
-      AddLiveStmt(val.liveStmts, LV.SSetFact, cast<DoStmt>(S)->getCond());
+      AddLiveStmt(val, cast<DoStmt>(S)->getCond());
       return;
     }
     case Stmt::ForStmtClass: {
       // If the loop body is an expression rather than a compound statement,
       // it will be bad if we mark it as live at the terminator of the loop
       // (i.e., immediately after the condition expression).
-      AddLiveStmt(val.liveStmts, LV.SSetFact, cast<ForStmt>(S)->getCond());
+      AddLiveStmt(val, cast<ForStmt>(S)->getCond());
       return;
     }
 
@@ -313,7 +359,7 @@ void TransferFunctions::Visit(Stmt *S) {
 
   for (Stmt *Child : S->children()) {
     if (Child)
-      AddLiveStmt(val.liveStmts, LV.SSetFact, Child);
+      AddLiveStmt(val, Child);
   }
 }
 
@@ -322,7 +368,8 @@ static bool writeShouldKill(const VarDecl *VD) {
     !isAlwaysAlive(VD);
 }
 
-void TransferFunctions::VisitBinaryOperator(BinaryOperator *B) {
+template <typename LivenessTy>
+void TransferFunctions<LivenessTy>::VisitBinaryOperator(BinaryOperator *B) {
   if (B->isAssignmentOp()) {
     if (!LV.killAtAssign)
       return;
@@ -337,11 +384,11 @@ void TransferFunctions::VisitBinaryOperator(BinaryOperator *B) {
       if (const BindingDecl* BD = dyn_cast<BindingDecl>(D)) {
         Killed = !BD->getType()->isReferenceType();
         if (Killed)
-          val.liveBindings = LV.BSetFact.remove(val.liveBindings, BD);
+          val.remove(BD);
       } else if (const auto *VD = dyn_cast<VarDecl>(D)) {
         Killed = writeShouldKill(VD);
         if (Killed)
-          val.liveDecls = LV.DSetFact.remove(val.liveDecls, VD);
+          val.remove(VD);
 
       }
 
@@ -351,35 +398,38 @@ void TransferFunctions::VisitBinaryOperator(BinaryOperator *B) {
   }
 }
 
-void TransferFunctions::VisitBlockExpr(BlockExpr *BE) {
+template <typename LivenessTy>
+void TransferFunctions<LivenessTy>::VisitBlockExpr(BlockExpr *BE) {
   for (const VarDecl *VD :
        LV.analysisContext.getReferencedBlockVars(BE->getBlockDecl())) {
     if (isAlwaysAlive(VD))
       continue;
-    val.liveDecls = LV.DSetFact.add(val.liveDecls, VD);
+    val.add(VD);
   }
 }
 
-void TransferFunctions::VisitDeclRefExpr(DeclRefExpr *DR) {
+template <typename LivenessTy>
+void TransferFunctions<LivenessTy>::VisitDeclRefExpr(DeclRefExpr *DR) {
   const Decl* D = DR->getDecl();
   bool InAssignment = LV.inAssignment[DR];
   if (const auto *BD = dyn_cast<BindingDecl>(D)) {
     if (!InAssignment)
-      val.liveBindings = LV.BSetFact.add(val.liveBindings, BD);
+      val.add(BD);
   } else if (const auto *VD = dyn_cast<VarDecl>(D)) {
     if (!InAssignment && !isAlwaysAlive(VD))
-      val.liveDecls = LV.DSetFact.add(val.liveDecls, VD);
+      val.add(VD);
   }
 }
 
-void TransferFunctions::VisitDeclStmt(DeclStmt *DS) {
+template <typename LivenessTy>
+void TransferFunctions<LivenessTy>::VisitDeclStmt(DeclStmt *DS) {
   for (const auto *DI : DS->decls()) {
     if (const auto *DD = dyn_cast<DecompositionDecl>(DI)) {
       for (const auto *BD : DD->bindings())
-        val.liveBindings = LV.BSetFact.remove(val.liveBindings, BD);
+        val.remove(BD);
     } else if (const auto *VD = dyn_cast<VarDecl>(DI)) {
       if (!isAlwaysAlive(VD))
-        val.liveDecls = LV.DSetFact.remove(val.liveDecls, VD);
+        val.remove(VD);
     }
   }
 }
@@ -404,7 +454,8 @@ void TransferFunctions::VisitDeclStmt(DeclStmt *DS) {
 //   }
 // }
 
-void TransferFunctions::
+template <typename LivenessTy>
+void TransferFunctions<LivenessTy>::
 VisitUnaryExprOrTypeTraitExpr(UnaryExprOrTypeTraitExpr *UE)
 {
   // While sizeof(var) doesn't technically extend the liveness of 'var', it
@@ -416,11 +467,12 @@ VisitUnaryExprOrTypeTraitExpr(UnaryExprOrTypeTraitExpr *UE)
   const Expr *subEx = UE->getArgumentExpr();
   if (subEx->getType()->isVariableArrayType()) {
     assert(subEx->isLValue());
-    val.liveStmts = LV.SSetFact.add(val.liveStmts, subEx->IgnoreParens());
+    val.add(subEx->IgnoreParens());
   }
 }
 
-void TransferFunctions::VisitUnaryOperator(UnaryOperator *UO) {
+template <typename LivenessTy>
+void TransferFunctions<LivenessTy>::VisitUnaryOperator(UnaryOperator *UO) {
   // Treat ++/-- as a kill.
   // Note we don't actually have to do anything if we don't have an observer,
   // since a ++/-- acts as both a kill and a "use".
@@ -446,12 +498,11 @@ void TransferFunctions::VisitUnaryOperator(UnaryOperator *UO) {
   }
 }
 
-LiveVariables::LivenessValues
-LiveVariablesImpl::runOnBlock(const CFGBlock *block,
-                              LiveVariables::LivenessValues val,
-                              LiveVariables::Observer *obs) {
+template <typename LivenessTy>
+void LiveVariablesImpl::runOnBlock(const CFGBlock *block, LivenessTy &val,
+                                   LiveVariables::Observer *obs) {
 
-  TransferFunctions TF(*this, val, obs, block);
+  TransferFunctions<LivenessTy> TF(*this, val, obs, block);
 
   // Visit the terminator (if any).
   if (const Stmt *term = block->getTerminatorStmt())
@@ -464,7 +515,7 @@ LiveVariablesImpl::runOnBlock(const CFGBlock *block,
 
     if (Optional<CFGAutomaticObjDtor> Dtor =
             elem.getAs<CFGAutomaticObjDtor>()) {
-      val.liveDecls = DSetFact.add(val.liveDecls, Dtor->getVarDecl());
+      val.add(Dtor->getVarDecl());
       continue;
     }
 
@@ -473,7 +524,63 @@ LiveVariablesImpl::runOnBlock(const CFGBlock *block,
 
     const Stmt *S = elem.castAs<CFGStmt>().getStmt();
     TF.Visit(const_cast<Stmt*>(S));
-    stmtsToLiveness[S] = val;
+    val.recordStmt(S);
+  }
+}
+
+LiveVariables::LivenessValues
+LiveVariablesImpl::runOnBlock(const CFGBlock *block,
+                              LiveVariables::LivenessValues val,
+                              LiveVariables::Observer *obs) {
+  LiveSets Sets(*this, val);
+  runOnBlock(block, Sets, obs);
+  return val;
+}
+
+std::vector<BlockGenKill> LiveVariablesImpl::computeGenKill(const CFG &cfg) {
+  std::vector<BlockGenKill> genKill(cfg.getNumBlockIDs());
+  std::vector<SmallVector<LiveFact, 4>> killed(cfg.getNumBlockIDs());
+
+  for (const CFGBlock *block : cfg) {
+    LiveUpdates updates;
+    runOnBlock(block, updates, nullptr);
+
+    BlockGenKill &blockGenKill = genKill[block->getBlockID()];
+    for (const auto &update : updates.getUpdates()) {
+      if (!update.second) {
+        killed[block->getBlockID()].push_back(update.first);
+        continue;
+      }
+      auto inserted = factIndex.try_emplace(update.first, trackedFacts.size());
+      if (inserted.second)
+        trackedFacts.push_back(update.first);
+      blockGenKill.Gen.push_back(inserted.first->second);
+    }
+  }
+
+  // A fact that no block makes live is never live at the entry of a block,
+  // so its kills need no tracking.
+  for (const CFGBlock *block : cfg)
+    for (LiveFact fact : killed[block->getBlockID()]) {
+      auto it = factIndex.find(fact);
+      if (it != factIndex.end())
+        genKill[block->getBlockID()].Kill.push_back(it->second);
+    }
+  return genKill;
+}
+
+LiveVariables::LivenessValues
+LiveVariablesImpl::getLivenessValues(const llvm::BitVector &bits) {
+  LiveVariables::LivenessValues val;
+  LiveSets Sets(*this, val);
+  for (unsigned index : bits.set_bits()) {
+    LiveFact fact = trackedFacts[index];
+    if (const auto *S = fact.dyn_cast<const Stmt *>())
+      Sets.add(S);
+    else if (const auto *VD = fact.dyn_cast<const VarDecl *>())
+      Sets.add(VD);
+    else
+      Sets.add(fact.get<const BindingDecl *>());
   }
   return val;
 }
@@ -505,21 +612,12 @@ LiveVariables::computeLiveness(AnalysisDeclContext &AC, bool killAtAssign) {
 
   LiveVariablesImpl *LV = new LiveVariablesImpl(AC, killAtAssign);
 
-  // Construct the dataflow worklist.  Enqueue the exit block as the
-  // start of the analysis.
-  BackwardDataflowWorklist worklist(*cfg, AC);
-  llvm::BitVector everAnalyzedBlock(cfg->getNumBlockIDs());
-
-  // FIXME: we should enqueue using post order.
-  for (CFG::const_iterator it = cfg->begin(), ei = cfg->end(); it != ei; ++it) {
-    const CFGBlock *block = *it;
-    worklist.enqueueBlock(block);
-
-    // FIXME: Scan for DeclRefExprs using in the LHS of an assignment.
-    // We need to do this because we lack context in the reverse analysis
-    // to determine if a DeclRefExpr appears in such a context, and thus
-    // doesn't constitute a "use".
-    if (killAtAssign)
+  // FIXME: Scan for DeclRefExprs using in the LHS of an assignment.
+  // We need to do this because we lack context in the reverse analysis
+  // to determine if a DeclRefExpr appears in such a context, and thus
+  // doesn't constitute a "use".
+  if (killAtAssign)
+    for (const CFGBlock *block : *cfg)
       for (CFGBlock::const_iterator bi = block->begin(), be = block->end();
            bi != be; ++bi) {
         if (Optional<CFGStmt> cs = bi->getAs<CFGStmt>()) {
@@ -534,34 +632,27 @@ LiveVariables::computeLiveness(AnalysisDeclContext &AC, bool killAtAssign) {
           }
         }
       }
-  }
-
-  while (const CFGBlock *block = worklist.dequeue()) {
-    // Determine if the block's end value has changed.  If not, we
-    // have nothing left to do for this block.
-    LivenessValues &prevVal = LV->blocksEndToLiveness[block];
-
-    // Merge the values of all successor blocks.
-    LivenessValues val;
-    for (CFGBlock::const_succ_iterator it = block->succ_begin(),
-                                       ei = block->succ_end(); it != ei; ++it) {
-      if (const CFGBlock *succ = *it) {
-        val = LV->merge(val, LV->blocksBeginToLiveness[succ]);
-      }
-    }
-
-    if (!everAnalyzedBlock[block->getBlockID()])
-      everAnalyzedBlock[block->getBlockID()] = true;
-    else if (prevVal.equals(val))
-      continue;
 
-    prevVal = val;
+  // Solve the liveness of the facts live at the entry of some block, with
+  // the effect of each block computed once.
+  std::vector<BlockGenKill> genKill = LV->computeGenKill(*cfg);
+  BitVectorDataflow<dataflow::backward_analysis_tag> dataflow(
+      *cfg, AC, LV->trackedFacts.size());
+  for (const CFGBlock *block : *cfg)
+    dataflow.enqueueBlock(block);
+  dataflow.solve([&](const CFGBlock *block, llvm::BitVector &val) {
+    const BlockGenKill &blockGenKill = genKill[block->getBlockID()];
+    for (unsigned index : blockGenKill.Kill)
+      val.reset(index);
+    for (unsigned index : blockGenKill.Gen)
+      val.set(index);
+  });
 
-    // Update the dataflow value for the start of this block.
+  // Record the live sets at the exit of each block, and at each statement.
+  for (const CFGBlock *block : *cfg) {
+    LivenessValues val = LV->getLivenessValues(dataflow.getIn(block));
+    LV->blocksEndToLiveness[block] = val;
     LV->blocksBeginToLiveness[block] = LV->runOnBlock(block, val);
-
-    // Enqueue the value to the predecessors.
-    worklist.enqueuePredecessors(block);
   }
 
   return std::unique_ptr<LiveVariables>(new LiveVariables(LV));
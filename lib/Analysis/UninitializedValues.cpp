@@ -24,23 +24,20 @@
 #include "latino/Analysis/AnalysisDeclContext.h"
 #include "latino/Analysis/CFG.h"
 // #include "latino/Analysis/DomainSpecific/ObjCNoReturn.h"
-#include "latino/Analysis/FlowSensitive/DataflowWorklist.h"
+#include "latino/Analysis/FlowSensitive/BitVectorDataflow.h"
 #include "latino/Basic/LLVM.h"
 #include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/None.h"
 #include "llvm/ADT/Optional.h"
-#include "llvm/ADT/PackedVector.h"
-#include "llvm/ADT/SmallBitVector.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Casting.h"
 #include <algorithm>
 #include <cassert>
+#include <memory>
 
 using namespace latino;
 
-#define DEBUG_LOGGING 0
-
 static bool isTrackedVar(const VarDecl *vd, const DeclContext *dc) {
   if (vd->isLocalVarDecl() && !vd->hasGlobalStorage() &&
       !vd->isExceptionVariable() && !vd->isInitCapture() &&
@@ -112,105 +109,94 @@ static bool isAlwaysUninit(const Value v) {
   return v == Uninitialized;
 }
 
+/// Each tracked variable takes two bits of the dataflow values, with the
+/// Initialized bit first.
+static Value getValueAt(const llvm::BitVector &bits, unsigned idx) {
+  return static_cast<Value>(bits[2 * idx] | (bits[2 * idx + 1] << 1));
+}
+
+static void setValueAt(llvm::BitVector &bits, unsigned idx, Value v) {
+  bits[2 * idx] = v & Initialized;
+  bits[2 * idx + 1] = v & Uninitialized;
+}
+
 namespace {
 
-using ValueVector = llvm::PackedVector<Value, 2, llvm::SmallBitVector>;
+using UninitValuesDataflow = BitVectorDataflow<dataflow::forward_analysis_tag>;
 
 class CFGBlockValues {
   const CFG &cfg;
-  SmallVector<ValueVector, 8> vals;
-  ValueVector scratch;
+  std::unique_ptr<UninitValuesDataflow> dataflow;
+  llvm::BitVector *scratch = nullptr;
   DeclToIndex declToIndex;
 
 public:
+  /// A reference to the value of a variable in the scratch values.
+  class reference {
+    llvm::BitVector &bits;
+    unsigned idx;
+
+  public:
+    reference(llvm::BitVector &bits, unsigned idx) : bits(bits), idx(idx) {}
+
+    operator Value() const { return getValueAt(bits, idx); }
+
+    reference &operator=(Value v) {
+      setValueAt(bits, idx, v);
+      return *this;
+    }
+  };
+
   CFGBlockValues(const CFG &cfg);
 
   unsigned getNumEntries() const { return declToIndex.size(); }
 
-  void computeSetOfDeclarations(const DeclContext &dc);
+  void computeSetOfDeclarations(const DeclContext &dc,
+                                AnalysisDeclContext &ac);
 
-  ValueVector &getValueVector(const CFGBlock *block) {
-    return vals[block->getBlockID()];
-  }
+  UninitValuesDataflow &getDataflow() { return *dataflow; }
+
+  /// Set the values the transfer functions read and update.
+  void setScratch(llvm::BitVector &values) { scratch = &values; }
 
   void setAllScratchValues(Value V);
-  void mergeIntoScratch(ValueVector const &source, bool isFirst);
-  bool updateValueVectorWithScratch(const CFGBlock *block);
 
   bool hasNoDeclarations() const {
     return declToIndex.size() == 0;
   }
 
-  void resetScratch();
-
-  ValueVector::reference operator[](const VarDecl *vd);
+  reference operator[](const VarDecl *vd);
 
   Value getValue(const CFGBlock *block, const CFGBlock *dstBlock,
                  const VarDecl *vd) {
     const Optional<unsigned> &idx = declToIndex.getValueIndex(vd);
     assert(idx.hasValue());
-    return getValueVector(block)[idx.getValue()];
+    return getValueAt(dataflow->getOut(block), idx.getValue());
   }
 };
 
 } // namespace
 
-CFGBlockValues::CFGBlockValues(const CFG &c) : cfg(c), vals(0) {}
+CFGBlockValues::CFGBlockValues(const CFG &c) : cfg(c) {}
 
-void CFGBlockValues::computeSetOfDeclarations(const DeclContext &dc) {
+void CFGBlockValues::computeSetOfDeclarations(const DeclContext &dc,
+                                              AnalysisDeclContext &ac) {
   declToIndex.computeMap(dc);
-  unsigned decls = declToIndex.size();
-  scratch.resize(decls);
-  unsigned n = cfg.getNumBlockIDs();
-  if (!n)
-    return;
-  vals.resize(n);
-  for (auto &val : vals)
-    val.resize(decls);
+  dataflow =
+      std::make_unique<UninitValuesDataflow>(cfg, ac, 2 * declToIndex.size());
 }
 
-#if DEBUG_LOGGING
-static void printVector(const CFGBlock *block, ValueVector &bv,
-                        unsigned num) {
-  llvm::errs() << block->getBlockID() << " :";
-  for (const auto &i : bv)
-    llvm::errs() << ' ' << i;
-  llvm::errs() << " : " << num << '\n';
-}
-#endif
-
 void CFGBlockValues::setAllScratchValues(Value V) {
-  for (unsigned I = 0, E = scratch.size(); I != E; ++I)
-    scratch[I] = V;
-}
-
-void CFGBlockValues::mergeIntoScratch(ValueVector const &source,
-                                      bool isFirst) {
-  if (isFirst)
-    scratch = source;
-  else
-    scratch |= source;
-}
-
-bool CFGBlockValues::updateValueVectorWithScratch(const CFGBlock *block) {
-  ValueVector &dst = getValueVector(block);
-  bool changed = (dst != scratch);
-  if (changed)
-    dst = scratch;
-#if DEBUG_LOGGING
-  printVector(block, scratch, 0);
-#endif
-  return changed;
-}
-
-void CFGBlockValues::resetScratch() {
-  scratch.reset();
+  assert(scratch && "No values to update");
+  for (unsigned I = 0, E = getNumEntries(); I != E; ++I)
+    setValueAt(*scratch, I, V);
 }
 
-ValueVector::reference CFGBlockValues::operator[](const VarDecl *vd) {
+CFGBlockValues::reference CFGBlockValues::operator[](const VarDecl *vd) {
+  assert(scratch && "No values to update");
   const Optional<unsigned> &idx = declToIndex.getValueIndex(vd);
   assert(idx.hasValue());
-  return scratch[idx.getValue()];
+  return reference(*scratch, idx.getValue());
 }
 
 //------------------------------------------------------------------------====//
@@ -831,25 +817,14 @@ void TransferFunctions::VisitGCCAsmStmt(GCCAsmStmt *as) {
 // High-level "driver" logic for uninitialized values analysis.
 //====------------------------------------------------------------------------//
 
-static bool runOnBlock(const CFGBlock *block, const CFG &cfg,
+/// Turn \p values, the values at the entry of \p block, into those at its
+/// exit.
+static void runOnBlock(const CFGBlock *block, const CFG &cfg,
                        AnalysisDeclContext &ac, CFGBlockValues &vals,
                        const ClassifyRefs &classification,
-                       llvm::BitVector &wasAnalyzed,
+                       llvm::BitVector &values,
                        UninitVariablesHandler &handler) {
-  wasAnalyzed[block->getBlockID()] = true;
-  vals.resetScratch();
-  // Merge in values of predecessor blocks.
-  bool isFirst = true;
-  for (CFGBlock::const_pred_iterator I = block->pred_begin(),
-       E = block->pred_end(); I != E; ++I) {
-    const CFGBlock *pred = *I;
-    if (!pred)
-      continue;
-    if (wasAnalyzed[pred->getBlockID()]) {
-      vals.mergeIntoScratch(vals.getValueVector(pred), isFirst);
-      isFirst = false;
-    }
-  }
+  vals.setScratch(values);
   // Apply the transfer function.
   TransferFunctions tf(vals, cfg, block, ac, classification, handler);
   for (const auto &I : *block) {
@@ -860,7 +835,6 @@ static bool runOnBlock(const CFGBlock *block, const CFG &cfg,
   if (auto *as = dyn_cast_or_null<GCCAsmStmt>(terminator.getStmt()))
     if (as->isAsmGoto())
       tf.Visit(as);
-  return vals.updateValueVectorWithScratch(block);
 }
 
 namespace {
@@ -913,7 +887,7 @@ void latino::runUninitializedVariablesAnalysis(
     UninitVariablesHandler &handler,
     UninitVariablesAnalysisStats &stats) {
   CFGBlockValues vals(cfg);
-  vals.computeSetOfDeclarations(dc);
+  vals.computeSetOfDeclarations(dc, ac);
   if (vals.hasNoDeclarations())
     return;
 
@@ -924,40 +898,33 @@ void latino::runUninitializedVariablesAnalysis(
   cfg.VisitBlockStmts(classification);
 
   // Mark all variables uninitialized at the entry.
+  UninitValuesDataflow &dataflow = vals.getDataflow();
   const CFGBlock &entry = cfg.getEntry();
-  ValueVector &vec = vals.getValueVector(&entry);
+  llvm::BitVector entryValues(dataflow.getNumBits());
   const unsigned n = vals.getNumEntries();
-  for (unsigned j = 0; j < n; ++j) {
-    vec[j] = Uninitialized;
-  }
+  for (unsigned j = 0; j < n; ++j)
+    setValueAt(entryValues, j, Uninitialized);
+  dataflow.setOut(&entry, entryValues);
 
-  // Proceed with the workist.
-  ForwardDataflowWorklist worklist(cfg, ac);
-  llvm::BitVector previouslyVisited(cfg.getNumBlockIDs());
-  worklist.enqueueSuccessors(&cfg.getEntry());
-  llvm::BitVector wasAnalyzed(cfg.getNumBlockIDs(), false);
-  wasAnalyzed[cfg.getEntry().getBlockID()] = true;
+  // Proceed with the workist. Only the blocks reachable from the entry are
+  // analyzed.
+  dataflow.enqueueFlowSuccessors(&entry);
   PruneBlocksHandler PBH(cfg.getNumBlockIDs());
-
-  while (const CFGBlock *block = worklist.dequeue()) {
+  dataflow.solve([&](const CFGBlock *block, llvm::BitVector &values) {
     PBH.currentBlock = block->getBlockID();
-
-    // Did the block change?
-    bool changed = runOnBlock(block, cfg, ac, vals,
-                              classification, wasAnalyzed, PBH);
-    ++stats.NumBlockVisits;
-    if (changed || !previouslyVisited[block->getBlockID()])
-      worklist.enqueueSuccessors(block);
-    previouslyVisited[block->getBlockID()] = true;
-  }
+    runOnBlock(block, cfg, ac, vals, classification, values, PBH);
+  });
+  stats.NumBlockVisits += dataflow.getNumBlockVisits();
 
   if (!PBH.hadAnyUse)
     return;
 
   // Run through the blocks one more time, and report uninitialized variables.
+  llvm::BitVector values;
   for (const auto *block : cfg)
     if (PBH.hadUse[block->getBlockID()]) {
-      runOnBlock(block, cfg, ac, vals, classification, wasAnalyzed, handler);
+      values = dataflow.getIn(block);
+      runOnBlock(block, cfg, ac, vals, classification, values, handler);
       ++stats.NumBlockVisits;
     }
 }
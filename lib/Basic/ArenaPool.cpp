@@ -0,0 +1,108 @@
+//===- ArenaPool.cpp - Slab pool shared by bump allocators ----------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the ArenaPool class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/Basic/ArenaPool.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace latino;
+
+/// Whether slabs of the given size and alignment are kept for reuse. Bump
+/// allocators grow their slabs in powers of two, so only those sizes recur;
+/// other sizes come from single oversized allocations.
+static bool isPoolable(size_t Size, size_t Alignment) {
+  return llvm::isPowerOf2_64(Size) && Alignment <= alignof(std::max_align_t);
+}
+
+ArenaPool::~ArenaPool() { trim(); }
+
+void *ArenaPool::allocateSlab(size_t Size, size_t Alignment) {
+  {
+    std::lock_guard<std::mutex> Guard(Lock);
+    BytesInUse += Size;
+    PeakBytesInUse = std::max(PeakBytesInUse, BytesInUse);
+
+    if (isPoolable(Size, Alignment)) {
+      auto Free = FreeSlabs.find(Size);
+      if (Free != FreeSlabs.end() && !Free->second.empty()) {
+        PooledBytes -= Size;
+        ++NumSlabsReused;
+        return Free->second.pop_back_val();
+      }
+    }
+    ++NumSlabsAllocated;
+  }
+
+  if (isPoolable(Size, Alignment))
+    Alignment = alignof(std::max_align_t);
+  return llvm::allocate_buffer(Size, Alignment);
+}
+
+void ArenaPool::releaseSlab(void *Slab, size_t Size, size_t Alignment) {
+  {
+    std::lock_guard<std::mutex> Guard(Lock);
+    BytesInUse -= Size;
+    if (isPoolable(Size, Alignment) && PooledBytes + Size <= MaxPooledBytes) {
+      FreeSlabs[Size].push_back(Slab);
+      PooledBytes += Size;
+      return;
+    }
+  }
+
+  if (isPoolable(Size, Alignment))
+    Alignment = alignof(std::max_align_t);
+  llvm::deallocate_buffer(Slab, Size, Alignment);
+}
+
+void ArenaPool::trim() {
+  std::lock_guard<std::mutex> Guard(Lock);
+  for (auto &Free : FreeSlabs)
+    for (void *Slab : Free.second)
+      llvm::deallocate_buffer(Slab, Free.first, alignof(std::max_align_t));
+  FreeSlabs.clear();
+  PooledBytes = 0;
+}
+
+size_t ArenaPool::getBytesInUse() const {
+  std::lock_guard<std::mutex> Guard(Lock);
+  return BytesInUse;
+}
+
+size_t ArenaPool::getPeakBytesInUse() const {
+  std::lock_guard<std::mutex> Guard(Lock);
+  return PeakBytesInUse;
+}
+
+size_t ArenaPool::getPooledBytes() const {
+  std::lock_guard<std::mutex> Guard(Lock);
+  return PooledBytes;
+}
+
+uint64_t ArenaPool::getNumSlabsAllocated() const {
+  std::lock_guard<std::mutex> Guard(Lock);
+  return NumSlabsAllocated;
+}
+
+uint64_t ArenaPool::getNumSlabsReused() const {
+  std::lock_guard<std::mutex> Guard(Lock);
+  return NumSlabsReused;
+}
+
+void ArenaPool::PrintStats() const {
+  std::lock_guard<std::mutex> Guard(Lock);
+  llvm::errs() << "\n*** Arena Pool Stats:\n";
+  llvm::errs() << BytesInUse << " bytes in use, " << PeakBytesInUse
+               << " bytes at peak, " << PooledBytes << " bytes pooled.\n";
+  llvm::errs() << NumSlabsAllocated << " slabs allocated, " << NumSlabsReused
+               << " slabs reused.\n";
+}
@@ -549,6 +549,13 @@ void FileManager::GetUniqueIDMapping(
     UIDToFiles[VFE->getUID()] = VFE.get();
 }
 
+void FileManager::GetSeenPaths(SmallVectorImpl<StringRef> &Paths) const {
+  for (const auto &Dir : SeenDirEntries)
+    Paths.push_back(Dir.getKey());
+  for (const auto &File : SeenFileEntries)
+    Paths.push_back(File.getKey());
+}
+
 StringRef FileManager::getCanonicalName(const DirectoryEntry *Dir) {
   llvm::DenseMap<const void *, llvm::StringRef>::iterator Known
     = CanonicalNames.find(Dir);
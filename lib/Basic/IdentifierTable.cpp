@@ -20,12 +20,16 @@
 #include "latino/Basic/TokenKinds.h"
 #include "llvm/ADT/DenseMapInfo.h"
 #include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <cstring>
@@ -229,6 +233,100 @@ void IdentifierTable::AddKeywords(const LangOptions &LangOpts) {
 
   // Add the 'import' contextual keyword.
   get("import").setModulesImport(true);
+
+  buildKeywordHash();
+}
+
+/// buildKeywordHash - Build a perfect hash over the keywords currently in the
+/// table, using hash-and-displace: keys are grouped into buckets by their
+/// hash, and each bucket, largest first, is given the smallest displacement
+/// that places all of its keys in free slots.
+void IdentifierTable::buildKeywordHash() {
+  KeywordDisplacements.clear();
+  KeywordSlots.clear();
+  KeywordLengths = 0;
+
+  SmallVector<IdentifierInfo *, 256> Keywords;
+  for (auto &Entry : HashTable) {
+    IdentifierInfo *II = Entry.second;
+    if (II && II->getTokenID() != tok::identifier && II->getLength() < 64)
+      Keywords.push_back(II);
+  }
+  if (Keywords.empty())
+    return;
+
+  unsigned NumBuckets =
+      llvm::PowerOf2Ceil(std::max<size_t>(Keywords.size() / 2, 1));
+  unsigned NumSlots = llvm::PowerOf2Ceil(Keywords.size() * 2);
+  SmallVector<SmallVector<IdentifierInfo *, 4>, 0> Buckets(NumBuckets);
+  for (IdentifierInfo *II : Keywords)
+    Buckets[getKeywordHash(II->getName()) & (NumBuckets - 1)].push_back(II);
+
+  SmallVector<unsigned, 0> Order(NumBuckets);
+  for (unsigned I = 0; I != NumBuckets; ++I)
+    Order[I] = I;
+  llvm::stable_sort(Order, [&](unsigned A, unsigned B) {
+    return Buckets[A].size() > Buckets[B].size();
+  });
+
+  SmallVector<uint16_t, 0> Displacements(NumBuckets, 0);
+  SmallVector<IdentifierInfo *, 0> Slots(NumSlots, nullptr);
+  SmallVector<unsigned, 4> Placed;
+  for (unsigned B : Order) {
+    if (Buckets[B].empty())
+      break;
+    bool Found = false;
+    for (unsigned D = 0; D != 0x10000 && !Found; ++D) {
+      Placed.clear();
+      Found = true;
+      for (IdentifierInfo *II : Buckets[B]) {
+        unsigned Slot =
+            getKeywordSlot(getKeywordHash(II->getName()), D) & (NumSlots - 1);
+        if (Slots[Slot] || llvm::is_contained(Placed, Slot)) {
+          Found = false;
+          break;
+        }
+        Placed.push_back(Slot);
+      }
+      if (Found) {
+        Displacements[B] = D;
+        for (unsigned I = 0, E = Placed.size(); I != E; ++I)
+          Slots[Placed[I]] = Buckets[B][I];
+      }
+    }
+    // Two keywords share the hashed key; keep using the string map only.
+    if (!Found)
+      return;
+  }
+
+  for (IdentifierInfo *II : Keywords)
+    KeywordLengths |= uint64_t(1) << II->getLength();
+  KeywordDisplacements = std::move(Displacements);
+  KeywordSlots = std::move(Slots);
+}
+
+void IdentifierTable::reserve(unsigned NumIdentifiers) {
+  // StringMap grows once it is three quarters full.
+  if (uint64_t(NumIdentifiers) * 4 < uint64_t(HashTable.getNumBuckets()) * 3)
+    return;
+
+  // Move the existing entries, which own the identifier names and are what
+  // IdentifierInfo::Entry points to, into a larger table.  Entries are never
+  // reallocated, only rehashed, so every IdentifierInfo stays valid.
+  SmallVector<HashTableTy::MapEntryTy *, 0> Entries;
+  Entries.reserve(HashTable.size());
+  for (auto &Entry : HashTable)
+    Entries.push_back(&Entry);
+
+  HashTableTy NewTable(NumIdentifiers);
+  for (HashTableTy::MapEntryTy *Entry : Entries) {
+    HashTable.remove(Entry);
+    NewTable.insert(Entry);
+  }
+  // The entries and IdentifierInfos live in the old allocator; hand it over
+  // along with them.
+  std::swap(NewTable.getAllocator(), HashTable.getAllocator());
+  HashTable = std::move(NewTable);
 }
 
 /// Checks if the specified token kind represents a keyword in the
@@ -306,8 +404,10 @@ tok::PPKeywordKind IdentifierInfo::getPPKeywordID() const {
 
   // CASE( 7, 'd', 'f', defined);
   // CASE( 7, 'i', 'c', include);
+  CASE( 7, 'i', 'c', incluir);
   // CASE( 7, 'w', 'r', warning);
 
+  CASE( 8, 'i', 'p', importar);
   // CASE( 8, 'u', 'a', unassert);
   // CASE(12, 'i', 'c', include_next);
 
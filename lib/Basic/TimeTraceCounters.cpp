@@ -0,0 +1,155 @@
+//===- TimeTraceCounters.cpp - Counter events for -ftime-trace ------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the counters recorded alongside the time trace.
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/Basic/TimeTraceCounters.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace latino;
+
+namespace {
+
+using ClockType = std::chrono::steady_clock;
+
+struct CounterSample {
+  /// Microseconds since the start of the trace.
+  int64_t Time;
+  /// The values, in the order of the counter's ValueNames.
+  SmallVector<uint64_t, 2> Values;
+};
+
+struct Counter {
+  std::string Name;
+  SmallVector<std::string, 2> ValueNames;
+  std::vector<CounterSample> Samples;
+};
+
+struct TimeTraceCounters {
+  TimeTraceCounters(unsigned Granularity)
+      : StartTime(ClockType::now()), Granularity(Granularity),
+        Tid(llvm::get_threadid()) {}
+
+  void record(StringRef Name, ArrayRef<TimeTraceCounterValue> Values) {
+    int64_t Time = std::chrono::duration_cast<std::chrono::microseconds>(
+                       ClockType::now() - StartTime)
+                       .count();
+
+    auto Inserted = CounterIndex.try_emplace(Name, Counters.size());
+    if (Inserted.second) {
+      Counters.emplace_back();
+      Counters.back().Name = std::string(Name);
+    }
+    Counter &C = Counters[Inserted.first->second];
+
+    // Keep the samples at least Granularity apart, except for the last one,
+    // which always holds the latest values.
+    size_t NumSamples = C.Samples.size();
+    if (NumSamples < 2 || Time - C.Samples[NumSamples - 2].Time >= Granularity)
+      C.Samples.push_back({Time, {}});
+    CounterSample &Sample = C.Samples.back();
+    Sample.Time = Time;
+    Sample.Values.assign(C.ValueNames.size(), 0);
+
+    for (const TimeTraceCounterValue &Value : Values) {
+      auto I = llvm::find(C.ValueNames, Value.first);
+      if (I == C.ValueNames.end()) {
+        C.ValueNames.push_back(std::string(Value.first));
+        Sample.Values.push_back(0);
+        I = C.ValueNames.end() - 1;
+      }
+      Sample.Values[I - C.ValueNames.begin()] = Value.second;
+    }
+  }
+
+  void addEvents(llvm::json::Array &Events) const {
+    for (const Counter &C : Counters) {
+      for (const CounterSample &Sample : C.Samples) {
+        llvm::json::Object Args;
+        for (unsigned I = 0, E = Sample.Values.size(); I != E; ++I)
+          Args[C.ValueNames[I]] = int64_t(Sample.Values[I]);
+        Events.push_back(llvm::json::Object{{"pid", 1},
+                                            {"tid", int64_t(Tid)},
+                                            {"ph", "C"},
+                                            {"ts", Sample.Time},
+                                            {"name", C.Name},
+                                            {"args", std::move(Args)}});
+      }
+    }
+  }
+
+  const ClockType::time_point StartTime;
+  const int64_t Granularity;
+  const uint64_t Tid;
+  std::vector<Counter> Counters;
+  llvm::StringMap<unsigned> CounterIndex;
+};
+
+} // namespace
+
+static LLVM_THREAD_LOCAL TimeTraceCounters *CountersInstance = nullptr;
+
+void latino::timeTraceCountersInitialize(unsigned TimeTraceGranularity) {
+  assert(!CountersInstance && "Counters should not be initialized twice");
+  CountersInstance = new TimeTraceCounters(TimeTraceGranularity);
+}
+
+void latino::timeTraceCountersCleanup() {
+  delete CountersInstance;
+  CountersInstance = nullptr;
+}
+
+bool latino::timeTraceCountersEnabled() { return CountersInstance != nullptr; }
+
+void latino::timeTraceCounter(StringRef Name,
+                              ArrayRef<TimeTraceCounterValue> Values) {
+  if (CountersInstance)
+    CountersInstance->record(Name, Values);
+}
+
+void latino::timeTraceCountersWrite(llvm::raw_pwrite_stream &OS) {
+  if (!CountersInstance || CountersInstance->Counters.empty())
+    return llvm::timeTraceProfilerWrite(OS);
+
+  // The profiler writes its events straight to a stream, so add the counter
+  // events to what it wrote.
+  SmallString<0> Buffer;
+  llvm::raw_svector_ostream BufferOS(Buffer);
+  llvm::timeTraceProfilerWrite(BufferOS);
+
+  llvm::Expected<llvm::json::Value> Trace = llvm::json::parse(Buffer);
+  if (!Trace) {
+    llvm::consumeError(Trace.takeError());
+    OS << Buffer;
+    return;
+  }
+  llvm::json::Object *Root = Trace->getAsObject();
+  llvm::json::Array *Events = Root ? Root->getArray("traceEvents") : nullptr;
+  if (!Events) {
+    OS << Buffer;
+    return;
+  }
+
+  CountersInstance->addEvents(*Events);
+  OS << *Trace;
+}
@@ -45,6 +45,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/ToolOutputFile.h"
@@ -76,11 +77,16 @@
 #include "llvm/Transforms/Scalar/GVN.h"
 #include "llvm/Transforms/Utils.h"
 #include "llvm/Transforms/Utils/CanonicalizeAliases.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/EntryExitInstrumenter.h"
 #include "llvm/Transforms/Utils/NameAnonGlobals.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "llvm/Transforms/Utils/SymbolRewriter.h"
 #include "llvm/Transforms/Utils/UniqueInternalLinkageNames.h"
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <string>
 using namespace latino;
 using namespace llvm;
 
@@ -130,6 +136,20 @@ class EmitAssemblyHelper {
   bool AddEmitPasses(legacy::PassManager &CodeGenPasses, BackendAction Action,
                      raw_pwrite_stream &OS, raw_pwrite_stream *DwoOS);
 
+  /// Whether code generation is split into partitions that run in parallel.
+  bool usesParallelCodeGen(BackendAction Action) const {
+    return Action == Backend_EmitObj &&
+           !CodeGenOpts.ParallelCodeGenOutputs.empty() &&
+           CodeGenOpts.SplitDwarfOutput.empty();
+  }
+
+  /// Split the optimized module into partitions and generate an object file
+  /// for each of them in parallel. Partition 0 is written to \p OS and the
+  /// others to the files in CodeGenOptions::ParallelCodeGenOutputs.
+  ///
+  /// \return True on success.
+  bool EmitPartitions(raw_pwrite_stream &OS);
+
   std::unique_ptr<llvm::ToolOutputFile> openOutputFile(StringRef Path) {
     std::error_code EC;
     auto F = std::make_unique<llvm::ToolOutputFile>(Path, EC,
@@ -797,6 +817,10 @@ static void setCommandLineOpts(const CodeGenOptions &CodeGenOpts) {
     BackendArgs.push_back("-limit-float-precision");
     BackendArgs.push_back(CodeGenOpts.LimitFloatPrecision.c_str());
   }
+  // The options are process-wide, and other in-process invocations may be
+  // using them, so leave them alone unless there is something to set.
+  if (BackendArgs.size() == 1)
+    return;
   BackendArgs.push_back(nullptr);
   llvm::cl::ParseCommandLineOptions(BackendArgs.size() - 1,
                                     BackendArgs.data());
@@ -854,6 +878,100 @@ bool EmitAssemblyHelper::AddEmitPasses(legacy::PassManager &CodeGenPasses,
   return true;
 }
 
+bool EmitAssemblyHelper::EmitPartitions(raw_pwrite_stream &OS) {
+  SmallVector<raw_pwrite_stream *, 8> OSs = {&OS};
+  std::vector<std::unique_ptr<llvm::ToolOutputFile>> PartitionFiles;
+  for (const std::string &Path : CodeGenOpts.ParallelCodeGenOutputs) {
+    PartitionFiles.push_back(openOutputFile(Path));
+    if (!PartitionFiles.back())
+      return false;
+    OSs.push_back(&PartitionFiles.back()->os());
+  }
+
+  // Keep local symbols in the partition of their users, so that splitting
+  // does not make them visible outside the object file. The partitioning
+  // depends only on the module, which keeps the output deterministic. Each
+  // partition is handed over as bitcode, because the thread generating its
+  // code needs an LLVMContext of its own.
+  SmallVector<SmallString<0>, 8> Partitions;
+  {
+    llvm::TimeTraceScope TimeScope("SplitModule");
+    SplitModule(CloneModule(*TheModule), OSs.size(),
+                [&](std::unique_ptr<Module> MPart) {
+                  Partitions.emplace_back();
+                  raw_svector_ostream BCOS(Partitions.back());
+                  WriteBitcodeToFile(*MPart, BCOS);
+                },
+                /*PreserveLocals=*/true);
+  }
+
+  // The worker threads cannot use the diagnostics engine, so they only
+  // record what went wrong.
+  std::atomic<bool> Failed(false);
+  std::mutex ReadErrorMutex;
+  std::string ReadError;
+  {
+    ThreadPool Pool(hardware_concurrency(OSs.size()));
+    for (unsigned I = 0, E = OSs.size(); I != E; ++I) {
+      Pool.async([&, I] {
+        LLVMContext Ctx;
+        Expected<std::unique_ptr<Module>> MOrErr = parseBitcodeFile(
+            MemoryBufferRef(StringRef(Partitions[I].data(),
+                                      Partitions[I].size()),
+                            "<partition>"),
+            Ctx);
+        if (!MOrErr) {
+          std::string Message = toString(MOrErr.takeError());
+          std::lock_guard<std::mutex> Guard(ReadErrorMutex);
+          if (ReadError.empty())
+            ReadError = std::move(Message);
+          return;
+        }
+        std::unique_ptr<Module> MPart = std::move(*MOrErr);
+
+        // Target machines are not thread-safe, so each partition gets its
+        // own, configured like the one used for optimization.
+        std::unique_ptr<TargetMachine> PartTM(
+            TM->getTarget().createTargetMachine(
+                TM->getTargetTriple().str(), TM->getTargetCPU(),
+                TM->getTargetFeatureString(), TM->Options,
+                TM->getRelocationModel(), TM->getCodeModel(),
+                TM->getOptLevel()));
+
+        legacy::PassManager CodeGenPasses;
+        CodeGenPasses.add(createTargetTransformInfoWrapperPass(
+            PartTM->getTargetIRAnalysis()));
+        llvm::Triple TargetTriple(MPart->getTargetTriple());
+        std::unique_ptr<TargetLibraryInfoImpl> TLII(
+            createTLII(TargetTriple, CodeGenOpts));
+        CodeGenPasses.add(new TargetLibraryInfoWrapperPass(*TLII));
+        if (CodeGenOpts.OptimizationLevel > 0)
+          CodeGenPasses.add(createObjCARCContractPass());
+        if (PartTM->addPassesToEmitFile(
+                CodeGenPasses, *OSs[I], /*DwoOut=*/nullptr, CGFT_ObjectFile,
+                /*DisableVerify=*/!CodeGenOpts.VerifyModule)) {
+          Failed = true;
+          return;
+        }
+        CodeGenPasses.run(*MPart);
+      });
+    }
+  }
+
+  if (!ReadError.empty()) {
+    Diags.Report(diag::err_fe_error_backend)
+        << "cannot read a code generation partition: " + ReadError;
+    return false;
+  }
+  if (Failed) {
+    Diags.Report(diag::err_fe_unable_to_interface_with_target);
+    return false;
+  }
+  for (std::unique_ptr<llvm::ToolOutputFile> &File : PartitionFiles)
+    File->keep();
+  return true;
+}
+
 void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
                                       std::unique_ptr<raw_pwrite_stream> OS) {
   TimeRegion Region(FrontendTimesIsEnabled ? &CodeGenerationTime : nullptr);
@@ -927,6 +1045,9 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
     break;
 
   default:
+    // The partitions get their own code generation passes.
+    if (usesParallelCodeGen(Action))
+      break;
     if (!CodeGenOpts.SplitDwarfOutput.empty()) {
       DwoOS = openOutputFile(CodeGenOpts.SplitDwarfOutput);
       if (!DwoOS)
@@ -963,7 +1084,12 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
   {
     PrettyStackTraceString CrashInfo("Code generation");
     llvm::TimeTraceScope TimeScope("CodeGenPasses");
-    CodeGenPasses.run(*TheModule);
+    if (usesParallelCodeGen(Action)) {
+      if (!EmitPartitions(*OS))
+        return;
+    } else {
+      CodeGenPasses.run(*TheModule);
+    }
   }
 
   if (ThinLinkOS)
@@ -1426,6 +1552,9 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
   case Backend_EmitMCNull:
   case Backend_EmitObj:
     NeedCodeGen = true;
+    // The partitions get their own code generation passes.
+    if (usesParallelCodeGen(Action))
+      break;
     CodeGenPasses.add(
         createTargetTransformInfoWrapperPass(getTargetIRAnalysis()));
     if (!CodeGenOpts.SplitDwarfOutput.empty()) {
@@ -1452,7 +1581,12 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
   // Now if needed, run the legacy PM for codegen.
   if (NeedCodeGen) {
     PrettyStackTraceString CrashInfo("Code generation");
-    CodeGenPasses.run(*TheModule);
+    if (usesParallelCodeGen(Action)) {
+      if (!EmitPartitions(*OS))
+        return;
+    } else {
+      CodeGenPasses.run(*TheModule);
+    }
   }
 
   if (ThinLinkOS)
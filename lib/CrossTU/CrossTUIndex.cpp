@@ -0,0 +1,210 @@
+//===--- CrossTUIndex.cpp - Binary index of external definitions ----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+//  The binary index starts with a header:
+//
+//    char     Magic[8];     "CTUIDX01"
+//    uint32_t TableOffset;  The offset of the buckets of the hash table.
+//    uint32_t NumEntries;
+//
+//  which is followed by the OnDiskChainedHashTable. Each entry holds the
+//  lengths of the lookup name and of the path as 32-bit integers, then the
+//  lookup name and the path. All integers are little-endian.
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/CrossTU/CrossTUIndex.h"
+#include "latino/CrossTU/CrossTranslationUnit.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/DJB.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/OnDiskHashTable.h"
+#include "llvm/Support/raw_ostream.h"
+#include <fstream>
+
+using namespace latino;
+using namespace cross_tu;
+
+static const char IndexMagic[] = {'C', 'T', 'U', 'I', 'D', 'X', '0', '1'};
+static const unsigned HeaderSize = sizeof(IndexMagic) + 2 * sizeof(uint32_t);
+
+namespace {
+
+class IndexWriterTrait {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef StringRef data_type;
+  typedef StringRef data_type_ref;
+  typedef uint32_t hash_value_type;
+  typedef uint32_t offset_type;
+
+  static hash_value_type ComputeHash(key_type_ref Key) {
+    return llvm::djbHash(Key);
+  }
+
+  std::pair<offset_type, offset_type>
+  EmitKeyDataLength(raw_ostream &Out, key_type_ref Key, data_type_ref Data) {
+    using namespace llvm::support;
+    endian::Writer LE(Out, little);
+    LE.write<uint32_t>(Key.size());
+    LE.write<uint32_t>(Data.size());
+    return std::make_pair(Key.size(), Data.size());
+  }
+
+  void EmitKey(raw_ostream &Out, key_type_ref Key, offset_type KeyLen) {
+    Out.write(Key.data(), KeyLen);
+  }
+
+  void EmitData(raw_ostream &Out, key_type_ref Key, data_type_ref Data,
+                offset_type DataLen) {
+    Out.write(Data.data(), DataLen);
+  }
+};
+
+class IndexReaderTrait {
+public:
+  typedef StringRef external_key_type;
+  typedef StringRef internal_key_type;
+  typedef StringRef data_type;
+  typedef uint32_t hash_value_type;
+  typedef uint32_t offset_type;
+
+  static bool EqualKey(internal_key_type A, internal_key_type B) {
+    return A == B;
+  }
+
+  static hash_value_type ComputeHash(internal_key_type Key) {
+    return llvm::djbHash(Key);
+  }
+
+  static internal_key_type GetInternalKey(external_key_type Key) {
+    return Key;
+  }
+
+  static external_key_type GetExternalKey(internal_key_type Key) {
+    return Key;
+  }
+
+  static std::pair<offset_type, offset_type>
+  ReadKeyDataLength(const unsigned char *&D) {
+    using namespace llvm::support;
+    offset_type KeyLen = endian::readNext<uint32_t, little, unaligned>(D);
+    offset_type DataLen = endian::readNext<uint32_t, little, unaligned>(D);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static internal_key_type ReadKey(const unsigned char *D, offset_type Len) {
+    return StringRef(reinterpret_cast<const char *>(D), Len);
+  }
+
+  static data_type ReadData(internal_key_type Key, const unsigned char *D,
+                            offset_type Len) {
+    return StringRef(reinterpret_cast<const char *>(D), Len);
+  }
+};
+
+} // end anonymous namespace
+
+class BinaryCrossTUIndex::Table
+    : public llvm::OnDiskChainedHashTable<IndexReaderTrait> {
+public:
+  using OnDiskChainedHashTable::OnDiskChainedHashTable;
+};
+
+BinaryCrossTUIndex::BinaryCrossTUIndex(
+    std::unique_ptr<llvm::MemoryBuffer> Buffer,
+    std::unique_ptr<Table> Definitions)
+    : Buffer(std::move(Buffer)), Definitions(std::move(Definitions)) {}
+
+BinaryCrossTUIndex::~BinaryCrossTUIndex() = default;
+
+bool BinaryCrossTUIndex::isBinaryIndex(StringRef IndexPath) {
+  std::ifstream File(std::string(IndexPath), std::ios::binary);
+  char Magic[sizeof(IndexMagic)];
+  return File.read(Magic, sizeof(Magic)) &&
+         StringRef(Magic, sizeof(Magic)) ==
+             StringRef(IndexMagic, sizeof(IndexMagic));
+}
+
+llvm::Expected<std::unique_ptr<BinaryCrossTUIndex>>
+BinaryCrossTUIndex::create(StringRef IndexPath) {
+  // The index is never modified while it is in use, so it can be mapped.
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(IndexPath, /*FileSize=*/-1,
+                                  /*RequiresNullTerminator=*/false);
+  if (!Buffer)
+    return llvm::make_error<IndexError>(index_error_code::missing_index_file,
+                                        IndexPath.str());
+
+  StringRef Data = (*Buffer)->getBuffer();
+  if (Data.size() < HeaderSize ||
+      !Data.startswith(StringRef(IndexMagic, sizeof(IndexMagic))))
+    return llvm::make_error<IndexError>(index_error_code::invalid_index_format,
+                                        IndexPath.str());
+
+  using namespace llvm::support;
+  const auto *Base = reinterpret_cast<const unsigned char *>(Data.data());
+  uint32_t TableOffset =
+      endian::read<uint32_t, little, unaligned>(Base + sizeof(IndexMagic));
+  // The buckets are aligned, and hold at least their count and the number of
+  // entries.
+  if (TableOffset < HeaderSize || TableOffset % alignof(uint32_t) ||
+      TableOffset + 2 * sizeof(uint32_t) > Data.size())
+    return llvm::make_error<IndexError>(index_error_code::invalid_index_format,
+                                        IndexPath.str());
+
+  const unsigned char *Buckets = Base + TableOffset;
+  auto NumBucketsAndEntries = Table::readNumBucketsAndEntries(Buckets);
+  uint64_t NumBuckets = NumBucketsAndEntries.first;
+  if (!llvm::isPowerOf2_64(NumBuckets) ||
+      TableOffset + (NumBuckets + 2) * sizeof(uint32_t) > Data.size())
+    return llvm::make_error<IndexError>(index_error_code::invalid_index_format,
+                                        IndexPath.str());
+  auto Definitions = std::make_unique<Table>(NumBucketsAndEntries.first,
+                                             NumBucketsAndEntries.second,
+                                             Buckets, Base);
+  return std::unique_ptr<BinaryCrossTUIndex>(
+      new BinaryCrossTUIndex(std::move(*Buffer), std::move(Definitions)));
+}
+
+llvm::Optional<StringRef>
+BinaryCrossTUIndex::lookup(StringRef LookupName) const {
+  auto Found = Definitions->find(LookupName);
+  if (Found == Definitions->end())
+    return llvm::None;
+  return *Found;
+}
+
+unsigned BinaryCrossTUIndex::size() const {
+  return Definitions->getNumEntries();
+}
+
+void latino::cross_tu::writeBinaryCrossTUIndex(
+    const llvm::StringMap<std::string> &Index, raw_ostream &OS) {
+  llvm::OnDiskChainedHashTableGenerator<IndexWriterTrait> Generator;
+  for (const auto &Entry : Index)
+    Generator.insert(Entry.getKey(), Entry.getValue());
+
+  // The offsets in the table are relative to the start of the file, so emit
+  // the whole file into one buffer.
+  SmallString<4096> Buffer;
+  llvm::raw_svector_ostream Out(Buffer);
+  using namespace llvm::support;
+  endian::Writer LE(Out, little);
+  Out.write(IndexMagic, sizeof(IndexMagic));
+  LE.write<uint32_t>(0);
+  LE.write<uint32_t>(Index.size());
+  IndexWriterTrait Trait;
+  uint32_t TableOffset = Generator.Emit(Out, Trait);
+  endian::write32le(&Buffer[sizeof(IndexMagic)], TableOffset);
+
+  OS << Buffer;
+}
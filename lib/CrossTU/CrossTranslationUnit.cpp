@@ -26,6 +26,8 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/YAMLParser.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
@@ -55,6 +57,11 @@ STATISTIC(NumLangMismatch, "The # of language mismatches");
 STATISTIC(NumLangDialectMismatch, "The # of language dialect mismatches");
 STATISTIC(NumASTLoadThresholdReached,
           "The # of ASTs not loaded because of threshold");
+STATISTIC(NumASTsPrefetched, "The # of ASTs whose loading started early");
+STATISTIC(NumPrefetchedASTsUsed,
+          "The # of prefetched ASTs that were used for an import");
+STATISTIC(NumPrefetchedASTsDropped,
+          "The # of prefetched ASTs dropped to stay within the memory limit");
 
 // Same as Triple's equality operator, but we check a field only if that is
 // known in both instances.
@@ -369,7 +376,21 @@ CrossTranslationUnitContext::ASTUnitStorage::ASTUnitStorage(
              CI.getAnalyzerOpts()->CTUInvocationList),
       LoadGuard(CI.getASTContext().getLangOpts().CPlusPlus
                     ? CI.getAnalyzerOpts()->CTUImportCppThreshold
-                    : CI.getAnalyzerOpts()->CTUImportThreshold) {}
+                    : CI.getAnalyzerOpts()->CTUImportThreshold),
+      PrefetchMemoryLimit(
+          uint64_t(CI.getAnalyzerOpts()->CTUPrefetchMemoryLimit) << 20) {
+  if (unsigned Threads = CI.getAnalyzerOpts()->CTUPrefetchThreads)
+    PrefetchThreads = std::make_unique<llvm::ThreadPool>(
+        llvm::hardware_concurrency(Threads));
+}
+
+CrossTranslationUnitContext::ASTUnitStorage::~ASTUnitStorage() {
+  // Do not start the loads still queued.
+  for (auto &Entry : PrefetchedASTs)
+    *Entry.second.Cancelled = true;
+  if (PrefetchThreads)
+    PrefetchThreads->wait();
+}
 
 llvm::Expected<ASTUnit *>
 CrossTranslationUnitContext::ASTUnitStorage::getASTUnitForFile(
@@ -381,16 +402,20 @@ CrossTranslationUnitContext::ASTUnitStorage::getASTUnitForFile(
     // Do not load if the limit is reached.
     if (!LoadGuard) {
       ++NumASTLoadThresholdReached;
+      dropPrefetchedAST(FileName);
       return llvm::make_error<IndexError>(
           index_error_code::load_threshold_reached);
     }
 
-    auto LoadAttempt = Loader.load(FileName);
+    std::unique_ptr<ASTUnit> LoadedUnit = takePrefetchedAST(FileName);
+    if (!LoadedUnit) {
+      auto LoadAttempt = Loader.load(FileName);
 
-    if (!LoadAttempt)
-      return LoadAttempt.takeError();
+      if (!LoadAttempt)
+        return LoadAttempt.takeError();
 
-    std::unique_ptr<ASTUnit> LoadedUnit = std::move(LoadAttempt.get());
+      LoadedUnit = std::move(LoadAttempt.get());
+    }
 
     // Need the raw pointer and the unique_ptr as well.
     ASTUnit *Unit = LoadedUnit.get();
@@ -426,7 +451,8 @@ CrossTranslationUnitContext::ASTUnitStorage::getASTUnitForFunction(
       return std::move(IndexLoadError);
 
     // Check if there is and entry in the index for the function.
-    if (!NameFileMap.count(FunctionName)) {
+    llvm::Optional<StringRef> FileName = lookupIndex(FunctionName);
+    if (!FileName) {
       ++NumNotInOtherTU;
       return llvm::make_error<IndexError>(index_error_code::missing_definition);
     }
@@ -434,7 +460,7 @@ CrossTranslationUnitContext::ASTUnitStorage::getASTUnitForFunction(
     // Search in the index for the filename where the definition of FuncitonName
     // resides.
     if (llvm::Expected<ASTUnit *> FoundForFile =
-            getASTUnitForFile(NameFileMap[FunctionName], DisplayCTUProgress)) {
+            getASTUnitForFile(*FileName, DisplayCTUProgress)) {
 
       // Update the cache.
       NameASTUnitMap[FunctionName] = *FoundForFile;
@@ -454,13 +480,122 @@ CrossTranslationUnitContext::ASTUnitStorage::getFileForFunction(
     StringRef FunctionName, StringRef CrossTUDir, StringRef IndexName) {
   if (llvm::Error IndexLoadError = ensureCTUIndexLoaded(CrossTUDir, IndexName))
     return std::move(IndexLoadError);
-  return NameFileMap[FunctionName];
+  return std::string(lookupIndex(FunctionName).getValueOr(""));
+}
+
+llvm::Optional<StringRef>
+CrossTranslationUnitContext::ASTUnitStorage::lookupIndex(
+    StringRef FunctionName) const {
+  if (BinaryIndex)
+    return BinaryIndex->lookup(FunctionName);
+  auto IndexEntry = NameFileMap.find(FunctionName);
+  if (IndexEntry == NameFileMap.end())
+    return llvm::None;
+  return StringRef(IndexEntry->second);
+}
+
+void CrossTranslationUnitContext::ASTUnitStorage::prefetchFunctions(
+    ArrayRef<std::string> FunctionNames, StringRef CrossTUDir,
+    StringRef IndexName) {
+  if (!PrefetchThreads)
+    return;
+
+  // A missing or broken index is reported when a definition is looked up.
+  if (llvm::Error IndexLoadError =
+          ensureCTUIndexLoaded(CrossTUDir, IndexName)) {
+    llvm::consumeError(std::move(IndexLoadError));
+    return;
+  }
+
+  for (const std::string &FunctionName : FunctionNames) {
+    llvm::Optional<StringRef> IndexEntry = lookupIndex(FunctionName);
+    if (!IndexEntry)
+      continue;
+    StringRef FileName = *IndexEntry;
+    if (FileASTUnitMap.count(FileName))
+      continue;
+
+    // Requesting a file again makes it the most recently requested one.
+    auto Prefetched = PrefetchedASTs.find(FileName);
+    if (Prefetched != PrefetchedASTs.end()) {
+      PrefetchOrder.splice(PrefetchOrder.begin(), PrefetchOrder,
+                           Prefetched->second.OrderPos);
+      continue;
+    }
+
+    // Never load more units than the threshold would let be used.
+    if (PrefetchedASTs.size() >= LoadGuard.getNumRemaining())
+      return;
+
+    std::string Path = Loader.getPath(FileName);
+    uint64_t Size;
+    if (!ASTLoader::isDump(Path) || llvm::sys::fs::file_size(Path, Size) ||
+        Size > PrefetchMemoryLimit)
+      continue;
+
+    // Make room by dropping the least recently requested units.
+    while (PrefetchedBytes + Size > PrefetchMemoryLimit) {
+      dropPrefetchedAST(PrefetchOrder.back());
+      ++NumPrefetchedASTsDropped;
+    }
+
+    auto Result = std::make_shared<std::promise<std::unique_ptr<ASTUnit>>>();
+    auto Cancelled = std::make_shared<std::atomic<bool>>(false);
+    PrefetchOrder.push_front(std::string(FileName));
+    PrefetchedASTs[FileName] = {Result->get_future(), Cancelled, Size,
+                                PrefetchOrder.begin()};
+    PrefetchedBytes += Size;
+    ++NumASTsPrefetched;
+
+    PrefetchThreads->async([this, Path, Result, Cancelled] {
+      std::unique_ptr<ASTUnit> Unit;
+      if (!*Cancelled) {
+        if (LoadResultTy Loaded = Loader.loadFromDump(Path))
+          Unit = std::move(*Loaded);
+        else
+          llvm::consumeError(Loaded.takeError());
+      }
+      Result->set_value(std::move(Unit));
+    });
+  }
+}
+
+std::unique_ptr<ASTUnit>
+CrossTranslationUnitContext::ASTUnitStorage::takePrefetchedAST(
+    StringRef FileName) {
+  auto Prefetched = PrefetchedASTs.find(FileName);
+  if (Prefetched == PrefetchedASTs.end())
+    return nullptr;
+
+  std::unique_ptr<ASTUnit> Unit = Prefetched->second.Unit.get();
+  PrefetchedBytes -= Prefetched->second.Size;
+  PrefetchOrder.erase(Prefetched->second.OrderPos);
+  PrefetchedASTs.erase(Prefetched);
+  if (Unit) {
+    ++NumPrefetchedASTsUsed;
+    ++NumPrefetchedUsed;
+  }
+  return Unit;
+}
+
+void CrossTranslationUnitContext::ASTUnitStorage::dropPrefetchedAST(
+    StringRef FileName) {
+  auto Prefetched = PrefetchedASTs.find(FileName);
+  if (Prefetched == PrefetchedASTs.end())
+    return;
+
+  // A load that already started finishes on its thread, which then frees the
+  // unit.
+  *Prefetched->second.Cancelled = true;
+  PrefetchedBytes -= Prefetched->second.Size;
+  PrefetchOrder.erase(Prefetched->second.OrderPos);
+  PrefetchedASTs.erase(Prefetched);
 }
 
 llvm::Error CrossTranslationUnitContext::ASTUnitStorage::ensureCTUIndexLoaded(
     StringRef CrossTUDir, StringRef IndexName) {
   // Dont initialize if the map is filled.
-  if (!NameFileMap.empty())
+  if (!NameFileMap.empty() || BinaryIndex)
     return llvm::Error::success();
 
   // Get the absolute path to the index file.
@@ -470,6 +605,15 @@ llvm::Error CrossTranslationUnitContext::ASTUnitStorage::ensureCTUIndexLoaded(
   else
     llvm::sys::path::append(IndexFile, IndexName);
 
+  // A binary index is looked up in place.
+  if (BinaryCrossTUIndex::isBinaryIndex(IndexFile)) {
+    auto Index = BinaryCrossTUIndex::create(IndexFile);
+    if (!Index)
+      return Index.takeError();
+    BinaryIndex = std::move(*Index);
+    return llvm::Error::success();
+  }
+
   if (auto IndexMapping = parseCrossTUIndex(IndexFile)) {
     // Initialize member map.
     NameFileMap = *IndexMapping;
@@ -503,12 +647,27 @@ llvm::Expected<ASTUnit *> CrossTranslationUnitContext::loadExternalAST(
   return Unit;
 }
 
+void CrossTranslationUnitContext::prefetchExternalASTs(
+    ArrayRef<std::string> LookupNames, StringRef CrossTUDir,
+    StringRef IndexName) {
+  ASTStorage.prefetchFunctions(LookupNames, CrossTUDir, IndexName);
+}
+
 CrossTranslationUnitContext::ASTLoader::ASTLoader(
     CompilerInstance &CI, StringRef CTUDir, StringRef InvocationListFilePath)
     : CI(CI), CTUDir(CTUDir), InvocationListFilePath(InvocationListFilePath) {}
 
 CrossTranslationUnitContext::LoadResultTy
 CrossTranslationUnitContext::ASTLoader::load(StringRef Identifier) {
+  std::string Path = getPath(Identifier);
+  if (isDump(Path))
+    return loadFromDump(Path);
+  else
+    return loadFromSource(Path);
+}
+
+std::string
+CrossTranslationUnitContext::ASTLoader::getPath(StringRef Identifier) const {
   llvm::SmallString<256> Path;
   if (llvm::sys::path::is_absolute(Identifier, PathStyle)) {
     Path = Identifier;
@@ -524,10 +683,7 @@ CrossTranslationUnitContext::ASTLoader::load(StringRef Identifier) {
   // Normalize by removing relative path components.
   llvm::sys::path::remove_dots(Path, /*remove_dot_dot*/ true, PathStyle);
 
-  if (Path.endswith(".ast"))
-    return loadFromDump(Path);
-  else
-    return loadFromSource(Path);
+  return std::string(Path.str());
 }
 
 CrossTranslationUnitContext::LoadResultTy
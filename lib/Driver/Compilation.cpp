@@ -17,14 +17,21 @@
 #include "latino/Driver/Util.h"
 #include "llvm/ADT/None.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Option/OptSpecifier.h"
 #include "llvm/Option/Option.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <system_error>
 #include <utility>
@@ -161,33 +168,41 @@ bool Compilation::CleanupFileMap(const ArgStringMap &Files,
   return Success;
 }
 
-int Compilation::ExecuteCommand(const Command &C,
-                                const Command *&FailingCommand) const {
-  if ((getDriver().CCPrintOptions ||
-       getArgs().hasArg(options::OPT_v)) && !getDriver().CCGenDiagnostics) {
-    raw_ostream *OS = &llvm::errs();
-    std::unique_ptr<llvm::raw_fd_ostream> OwnedStream;
-
-    // Follow gcc implementation of CC_PRINT_OPTIONS; we could also cache the
-    // output stream.
-    if (getDriver().CCPrintOptions && getDriver().CCPrintOptionsFilename) {
-      std::error_code EC;
-      OwnedStream.reset(new llvm::raw_fd_ostream(
-          getDriver().CCPrintOptionsFilename, EC,
-          llvm::sys::fs::OF_Append | llvm::sys::fs::OF_Text));
-      if (EC) {
-        getDriver().Diag(diag::err_drv_cc_print_options_failure)
-            << EC.message();
-        FailingCommand = &C;
-        return 1;
-      }
-      OS = OwnedStream.get();
+bool Compilation::PrintCommand(const Command &C) const {
+  if ((!getDriver().CCPrintOptions && !getArgs().hasArg(options::OPT_v)) ||
+      getDriver().CCGenDiagnostics)
+    return true;
+
+  raw_ostream *OS = &llvm::errs();
+  std::unique_ptr<llvm::raw_fd_ostream> OwnedStream;
+
+  // Follow gcc implementation of CC_PRINT_OPTIONS; we could also cache the
+  // output stream.
+  if (getDriver().CCPrintOptions && getDriver().CCPrintOptionsFilename) {
+    std::error_code EC;
+    OwnedStream.reset(new llvm::raw_fd_ostream(
+        getDriver().CCPrintOptionsFilename, EC,
+        llvm::sys::fs::OF_Append | llvm::sys::fs::OF_Text));
+    if (EC) {
+      getDriver().Diag(diag::err_drv_cc_print_options_failure)
+          << EC.message();
+      return false;
     }
+    OS = OwnedStream.get();
+  }
+
+  if (getDriver().CCPrintOptions)
+    *OS << "[Logging clang options]\n";
 
-    if (getDriver().CCPrintOptions)
-      *OS << "[Logging clang options]\n";
+  C.Print(*OS, "\n", /*Quote=*/getDriver().CCPrintOptions);
+  return true;
+}
 
-    C.Print(*OS, "\n", /*Quote=*/getDriver().CCPrintOptions);
+int Compilation::ExecuteCommand(const Command &C,
+                                const Command *&FailingCommand) const {
+  if (!PrintCommand(C)) {
+    FailingCommand = &C;
+    return 1;
   }
 
   std::string Error;
@@ -235,6 +250,9 @@ static bool InputsOk(const Command &C,
 
 void Compilation::ExecuteJobs(const JobList &Jobs,
                               FailingCommandList &FailingCommands) const {
+  if (TheDriver.NumParallelJobs > 1 && Jobs.size() > 1)
+    return ExecuteJobsInParallel(Jobs, FailingCommands);
+
   // According to UNIX standard, driver need to continue compiling all the
   // inputs on the command line even one of them failed.
   // In all but CLMode, execute all the jobs unless the necessary inputs for the
@@ -252,6 +270,179 @@ void Compilation::ExecuteJobs(const JobList &Jobs,
   }
 }
 
+namespace {
+/// The scheduling state of one job in ExecuteJobsInParallel.
+struct ParallelJob {
+  enum StatusKind { Pending, Running, Finished, Skipped };
+  StatusKind Status = Pending;
+
+  /// Indices of the earlier jobs that produce an input of this job.
+  SmallVector<unsigned, 4> Deps;
+
+  /// Files capturing the job's stdout and stderr while it runs, so that its
+  /// output is not interleaved with the output of the other jobs.
+  SmallString<128> OutFile;
+  SmallString<128> ErrFile;
+
+  int Res = 0;
+  bool ExecutionFailed = false;
+  std::string ErrMsg;
+};
+} // namespace
+
+/// Collect every action reachable through the inputs of \p A.
+static void CollectInputActions(const Action *A,
+                                llvm::SmallPtrSetImpl<const Action *> &Seen) {
+  for (const Action *AI : A->inputs())
+    if (Seen.insert(AI).second)
+      CollectInputActions(AI, Seen);
+}
+
+/// Copy a captured output file to \p OS and remove it.
+static void ReplayCapturedOutput(StringRef File, raw_ostream &OS) {
+  if (File.empty())
+    return;
+  if (auto Buf = llvm::MemoryBuffer::getFile(File))
+    OS << (*Buf)->getBuffer();
+  OS.flush();
+  llvm::sys::fs::remove(File);
+}
+
+void Compilation::ExecuteJobsInParallel(
+    const JobList &Jobs, FailingCommandList &FailingCommands) const {
+  const auto &JobsList = Jobs.getJobs();
+  std::vector<ParallelJob> State(JobsList.size());
+
+  // A job depends on every earlier job whose action feeds into its own, e.g.
+  // the link job on the compile jobs of its inputs. The commands built for a
+  // single action, e.g. by a tool which needs several steps, keep their order.
+  for (unsigned I = 0, E = JobsList.size(); I != E; ++I) {
+    const Action *Source = &JobsList[I]->getSource();
+    llvm::SmallPtrSet<const Action *, 16> Inputs;
+    CollectInputActions(Source, Inputs);
+    Inputs.insert(Source);
+    for (unsigned J = 0; J != I; ++J)
+      if (Inputs.count(&JobsList[J]->getSource()))
+        State[I].Deps.push_back(J);
+  }
+
+  // Only capture output if the compilation has not been redirected already.
+  bool CaptureOutput = Redirects.empty();
+
+  std::mutex Mutex;
+  std::condition_variable JobFinished;
+  unsigned NumRunning = 0;
+  unsigned NextToReport = 0;
+  bool StopLaunching = false;
+  // Failures in completion order, used to decide whether later jobs can run.
+  SmallVector<std::pair<int, const Command *>, 4> FinishedFailures;
+
+  llvm::ThreadPool Pool(llvm::hardware_concurrency(TheDriver.NumParallelJobs));
+  std::unique_lock<std::mutex> Lock(Mutex);
+  while (NextToReport != JobsList.size()) {
+    // Record failures as soon as jobs finish, so that dependent jobs are
+    // skipped without waiting for earlier jobs to be reported.
+    for (unsigned I = NextToReport, E = JobsList.size(); I != E; ++I) {
+      ParallelJob &PJ = State[I];
+      if (PJ.Status == ParallelJob::Finished && PJ.Res &&
+          llvm::none_of(FinishedFailures, [&](const auto &F) {
+            return F.second == JobsList[I].get();
+          })) {
+        FinishedFailures.push_back(std::make_pair(PJ.Res, JobsList[I].get()));
+        if (TheDriver.IsCLMode())
+          StopLaunching = true;
+      }
+    }
+
+    // Start every job whose inputs are ready, up to the job limit.
+    for (unsigned I = NextToReport, E = JobsList.size();
+         I != E && NumRunning < TheDriver.NumParallelJobs; ++I) {
+      ParallelJob &PJ = State[I];
+      if (PJ.Status != ParallelJob::Pending)
+        continue;
+      if (StopLaunching) {
+        PJ.Status = ParallelJob::Skipped;
+        continue;
+      }
+      if (llvm::any_of(PJ.Deps, [&](unsigned D) {
+            return State[D].Status == ParallelJob::Pending ||
+                   State[D].Status == ParallelJob::Running;
+          }))
+        continue;
+
+      const Command &C = *JobsList[I];
+      if (!InputsOk(C, FinishedFailures)) {
+        PJ.Status = ParallelJob::Skipped;
+        continue;
+      }
+      if (!PrintCommand(C)) {
+        PJ.Status = ParallelJob::Finished;
+        PJ.Res = 1;
+        FinishedFailures.push_back(std::make_pair(PJ.Res, &C));
+        continue;
+      }
+
+      std::vector<Optional<StringRef>> JobRedirects = Redirects;
+      if (CaptureOutput &&
+          !llvm::sys::fs::createTemporaryFile("latino-job", "out",
+                                              PJ.OutFile) &&
+          !llvm::sys::fs::createTemporaryFile("latino-job", "err",
+                                              PJ.ErrFile))
+        JobRedirects = {None, StringRef(PJ.OutFile), StringRef(PJ.ErrFile)};
+
+      PJ.Status = ParallelJob::Running;
+      ++NumRunning;
+      Pool.async([&, I, JobRedirects]() {
+        std::string ErrMsg;
+        bool ExecutionFailed = false;
+        int Res = JobsList[I]->Execute(JobRedirects, &ErrMsg, &ExecutionFailed);
+
+        std::lock_guard<std::mutex> Guard(Mutex);
+        ParallelJob &Done = State[I];
+        Done.Res = Res;
+        Done.ExecutionFailed = ExecutionFailed;
+        Done.ErrMsg = std::move(ErrMsg);
+        Done.Status = ParallelJob::Finished;
+        --NumRunning;
+        JobFinished.notify_one();
+      });
+    }
+
+    // Report finished jobs in job-list order, so the output and the failing
+    // commands do not depend on scheduling.
+    while (NextToReport != JobsList.size()) {
+      ParallelJob &PJ = State[NextToReport];
+      if (PJ.Status == ParallelJob::Pending || PJ.Status == ParallelJob::Running)
+        break;
+      const Command &C = *JobsList[NextToReport++];
+      if (PJ.Status == ParallelJob::Skipped)
+        continue;
+
+      {
+        // A running in-process job may have the stdout of the driver pointed
+        // at its own capture file.
+        std::lock_guard<std::mutex> Guard(
+            CC1Command::getStdoutRedirectMutex());
+        ReplayCapturedOutput(PJ.OutFile, llvm::outs());
+      }
+      ReplayCapturedOutput(PJ.ErrFile, llvm::errs());
+      if (!PJ.ErrMsg.empty()) {
+        assert(PJ.Res && "Error string set with 0 result code!");
+        getDriver().Diag(diag::err_drv_command_failure) << PJ.ErrMsg;
+      }
+      if (int Res = PJ.ExecutionFailed ? 1 : PJ.Res) {
+        FailingCommands.push_back(std::make_pair(Res, &C));
+        // Bail as soon as one command fails in cl driver mode.
+        if (TheDriver.IsCLMode())
+          StopLaunching = true;
+      }
+    }
+
+    if (NumRunning && NextToReport != JobsList.size())
+      JobFinished.wait(Lock);
+  }
+}
+
 void Compilation::initCompilationForDiagnostics() {
   ForDiagnostics = true;
 
@@ -79,6 +79,7 @@
 #include "llvm/Support/Program.h"
 #include "llvm/Support/StringSaver.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/VirtualFileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 #include <map>
@@ -1121,6 +1122,17 @@ Compilation *Driver::BuildCompilation(ArrayRef<const char *> ArgList) {
                     .Default(SaveTempsCwd);
   }
 
+  // Process -j <N>; zero asks for one job per available core.
+  if (const Arg *A = Args.getLastArg(options::OPT_j)) {
+    StringRef Value = A->getValue();
+    unsigned Jobs;
+    if (Value.getAsInteger(10, Jobs))
+      Diag(diag::err_drv_invalid_int_value) << A->getAsString(Args) << Value;
+    else
+      NumParallelJobs =
+          Jobs ? Jobs : llvm::hardware_concurrency().compute_thread_count();
+  }
+
   setLTOMode(Args);
 
   // Process -fembed-bitcode= flags.
@@ -3831,10 +3843,27 @@ void Driver::BuildJobs(Compilation &C) const {
                        /*TargetDeviceOffloadKind*/ Action::OFK_None);
   }
 
-  // If we have more than one job, then disable integrated-cc1 for now.
-  if (C.getJobs().size() > 1)
-    for (auto &J : C.getJobs())
-      J.InProcess = false;
+  // If we have more than one job, then disable integrated-cc1 unless it was
+  // requested explicitly. The driver keeps running after each in-process job,
+  // so those jobs have to free their memory on the way out.
+  if (C.getJobs().size() > 1) {
+    bool KeepInProcess = C.getArgs().hasFlag(options::OPT_fintegrated_cc1,
+                                             options::OPT_fno_integrated_cc1,
+                                             /*Default=*/false);
+    for (auto &J : C.getJobs()) {
+      if (!J.InProcess)
+        continue;
+      if (!KeepInProcess) {
+        J.InProcess = false;
+        continue;
+      }
+      ArgStringList Args;
+      for (const char *Arg : J.getArguments())
+        if (StringRef(Arg) != "-disable-free")
+          Args.push_back(Arg);
+      J.replaceArguments(std::move(Args));
+    }
+  }
 
   // If the user passed -Qunused-arguments or there were errors, don't warn
   // about any unused arguments.
@@ -9,6 +9,7 @@
 #include "latino/Driver/Job.h"
 #include "InputInfo.h"
 #include "latino/Basic/LLVM.h"
+#include "latino/Basic/Stack.h"
 #include "latino/Driver/Driver.h"
 #include "latino/Driver/DriverDiagnostic.h"
 #include "latino/Driver/Tool.h"
@@ -19,6 +20,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/StringSwitch.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
@@ -28,10 +30,15 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <mutex>
 #include <string>
 #include <system_error>
 #include <utility>
 
+#ifdef LLVM_ON_UNIX
+#include <unistd.h>
+#endif
+
 using namespace latino;
 using namespace driver;
 
@@ -369,6 +376,61 @@ void CC1Command::Print(raw_ostream &OS, const char *Terminator, bool Quote,
   Command::Print(OS, Terminator, Quote, CrashInfo);
 }
 
+/// Only the stdout of the whole driver can be redirected, so only one
+/// invocation may have it at a time.
+std::mutex &CC1Command::getStdoutRedirectMutex() {
+  static std::mutex StdoutRedirectMutex;
+  return StdoutRedirectMutex;
+}
+
+namespace {
+/// Points the stdout of the driver at a file while it is alive, like the
+/// stdout redirection of a spawned process.
+class StdoutRedirection {
+  int SavedFD = -1;
+
+public:
+  StdoutRedirection() = default;
+  StdoutRedirection(const StdoutRedirection &) = delete;
+  StdoutRedirection &operator=(const StdoutRedirection &) = delete;
+
+  /// Redirect stdout to \p Path, or discard it if \p Path is empty.
+  std::error_code redirect(StringRef Path) {
+#ifdef LLVM_ON_UNIX
+    int FD;
+    if (std::error_code EC = llvm::sys::fs::openFileForWrite(
+            Path.empty() ? "/dev/null" : Path, FD,
+            llvm::sys::fs::CD_CreateAlways, llvm::sys::fs::OF_Text))
+      return EC;
+    llvm::outs().flush();
+    SavedFD = ::dup(STDOUT_FILENO);
+    if (SavedFD < 0 || ::dup2(FD, STDOUT_FILENO) < 0) {
+      std::error_code EC(errno, std::generic_category());
+      if (SavedFD >= 0)
+        ::close(SavedFD);
+      SavedFD = -1;
+      ::close(FD);
+      return EC;
+    }
+    ::close(FD);
+    return std::error_code();
+#else
+    return std::make_error_code(std::errc::not_supported);
+#endif
+  }
+
+  ~StdoutRedirection() {
+#ifdef LLVM_ON_UNIX
+    if (SavedFD < 0)
+      return;
+    llvm::outs().flush();
+    ::dup2(SavedFD, STDOUT_FILENO);
+    ::close(SavedFD);
+#endif
+  }
+};
+} // namespace
+
 int CC1Command::Execute(ArrayRef<llvm::Optional<StringRef>> Redirects,
                         std::string *ErrMsg, bool *ExecutionFailed) const {
   // FIXME: Currently, if there're more than one job, we disable
@@ -377,6 +439,20 @@ int CC1Command::Execute(ArrayRef<llvm::Optional<StringRef>> Redirects,
   if (!InProcess)
     return Command::Execute(Redirects, ErrMsg, ExecutionFailed);
 
+  // Redirect the stdout of the driver for the invocation. If another
+  // in-process invocation has it already, or it cannot be redirected, run
+  // this one in a process of its own, whose stdout can.
+  std::unique_lock<std::mutex> StdoutLock(getStdoutRedirectMutex(),
+                                          std::defer_lock);
+  StdoutRedirection Stdout;
+  if (Redirects.size() > 1 && Redirects[1]) {
+    if (!StdoutLock.try_lock() || Stdout.redirect(*Redirects[1])) {
+      if (StdoutLock.owns_lock())
+        StdoutLock.unlock();
+      return Command::Execute(Redirects, ErrMsg, ExecutionFailed);
+    }
+  }
+
   PrintFileNames();
 
   SmallVector<const char *, 128> Argv;
@@ -389,6 +465,22 @@ int CC1Command::Execute(ArrayRef<llvm::Optional<StringRef>> Redirects,
   if (ExecutionFailed)
     *ExecutionFailed = false;
 
+  // Send the diagnostics of the invocation where the stderr of a process
+  // would have gone.
+  std::unique_ptr<llvm::raw_fd_ostream> DiagOS;
+  if (Redirects.size() > 2 && Redirects[2] && !Redirects[2]->empty()) {
+    std::error_code EC;
+    DiagOS = std::make_unique<llvm::raw_fd_ostream>(*Redirects[2], EC,
+                                                    llvm::sys::fs::OF_Text);
+    if (EC) {
+      if (ErrMsg)
+        *ErrMsg = EC.message();
+      if (ExecutionFailed)
+        *ExecutionFailed = true;
+      return -1;
+    }
+  }
+
   llvm::CrashRecoveryContext CRC;
   CRC.DumpStackAndCleanupOnFailure = true;
 
@@ -397,7 +489,13 @@ int CC1Command::Execute(ArrayRef<llvm::Optional<StringRef>> Redirects,
 
   int R = 0;
   // Enter ExecuteCC1Tool() instead of starting up a new process
-  if (!CRC.RunSafely([&]() { R = D.CC1Main(Argv); })) {
+  auto RunCC1 = [&]() { R = D.CC1Main(Argv, DiagOS.get()); };
+  // Job threads have default-sized stacks, so when jobs may run concurrently
+  // give the invocation a thread with the stack size a process would have.
+  bool Crashed = D.NumParallelJobs > 1
+                     ? !CRC.RunSafelyOnThread(RunCC1, DesiredStackSize)
+                     : !CRC.RunSafely(RunCC1);
+  if (Crashed) {
     llvm::RestorePrettyStackState(PrettyState);
     return CRC.RetCode;
   }
@@ -1292,6 +1292,27 @@ void Clang::AddPreprocessingOptions(Compilation &C, const JobAction &JA,
   if (Arg *A = Args.getLastArg(options::OPT_I_))
     D.Diag(diag::err_drv_I_dash_not_supported) << A->getAsString(Args);
 
+  // The prelude is precompiled by the frontend on first use and cached, so
+  // pass it down with an absolute path and a cache directory. Precompiling a
+  // header does not load the prelude.
+  if (Arg *A = Args.getLastArg(options::OPT_fprelude_EQ)) {
+    A->claim();
+    if (!isa<PrecompileJobAction>(JA)) {
+      SmallString<128> Prelude(A->getValue());
+      D.getVFS().makeAbsolute(Prelude);
+      CmdArgs.push_back(Args.MakeArgString("-fprelude=" + Prelude));
+
+      SmallString<128> CachePath;
+      if (Arg *CacheArg = Args.getLastArg(options::OPT_fprelude_cache_path_EQ))
+        CachePath = CacheArg->getValue();
+      else if (llvm::sys::path::cache_directory(CachePath))
+        llvm::sys::path::append(CachePath, "latino", "Prelude");
+      if (!CachePath.empty())
+        CmdArgs.push_back(
+            Args.MakeArgString("-fprelude-cache-path=" + CachePath));
+    }
+  }
+
   // If we have a --sysroot, and don't have an explicit -isysroot flag, add an
   // -isysroot to the CC1 invocation.
   StringRef sysroot = C.getSysRoot();
@@ -6192,6 +6213,35 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     CmdArgs.push_back(Args.MakeArgString(Str));
   }
 
+  // With -fparallel-codegen=<n>, the backend writes each partition of the
+  // module to its own temporary object file, and a relocatable link after the
+  // compile combines them into the requested output. The partitioning does
+  // not depend on the number of threads, so neither does the output.
+  SmallVector<const char *, 8> PartitionOutputs;
+  if (Arg *A = Args.getLastArg(options::OPT_fparallel_codegen_EQ)) {
+    unsigned Partitions;
+    if (StringRef(A->getValue()).getAsInteger(10, Partitions) ||
+        Partitions == 0) {
+      D.Diag(diag::err_drv_invalid_int_value)
+          << A->getAsString(Args) << A->getValue();
+    } else if (Partitions > 1 && Output.isFilename() &&
+               Output.getType() == types::TY_Object && !SplitDWARF &&
+               !TC.getTriple().isWindowsMSVCEnvironment()) {
+      StringRef Stem = llvm::sys::path::stem(Output.getFilename());
+      for (unsigned I = 0; I != Partitions; ++I) {
+        std::string TmpName =
+            D.GetTemporaryPath((Stem + "-part" + Twine(I)).str(), "o");
+        PartitionOutputs.push_back(
+            C.addTempFile(C.getArgs().MakeArgString(TmpName)));
+      }
+      for (const char *PartitionOutput :
+           makeArrayRef(PartitionOutputs).drop_front()) {
+        CmdArgs.push_back("-fparallel-codegen-output");
+        CmdArgs.push_back(PartitionOutput);
+      }
+    }
+  }
+
   // Add the "-o out -x type src.c" flags last. This is done primarily to make
   // the -cc1 command easier to edit when reproducing compiler crashes.
   if (Output.getType() == types::TY_Dependencies) {
@@ -6205,7 +6255,8 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
       CmdArgs.push_back(Args.MakeArgString(OutputFilename));
     } else {
       CmdArgs.push_back("-o");
-      CmdArgs.push_back(Output.getFilename());
+      CmdArgs.push_back(PartitionOutputs.empty() ? Output.getFilename()
+                                                 : PartitionOutputs.front());
     }
   } else {
     assert(Output.isNothing() && "Invalid output.");
@@ -6257,6 +6308,22 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     C.getJobs().getJobs().back()->PrintInputFilenames = true;
   }
 
+  // Combine the partitions into the requested object file. The link shares
+  // the action of the compile command, so even with -j it only starts once
+  // the compile has succeeded (see Compilation::ExecuteJobsInParallel).
+  if (!PartitionOutputs.empty()) {
+    ArgStringList LinkArgs;
+    LinkArgs.push_back("-r");
+    LinkArgs.push_back("-o");
+    LinkArgs.push_back(Output.getFilename());
+    LinkArgs.append(PartitionOutputs.begin(), PartitionOutputs.end());
+    InputInfo II(types::TY_Object, PartitionOutputs.front(),
+                 PartitionOutputs.front());
+    C.addCommand(std::make_unique<Command>(
+        JA, *this, ResponseFileSupport::AtFileCurCP(),
+        Args.MakeArgString(TC.GetLinkerPath()), LinkArgs, II));
+  }
+
   if (Arg *A = Args.getLastArg(options::OPT_pg))
     if (FPKeepKind == CodeGenOptions::FramePointerKind::None &&
         !Args.hasArg(options::OPT_mfentry))
@@ -36,7 +36,9 @@
 #include "latino/Serialization/ASTReader.h"
 #include "latino/Serialization/GlobalModuleIndex.h"
 #include "latino/Serialization/InMemoryModuleCache.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/BuryPointer.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/Errc.h"
@@ -59,7 +61,7 @@ CompilerInstance::CompilerInstance(
     std::shared_ptr<PCHContainerOperations> PCHContainerOps,
     InMemoryModuleCache *SharedModuleCache)
     : ModuleLoader(/* BuildingModule = */ SharedModuleCache),
-      Invocation(new CompilerInvocation()),
+      Invocation(new CompilerInvocation()), Arenas(new ArenaPool()),
       ModuleCache(SharedModuleCache ? SharedModuleCache
                                     : new InMemoryModuleCache),
       ThePCHContainerOperations(std::move(PCHContainerOps)) {}
@@ -394,7 +396,8 @@ void CompilerInstance::createPreprocessor(TranslationUnitKind TUKind) {
                                       getDiagnostics(), getLangOpts(),
                                       getSourceManager(), *HeaderInfo, *this,
                                       /*IdentifierInfoLookup=*/nullptr,
-                                      /*OwnsHeaderSearch=*/true, TUKind);
+                                      /*OwnsHeaderSearch=*/true, TUKind,
+                                      Arenas.get());
   getTarget().adjust(getLangOpts());
   PP->Initialize(getTarget(), getAuxTarget());
 
@@ -487,7 +490,7 @@ void CompilerInstance::createASTContext() {
   Preprocessor &PP = getPreprocessor();
   auto *Context = new ASTContext(getLangOpts(), PP.getSourceManager(),
                                  PP.getIdentifierTable(), /*PP.getSelectorTable(),*/
-                                 PP.getBuiltinInfo());
+                                 PP.getBuiltinInfo(), Arenas.get());
   Context->InitBuiltinTypes(getTarget(), getAuxTarget());
   setASTContext(Context);
 }
@@ -1021,6 +1024,8 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
       getFileManager().PrintStats();
       OS << '\n';
     }
+    getArenaPool().PrintStats();
+    OS << '\n';
     llvm::PrintStatistics(OS);
   }
   StringRef StatsFile = getFrontendOpts().StatsFile;
@@ -1051,6 +1056,29 @@ static Language getLanguageFromOptions(const LangOptions &LangOpts) {
   return LangOpts.CPlusPlus ? Language::CXX : Language::C;
 }
 
+/// Replace the copy of a module file that was just built in memory by a
+/// read-only mapping of the file it was written to. The pages of the mapping
+/// come from the page cache, so they are shared with every other compilation
+/// importing the module instead of being private to this one.
+static void mapBuiltModuleFile(CompilerInstance &CI, StringRef ModuleFileName) {
+  InMemoryModuleCache &ModuleCache = CI.getModuleCache();
+  llvm::MemoryBuffer *Built = ModuleCache.lookupPCM(ModuleFileName);
+  if (!Built || !ModuleCache.isPCMFinal(ModuleFileName) ||
+      Built->getBufferKind() != llvm::MemoryBuffer::MemoryBuffer_Malloc)
+    return;
+
+  // The file is volatile because another compilation may have replaced it in
+  // the meantime, so only keep the mapping if it holds the PCM we built.
+  auto Mapped = CI.getFileManager().getBufferForFile(
+      ModuleFileName, /*isVolatile=*/true, /*RequiresNullTerminator=*/false);
+  if (!Mapped ||
+      (*Mapped)->getBufferKind() != llvm::MemoryBuffer::MemoryBuffer_MMap ||
+      CI.getPCHContainerReader().ExtractPCH(**Mapped) != Built->getBuffer())
+    return;
+
+  ModuleCache.replaceBuiltPCM(ModuleFileName, std::move(*Mapped));
+}
+
 /// Compile a module file for the given module, using the options
 /// provided by the importing compiler instance. Returns true if the module
 /// was built without errors.
@@ -1140,6 +1168,7 @@ compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
   // Note that this module is part of the module build stack, so that we
   // can detect cycles in the module graph.
   Instance.setFileManager(&ImportingInstance.getFileManager());
+  Instance.setArenaPool(&ImportingInstance.getArenaPool());
   Instance.createSourceManager(Instance.getFileManager());
   SourceManager &SourceMgr = Instance.getSourceManager();
   SourceMgr.setModuleBuildStack(
@@ -1181,7 +1210,13 @@ compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
   // doesn't make sense for all clients, so clean this up manually.
   Instance.clearOutputFiles(/*EraseFiles=*/true);
 
-  return !Instance.getDiagnostics().hasErrorOccurred();
+  if (Instance.getDiagnostics().hasErrorOccurred())
+    return false;
+
+  // Nothing has read the module from the cache yet, so its buffer can still
+  // be replaced.
+  mapBuiltModuleFile(ImportingInstance, ModuleFileName);
+  return true;
 }
 
 static const FileEntry *getPublicModuleMap(const FileEntry *File,
@@ -1354,6 +1389,163 @@ static bool compileModuleAndReadAST(CompilerInstance &ImportingInstance,
   }
 }
 
+namespace {
+
+/// Collects the names of the input files recorded in an AST file.
+class InputFileCollector : public ASTReaderListener {
+public:
+  std::vector<std::string> Files;
+
+  bool needsInputFileVisitation() override { return true; }
+  bool needsSystemInputFileVisitation() override { return true; }
+  bool visitInputFile(StringRef Filename, bool isSystem, bool isOverridden,
+                      bool isExplicitModule) override {
+    Files.push_back(std::string(Filename));
+    return true;
+  }
+};
+
+} // end anonymous namespace
+
+/// Determine whether the precompiled prelude at \p PCHPath exists, was built
+/// with options compatible with those of \p CI, and none of the files it was
+/// built from has been modified since it was written.
+static bool isPreludeUpToDate(CompilerInstance &CI, StringRef PCHPath) {
+  llvm::sys::fs::file_status PCHStatus;
+  if (llvm::sys::fs::status(PCHPath, PCHStatus))
+    return false;
+
+  // A cached file that does not match this invocation, because it was left
+  // by a different compiler or its key collided, is rebuilt rather than
+  // rejected when it is loaded.
+  if (!ASTReader::isAcceptableASTFile(
+          PCHPath, CI.getFileManager(), CI.getPCHContainerReader(),
+          CI.getLangOpts(), CI.getTargetOpts(), CI.getPreprocessorOpts(),
+          CI.getSpecificModuleCachePath()))
+    return false;
+
+  InputFileCollector Collector;
+  if (ASTReader::readASTFileControlBlock(
+          PCHPath, CI.getFileManager(), CI.getPCHContainerReader(),
+          /*FindModuleFileExtensions=*/false, Collector,
+          /*ValidateDiagnosticOptions=*/false))
+    return false;
+
+  for (const std::string &File : Collector.Files) {
+    llvm::sys::fs::file_status Status;
+    if (llvm::sys::fs::status(File, Status) ||
+        Status.getLastModificationTime() > PCHStatus.getLastModificationTime())
+      return false;
+  }
+  return true;
+}
+
+/// Compile the prelude into a precompiled header in a separate compiler
+/// instance, using the options of the given instance. Returns true if the
+/// prelude was built without errors.
+static bool compilePrelude(CompilerInstance &CI, StringRef PreludeFile,
+                           StringRef PCHPath) {
+  llvm::TimeTraceScope TimeScope("Prelude Compile", PreludeFile);
+
+  // Build the prelude with the options of this translation unit, so that the
+  // PCH validates against it, but as a header and without loading itself.
+  auto Invocation = std::make_shared<CompilerInvocation>(CI.getInvocation());
+  PreprocessorOptions &PPOpts = Invocation->getPreprocessorOpts();
+  PPOpts.PreludeFile.clear();
+  PPOpts.ImplicitPCHInclude.clear();
+  PPOpts.RetainRemappedFileBuffers = true;
+
+  FrontendOptions &FrontendOpts = Invocation->getFrontendOpts();
+  FrontendOpts.ProgramAction = frontend::GeneratePCH;
+  FrontendOpts.OutputFile = PCHPath.str();
+  FrontendOpts.DisableFree = false;
+  FrontendOpts.Inputs = {FrontendInputFile(
+      PreludeFile, InputKind(getLanguageFromOptions(CI.getLangOpts())))};
+
+  Invocation->getDependencyOutputOpts() = DependencyOutputOptions();
+  Invocation->getDiagnosticOpts().VerifyDiagnostics = 0;
+
+  CompilerInstance Instance(CI.getPCHContainerOperations(),
+                            &CI.getModuleCache());
+  Instance.setInvocation(std::move(Invocation));
+  Instance.createDiagnostics(
+      new ForwardingDiagnosticConsumer(CI.getDiagnosticClient()),
+      /*ShouldOwnClient=*/true);
+  Instance.setFileManager(&CI.getFileManager());
+  Instance.setArenaPool(&CI.getArenaPool());
+
+  CI.getDiagnostics().Report(diag::remark_prelude_build)
+      << PreludeFile << PCHPath;
+
+  // Execute the action on a separate thread so that we get a stack large
+  // enough.
+  llvm::CrashRecoveryContext CRC;
+  bool Crashed = !CRC.RunSafelyOnThread(
+      [&]() {
+        GeneratePCHAction Action;
+        Instance.ExecuteAction(Action);
+      },
+      DesiredStackSize);
+
+  Instance.clearOutputFiles(/*EraseFiles=*/true);
+  return !Crashed && !Instance.getDiagnostics().hasErrorOccurred();
+}
+
+bool CompilerInstance::loadPrelude() {
+  PreprocessorOptions &PPOpts = getPreprocessorOpts();
+  SmallString<128> PreludeFile(PPOpts.PreludeFile);
+  llvm::sys::fs::make_absolute(PreludeFile);
+
+  // The precompiled prelude is only valid for the options it was built with,
+  // so key it by the module hash of this invocation as well as the prelude.
+  SmallString<128> PCHPath(PPOpts.PreludeCachePath);
+  if (PCHPath.empty())
+    llvm::sys::path::system_temp_directory(/*erasedOnReboot=*/true, PCHPath);
+  llvm::sys::path::append(
+      PCHPath, llvm::sys::path::stem(PreludeFile) + "-" +
+                   llvm::utohexstr(size_t(llvm::hash_combine(
+                       getInvocation().getModuleHash(), PreludeFile))) +
+                   ".pch");
+
+  // FIXME: have LockFileManager return an error_code so that we can
+  // avoid the mkdir when the directory already exists.
+  llvm::sys::fs::create_directories(llvm::sys::path::parent_path(PCHPath));
+
+  while (!isPreludeUpToDate(*this, PCHPath)) {
+    llvm::LockFileManager Locked(PCHPath);
+    switch (Locked) {
+    case llvm::LockFileManager::LFS_Error:
+      // Locks are only necessary for performance; build the prelude
+      // ourselves.
+      Locked.unsafeRemoveLockFile();
+      LLVM_FALLTHROUGH;
+    case llvm::LockFileManager::LFS_Owned:
+      if (!compilePrelude(*this, PreludeFile, PCHPath)) {
+        getDiagnostics().Report(diag::err_prelude_not_built) << PreludeFile;
+        return false;
+      }
+      break;
+
+    case llvm::LockFileManager::LFS_Shared:
+      // Someone else is building the prelude. Wait for them to finish and
+      // check again.
+      switch (Locked.waitForUnlock()) {
+      case llvm::LockFileManager::Res_Success:
+      case llvm::LockFileManager::Res_OwnerDied:
+        continue;
+      case llvm::LockFileManager::Res_Timeout:
+        Locked.unsafeRemoveLockFile();
+        continue;
+      }
+      break;
+    }
+    break;
+  }
+
+  PPOpts.ImplicitPCHInclude = std::string(PCHPath);
+  return true;
+}
+
 /// Diagnose differences between the current definition of the given
 /// configuration macro and the definition provided on the command line.
 static void checkConfigMacro(Preprocessor &PP, StringRef ConfigMacro,
@@ -798,6 +798,8 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
   Opts.SplitDwarfFile = std::string(Args.getLastArgValue(OPT_split_dwarf_file));
   Opts.SplitDwarfOutput =
       std::string(Args.getLastArgValue(OPT_split_dwarf_output));
+  Opts.ParallelCodeGenOutputs =
+      Args.getAllArgValues(OPT_fparallel_codegen_output);
   Opts.SplitDwarfInlining = !Args.hasArg(OPT_fno_split_dwarf_inlining);
   Opts.DebugTypeExtRefs = Args.hasArg(OPT_dwarf_ext_refs);
   Opts.DebugExplicitImport = Args.hasArg(OPT_dwarf_explicit_import);
@@ -3512,6 +3514,9 @@ static void ParsePreprocessorArgs(PreprocessorOptions &Opts, ArgList &Args,
                                   DiagnosticsEngine &Diags,
                                   frontend::ActionKind Action) {
   Opts.ImplicitPCHInclude = std::string(Args.getLastArgValue(OPT_include_pch));
+  Opts.PreludeFile = std::string(Args.getLastArgValue(OPT_fprelude_EQ));
+  Opts.PreludeCachePath =
+      std::string(Args.getLastArgValue(OPT_fprelude_cache_path_EQ));
   Opts.PCHWithHdrStop = Args.hasArg(OPT_pch_through_hdrstop_create) ||
                         Args.hasArg(OPT_pch_through_hdrstop_use);
   Opts.PCHWithHdrStopCreate = Args.hasArg(OPT_pch_through_hdrstop_create);
@@ -3690,6 +3695,23 @@ bool CompilerInvocation::parseSimpleArgs(const ArgList &Args,
   return true;
 }
 
+/// Whether the warning options enable -Wmisexpect. The diagnostics engine
+/// passed to CreateFromArgs does not have the warning options applied yet, so
+/// they are read here directly.
+static bool isMisExpectEnabled(const DiagnosticOptions &Opts) {
+  if (Opts.IgnoreWarnings)
+    return false;
+  bool Enabled = false;
+  for (StringRef Warning : Opts.Warnings) {
+    if (Warning == "misexpect" || Warning == "error=misexpect" ||
+        Warning == "everything")
+      Enabled = true;
+    else if (Warning == "no-misexpect")
+      Enabled = false;
+  }
+  return Enabled;
+}
+
 bool CompilerInvocation::CreateFromArgs(CompilerInvocation &Res,
                                         ArrayRef<const char *> CommandLineArgs,
                                         DiagnosticsEngine &Diags,
@@ -3777,7 +3799,9 @@ bool CompilerInvocation::CreateFromArgs(CompilerInvocation &Res,
     }
   }
 
-  if (Diags.isIgnored(diag::warn_profile_data_misexpect, SourceLocation()))
+  // Only ask for the misexpect remarks when they would be reported. Any LLVM
+  // argument makes the invocation parse the process-wide llvm::cl options.
+  if (isMisExpectEnabled(Res.getDiagnosticOpts()))
     Res.FrontendOpts.LLVMArgs.push_back("-pgo-warn-misexpect");
 
   LangOpts.FunctionAlignment =
@@ -718,6 +718,16 @@ bool FrontendAction::BeginSourceFile(CompilerInstance &CI,
     return true;
   }
 
+  // Load the prelude as the implicit PCH include, precompiling it first if
+  // the cached copy is missing or stale.
+  if (!CI.getPreprocessorOpts().PreludeFile.empty() &&
+      CI.getPreprocessorOpts().ImplicitPCHInclude.empty() &&
+      getTranslationUnitKind() == TU_Complete && hasPCHSupport() &&
+      !usesPreprocessorOnly()) {
+    if (!CI.loadPrelude())
+      goto failure;
+  }
+
   // If the implicit PCH include is actually a directory, rather than
   // a single file, search for a suitable PCH file in that directory.
   if (!CI.getPreprocessorOpts().ImplicitPCHInclude.empty()) {
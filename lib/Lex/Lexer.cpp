@@ -48,6 +48,16 @@
 #include <tuple>
 #include <utility>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif __ALTIVEC__
+#include <altivec.h>
+#undef bool
+#endif
+
 using namespace latino;
 
 //===----------------------------------------------------------------------===//
@@ -1637,12 +1647,89 @@ bool Lexer::tryConsumeIdentifierUTF8Char(const char *&CurPtr) {
   return true;
 }
 
+#ifdef __SSE2__
+/// Return a mask with bit N set if byte N of \p V is in [_A-Za-z0-9], or also
+/// '.' if \p AllowPeriod.  Bytes >= 0x80 compare as negative and never match.
+static inline unsigned getIdentifierBodyMask(__m128i V, bool AllowPeriod) {
+  __m128i Lower = _mm_or_si128(V, _mm_set1_epi8(0x20));
+  __m128i IsAlpha =
+      _mm_and_si128(_mm_cmpgt_epi8(Lower, _mm_set1_epi8('a' - 1)),
+                    _mm_cmplt_epi8(Lower, _mm_set1_epi8('z' + 1)));
+  __m128i IsDigit = _mm_and_si128(_mm_cmpgt_epi8(V, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmplt_epi8(V, _mm_set1_epi8('9' + 1)));
+  __m128i Body = _mm_or_si128(_mm_or_si128(IsAlpha, IsDigit),
+                              _mm_cmpeq_epi8(V, _mm_set1_epi8('_')));
+  if (AllowPeriod)
+    Body = _mm_or_si128(Body, _mm_cmpeq_epi8(V, _mm_set1_epi8('.')));
+  return _mm_movemask_epi8(Body);
+}
+#endif
+
+#ifdef __AVX2__
+/// 32-byte version of getIdentifierBodyMask.
+static inline unsigned getIdentifierBodyMask(__m256i V, bool AllowPeriod) {
+  __m256i Lower = _mm256_or_si256(V, _mm256_set1_epi8(0x20));
+  __m256i IsAlpha = _mm256_andnot_si256(
+      _mm256_cmpgt_epi8(Lower, _mm256_set1_epi8('z')),
+      _mm256_cmpgt_epi8(Lower, _mm256_set1_epi8('a' - 1)));
+  __m256i IsDigit = _mm256_andnot_si256(
+      _mm256_cmpgt_epi8(V, _mm256_set1_epi8('9')),
+      _mm256_cmpgt_epi8(V, _mm256_set1_epi8('0' - 1)));
+  __m256i Body = _mm256_or_si256(_mm256_or_si256(IsAlpha, IsDigit),
+                                 _mm256_cmpeq_epi8(V, _mm256_set1_epi8('_')));
+  if (AllowPeriod)
+    Body = _mm256_or_si256(Body, _mm256_cmpeq_epi8(V, _mm256_set1_epi8('.')));
+  return _mm256_movemask_epi8(Body);
+}
+#endif
+
+/// Skip over a run of [_A-Za-z0-9] characters (and '.' if \p AllowPeriod)
+/// starting at \p CurPtr, returning a pointer to the first character that is
+/// not part of the run.  Only plain characters are skipped; trigraphs, escaped
+/// newlines, '$', UCNs and UTF-8 are left for the caller to handle.  The
+/// vector loops never read at or past \p BufferEnd, and the buffer is
+/// null-terminated, so the scalar tail always stops.
+static const char *skipIdentifierBody(const char *CurPtr,
+                                      const char *BufferEnd,
+                                      bool AllowPeriod) {
+  // Most identifiers are short; only pay for the vector setup once we've seen
+  // that this one is not.
+  for (unsigned I = 0; I != 8; ++I, ++CurPtr) {
+    unsigned char C = *CurPtr;
+    if (!(AllowPeriod ? isPreprocessingNumberBody(C) : isIdentifierBody(C)))
+      return CurPtr;
+  }
+
+#ifdef __AVX2__
+  while (CurPtr + 32 <= BufferEnd) {
+    unsigned Mask = ~getIdentifierBodyMask(
+        _mm256_loadu_si256((const __m256i *)CurPtr), AllowPeriod);
+    if (Mask != 0)
+      return CurPtr + llvm::countTrailingZeros(Mask);
+    CurPtr += 32;
+  }
+#endif
+#ifdef __SSE2__
+  while (CurPtr + 16 <= BufferEnd) {
+    unsigned Mask = ~getIdentifierBodyMask(
+        _mm_loadu_si128((const __m128i *)CurPtr), AllowPeriod) & 0xFFFF;
+    if (Mask != 0)
+      return CurPtr + llvm::countTrailingZeros(Mask);
+    CurPtr += 16;
+  }
+#endif
+
+  while (AllowPeriod ? isPreprocessingNumberBody(*CurPtr)
+                     : isIdentifierBody(*CurPtr))
+    ++CurPtr;
+  return CurPtr;
+}
+
 bool Lexer::LexIdentifier(Token &Result, const char *CurPtr) {
   // Match [_A-Za-z0-9]*, we have already matched [_A-Za-z$]
   unsigned Size;
+  CurPtr = skipIdentifierBody(CurPtr, BufferEnd, /*AllowPeriod=*/false);
   unsigned char C = *CurPtr++;
-  while (isIdentifierBody(C))
-    C = *CurPtr++;
 
   --CurPtr;   // Back up over the skipped character.
 
@@ -1752,8 +1839,16 @@ bool Lexer::isHexaLiteral(const char *Start, const LangOptions &LangOpts) {
 /// constant.
 bool Lexer::LexNumericConstant(Token &Result, const char *CurPtr) {
   unsigned Size;
-  char C = getCharAndSize(CurPtr, Size);
   char PrevCh = 0;
+  // Skip the plain digits, letters and periods in bulk; anything that needs
+  // getCharAndSize (trigraphs, escaped newlines) stops the fast scan.
+  const char *RunEnd = skipIdentifierBody(CurPtr, BufferEnd,
+                                          /*AllowPeriod=*/true);
+  if (RunEnd != CurPtr) {
+    PrevCh = RunEnd[-1];
+    CurPtr = RunEnd;
+  }
+  char C = getCharAndSize(CurPtr, Size);
   while (isPreprocessingNumberBody(C)) {
     CurPtr = ConsumeChar(CurPtr, Size, Result);
     PrevCh = C;
@@ -2476,13 +2571,6 @@ static bool isEndOfBlockCommentWithEscapedNewLine(const char *CurPtr,
   return true;
 }
 
-#ifdef __SSE2__
-#include <emmintrin.h>
-#elif __ALTIVEC__
-#include <altivec.h>
-#undef bool
-#endif
-
 /// We have just read from input the / and * characters that started a comment.
 /// Read until we find the * and / characters that terminate the comment.
 /// Note that we don't bother decoding trigraphs or escaped newlines in block
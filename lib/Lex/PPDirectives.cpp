@@ -42,6 +42,7 @@
 #include "llvm/Support/AlignOf.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/TimeProfiler.h"
 #include <algorithm>
 #include <cassert>
 #include <cstring>
@@ -934,6 +935,13 @@ void Preprocessor::HandleDirective(Token &Result) {
   if (InMacroArgs) {
     if (IdentifierInfo *II = Result.getIdentifierInfo()) {
       switch (II->getPPKeywordID()) {
+      case tok::pp_incluir:
+      case tok::pp_importar:
+        Diag(Result, diag::err_embedded_directive) << II->getName();
+        Diag(*ArgMacro, diag::note_macro_expansion_here)
+            << ArgMacro->getIdentifierInfo();
+        DiscardUntilEndOfDirective();
+        return;
       // case tok::pp_include:
       // case tok::pp_import:
       // case tok::pp_include_next:
@@ -998,6 +1006,9 @@ void Preprocessor::HandleDirective(Token &Result) {
     // case tok::pp_include:
       // Handle #include.
       // return HandleIncludeDirective(SavedHash.getLocation(), Result);
+    case tok::pp_incluir:
+    case tok::pp_importar:
+      return HandleIncludeDirective(SavedHash.getLocation(), Result);
     // case tok::pp___include_macros:
     //   // Handle -imacros.
     //   return HandleIncludeMacrosDirective(SavedHash.getLocation(), Result);
@@ -1667,56 +1678,60 @@ bool Preprocessor::checkModuleIsAvailable(const LangOptions &LangOpts,
   return true;
 }
 
-/// HandleIncludeDirective - The "\#include" tokens have just been read, read
+/// HandleIncludeDirective - The "\#incluir" tokens have just been read, read
 /// the file to be included from the lexer, then include it!  This is a common
-/// routine with functionality shared between \#include, \#include_next and
-/// \#import.  LookupFrom is set when this is a \#include_next directive, it
-/// specifies the file to start searching from.
-// void Preprocessor::HandleIncludeDirective(SourceLocation HashLoc,
-//                                           Token &IncludeTok,
-//                                           const DirectoryLookup *LookupFrom,
-//                                           const FileEntry *LookupFromFile) {
-//   Token FilenameTok;
-//   if (LexHeaderName(FilenameTok))
-//     return;
+/// routine with functionality shared between \#incluir and \#importar.
+/// LookupFrom specifies the directory to start searching from, if any.
+void Preprocessor::HandleIncludeDirective(SourceLocation HashLoc,
+                                          Token &IncludeTok,
+                                          const DirectoryLookup *LookupFrom,
+                                          const FileEntry *LookupFromFile) {
+  Token FilenameTok;
+  if (LexHeaderName(FilenameTok))
+    return;
 
-//   if (FilenameTok.isNot(tok::header_name)) {
-//     Diag(FilenameTok.getLocation(), diag::err_pp_expects_filename);
-//     if (FilenameTok.isNot(tok::eod))
-//       DiscardUntilEndOfDirective();
-//     return;
-//   }
+  if (FilenameTok.isNot(tok::header_name)) {
+    Diag(FilenameTok.getLocation(), diag::err_pp_expects_filename);
+    if (FilenameTok.isNot(tok::eod))
+      DiscardUntilEndOfDirective();
+    return;
+  }
 
-//   // Verify that there is nothing after the filename, other than EOD.  Note
-//   // that we allow macros that expand to nothing after the filename, because
-//   // this falls into the category of "#include pp-tokens new-line" specified
-//   // in C99 6.10.2p4.
-//   SourceLocation EndLoc =
-//       CheckEndOfDirective(IncludeTok.getIdentifierInfo()->getNameStart(), true);
-
-//   auto Action = HandleHeaderIncludeOrImport(HashLoc, IncludeTok, FilenameTok,
-//                                             EndLoc, LookupFrom, LookupFromFile);
-//   switch (Action.Kind) {
-//   case ImportAction::None:
-//   case ImportAction::SkippedModuleImport:
-//     break;
-//   case ImportAction::ModuleBegin:
-//     EnterAnnotationToken(SourceRange(HashLoc, EndLoc),
-//                          tok::annot_module_begin, Action.ModuleForHeader);
-//     break;
-//   case ImportAction::ModuleImport:
-//     EnterAnnotationToken(SourceRange(HashLoc, EndLoc),
-//                          tok::annot_module_include, Action.ModuleForHeader);
-//     break;
-//   case ImportAction::Failure:
-//     assert(TheModuleLoader.HadFatalFailure &&
-//            "This should be an early exit only to a fatal error");
-//     TheModuleLoader.HadFatalFailure = true;
-//     IncludeTok.setKind(tok::eof);
-//     CurLexer->cutOffLexing();
-//     return;
-//   }
-// }
+  llvm::TimeTraceScope TimeScope("Include",
+                                 [&]() { return getSpelling(FilenameTok); });
+
+  // Verify that there is nothing after the filename, other than EOD.  Note
+  // that we allow macros that expand to nothing after the filename, because
+  // this falls into the category of "#include pp-tokens new-line" specified
+  // in C99 6.10.2p4.
+  SourceLocation EndLoc =
+      CheckEndOfDirective(IncludeTok.getIdentifierInfo()->getNameStart(), true);
+
+  auto Action = HandleHeaderIncludeOrImport(HashLoc, IncludeTok, FilenameTok,
+                                            EndLoc, LookupFrom, LookupFromFile);
+  switch (Action.Kind) {
+  case ImportAction::None:
+  case ImportAction::SkippedModuleImport:
+    break;
+  case ImportAction::ModuleBegin:
+    EnterAnnotationToken(SourceRange(HashLoc, EndLoc),
+                         tok::annot_module_begin, Action.ModuleForHeader);
+    break;
+  case ImportAction::ModuleImport:
+    EnterAnnotationToken(SourceRange(HashLoc, EndLoc),
+                         tok::annot_module_include, Action.ModuleForHeader);
+    break;
+  case ImportAction::Failure:
+    assert(TheModuleLoader.HadFatalFailure &&
+           "This should be an early exit only to a fatal error");
+    TheModuleLoader.HadFatalFailure = true;
+    IncludeTok.setKind(tok::eof);
+    CurLexer->cutOffLexing();
+    return;
+  }
+
+  recordMemoryCounters();
+}
 
 Optional<FileEntryRef> Preprocessor::LookupHeaderIncludeOrImport(
     const DirectoryLookup *&CurDir, StringRef& Filename,
@@ -2026,16 +2041,16 @@ Preprocessor::ImportAction Preprocessor::HandleHeaderIncludeOrImport(
     FileCharacter = std::max(HeaderInfo.getFileDirFlavor(&File->getFileEntry()),
                              FileCharacter);
 
-  // If this is a '#import' or an import-declaration, don't re-enter the file.
+  // If this is a '#importar' or an import-declaration, don't re-enter the
+  // file. HeaderSearch remembers the file, so later imports of it are skipped
+  // without being lexed again.
   //
   // FIXME: If we have a suggested module for a '#include', and we've already
   // visited this file, don't bother entering it again. We know it has no
   // further effect.
-  // bool EnterOnce =
-  //     IsImportDecl ||
-  //     IncludeTok.getIdentifierInfo()->getPPKeywordID() == tok::pp_import;
-
-  bool EnterOnce = false;
+  bool EnterOnce =
+      IsImportDecl ||
+      IncludeTok.getIdentifierInfo()->getPPKeywordID() == tok::pp_importar;
 
   // Ask HeaderInfo if we should enter this #include file.  If not, #including
   // this file will have no effect.
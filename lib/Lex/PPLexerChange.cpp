@@ -324,6 +324,10 @@ bool Preprocessor::HandleEndOfFile(Token &Result, bool isEndOfMacro) {
     return true;
   }
 
+  // Sample the memory use as each file ends, with its macros defined.
+  if (CurPPLexer)
+    recordMemoryCounters();
+
   // See if this file had a controlling macro.
   if (CurPPLexer) {  // Not ending a macro, ignore it.
     if (const IdentifierInfo *ControllingMacro =
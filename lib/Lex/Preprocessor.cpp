@@ -35,6 +35,7 @@
 #include "latino/Basic/SourceLocation.h"
 #include "latino/Basic/SourceManager.h"
 #include "latino/Basic/TargetInfo.h"
+#include "latino/Basic/TimeTraceCounters.h"
 #include "latino/Lex/CodeCompletionHandler.h"
 #include "latino/Lex/ExternalPreprocessorSource.h"
 #include "latino/Lex/HeaderSearch.h"
@@ -81,11 +82,11 @@ Preprocessor::Preprocessor(std::shared_ptr<PreprocessorOptions> PPOpts,
                            SourceManager &SM, HeaderSearch &Headers,
                            ModuleLoader &TheModuleLoader,
                            IdentifierInfoLookup *IILookup, bool OwnsHeaders,
-                           TranslationUnitKind TUKind)
+                           TranslationUnitKind TUKind, ArenaPool *Arenas)
     : PPOpts(std::move(PPOpts)), Diags(&diags), LangOpts(opts),
       FileMgr(Headers.getFileMgr()), SourceMgr(SM),
       ScratchBuf(new ScratchBuffer(SourceMgr)), HeaderInfo(Headers),
-      TheModuleLoader(TheModuleLoader), ExternalSource(nullptr),
+      TheModuleLoader(TheModuleLoader), ExternalSource(nullptr), BP(Arenas),
       // As the language options may have not been loaded yet (when
       // deserializing an ASTUnit), adding keywords to the identifier table is
       // deferred to Preprocessor::Initialize().
@@ -334,6 +335,14 @@ size_t Preprocessor::getTotalMemory() const {
     + llvm::capacity_in_bytes(CommentHandlers);
 }
 
+void Preprocessor::recordMemoryCounters() const {
+  if (!timeTraceCountersEnabled())
+    return;
+  timeTraceCounter("Preprocessor Memory", {{"Total", getTotalMemory()}});
+  timeTraceCounter("Source Manager Memory",
+                   {{"Content Caches", SourceMgr.getContentCacheSize()}});
+}
+
 Preprocessor::macro_iterator
 Preprocessor::macro_end(bool IncludeExternalMacros) const {
   if (IncludeExternalMacros && ExternalSource &&
@@ -543,6 +552,14 @@ void Preprocessor::EnterMainSourceFile() {
   // If MainFileID is loaded it means we loaded an AST file, no need to enter
   // a main file.
   if (!SourceMgr.isLoadedFileID(MainFileID)) {
+    // Size the identifier table for the main file up front, assuming roughly
+    // one new identifier per 32 bytes of source, so that it does not have to
+    // grow while we lex.
+    if (const FileEntry *FE = SourceMgr.getFileEntryForID(MainFileID))
+      Identifiers.reserve(
+          unsigned(std::min<off_t>(FE->getSize() / 32, 1 << 20)) +
+          Identifiers.size());
+
     // Enter the main file source buffer.
     EnterSourceFile(MainFileID, nullptr, SourceLocation());
 
@@ -168,6 +168,10 @@ void latino::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
   for (Decl *D : S.WeakTopLevelDecls())
     Consumer->HandleTopLevelDecl(DeclGroupRef(D));
 
+  // Sample the memory use at the end of parsing, before the consumer runs.
+  S.getASTContext().recordMemoryCounters();
+  S.getPreprocessor().recordMemoryCounters();
+
   Consumer->HandleTranslationUnit(S.getASTContext());
 
   // Finalize the template instantiation observer chain.
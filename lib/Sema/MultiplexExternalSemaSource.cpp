@@ -145,6 +145,12 @@ void MultiplexExternalSemaSource::ReadComments() {
     Sources[i]->ReadComments();
 }
 
+void MultiplexExternalSemaSource::ReadConstexprEvalResults(
+    const FunctionDecl *FD) {
+  for(size_t i = 0; i < Sources.size(); ++i)
+    Sources[i]->ReadConstexprEvalResults(FD);
+}
+
 void MultiplexExternalSemaSource::StartedDeserializing() {
   for(size_t i = 0; i < Sources.size(); ++i)
     Sources[i]->StartedDeserializing();
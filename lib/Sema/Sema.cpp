@@ -129,6 +129,7 @@ public:
       if (!IncludeStack.empty()) {
         if (llvm::timeTraceProfilerEnabled())
           llvm::timeTraceProfilerEnd();
+        S->getASTContext().recordMemoryCounters();
 
         S->DiagnoseNonDefaultPragmaPack(
             Sema::PragmaPackDiagnoseKind::ChangedStateAtExit,
@@ -19,6 +19,7 @@
 #include "latino/AST/ASTContext.h"
 #include "latino/AST/ASTMutationListener.h"
 #include "latino/AST/ASTUnresolvedSet.h"
+#include "latino/AST/ConstexprEvalCache.h"
 #include "latino/AST/Decl.h"
 #include "latino/AST/DeclBase.h"
 #include "latino/AST/DeclCXX.h"
@@ -117,6 +118,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SaveAndRestore.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/VersionTuple.h"
 #include "llvm/Support/raw_ostream.h"
@@ -3806,6 +3808,32 @@ ASTReader::ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities) {
       for (unsigned I = 0, N = Record.size(); I != N; ++I)
         DeclsToCheckForDeferredDiags.push_back(getGlobalDeclID(F, Record[I]));
       break;
+
+    case CONSTEXPR_EVAL_RESULTS: {
+      auto ReadBytes = [&Record](unsigned &I, std::string &Bytes) {
+        if (I >= Record.size() || Record[I] >= Record.size() - I)
+          return false;
+        Bytes = ReadString(Record, I);
+        return true;
+      };
+      for (unsigned I = 0, N = Record.size(); I < N;) {
+        PendingConstexprEvalResult Result;
+        if (N - I < 4) {
+          Error("invalid constexpr evaluation results record");
+          return Failure;
+        }
+        DeclID ID = getGlobalDeclID(F, Record[I++]);
+        Result.ODRHash = Record[I++];
+        Result.EvalCost.Steps = Record[I++];
+        Result.EvalCost.Depth = Record[I++];
+        if (!ReadBytes(I, Result.Key) || !ReadBytes(I, Result.Value)) {
+          Error("invalid constexpr evaluation results record");
+          return Failure;
+        }
+        PendingConstexprEvalResults[ID].push_back(std::move(Result));
+      }
+      break;
+    }
     }
   }
 }
@@ -4201,6 +4229,16 @@ ASTReader::ASTReadResult ASTReader::ReadAST(StringRef FileName,
                                             SourceLocation ImportLoc,
                                             unsigned ClientLoadCapabilities,
                                             SmallVectorImpl<ImportedSubmodule> *Imported) {
+  llvm::TimeTraceScope TimeScope("ReadAST", FileName);
+
+  // Sample the memory use once the file and its pending declarations are
+  // loaded.
+  auto RecordMemory = llvm::make_scope_exit([&] {
+    PP.recordMemoryCounters();
+    if (ContextObj)
+      ContextObj->recordMemoryCounters();
+  });
+
   llvm::SaveAndRestore<SourceLocation>
     SetCurImportLocRAII(CurrentImportLoc, ImportLoc);
 
@@ -7466,7 +7504,10 @@ Stmt *ASTReader::GetExternalDeclStmt(uint64_t Offset) {
   assert(NumCurrentElementsDeserializing == 0 &&
          "should not be called while already deserializing");
   Deserializing D(this);
-  return ReadStmtFromStream(*Loc.F);
+  Stmt *Body = ReadStmtFromStream(*Loc.F);
+  ++NumBodiesRead;
+  NumBodyBitsRead += Loc.F->DeclsCursor.GetCurrentBitNo() - Loc.Offset;
+  return Body;
 }
 
 void ASTReader::FindExternalLexicalDecls(
@@ -7723,6 +7764,11 @@ void ASTReader::PrintStats() {
     std::fprintf(stderr, "  %u/%u statements read (%f%%)\n",
                  NumStatementsRead, TotalNumStatements,
                  ((float)NumStatementsRead/TotalNumStatements * 100));
+  if (NumLazyBodies)
+    std::fprintf(stderr, "  %u/%u function bodies read (%f%%), %llu bytes\n",
+                 NumBodiesRead, NumLazyBodies,
+                 ((float)NumBodiesRead/NumLazyBodies * 100),
+                 (unsigned long long)(NumBodyBitsRead + 7) / 8);
   if (TotalNumMacros)
     std::fprintf(stderr, "  %u/%u macros read (%f%%)\n",
                  NumMacrosRead, TotalNumMacros,
@@ -9077,6 +9123,33 @@ void ASTReader::ClearSwitchCaseIDs() {
   CurrSwitchCaseStmts->clear();
 }
 
+void ASTReader::ReadConstexprEvalResults(const FunctionDecl *FD) {
+  if (PendingConstexprEvalResults.empty())
+    return;
+
+  // Drop the results of a definition other than the one which will be
+  // evaluated, such as one merged in from another module.
+  FunctionDecl *Definition = const_cast<FunctionDecl *>(FD)->getDefinition();
+
+  // The results may have been stored with any declaration of the callee.
+  ConstexprEvalCache &Cache = getContext().getConstexprEvalCache();
+  for (const FunctionDecl *Redecl : FD->redecls()) {
+    if (!Redecl->isFromASTFile())
+      continue;
+    auto It = PendingConstexprEvalResults.find(Redecl->getGlobalID());
+    if (It == PendingConstexprEvalResults.end())
+      continue;
+
+    for (PendingConstexprEvalResult &Result : It->second) {
+      APValue Value;
+      if (Definition && Result.ODRHash == Definition->getODRHash() &&
+          ConstexprEvalCache::decodeResult(Result.Value, Value))
+        Cache.insertLoaded(FD, Result.Key, std::move(Value), Result.EvalCost);
+    }
+    PendingConstexprEvalResults.erase(It);
+  }
+}
+
 void ASTReader::ReadComments() {
   ASTContext &Context = getContext();
   std::vector<RawComment *> Comments;
@@ -9366,6 +9439,7 @@ void ASTReader::finishPendingActions() {
       const FunctionDecl *Defn = nullptr;
       if (!getContext().getLangOpts().Modules || !FD->hasBody(Defn)) {
         FD->setLazyBody(PB->second);
+        ++NumLazyBodies;
       } else {
         auto *NonConstDefn = const_cast<FunctionDecl*>(Defn);
         mergeDefinitionVisibility(NonConstDefn, FD);
@@ -17,6 +17,7 @@
 #include "latino/AST/ASTUnresolvedSet.h"
 #include "latino/AST/AbstractTypeWriter.h"
 #include "latino/AST/Attr.h"
+#include "latino/AST/ConstexprEvalCache.h"
 #include "latino/AST/Decl.h"
 #include "latino/AST/DeclBase.h"
 #include "latino/AST/DeclCXX.h"
@@ -788,6 +789,7 @@ void ASTWriter::WriteBlockInfoBlock() {
   RECORD(CUDA_PRAGMA_FORCE_HOST_DEVICE_DEPTH);
   RECORD(PP_CONDITIONAL_STACK);
   RECORD(DECLS_TO_CHECK_FOR_DEFERRED_DIAGS);
+  RECORD(CONSTEXPR_EVAL_RESULTS);
 
   // SourceManager Block.
   BLOCK(SOURCE_MANAGER_BLOCK);
@@ -4752,6 +4754,30 @@ ASTFileSignature ASTWriter::WriteASTCore(Sema &SemaRef, StringRef isysroot,
   for (auto *D : SemaRef.DeclsToCheckForDeferredDiags)
     AddDeclRef(D, DeclsToCheckForDeferredDiags);
 
+  // Build a record containing the results of the constexpr calls evaluated
+  // in this file. Each result is stored with the ODR hash of the callee, so
+  // that it is dropped if another definition of the callee is merged in, and
+  // with the cost of its evaluation.
+  RecordData ConstexprEvalResults;
+  Context.getConstexprEvalCache().forEachEvaluated(
+      [&](const FunctionDecl *FD, StringRef Key, const APValue &Value,
+          ConstexprEvalCache::Cost Cost) {
+        FunctionDecl *Definition =
+            const_cast<FunctionDecl *>(FD)->getDefinition();
+        if (!Definition)
+          return;
+        AddDeclRef(FD, ConstexprEvalResults);
+        ConstexprEvalResults.push_back(Definition->getODRHash());
+        ConstexprEvalResults.push_back(Cost.Steps);
+        ConstexprEvalResults.push_back(Cost.Depth);
+        SmallString<16> Result;
+        ConstexprEvalCache::encodeResult(Value, Result);
+        for (StringRef Bytes : {Key, StringRef(Result)}) {
+          ConstexprEvalResults.push_back(Bytes.size());
+          ConstexprEvalResults.append(Bytes.bytes_begin(), Bytes.bytes_end());
+        }
+      });
+
   RecordData DeclUpdatesOffsetsRecord;
 
   // Keep writing types, declarations, and declaration update records
@@ -4849,6 +4875,10 @@ ASTFileSignature ASTWriter::WriteASTCore(Sema &SemaRef, StringRef isysroot,
     Stream.EmitRecord(DECLS_TO_CHECK_FOR_DEFERRED_DIAGS,
         DeclsToCheckForDeferredDiags);
 
+  // Write the record containing the results of constexpr calls.
+  if (!ConstexprEvalResults.empty())
+    Stream.EmitRecord(CONSTEXPR_EVAL_RESULTS, ConstexprEvalResults);
+
   // Write the record containing CUDA-specific declaration references.
   if (!CUDASpecialDeclRefs.empty())
     Stream.EmitRecord(CUDA_SPECIAL_DECL_REFS, CUDASpecialDeclRefs);
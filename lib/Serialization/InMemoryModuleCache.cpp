@@ -40,6 +40,18 @@ InMemoryModuleCache::addBuiltPCM(llvm::StringRef Filename,
   return *PCM.Buffer;
 }
 
+llvm::MemoryBuffer &
+InMemoryModuleCache::replaceBuiltPCM(llvm::StringRef Filename,
+                                     std::unique_ptr<llvm::MemoryBuffer> Buffer) {
+  auto I = PCMs.find(Filename);
+  assert(I != PCMs.end() && "PCM to replace is unknown...");
+
+  auto &PCM = I->second;
+  assert(PCM.IsFinal && "Trying to replace a PCM that was not built...");
+  PCM.Buffer = std::move(Buffer);
+  return *PCM.Buffer;
+}
+
 llvm::MemoryBuffer *
 InMemoryModuleCache::lookupPCM(llvm::StringRef Filename) const {
   auto I = PCMs.find(Filename);
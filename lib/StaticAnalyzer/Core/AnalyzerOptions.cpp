@@ -76,6 +76,8 @@ AnalyzerOptions::getExplorationStrategy() const {
                 ExplorationStrategyKind::UnexploredFirstLocationQueue)
           .Case("bfs_block_dfs_contents",
                 ExplorationStrategyKind::BFSBlockDFSContents)
+          .Case("coverage_first_queue",
+                ExplorationStrategyKind::CoverageFirstQueue)
           .Default(None);
   assert(K.hasValue() && "User mode is invalid.");
   return K.getValue();
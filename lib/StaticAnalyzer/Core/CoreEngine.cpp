@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "latino/StaticAnalyzer/Core/PathSensitive/CoreEngine.h"
+#include "latino/AST/Decl.h"
 #include "latino/AST/Expr.h"
 #include "latino/AST/ExprCXX.h"
 #include "latino/AST/Stmt.h"
@@ -20,6 +21,7 @@
 #include "latino/Analysis/CFG.h"
 #include "latino/Analysis/ProgramPoint.h"
 #include "latino/Basic/LLVM.h"
+#include "latino/Basic/TimeTraceCounters.h"
 #include "latino/StaticAnalyzer/Core/AnalyzerOptions.h"
 #include "latino/StaticAnalyzer/Core/PathSensitive/BlockCounter.h"
 #include "latino/StaticAnalyzer/Core/PathSensitive/ExplodedGraph.h"
@@ -31,6 +33,7 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/TimeProfiler.h"
 #include <algorithm>
 #include <cassert>
 #include <memory>
@@ -66,6 +69,8 @@ static std::unique_ptr<WorkList> generateWorkList(AnalyzerOptions &Opts) {
       return WorkList::makeUnexploredFirstPriorityQueue();
     case ExplorationStrategyKind::UnexploredFirstLocationQueue:
       return WorkList::makeUnexploredFirstPriorityLocationQueue();
+    case ExplorationStrategyKind::CoverageFirstQueue:
+      return WorkList::makeCoverageFirstPriorityQueue();
   }
   llvm_unreachable("Unknown AnalyzerOptions::ExplorationStrategyKind");
 }
@@ -78,6 +83,12 @@ CoreEngine::CoreEngine(ExprEngine &exprengine, FunctionSummariesTy *FS,
 /// ExecuteWorkList - Run the worklist algorithm for a maximum number of steps.
 bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
                                    ProgramStateRef InitState) {
+  llvm::TimeTraceScope TimeScope("ExecuteWorkList", [&]() {
+    if (const auto *ND = dyn_cast<NamedDecl>(L->getDecl()))
+      return ND->getQualifiedNameAsString();
+    return std::string();
+  });
+
   if (G.num_roots() == 0) { // Initialize the analysis by constructing
     // the root if none exists.
 
@@ -125,6 +136,10 @@ bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
   if(!UnlimitedSteps)
     G.reserve(std::min(Steps,PreReservationCap));
 
+  // The number of steps between samples of the graph size for -ftime-trace.
+  const unsigned MemorySampleInterval = 1024;
+  unsigned StepsSinceSample = 0;
+
   while (WList->hasWork()) {
     if (!UnlimitedSteps) {
       if (Steps == 0) {
@@ -136,6 +151,11 @@ bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
 
     NumSteps++;
 
+    if (++StepsSinceSample == MemorySampleInterval) {
+      recordMemoryCounters();
+      StepsSinceSample = 0;
+    }
+
     const WorkListUnit& WU = WList->dequeue();
 
     // Set the current block counter.
@@ -147,9 +167,18 @@ bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
     dispatchWorkItem(Node, Node->getLocation(), WU);
   }
   ExprEng.processEndWorklist();
+  recordMemoryCounters();
   return WList->hasWork();
 }
 
+void CoreEngine::recordMemoryCounters() {
+  if (!timeTraceCountersEnabled())
+    return;
+  timeTraceCounter("Exploded Graph",
+                   {{"Nodes", G.size()},
+                    {"Allocator", G.getAllocator().getTotalMemory()}});
+}
+
 void CoreEngine::dispatchWorkItem(ExplodedNode* Pred, ProgramPoint Loc,
                                   const WorkListUnit& WU) {
   // Dispatch on the location type.
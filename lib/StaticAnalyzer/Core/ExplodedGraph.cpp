@@ -21,6 +21,7 @@
 #include "latino/Analysis/Support/BumpVector.h"
 #include "latino/Basic/LLVM.h"
 #include "latino/StaticAnalyzer/Core/PathSensitive/CallEvent.h"
+#include "latino/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "latino/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "latino/StaticAnalyzer/Core/PathSensitive/ProgramState_Fwd.h"
 #include "llvm/ADT/DenseSet.h"
@@ -68,7 +69,7 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   // are used only for intermediate processing, and are not essential
   // for analyzer history:
   //
-  // (a) PreStmtPurgeDeadSymbols
+  // (a) PreStmtPurgeDeadSymbols, unless a checker tagged it
   //
   // We then discard all other nodes where *all* of the following conditions
   // apply:
@@ -82,8 +83,13 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   // (9) The PostStmt isn't for a non-consumed Stmt or Expr.
   // (10) The successor is neither a CallExpr StmtPoint nor a CallEnter or
   //      PreImplicitCall (so that we would be able to find it when retrying a
-  //      call with no inlining).
-  // FIXME: It may be safe to reclaim PreCall and PostCall nodes as well.
+  //      call with no inlining). This only applies if calls may be retried.
+  //
+  // Nodes at call boundaries are kept: CallEnter and CallExitEnd nodes anchor
+  // the call pieces of path diagnostics, and PreCall and PostCall nodes are
+  // where checkers observe calls.
+  // FIXME: It may be safe to reclaim PreCall and PostCall nodes as well, but
+  // that has to be shown together with the memory it saves.
 
   // Conditions 1 and 2.
   if (node->pred_size() != 1 || node->succ_size() != 1)
@@ -101,7 +107,8 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   // analysis history and are not consulted by any client code.
   ProgramPoint progPoint = node->getLocation();
   if (progPoint.getAs<PreStmtPurgeDeadSymbols>())
-    return !progPoint.getTag();
+    return !progPoint.getTag() ||
+           progPoint.getTag() == ExprEngine::cleanupNodeTag();
 
   // Condition 3.
   if (!progPoint.getAs<PostStmt>() || progPoint.getAs<PostStore>())
@@ -139,6 +146,8 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
     return false;
 
   // Condition 10.
+  if (!KeepNodesBeforeCalls)
+    return true;
   const ProgramPoint SuccLoc = succ->getLocation();
   if (Optional<StmtPoint> SP = SuccLoc.getAs<StmtPoint>())
     if (CallEvent::isCallStmt(SP->getStmt()))
@@ -179,9 +188,19 @@ void ExplodedGraph::reclaimRecentlyAllocatedNodes() {
     return;
   ReclaimCounter = ReclaimNodeInterval;
 
-  for (const auto node : ChangedNodes)
+  // The nodes still without a successor last time have likely been
+  // processed since.
+  for (const auto node : FrontierNodes)
     if (shouldCollect(node))
       collectNode(node);
+  FrontierNodes.clear();
+
+  for (const auto node : ChangedNodes) {
+    if (node->succ_empty() && !node->isSink())
+      FrontierNodes.push_back(node);
+    else if (shouldCollect(node))
+      collectNode(node);
+  }
   ChangedNodes.clear();
 }
 
@@ -235,7 +254,8 @@ void ExplodedNode::NodeGroup::addNode(ExplodedNode *N, ExplodedGraph &G) {
 
     BumpVectorContext &Ctx = G.getNodeAllocator();
     V = G.getAllocator().Allocate<ExplodedNodeVector>();
-    new (V) ExplodedNodeVector(Ctx, 4);
+    // Most groups of several nodes are the two successors of a branch.
+    new (V) ExplodedNodeVector(Ctx, 2);
     V->push_back(Old, Ctx);
 
     Storage = V;
@@ -0,0 +1,167 @@
+//===- FunctionSummaryCache.cpp - Summaries kept across runs --------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the on-disk cache of function summaries. The cache is
+// a JSON file:
+//
+//   {"version": 1, "config": "<hex>", "functions": {
+//     "<lookup name>": {"hash": "<hex>", "reports": 0, "blocks": 12,
+//                       "visited": [0, 1, ...], "inlined": [...],
+//                       "not_inlinable": [...]}}}
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/StaticAnalyzer/Core/PathSensitive/FunctionSummaryCache.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace latino;
+using namespace ento;
+
+static constexpr int64_t CacheVersion = 1;
+
+static llvm::Error makeMalformedError(StringRef Path) {
+  return llvm::createStringError(llvm::errc::invalid_argument,
+                                 "malformed function summary cache '%s'",
+                                 Path.str().c_str());
+}
+
+static bool readHash(const llvm::json::Object &O, StringRef Key,
+                     uint64_t &Result) {
+  Optional<StringRef> Hex = O.getString(Key);
+  return Hex && !Hex->getAsInteger(16, Result);
+}
+
+static bool readStrings(const llvm::json::Object &O, StringRef Key,
+                        std::vector<std::string> &Result) {
+  const llvm::json::Array *A = O.getArray(Key);
+  if (!A)
+    return false;
+  for (const llvm::json::Value &V : *A) {
+    Optional<StringRef> S = V.getAsString();
+    if (!S)
+      return false;
+    Result.push_back(S->str());
+  }
+  return true;
+}
+
+static bool readSummary(const llvm::json::Object &O,
+                        CachedFunctionSummary &Summary) {
+  Optional<int64_t> Reports = O.getInteger("reports");
+  Optional<int64_t> Blocks = O.getInteger("blocks");
+  const llvm::json::Array *Visited = O.getArray("visited");
+  if (!readHash(O, "hash", Summary.Hash) || !Reports || !Blocks || !Visited)
+    return false;
+  Summary.NumReports = *Reports;
+  Summary.TotalBlocks = *Blocks;
+
+  for (const llvm::json::Value &V : *Visited) {
+    Optional<int64_t> ID = V.getAsInteger();
+    if (!ID || *ID < 0 || *ID >= *Blocks)
+      return false;
+    Summary.VisitedBlocks.push_back(*ID);
+  }
+  return readStrings(O, "inlined", Summary.InlinedCallees) &&
+         readStrings(O, "not_inlinable", Summary.NotInlinableCallees);
+}
+
+llvm::Expected<FunctionSummaryCache>
+FunctionSummaryCache::load(StringRef Path, uint64_t ConfigHash) {
+  FunctionSummaryCache Cache(ConfigHash);
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(Path);
+  if (!Buffer) {
+    if (Buffer.getError() == std::errc::no_such_file_or_directory)
+      return std::move(Cache);
+    return llvm::errorCodeToError(Buffer.getError());
+  }
+
+  llvm::Expected<llvm::json::Value> Root =
+      llvm::json::parse((*Buffer)->getBuffer());
+  if (!Root) {
+    llvm::consumeError(Root.takeError());
+    return makeMalformedError(Path);
+  }
+  const llvm::json::Object *O = Root->getAsObject();
+  if (!O)
+    return makeMalformedError(Path);
+
+  // A cache of another version or configuration is not an error; it is
+  // replaced when the analysis finishes.
+  uint64_t FileConfigHash;
+  if (O->getInteger("version") != CacheVersion ||
+      !readHash(*O, "config", FileConfigHash) || FileConfigHash != ConfigHash)
+    return std::move(Cache);
+
+  const llvm::json::Object *Functions = O->getObject("functions");
+  if (!Functions)
+    return makeMalformedError(Path);
+  for (const auto &Entry : *Functions) {
+    const llvm::json::Object *F = Entry.second.getAsObject();
+    CachedFunctionSummary Summary;
+    if (!F || !readSummary(*F, Summary))
+      return makeMalformedError(Path);
+    Cache.insert(Entry.first, std::move(Summary));
+  }
+  return std::move(Cache);
+}
+
+llvm::Error FunctionSummaryCache::save(StringRef Path) const {
+  llvm::json::Object Functions;
+  for (const auto &Entry : Summaries) {
+    const CachedFunctionSummary &S = Entry.second;
+    Functions[Entry.first()] = llvm::json::Object{
+        {"hash", llvm::utohexstr(S.Hash)},
+        {"reports", S.NumReports},
+        {"blocks", S.TotalBlocks},
+        {"visited", llvm::json::Array(S.VisitedBlocks)},
+        {"inlined", llvm::json::Array(S.InlinedCallees)},
+        {"not_inlinable", llvm::json::Array(S.NotInlinableCallees)}};
+  }
+  llvm::json::Value Root =
+      llvm::json::Object{{"version", CacheVersion},
+                         {"config", llvm::utohexstr(ConfigHash)},
+                         {"functions", std::move(Functions)}};
+
+  // Write a temporary file next to the cache and move it into place.
+  int FD;
+  SmallString<128> TempPath;
+  if (std::error_code EC =
+          llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", FD, TempPath))
+    return llvm::errorCodeToError(EC);
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Root;
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return llvm::createStringError(llvm::errc::io_error,
+                                     "cannot write '%s'", TempPath.c_str());
+    }
+  }
+  if (std::error_code EC = llvm::sys::fs::rename(TempPath, Path)) {
+    llvm::sys::fs::remove(TempPath);
+    return llvm::errorCodeToError(EC);
+  }
+  return llvm::Error::success();
+}
+
+const CachedFunctionSummary *
+FunctionSummaryCache::lookup(StringRef Name, uint64_t Hash) const {
+  auto I = Summaries.find(Name);
+  if (I == Summaries.end() || I->second.Hash != Hash)
+    return nullptr;
+  return &I->second;
+}
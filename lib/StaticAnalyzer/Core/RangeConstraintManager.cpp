@@ -20,6 +20,8 @@
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/ImmutableSet.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <iterator>
 
 using namespace latino;
 using namespace ento;
@@ -101,12 +103,40 @@ public:
 //                           RangeSet implementation
 //===----------------------------------------------------------------------===//
 
-void RangeSet::IntersectInRange(BasicValueFactory &BV, Factory &F,
+/// Orders ranges by their values, unlike the pointer comparison of the pairs
+/// they are.
+static bool isLess(const Range &LHS, const Range &RHS) {
+  return LHS.From() < RHS.From() ||
+         (!(RHS.From() < LHS.From()) && LHS.To() < RHS.To());
+}
+
+RangeSet RangeSet::Factory::getPersistentSet(ContainerType Ranges) {
+  llvm::FoldingSetNodeID ID;
+  StorageNode::Profile(ID, Ranges);
+
+  void *InsertPos;
+  if (StorageNode *Existing = Sets.FindNodeOrInsertPos(ID, InsertPos))
+    return RangeSet(Existing);
+
+  StorageNode *New = new (Arena.Allocate()) StorageNode(std::move(Ranges));
+  Sets.InsertNode(New, InsertPos);
+  return RangeSet(New);
+}
+
+RangeSet RangeSet::addRange(Factory &F, const RangeSet &RS) const {
+  ContainerType Ranges;
+  Ranges.reserve(Impl->Ranges.size() + RS.Impl->Ranges.size());
+  std::merge(begin(), end(), RS.begin(), RS.end(), std::back_inserter(Ranges),
+             isLess);
+  Ranges.erase(std::unique(Ranges.begin(), Ranges.end()), Ranges.end());
+  return F.getPersistentSet(std::move(Ranges));
+}
+
+void RangeSet::IntersectInRange(BasicValueFactory &BV,
                                 const llvm::APSInt &Lower,
                                 const llvm::APSInt &Upper,
-                                PrimRangeSet &newRanges,
-                                PrimRangeSet::iterator &i,
-                                PrimRangeSet::iterator &e) const {
+                                ContainerType &newRanges, iterator &i,
+                                iterator &e) const {
   // There are six cases for each range R in the set:
   //   1. R is entirely before the intersection range.
   //   2. R is entirely after the intersection range.
@@ -125,17 +155,16 @@ void RangeSet::IntersectInRange(BasicValueFactory &BV, Factory &F,
 
     if (i->Includes(Lower)) {
       if (i->Includes(Upper)) {
-        newRanges =
-            F.add(newRanges, Range(BV.getValue(Lower), BV.getValue(Upper)));
+        newRanges.push_back(Range(BV.getValue(Lower), BV.getValue(Upper)));
         break;
       } else
-        newRanges = F.add(newRanges, Range(BV.getValue(Lower), i->To()));
+        newRanges.push_back(Range(BV.getValue(Lower), i->To()));
     } else {
       if (i->Includes(Upper)) {
-        newRanges = F.add(newRanges, Range(i->From(), BV.getValue(Upper)));
+        newRanges.push_back(Range(i->From(), BV.getValue(Upper)));
         break;
       } else
-        newRanges = F.add(newRanges, *i);
+        newRanges.push_back(*i);
     }
   }
 }
@@ -147,14 +176,7 @@ const llvm::APSInt &RangeSet::getMinValue() const {
 
 const llvm::APSInt &RangeSet::getMaxValue() const {
   assert(!isEmpty());
-  // NOTE: It's a shame that we can't implement 'getMaxValue' without scanning
-  //       the whole tree to get to the last element.
-  //       llvm::ImmutableSet should support decrement for 'end' iterators
-  //       or reverse order iteration.
-  auto It = begin();
-  for (auto End = end(); std::next(It) != End; ++It) {
-  }
-  return It->To();
+  return Impl->Ranges.back().To();
 }
 
 bool RangeSet::pin(llvm::APSInt &Lower, llvm::APSInt &Upper) const {
@@ -252,39 +274,61 @@ bool RangeSet::pin(llvm::APSInt &Lower, llvm::APSInt &Upper) const {
 // or, alternatively, /removing/ all integers between Upper and Lower.
 RangeSet RangeSet::Intersect(BasicValueFactory &BV, Factory &F,
                              llvm::APSInt Lower, llvm::APSInt Upper) const {
-  PrimRangeSet newRanges = F.getEmptySet();
-
   if (isEmpty() || !pin(Lower, Upper))
-    return newRanges;
+    return F.getEmptySet();
 
-  PrimRangeSet::iterator i = begin(), e = end();
+  ContainerType newRanges;
+  iterator i = begin(), e = end();
   if (Lower <= Upper)
-    IntersectInRange(BV, F, Lower, Upper, newRanges, i, e);
+    IntersectInRange(BV, Lower, Upper, newRanges, i, e);
   else {
     // The order of the next two statements is important!
     // IntersectInRange() does not reset the iteration state for i and e.
     // Therefore, the lower range most be handled first.
-    IntersectInRange(BV, F, BV.getMinValue(Upper), Upper, newRanges, i, e);
-    IntersectInRange(BV, F, Lower, BV.getMaxValue(Lower), newRanges, i, e);
+    IntersectInRange(BV, BV.getMinValue(Upper), Upper, newRanges, i, e);
+    IntersectInRange(BV, Lower, BV.getMaxValue(Lower), newRanges, i, e);
   }
 
-  return newRanges;
+  return F.getPersistentSet(std::move(newRanges));
 }
 
 // Returns a set containing the values in the receiving set, intersected with
 // the range set passed as parameter.
 RangeSet RangeSet::Intersect(BasicValueFactory &BV, Factory &F,
                              const RangeSet &Other) const {
-  PrimRangeSet newRanges = F.getEmptySet();
+  if (*this == Other)
+    return *this;
+  if (isEmpty() || Other.isEmpty())
+    return F.getEmptySet();
 
-  for (iterator i = Other.begin(), e = Other.end(); i != e; ++i) {
-    RangeSet newPiece = Intersect(BV, F, i->From(), i->To());
-    for (iterator j = newPiece.begin(), ee = newPiece.end(); j != ee; ++j) {
-      newRanges = F.add(newRanges, *j);
+  // The ranges of a set of another type are converted to the type of this
+  // set one at a time.
+  if (!(APSIntType(getMinValue()) == APSIntType(Other.getMinValue()))) {
+    ContainerType newRanges;
+    for (const Range &R : Other) {
+      RangeSet newPiece = Intersect(BV, F, R.From(), R.To());
+      newRanges.append(newPiece.begin(), newPiece.end());
     }
+    return F.getPersistentSet(std::move(newRanges));
   }
 
-  return newRanges;
+  // Otherwise, both sets are sorted, so a single pass over them finds the
+  // overlapping ranges. The bounds of the result are bounds of the inputs.
+  ContainerType newRanges;
+  iterator i = begin(), e = end();
+  for (const Range &R : Other) {
+    while (i != e && i->To() < R.From())
+      ++i;
+    // A range of this set may overlap the next range of Other as well, so
+    // 'i' stays on it.
+    for (iterator j = i; j != e && j->From() <= R.To(); ++j) {
+      const llvm::APSInt &From = j->From() < R.From() ? R.From() : j->From();
+      const llvm::APSInt &To = R.To() < j->To() ? R.To() : j->To();
+      newRanges.push_back(Range(From, To));
+    }
+  }
+
+  return F.getPersistentSet(std::move(newRanges));
 }
 
 // Turn all [A, B] ranges to [-B, -A], when "-" is a C-like unary minus
@@ -306,62 +350,59 @@ RangeSet RangeSet::Intersect(BasicValueFactory &BV, Factory &F,
 // Negate restores disrupted ranges on bounds,
 // e.g. [MIN, B] => [MIN, MIN] U [-B, MAX] => [MIN, B].
 RangeSet RangeSet::Negate(BasicValueFactory &BV, Factory &F) const {
-  PrimRangeSet newRanges = F.getEmptySet();
-
   if (isEmpty())
-    return newRanges;
+    return *this;
 
   const llvm::APSInt sampleValue = getMinValue();
   const llvm::APSInt &MIN = BV.getMinValue(sampleValue);
   const llvm::APSInt &MAX = BV.getMaxValue(sampleValue);
 
+  ContainerType newRanges;
+  newRanges.reserve(Impl->Ranges.size() + 1);
+
   // Handle a special case for MIN value.
-  iterator i = begin();
+  iterator i = begin(), e = end();
   const llvm::APSInt &from = i->From();
   const llvm::APSInt &to = i->To();
   if (from == MIN) {
     // If [from, to] are [MIN, MAX], then just return the same [MIN, MAX].
-    if (to == MAX) {
-      newRanges = ranges;
-    } else {
-      // Add separate range for the lowest value.
-      newRanges = F.add(newRanges, Range(MIN, MIN));
-      // Skip adding the second range in case when [from, to] are [MIN, MIN].
-      if (to != MIN) {
-        newRanges = F.add(newRanges, Range(BV.getValue(-to), MAX));
-      }
-    }
+    if (to == MAX)
+      return *this;
+
+    // Add separate range for the lowest value.
+    newRanges.push_back(Range(MIN, MIN));
+    // Skip adding the second range in case when [from, to] are [MIN, MIN].
+    if (to != MIN)
+      newRanges.push_back(Range(BV.getValue(-to), MAX));
     // Skip the first range in the loop.
     ++i;
   }
 
-  // Negate all other ranges.
-  for (iterator e = end(); i != e; ++i) {
+  // Negate all other ranges. Negation reverses their order, so add them
+  // backwards to keep the ranges sorted after the ones above.
+  size_t FirstNegated = newRanges.size();
+  for (; i != e; ++i) {
     // Negate int values.
     const llvm::APSInt &newFrom = BV.getValue(-i->To());
     const llvm::APSInt &newTo = BV.getValue(-i->From());
     // Add a negated range.
-    newRanges = F.add(newRanges, Range(newFrom, newTo));
+    newRanges.push_back(Range(newFrom, newTo));
   }
-
-  if (newRanges.isSingleton())
-    return newRanges;
+  std::reverse(newRanges.begin() + FirstNegated, newRanges.end());
+  // The negation of [MIN, N] goes after the ranges that end at or below -N.
+  if (FirstNegated == 2)
+    std::inplace_merge(newRanges.begin() + 1, newRanges.begin() + 2,
+                       newRanges.end(), isLess);
 
   // Try to find and unite next ranges:
   // [MIN, MIN] & [MIN + 1, N] => [MIN, N].
-  iterator iter1 = newRanges.begin();
-  iterator iter2 = std::next(iter1);
-
-  if (iter1->To() == MIN && (iter2->From() - 1) == MIN) {
-    const llvm::APSInt &to = iter2->To();
-    // remove adjacent ranges
-    newRanges = F.remove(newRanges, *iter1);
-    newRanges = F.remove(newRanges, *newRanges.begin());
-    // add united range
-    newRanges = F.add(newRanges, Range(MIN, to));
+  if (newRanges.size() > 1 && newRanges[0].To() == MIN &&
+      (newRanges[1].From() - 1) == MIN) {
+    newRanges[1] = Range(MIN, newRanges[1].To());
+    newRanges.erase(newRanges.begin());
   }
 
-  return newRanges;
+  return F.getPersistentSet(std::move(newRanges));
 }
 
 void RangeSet::print(raw_ostream &os) const {
@@ -28,9 +28,15 @@
 #include "latino/StaticAnalyzer/Core/PathSensitive/MemRegion.h"
 #include "latino/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "latino/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
+#include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/ImmutableMap.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/iterator.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/TrailingObjects.h"
 #include "llvm/Support/raw_ostream.h"
+#include <memory>
 #include <utility>
 
 using namespace latino;
@@ -144,17 +150,229 @@ void BindingKey::dump() const { llvm::errs() << *this; }
 // Actual Store type.
 //===----------------------------------------------------------------------===//
 
-typedef llvm::ImmutableMap<BindingKey, SVal>    ClusterBindings;
-typedef llvm::ImmutableMapRef<BindingKey, SVal> ClusterBindingsRef;
 typedef std::pair<BindingKey, SVal> BindingPair;
 
+namespace {
+/// The bindings of a cluster kept in a sorted array. The factory uniques
+/// them, so every state with the same cluster shares one array.
+class FlatClusterNode final
+    : public llvm::FoldingSetNode,
+      private llvm::TrailingObjects<FlatClusterNode, BindingPair> {
+  friend TrailingObjects;
+  unsigned NumBindings;
+
+  explicit FlatClusterNode(ArrayRef<BindingPair> Bindings)
+      : NumBindings(Bindings.size()) {
+    std::uninitialized_copy(Bindings.begin(), Bindings.end(),
+                            getTrailingObjects<BindingPair>());
+  }
+
+public:
+  static FlatClusterNode *Create(llvm::BumpPtrAllocator &Alloc,
+                                 ArrayRef<BindingPair> Bindings) {
+    void *Mem = Alloc.Allocate(totalSizeToAlloc<BindingPair>(Bindings.size()),
+                               alignof(FlatClusterNode));
+    return new (Mem) FlatClusterNode(Bindings);
+  }
+
+  ArrayRef<BindingPair> bindings() const {
+    return llvm::makeArrayRef(getTrailingObjects<BindingPair>(), NumBindings);
+  }
+
+  static void Profile(llvm::FoldingSetNodeID &ID,
+                      ArrayRef<BindingPair> Bindings) {
+    for (const BindingPair &B : Bindings) {
+      B.first.Profile(ID);
+      B.second.Profile(ID);
+    }
+  }
+  void Profile(llvm::FoldingSetNodeID &ID) const { Profile(ID, bindings()); }
+};
+
+/// The bindings of one cluster, that is, of a base region and its
+/// subregions. Depending on the 'region-store-flat-clusters' option, they
+/// are kept either in a balanced tree or in a uniqued sorted array; the
+/// factory that made a cluster tells which. An empty cluster is both. With
+/// the flat layout, a cluster that outgrows the arrays is kept in a tree.
+class ClusterBindings {
+public:
+  typedef llvm::ImmutableMap<BindingKey, SVal> TreeMapTy;
+
+  class iterator
+      : public llvm::iterator_facade_base<iterator, std::forward_iterator_tag,
+                                          const BindingPair> {
+    TreeMapTy::iterator TreeI;
+    const BindingPair *FlatI;
+
+  public:
+    /// Only one of the iterators is used; \p FlatI is null for a tree.
+    iterator(TreeMapTy::iterator TreeI, const BindingPair *FlatI)
+        : TreeI(TreeI), FlatI(FlatI) {}
+
+    const BindingPair &operator*() const { return FlatI ? *FlatI : *TreeI; }
+    const BindingKey &getKey() const { return (**this).first; }
+    const SVal &getData() const { return (**this).second; }
+
+    iterator &operator++() {
+      if (FlatI)
+        ++FlatI;
+      else
+        ++TreeI;
+      return *this;
+    }
+
+    bool operator==(const iterator &X) const {
+      return FlatI == X.FlatI && TreeI == X.TreeI;
+    }
+  };
+
+  explicit ClusterBindings(TreeMapTy Tree) : Tree(Tree) {}
+  explicit ClusterBindings(const FlatClusterNode *Flat)
+      : Tree(nullptr), Flat(Flat) {}
+
+  bool isEmpty() const { return !Flat && Tree.isEmpty(); }
+  bool isFlat() const { return Flat != nullptr; }
+  const TreeMapTy &getTree() const { return Tree; }
+  ArrayRef<BindingPair> getFlatBindings() const {
+    return Flat ? Flat->bindings() : ArrayRef<BindingPair>();
+  }
+
+  iterator begin() const {
+    return iterator(Tree.begin(), Flat ? Flat->bindings().begin() : nullptr);
+  }
+  iterator end() const {
+    return iterator(Tree.end(), Flat ? Flat->bindings().end() : nullptr);
+  }
+
+  const SVal *lookup(BindingKey K) const {
+    if (!Flat)
+      return Tree.lookup(K);
+    ArrayRef<BindingPair> Bindings = Flat->bindings();
+    auto I = llvm::partition_point(
+        Bindings, [K](const BindingPair &B) { return B.first < K; });
+    if (I != Bindings.end() && I->first == K)
+      return &I->second;
+    return nullptr;
+  }
+
+  bool operator==(const ClusterBindings &X) const {
+    return Flat == X.Flat && Tree == X.Tree;
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    ID.AddPointer(Flat);
+    Tree.Profile(ID);
+  }
+
+private:
+  TreeMapTy Tree;
+  const FlatClusterNode *Flat = nullptr;
+};
+
+/// Creates the clusters of one layout.
+class ClusterBindingsFactory {
+  /// The most bindings a flat cluster has. Every update copies the array, so
+  /// larger clusters are moved to a tree.
+  static constexpr size_t MaxFlatBindings = 64;
+
+  ClusterBindings::TreeMapTy::Factory TreeFactory;
+  llvm::BumpPtrAllocator &Alloc;
+  llvm::FoldingSet<FlatClusterNode> FlatNodes;
+  const bool UseFlatLayout;
+
+  ClusterBindings getFlatCluster(ArrayRef<BindingPair> Bindings) {
+    if (Bindings.empty())
+      return getEmptyMap();
+
+    llvm::FoldingSetNodeID ID;
+    FlatClusterNode::Profile(ID, Bindings);
+    void *InsertPos;
+    FlatClusterNode *Node = FlatNodes.FindNodeOrInsertPos(ID, InsertPos);
+    if (!Node) {
+      Node = FlatClusterNode::Create(Alloc, Bindings);
+      FlatNodes.InsertNode(Node, InsertPos);
+    }
+    return ClusterBindings(Node);
+  }
+
+public:
+  ClusterBindingsFactory(llvm::BumpPtrAllocator &Alloc, bool UseFlatLayout)
+      : TreeFactory(Alloc), Alloc(Alloc), UseFlatLayout(UseFlatLayout) {}
+
+  ClusterBindings getEmptyMap() {
+    return ClusterBindings(TreeFactory.getEmptyMap());
+  }
+
+  ClusterBindings add(const ClusterBindings &C, BindingKey K, SVal V) {
+    if (!UseFlatLayout || (!C.isFlat() && !C.isEmpty()))
+      return ClusterBindings(TreeFactory.add(C.getTree(), K, V));
+
+    ArrayRef<BindingPair> Old = C.getFlatBindings();
+    auto I = llvm::partition_point(
+        Old, [K](const BindingPair &B) { return B.first < K; });
+    bool Replaces = I != Old.end() && I->first == K;
+    if (Replaces && I->second == V)
+      return C;
+
+    if (!Replaces && Old.size() == MaxFlatBindings) {
+      llvm::ImmutableMapRef<BindingKey, SVal> Tree(TreeFactory.getEmptyMap(),
+                                                   TreeFactory);
+      for (const BindingPair &B : Old)
+        Tree = Tree.add(B.first, B.second);
+      return ClusterBindings(Tree.add(K, V).asImmutableMap());
+    }
+
+    SmallVector<BindingPair, 16> New(Old.begin(), I);
+    New.emplace_back(K, V);
+    New.append(Replaces ? std::next(I) : I, Old.end());
+    return getFlatCluster(New);
+  }
+
+  ClusterBindings remove(const ClusterBindings &C, BindingKey K) {
+    return remove(C, llvm::makeArrayRef(K));
+  }
+
+  /// Removes the bindings of all of \p Keys at once.
+  ClusterBindings remove(const ClusterBindings &C, ArrayRef<BindingKey> Keys) {
+    if (!C.isFlat()) {
+      llvm::ImmutableMapRef<BindingKey, SVal> Result(C.getTree(), TreeFactory);
+      for (BindingKey K : Keys)
+        Result = Result.remove(K);
+      return ClusterBindings(Result.asImmutableMap());
+    }
+
+    // Walk the bindings and the sorted keys together. The keys usually come
+    // from an iteration over the cluster, so they are sorted already.
+    SmallVector<BindingKey, 16> SortedKeys;
+    if (!std::is_sorted(Keys.begin(), Keys.end())) {
+      SortedKeys.assign(Keys.begin(), Keys.end());
+      llvm::sort(SortedKeys);
+      Keys = SortedKeys;
+    }
+
+    ArrayRef<BindingPair> Old = C.getFlatBindings();
+    SmallVector<BindingPair, 16> New;
+    const BindingKey *KI = Keys.begin(), *KE = Keys.end();
+    for (const BindingPair &B : Old) {
+      while (KI != KE && *KI < B.first)
+        ++KI;
+      if (KI == KE || B.first < *KI)
+        New.push_back(B);
+    }
+    if (New.size() == Old.size())
+      return C;
+    return getFlatCluster(New);
+  }
+};
+} // end anonymous namespace
+
 typedef llvm::ImmutableMap<const MemRegion *, ClusterBindings>
         RegionBindings;
 
 namespace {
 class RegionBindingsRef : public llvm::ImmutableMapRef<const MemRegion *,
                                  ClusterBindings> {
-  ClusterBindings::Factory *CBFactory;
+  ClusterBindingsFactory *CBFactory;
 
   // This flag indicates whether the current bindings are within the analysis
   // that has started from main(). It affects how we perform loads from
@@ -171,7 +389,7 @@ public:
   typedef llvm::ImmutableMapRef<const MemRegion *, ClusterBindings>
           ParentTy;
 
-  RegionBindingsRef(ClusterBindings::Factory &CBFactory,
+  RegionBindingsRef(ClusterBindingsFactory &CBFactory,
                     const RegionBindings::TreeTy *T,
                     RegionBindings::TreeTy::Factory *F,
                     bool IsMainAnalysis)
@@ -179,7 +397,7 @@ public:
         CBFactory(&CBFactory), IsMainAnalysis(IsMainAnalysis) {}
 
   RegionBindingsRef(const ParentTy &P,
-                    ClusterBindings::Factory &CBFactory,
+                    ClusterBindingsFactory &CBFactory,
                     bool IsMainAnalysis)
       : llvm::ImmutableMapRef<const MemRegion *, ClusterBindings>(P),
         CBFactory(&CBFactory), IsMainAnalysis(IsMainAnalysis) {}
@@ -353,7 +571,7 @@ public:
   const RegionStoreFeatures Features;
 
   RegionBindings::Factory RBFactory;
-  mutable ClusterBindings::Factory CBFactory;
+  mutable ClusterBindingsFactory CBFactory;
 
   typedef std::vector<SVal> SValListTy;
 private:
@@ -380,7 +598,11 @@ private:
 public:
   RegionStoreManager(ProgramStateManager& mgr, const RegionStoreFeatures &f)
     : StoreManager(mgr), Features(f),
-      RBFactory(mgr.getAllocator()), CBFactory(mgr.getAllocator()),
+      RBFactory(mgr.getAllocator()),
+      CBFactory(mgr.getAllocator(),
+                mgr.getOwningEngine()
+                    .getAnalysisManager()
+                    .options.ShouldUseFlatRegionStoreClusters),
       SmallStructLimit(0) {
     ExprEngine &Eng = StateMgr.getOwningEngine();
     AnalyzerOptions &Options = Eng.getAnalysisManager().options;
@@ -961,11 +1183,10 @@ RegionStoreManager::removeSubRegionBindings(RegionBindingsConstRef B,
   collectSubRegionBindings(Bindings, svalBuilder, *Cluster, Top, TopKey,
                            /*IncludeAllDefaultBindings=*/false);
 
-  ClusterBindingsRef Result(*Cluster, CBFactory);
-  for (SmallVectorImpl<BindingPair>::const_iterator I = Bindings.begin(),
-                                                    E = Bindings.end();
-       I != E; ++I)
-    Result = Result.remove(I->first);
+  SmallVector<BindingKey, 32> Keys;
+  for (const BindingPair &Binding : Bindings)
+    Keys.push_back(Binding.first);
+  ClusterBindings Result = CBFactory.remove(*Cluster, Keys);
 
   // If we're invalidating a region with a symbolic offset, we need to make sure
   // we don't treat the base region as uninitialized anymore.
@@ -973,13 +1194,14 @@ RegionStoreManager::removeSubRegionBindings(RegionBindingsConstRef B,
   // collectSubRegionBindings.
   if (TopKey.hasSymbolicOffset()) {
     const SubRegion *Concrete = TopKey.getConcreteOffsetRegion();
-    Result = Result.add(BindingKey::Make(Concrete, BindingKey::Default),
-                        UnknownVal());
+    Result = CBFactory.add(Result,
+                           BindingKey::Make(Concrete, BindingKey::Default),
+                           UnknownVal());
   }
 
   if (Result.isEmpty())
     return B.remove(ClusterHead);
-  return B.add(ClusterHead, Result.asImmutableMap());
+  return B.add(ClusterHead, Result);
 }
 
 namespace {
@@ -12,11 +12,13 @@
 
 #include "latino/StaticAnalyzer/Core/PathSensitive/WorkList.h"
 #include "llvm/ADT/PriorityQueue.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Statistic.h"
 #include <deque>
+#include <limits>
 #include <vector>
 
 using namespace latino;
@@ -311,3 +313,127 @@ public:
 std::unique_ptr<WorkList> WorkList::makeUnexploredFirstPriorityLocationQueue() {
   return std::make_unique<UnexploredFirstPriorityLocationQueue>();
 }
+
+namespace {
+/// Distance of a block from which every reachable block was entered.
+constexpr unsigned NoUnvisitedBlock = ~0U;
+
+class CoverageFirstPriorityQueue : public WorkList {
+  /// The blocks of one stack frame that have been entered so far, and the
+  /// distance from each block to the closest one that has not.
+  struct FrameCoverage {
+    llvm::BitVector Visited;
+    SmallVector<unsigned, 32> Distance;
+    bool DistanceIsStale = true;
+  };
+
+  // Compare by coverage gain first, then by insertion time (prefer expanding
+  // nodes inserted later, as a DFS would).
+  using QueuePriority = std::pair<int, unsigned long>;
+  using QueueItem = std::pair<WorkListUnit, QueuePriority>;
+
+  struct ExplorationComparator {
+    bool operator() (const QueueItem &LHS, const QueueItem &RHS) {
+      return LHS.second < RHS.second;
+    }
+  };
+
+  unsigned long Counter = 0;
+
+  llvm::DenseMap<const StackFrameContext *, FrameCoverage> Frames;
+
+  // The top item is the largest one.
+  llvm::PriorityQueue<QueueItem, std::vector<QueueItem>, ExplorationComparator>
+      queue;
+
+  FrameCoverage &getCoverage(const StackFrameContext *SF) {
+    FrameCoverage &FC = Frames[SF];
+    if (FC.Visited.empty())
+      FC.Visited.resize(SF->getCFG()->getNumBlockIDs());
+    return FC;
+  }
+
+  /// Recompute the distances with a backward breadth-first search from the
+  /// blocks that have not been entered yet.
+  static void computeDistances(const CFG &C, FrameCoverage &FC) {
+    FC.Distance.assign(C.getNumBlockIDs(), NoUnvisitedBlock);
+    SmallVector<const CFGBlock *, 32> Worklist;
+    for (const CFGBlock *B : C) {
+      if (!FC.Visited.test(B->getBlockID())) {
+        FC.Distance[B->getBlockID()] = 0;
+        Worklist.push_back(B);
+      }
+    }
+    for (unsigned I = 0; I != Worklist.size(); ++I) {
+      const CFGBlock *B = Worklist[I];
+      unsigned Dist = FC.Distance[B->getBlockID()] + 1;
+      for (const CFGBlock *Pred : B->preds()) {
+        if (!Pred || FC.Distance[Pred->getBlockID()] != NoUnvisitedBlock)
+          continue;
+        FC.Distance[Pred->getBlockID()] = Dist;
+        Worklist.push_back(Pred);
+      }
+    }
+    FC.DistanceIsStale = false;
+  }
+
+  /// The block a node at a block boundary leads into, or null if the node
+  /// is within a block.
+  static const CFGBlock *getEnteredBlock(const ExplodedNode *N) {
+    ProgramPoint P = N->getLocation();
+    if (auto BE = P.getAs<BlockEntrance>())
+      return BE->getBlock();
+    if (auto BE = P.getAs<BlockEdge>())
+      return BE->getDst();
+    return nullptr;
+  }
+
+public:
+  bool hasWork() const override {
+    return !queue.empty();
+  }
+
+  void enqueue(const WorkListUnit &U) override {
+    const ExplodedNode *N = U.getNode();
+
+    // Finish the block being evaluated before choosing where to go next.
+    int Gain = 1;
+    if (const CFGBlock *B = getEnteredBlock(N)) {
+      const StackFrameContext *SF = N->getLocationContext()->getStackFrame();
+      FrameCoverage &FC = getCoverage(SF);
+      if (FC.DistanceIsStale)
+        computeDistances(*SF->getCFG(), FC);
+      // Prefer the blocks closest to one that has not been entered yet, and
+      // leave those from which every reachable block was entered for last.
+      unsigned Dist = FC.Distance[B->getBlockID()];
+      Gain = Dist == NoUnvisitedBlock ? std::numeric_limits<int>::min()
+                                      : -static_cast<int>(Dist);
+    }
+
+    queue.push(std::make_pair(U, std::make_pair(Gain, ++Counter)));
+    MaxQueueSize.updateMax(queue.size());
+  }
+
+  WorkListUnit dequeue() override {
+    QueueItem U = queue.top();
+    queue.pop();
+
+    // The priorities of the nodes already queued are not updated when a
+    // block is entered, only those of the nodes enqueued afterwards.
+    const ExplodedNode *N = U.first.getNode();
+    if (auto BE = N->getLocation().getAs<BlockEntrance>()) {
+      FrameCoverage &FC = getCoverage(N->getLocationContext()->getStackFrame());
+      unsigned ID = BE->getBlock()->getBlockID();
+      if (!FC.Visited.test(ID)) {
+        FC.Visited.set(ID);
+        FC.DistanceIsStale = true;
+      }
+    }
+    return U.first;
+  }
+};
+} // namespace
+
+std::unique_ptr<WorkList> WorkList::makeCoverageFirstPriorityQueue() {
+  return std::make_unique<CoverageFirstPriorityQueue>();
+}
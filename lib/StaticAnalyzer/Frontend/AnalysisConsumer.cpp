@@ -21,9 +21,16 @@
 #include "latino/Analysis/CallGraph.h"
 #include "latino/Analysis/CodeInjector.h"
 #include "latino/Analysis/PathDiagnostic.h"
+#include "latino/Basic/FileManager.h"
 #include "latino/Basic/SourceManager.h"
+#include "latino/Basic/Stack.h"
+#include "latino/Basic/TargetInfo.h"
+#include "latino/Basic/Version.h"
 #include "latino/CrossTU/CrossTranslationUnit.h"
 #include "latino/Frontend/CompilerInstance.h"
+#include "latino/Frontend/FrontendAction.h"
+#include "latino/Frontend/FrontendDiagnostic.h"
+#include "latino/Lex/Lexer.h"
 #include "latino/Lex/Preprocessor.h"
 #include "latino/Rewrite/Core/Rewriter.h"
 #include "latino/StaticAnalyzer/Checkers/LocalCheckers.h"
@@ -33,14 +40,24 @@
 #include "latino/StaticAnalyzer/Core/PathDiagnosticConsumers.h"
 #include "latino/StaticAnalyzer/Core/PathSensitive/AnalysisManager.h"
 #include "latino/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
+#include "latino/StaticAnalyzer/Core/PathSensitive/FunctionSummaryCache.h"
 #include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <utility>
 
@@ -59,6 +76,565 @@ STATISTIC(NumVisitedBlocksInAnalyzedFunctions,
           "The # of visited basic blocks in the analyzed functions.");
 STATISTIC(PercentReachableBlocks, "The % of reachable basic blocks.");
 STATISTIC(MaxCFGSize, "The maximum number of basic blocks in a function.");
+STATISTIC(NumFunctionsReused,
+          "The # of functions whose cached summary was reused.");
+
+//===----------------------------------------------------------------------===//
+// Parallel analysis.
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// The functions of a call graph, grouped for analysis on several threads.
+///
+/// Each unit is a strongly connected component of the call graph, with its
+/// functions in the order of the sequential analysis. The units are in
+/// topological order, so a unit comes after all units that call into it.
+struct AnalysisUnits {
+  /// The functions of each unit.
+  std::vector<SmallVector<Decl *, 1>> Functions;
+
+  /// The units that call into each unit.
+  std::vector<SmallVector<unsigned, 4>> Callers;
+
+  /// The position of each function in the reverse post-order of the call
+  /// graph. It identifies the function across the ASTs of all threads.
+  llvm::DenseMap<const Decl *, unsigned> Index;
+
+  explicit AnalysisUnits(CallGraph &CG);
+};
+
+/// The state shared by the threads of a parallel analysis.
+///
+/// Unit I is analyzed by worker I modulo the number of workers, after the
+/// units that call into it. By then, every function that could inline one
+/// of its functions has been analyzed, so the unit skips the same functions
+/// as the sequential analysis does.
+class ParallelAnalysis {
+public:
+  ParallelAnalysis(const AnalysisUnits &Units, unsigned NumWorkers,
+                   PathDiagnosticConsumers &Consumers,
+                   ArrayRef<std::function<void(CheckerRegistry &)>> Fns)
+      : NumWorkers(NumWorkers), NumUnits(Units.Functions.size()),
+        NumFunctions(Units.Index.size()), Consumers(Consumers),
+        CheckerRegistrationFns(Fns.begin(), Fns.end()), Finished(NumUnits),
+        Visited(NumFunctions) {}
+
+  const unsigned NumWorkers;
+  const size_t NumUnits;
+  const size_t NumFunctions;
+
+  /// The consumers of the main thread, which receive the reports of all
+  /// workers.
+  PathDiagnosticConsumers &Consumers;
+
+  std::vector<std::function<void(CheckerRegistry &)>> CheckerRegistrationFns;
+
+  /// Wait until the units in \p Callers are analyzed. Returns false if the
+  /// parallel analysis was abandoned instead.
+  bool waitForCallers(ArrayRef<unsigned> Callers) {
+    std::unique_lock<std::mutex> Guard(Lock);
+    UnitFinished.wait(Guard, [&] {
+      return Abandoned ||
+             llvm::all_of(Callers, [&](unsigned U) { return Finished[U]; });
+    });
+    return !Abandoned;
+  }
+
+  /// Whether the function at \p Index was inlined by a function analyzed
+  /// before.
+  bool isVisited(unsigned Index) {
+    std::lock_guard<std::mutex> Guard(Lock);
+    return Visited[Index];
+  }
+
+  /// Mark \p Unit as analyzed, with the functions it inlined.
+  void finishUnit(unsigned Unit, ArrayRef<unsigned> VisitedFunctions) {
+    {
+      std::lock_guard<std::mutex> Guard(Lock);
+      for (unsigned Index : VisitedFunctions)
+        Visited[Index] = true;
+      Finished[Unit] = true;
+    }
+    UnitFinished.notify_all();
+  }
+
+  /// Give up on the parallel analysis, for instance because a worker did not
+  /// find the same functions as the main thread.
+  void abandon() {
+    {
+      std::lock_guard<std::mutex> Guard(Lock);
+      Abandoned = true;
+    }
+    UnitFinished.notify_all();
+  }
+
+  /// Called when \p Worker is done. Abandons the analysis if the worker left
+  /// some of its units unanalyzed, as other workers may wait for them.
+  void finishWorker(unsigned Worker) {
+    {
+      std::lock_guard<std::mutex> Guard(Lock);
+      for (size_t U = Worker; U < NumUnits; U += NumWorkers)
+        if (!Finished[U])
+          Abandoned = true;
+    }
+    UnitFinished.notify_all();
+  }
+
+  bool isAbandoned() {
+    std::lock_guard<std::mutex> Guard(Lock);
+    return Abandoned;
+  }
+
+private:
+  std::mutex Lock;
+  std::condition_variable UnitFinished;
+  std::vector<bool> Finished;
+  std::vector<bool> Visited;
+  bool Abandoned = false;
+};
+
+/// Keeps the reports of a worker of a parallel analysis until the main
+/// thread hands them to one of its consumers. The paths are generated as
+/// that consumer wants them.
+class CollectingDiagnosticConsumer : public PathDiagnosticConsumer {
+  PathDiagnosticConsumer &Target;
+
+public:
+  explicit CollectingDiagnosticConsumer(PathDiagnosticConsumer &Target)
+      : Target(Target) {}
+
+  void FlushDiagnosticsImpl(std::vector<const PathDiagnostic *> &Diags,
+                            FilesMade *filesMade) override {}
+
+  StringRef getName() const override { return Target.getName(); }
+
+  PathGenerationScheme getGenerationScheme() const override {
+    return Target.getGenerationScheme();
+  }
+
+  bool supportsLogicalOpControlFlow() const override {
+    return Target.supportsLogicalOpControlFlow();
+  }
+
+  bool supportsCrossFileDiagnostics() const override {
+    return Target.supportsCrossFileDiagnostics();
+  }
+
+  /// Hand the reports collected so far to the target consumer, which sorts
+  /// them when it is flushed.
+  void transferDiagnostics() {
+    std::vector<PathDiagnostic *> Collected;
+    for (PathDiagnostic &D : Diags)
+      Collected.push_back(&D);
+    Diags.clear();
+    for (PathDiagnostic *D : Collected)
+      Target.HandlePathDiagnostic(std::unique_ptr<PathDiagnostic>(D));
+  }
+};
+
+class AnalysisConsumer;
+
+/// A thread of a parallel analysis. It parses the translation unit again
+/// into a compiler instance of its own, as the AST and the analysis manager
+/// cannot be shared between threads.
+class AnalysisWorker {
+public:
+  AnalysisWorker(CompilerInstance &Main, const AnalyzerOptions &MainOpts,
+                 ParallelAnalysis &Schedule, unsigned Index);
+  ~AnalysisWorker();
+
+  unsigned getIndex() const { return Index; }
+
+  /// Parse the translation unit and analyze the units of this worker.
+  void run();
+
+  std::unique_ptr<ASTConsumer> createConsumer(CompilerInstance &CI);
+
+  /// Hand the reports of this worker to the consumers of the main thread.
+  void transferDiagnostics();
+
+private:
+  ParallelAnalysis &Schedule;
+  const unsigned Index;
+  AnalyzerOptionsRef Opts;
+  FrontendInputFile Input;
+  std::unique_ptr<CompilerInstance> Instance;
+  std::unique_ptr<FrontendAction> Action;
+  AnalysisConsumer *Consumer = nullptr;
+  bool Started = false;
+};
+
+} // end anonymous namespace
+
+AnalysisUnits::AnalysisUnits(CallGraph &CG) {
+  llvm::ReversePostOrderTraversal<latino::CallGraph *> RPOT(&CG);
+  for (CallGraphNode *N : RPOT)
+    if (Decl *D = N->getDecl())
+      Index.try_emplace(D, Index.size());
+
+  auto ByIndex = [&](const Decl *A, const Decl *B) {
+    return Index.lookup(A) < Index.lookup(B);
+  };
+  for (auto SCC = llvm::scc_begin(&CG); !SCC.isAtEnd(); ++SCC) {
+    SmallVector<Decl *, 1> Decls;
+    for (CallGraphNode *N : *SCC)
+      if (Decl *D = N->getDecl())
+        Decls.push_back(D);
+    // Skip the abstract root node.
+    if (Decls.empty())
+      continue;
+    llvm::sort(Decls, ByIndex);
+    Functions.push_back(std::move(Decls));
+  }
+
+  // A function comes before the functions it calls in the reverse
+  // post-order, unless they are in the same component, so ordering the units
+  // by their first function puts callers before callees.
+  llvm::sort(Functions,
+             [&](const SmallVector<Decl *, 1> &A,
+                 const SmallVector<Decl *, 1> &B) {
+               return ByIndex(A.front(), B.front());
+             });
+
+  llvm::DenseMap<const Decl *, unsigned> UnitOf;
+  for (unsigned U = 0, E = Functions.size(); U != E; ++U)
+    for (const Decl *D : Functions[U])
+      UnitOf[D] = U;
+
+  Callers.resize(Functions.size());
+  for (unsigned U = 0, E = Functions.size(); U != E; ++U) {
+    for (const Decl *D : Functions[U]) {
+      for (const CallGraphNode::CallRecord &Call : CG.getNode(D)->callees()) {
+        unsigned Callee = UnitOf.lookup(Call.Callee->getDecl());
+        if (Callee != U && !llvm::is_contained(Callers[Callee], U))
+          Callers[Callee].push_back(U);
+      }
+    }
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Function summary cache.
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// Reuses the cached summaries of the top-level functions that did not change
+/// since the last analysis of the translation unit, and caches the summaries
+/// of the functions analyzed now for the next one.
+///
+/// A function is identified by its cross translation unit lookup name. Its
+/// hash covers the function and, through the call graph, every function it
+/// may inline.
+class SummaryCacheSession {
+public:
+  SummaryCacheSession(CallGraph &CG, ASTContext &Ctx,
+                      const AnalyzerOptions &Opts,
+                      FunctionSummariesTy &FunctionSummaries);
+
+  /// Reuse the summary of \p D if it is still valid: the functions it
+  /// inlined are marked as visited, as if \p D had been analyzed.
+  bool reuse(const Decl *D, SetOfConstDecls &Visited);
+
+  /// Cache the results of the analysis of \p D.
+  void record(const Decl *D, unsigned NumReports,
+              const SetOfConstDecls &VisitedCallees);
+
+  void save();
+
+private:
+  Optional<std::string> getName(const Decl *D);
+  uint64_t getHash(const Decl *D);
+
+  CallGraph &CG;
+  ASTContext &Ctx;
+  FunctionSummariesTy &FunctionSummaries;
+  std::string Path;
+  uint64_t ConfigHash;
+  FunctionSummaryCache Previous;
+  FunctionSummaryCache Current;
+  llvm::DenseMap<const Decl *, uint64_t> Hashes;
+  llvm::StringMap<const Decl *> DeclsByName;
+};
+
+} // end anonymous namespace
+
+/// Hash the options that can change the results of the analysis.
+static uint64_t getConfigHash(const AnalyzerOptions &Opts) {
+  std::string Config;
+  llvm::raw_string_ostream OS(Config);
+  OS << getLatinoFullVersion() << '\n'
+     << Opts.AnalysisStoreOpt << ' ' << Opts.AnalysisConstraintsOpt << ' '
+     << Opts.InliningMode << ' ' << Opts.maxBlockVisitOnPath << ' '
+     << Opts.AnalyzeAll << ' ' << Opts.AnalyzeSpecificFunction << '\n';
+  for (const auto &Checker : Opts.CheckersAndPackages)
+    OS << Checker.first << '=' << Checker.second << '\n';
+
+  std::vector<StringRef> Keys;
+  for (const auto &Entry : Opts.Config)
+    Keys.push_back(Entry.first());
+  llvm::sort(Keys);
+  for (StringRef Key : Keys)
+    OS << Key << '=' << Opts.Config.lookup(Key) << '\n';
+  return llvm::xxHash64(OS.str());
+}
+
+/// The cache file of the main file of \p SM, or an empty string.
+static std::string getSummaryCachePath(const SourceManager &SM,
+                                       StringRef Dir) {
+  const FileEntry *Main = SM.getFileEntryForID(SM.getMainFileID());
+  if (!Main)
+    return "";
+
+  SmallString<256> MainPath(Main->tryGetRealPathName());
+  if (MainPath.empty())
+    MainPath = Main->getName();
+  llvm::sys::fs::make_absolute(MainPath);
+
+  // Files of the same name in different directories have different caches.
+  SmallString<256> CachePath(Dir);
+  llvm::sys::path::append(CachePath,
+                          llvm::sys::path::filename(MainPath) + "-" +
+                              llvm::utohexstr(llvm::xxHash64(MainPath)) +
+                              ".summaries.json");
+  return std::string(CachePath.str());
+}
+
+SummaryCacheSession::SummaryCacheSession(CallGraph &CG, ASTContext &Ctx,
+                                         const AnalyzerOptions &Opts,
+                                         FunctionSummariesTy &FunctionSummaries)
+    : CG(CG), Ctx(Ctx), FunctionSummaries(FunctionSummaries),
+      Path(getSummaryCachePath(Ctx.getSourceManager(), Opts.SummaryCacheDir)),
+      ConfigHash(getConfigHash(Opts)), Previous(ConfigHash),
+      Current(ConfigHash) {
+  if (Path.empty())
+    return;
+
+  for (const auto &Node : CG)
+    if (const Decl *D = Node.first)
+      if (Optional<std::string> Name = getName(D))
+        DeclsByName[*Name] = D;
+
+  llvm::Expected<FunctionSummaryCache> Cache =
+      FunctionSummaryCache::load(Path, ConfigHash);
+  if (!Cache) {
+    Ctx.getDiagnostics().Report(diag::warn_analyzer_summary_cache)
+        << llvm::toString(Cache.takeError());
+    return;
+  }
+  Previous = std::move(*Cache);
+}
+
+Optional<std::string> SummaryCacheSession::getName(const Decl *D) {
+  const auto *FD = dyn_cast<FunctionDecl>(D);
+  if (!FD)
+    return None;
+  return cross_tu::CrossTranslationUnitContext::getLookupName(FD);
+}
+
+namespace {
+/// Collects the global variables a function refers to and the definitions of
+/// the types it uses, which the analysis of the function depends on as much
+/// as on its body.
+class ReferencedDeclCollector
+    : public RecursiveASTVisitor<ReferencedDeclCollector> {
+public:
+  llvm::SetVector<const VarDecl *> Vars;
+  llvm::SetVector<const TagDecl *> Tags;
+
+  bool shouldVisitTemplateInstantiations() const { return true; }
+  bool shouldVisitImplicitCode() const { return true; }
+
+  bool VisitDeclRefExpr(DeclRefExpr *E) {
+    if (const auto *VD = dyn_cast<VarDecl>(E->getDecl())) {
+      if (VD->hasGlobalStorage() && !VD->isStaticLocal())
+        addVar(VD);
+    } else if (const auto *ECD = dyn_cast<EnumConstantDecl>(E->getDecl())) {
+      addTag(cast<EnumDecl>(ECD->getDeclContext()));
+    }
+    return true;
+  }
+
+  bool VisitExpr(Expr *E) {
+    addType(E->getType());
+    return true;
+  }
+
+  bool VisitDeclaratorDecl(DeclaratorDecl *D) {
+    addType(D->getType());
+    return true;
+  }
+
+  bool VisitTypeLoc(TypeLoc TL) {
+    addType(TL.getType());
+    return true;
+  }
+
+private:
+  /// Add the definition of the type \p T, looking through pointers, arrays
+  /// and functions.
+  void addType(QualType T) {
+    if (T.isNull())
+      return;
+    const Type *Ty = T.getCanonicalType().getTypePtr();
+    while (true) {
+      if (const auto *FT = Ty->getAs<FunctionType>()) {
+        if (const auto *FPT = dyn_cast<FunctionProtoType>(FT))
+          for (QualType Param : FPT->getParamTypes())
+            addType(Param);
+        Ty = FT->getReturnType().getTypePtr();
+      } else if (Ty->isArrayType()) {
+        Ty = Ty->getArrayElementTypeNoTypeQual();
+      } else if (!Ty->getPointeeType().isNull()) {
+        Ty = Ty->getPointeeType().getTypePtr();
+      } else {
+        break;
+      }
+    }
+    if (const TagDecl *Tag = Ty->getAsTagDecl())
+      addTag(Tag);
+  }
+
+  /// Add the definition of \p Tag and the definitions of the types of its
+  /// fields.
+  void addTag(const TagDecl *Tag) {
+    if (const TagDecl *Def = Tag->getDefinition())
+      Tag = Def;
+    if (!Tags.insert(Tag))
+      return;
+    if (const auto *RD = dyn_cast<RecordDecl>(Tag))
+      for (const FieldDecl *Field : RD->fields())
+        addType(Field->getType());
+  }
+
+  /// Add the declaration of \p VD with its initializer, and what the
+  /// initializer refers to.
+  void addVar(const VarDecl *VD) {
+    const Expr *Init = VD->getAnyInitializer(VD);
+    if (!Init)
+      VD = VD->getCanonicalDecl();
+    if (!Vars.insert(VD))
+      return;
+    addType(VD->getType());
+    if (Init)
+      TraverseStmt(const_cast<Expr *>(Init));
+  }
+};
+} // end anonymous namespace
+
+uint64_t SummaryCacheSession::getHash(const Decl *D) {
+  auto Inserted = Hashes.try_emplace(D, 0);
+  if (!Inserted.second)
+    return Inserted.first->second;
+
+  // The ODR hash covers what the body means, the text what it looks like,
+  // such as which macros it uses. Neither covers the initializers of the
+  // global variables the function refers to, nor the definitions of the
+  // types it uses, so their text is added.
+  const SourceManager &SM = Ctx.getSourceManager();
+  auto getText = [&](const Decl *D) {
+    return Lexer::getSourceText(
+        CharSourceRange::getTokenRange(D->getSourceRange()), SM,
+        Ctx.getLangOpts());
+  };
+  auto *FD = const_cast<FunctionDecl *>(cast<FunctionDecl>(D));
+  ReferencedDeclCollector Referenced;
+  Referenced.TraverseDecl(FD);
+
+  std::string LocalText;
+  llvm::raw_string_ostream LocalOS(LocalText);
+  LocalOS << getText(FD);
+  for (const VarDecl *VD : Referenced.Vars)
+    LocalOS << '\n' << VD->getQualifiedNameAsString() << ' '
+            << VD->getType().getAsString() << ' ' << getText(VD);
+  for (const TagDecl *Tag : Referenced.Tags)
+    LocalOS << '\n' << Tag->getQualifiedNameAsString() << ' '
+            << getText(Tag);
+  uint64_t LocalHash = llvm::xxHash64(LocalOS.str()) ^ FD->getODRHash();
+
+  // A function that calls itself, directly or not, sees the local hash of
+  // the functions of the cycle that are being hashed.
+  Hashes[D] = LocalHash;
+
+  std::vector<std::pair<std::string, uint64_t>> Callees;
+  for (const CallGraphNode::CallRecord &Call : CG.getNode(D)->callees()) {
+    const Decl *Callee = Call.Callee->getDecl();
+    if (Optional<std::string> Name = getName(Callee))
+      Callees.emplace_back(std::move(*Name), getHash(Callee));
+  }
+  llvm::sort(Callees);
+
+  std::string Buffer;
+  llvm::raw_string_ostream OS(Buffer);
+  OS << LocalHash;
+  for (const auto &Callee : Callees)
+    OS << '\n' << Callee.first << ' ' << Callee.second;
+  return Hashes[D] = llvm::xxHash64(OS.str());
+}
+
+bool SummaryCacheSession::reuse(const Decl *D, SetOfConstDecls &Visited) {
+  Optional<std::string> Name = getName(D);
+  if (Path.empty() || !Name)
+    return false;
+
+  // Functions with reports are analyzed again to report them.
+  const CachedFunctionSummary *Summary = Previous.lookup(*Name, getHash(D));
+  if (!Summary || Summary->NumReports)
+    return false;
+
+  for (unsigned ID : Summary->VisitedBlocks)
+    FunctionSummaries.markVisitedBasicBlock(ID, D, Summary->TotalBlocks);
+  for (const std::string &Callee : Summary->InlinedCallees)
+    if (const Decl *CalleeDecl = DeclsByName.lookup(Callee))
+      Visited.insert(CalleeDecl->getCanonicalDecl());
+  for (const std::string &Callee : Summary->NotInlinableCallees)
+    if (const Decl *CalleeDecl = DeclsByName.lookup(Callee))
+      FunctionSummaries.markShouldNotInline(CalleeDecl);
+
+  Current.insert(*Name, *Summary);
+  NumFunctionsReused++;
+  return true;
+}
+
+void SummaryCacheSession::record(const Decl *D, unsigned NumReports,
+                                 const SetOfConstDecls &VisitedCallees) {
+  Optional<std::string> Name = getName(D);
+  if (Path.empty() || !Name)
+    return;
+
+  CachedFunctionSummary Summary;
+  Summary.Hash = getHash(D);
+  Summary.NumReports = NumReports;
+  if (const llvm::SmallBitVector *Blocks =
+          FunctionSummaries.getVisitedBasicBlocks(D)) {
+    Summary.TotalBlocks = Blocks->size();
+    for (unsigned ID : Blocks->set_bits())
+      Summary.VisitedBlocks.push_back(ID);
+  }
+
+  // Only the callees that can be found again by name are useful.
+  for (const Decl *Callee : VisitedCallees) {
+    Optional<std::string> CalleeName = getName(Callee);
+    if (!CalleeName || !DeclsByName.count(*CalleeName))
+      continue;
+    if (FunctionSummaries.mayInline(Callee) == false)
+      Summary.NotInlinableCallees.push_back(*CalleeName);
+    Summary.InlinedCallees.push_back(std::move(*CalleeName));
+  }
+  llvm::sort(Summary.InlinedCallees);
+  llvm::sort(Summary.NotInlinableCallees);
+
+  Current.insert(*Name, std::move(Summary));
+}
+
+void SummaryCacheSession::save() {
+  if (Path.empty())
+    return;
+  if (llvm::Error Err = Current.save(Path))
+    Ctx.getDiagnostics().Report(diag::warn_analyzer_summary_cache)
+        << llvm::toString(std::move(Err));
+}
 
 //===----------------------------------------------------------------------===//
 // AnalysisConsumer declaration.
@@ -83,6 +659,7 @@ class AnalysisConsumer : public AnalysisASTConsumer,
   std::vector<std::function<void(CheckerRegistry &)>> CheckerRegistrationFns;
 
 public:
+  CompilerInstance &CI;
   ASTContext *Ctx;
   Preprocessor &PP;
   const std::string OutDir;
@@ -117,13 +694,34 @@ public:
   /// translation unit.
   FunctionSummariesTy FunctionSummaries;
 
+  /// The state of the parallel analysis this consumer is a worker of, or
+  /// null for the consumer of the main thread.
+  ParallelAnalysis *Parallel;
+  unsigned WorkerIndex;
+
+  /// The schedule and the workers of a parallel analysis started by this
+  /// consumer. The workers own the ASTs that the reports they handed over
+  /// refer to, so they are kept until the reports are flushed.
+  std::unique_ptr<ParallelAnalysis> Schedule;
+  std::vector<std::unique_ptr<AnalysisWorker>> Workers;
+
+  /// The number of path-sensitive reports found so far.
+  unsigned NumPathSensitiveReports = 0;
+
   AnalysisConsumer(CompilerInstance &CI, const std::string &outdir,
                    AnalyzerOptionsRef opts, ArrayRef<std::string> plugins,
-                   CodeInjector *injector)
-      : RecVisitorMode(0), RecVisitorBR(nullptr), Ctx(nullptr),
+                   CodeInjector *injector,
+                   ParallelAnalysis *Parallel = nullptr,
+                   unsigned WorkerIndex = 0)
+      : RecVisitorMode(0), RecVisitorBR(nullptr), CI(CI), Ctx(nullptr),
         PP(CI.getPreprocessor()), OutDir(outdir), Opts(std::move(opts)),
-        Plugins(plugins), Injector(injector), CTU(CI) {
+        Plugins(plugins), Injector(injector), CTU(CI), Parallel(Parallel),
+        WorkerIndex(WorkerIndex) {
     DigestAnalyzerOptions();
+    // A worker keeps its reports for the consumers of the main thread.
+    if (Parallel)
+      for (PathDiagnosticConsumer *Target : Parallel->Consumers)
+        PathConsumers.push_back(new CollectingDiagnosticConsumer(*Target));
     if (Opts->PrintStats || Opts->ShouldSerializeStats) {
       AnalyzerTimers = std::make_unique<llvm::TimerGroup>(
           "analyzer", "Analyzer timers");
@@ -233,6 +831,20 @@ public:
   /// use it to define the order in which the functions should be visited.
   void HandleDeclsCallGraph(const unsigned LocalTUDeclsSize);
 
+  /// Start loading the ASTs that hold the definitions of the functions \p N
+  /// may call into other translation units, directly or through the callees
+  /// it may inline.
+  void prefetchCrossTUDefinitions(CallGraphNode *N);
+
+  /// Analyze the functions of \p CG on the number of threads given by the
+  /// 'analysis-threads' option. Returns false if the functions still have to
+  /// be analyzed on this thread.
+  bool analyzeInParallel(CallGraph &CG);
+
+  /// Analyze the units of \p CG assigned to this worker of a parallel
+  /// analysis.
+  void analyzeWorkerUnits(CallGraph &CG);
+
   /// Run analyzes(syntax or path sensitive) on the given function.
   /// \param Mode - determines if we are requesting syntax only or path
   /// sensitive only analysis.
@@ -432,6 +1044,20 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
     CG.addToCallGraph(LocalTUDecls[i]);
   }
 
+  if (Parallel)
+    return analyzeWorkerUnits(CG);
+
+  // The summary cache only works with the sequential analysis, where the
+  // functions are analyzed in a known order.
+  bool UseSummaryCache =
+      !Opts->SummaryCacheDir.empty() && !Opts->IsNaiveCTUEnabled;
+  if (!UseSummaryCache && Opts->AnalysisThreads > 1 &&
+      analyzeInParallel(CG))
+    return;
+  Optional<SummaryCacheSession> SummaryCache;
+  if (UseSummaryCache)
+    SummaryCache.emplace(CG, *Ctx, *Opts, FunctionSummaries);
+
   // Walk over all of the call graph nodes in topological order, so that we
   // analyze parents before the children. Skip the functions inlined into
   // the previously processed functions. Use external Visited set to identify
@@ -457,12 +1083,26 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
     if (shouldSkipFunction(D, Visited, VisitedAsTopLevel))
       continue;
 
+    // Skip the functions that did not change since the last analysis.
+    if (SummaryCache && SummaryCache->reuse(D, Visited)) {
+      VisitedAsTopLevel.insert(D);
+      continue;
+    }
+
+    if (Opts->IsNaiveCTUEnabled && Opts->CTUPrefetchThreads)
+      prefetchCrossTUDefinitions(N);
+
     // Analyze the function.
     SetOfConstDecls VisitedCallees;
+    unsigned NumReportsBefore = NumPathSensitiveReports;
 
     HandleCode(D, AM_Path, getInliningModeForFunction(D, Visited),
                (Mgr->options.InliningMode == All ? nullptr : &VisitedCallees));
 
+    if (SummaryCache)
+      SummaryCache->record(D, NumPathSensitiveReports - NumReportsBefore,
+                           VisitedCallees);
+
     // Add the visited callees to the global visited set.
     for (const Decl *Callee : VisitedCallees)
       // Decls from CallGraph are already canonical. But Decls coming from
@@ -471,6 +1111,131 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
                                                  :*/ Callee->getCanonicalDecl());
     VisitedAsTopLevel.insert(D);
   }
+
+  if (SummaryCache)
+    SummaryCache->save();
+}
+
+void AnalysisConsumer::prefetchCrossTUDefinitions(CallGraphNode *N) {
+  // Walk the callees breadth first, so the definitions needed soonest are
+  // requested first, down to the depth the analyzer inlines to.
+  SmallVector<std::string, 16> LookupNames;
+  llvm::SmallPtrSet<CallGraphNode *, 32> Seen;
+  SmallVector<CallGraphNode *, 32> Level(1, N);
+  Seen.insert(N);
+  for (unsigned Depth = 0;
+       Depth != Opts->InlineMaxStackDepth && !Level.empty(); ++Depth) {
+    SmallVector<CallGraphNode *, 32> NextLevel;
+    for (CallGraphNode *Caller : Level) {
+      for (CallGraphNode *Callee : *Caller) {
+        if (!Seen.insert(Callee).second)
+          continue;
+        const auto *FD = dyn_cast_or_null<FunctionDecl>(Callee->getDecl());
+        if (!FD)
+          continue;
+        if (FD->hasBody()) {
+          NextLevel.push_back(Callee);
+          continue;
+        }
+        if (llvm::Optional<std::string> Name =
+                cross_tu::CrossTranslationUnitContext::getLookupName(FD))
+          LookupNames.push_back(std::move(*Name));
+      }
+    }
+    Level = std::move(NextLevel);
+  }
+
+  if (!LookupNames.empty())
+    CTU.prefetchExternalASTs(LookupNames, Opts->CTUDir, Opts->CTUIndexName);
+}
+
+bool AnalysisConsumer::analyzeInParallel(CallGraph &CG) {
+  // Every worker parses the input again, which has to be a source file.
+  const FrontendOptions &FrontendOpts = CI.getFrontendOpts();
+  if (FrontendOpts.Inputs.size() != 1)
+    return false;
+  const FrontendInputFile &Input = FrontendOpts.Inputs.front();
+  if (!Input.isFile() || Input.getFile() == "-" ||
+      Input.getKind().getFormat() != InputKind::Source)
+    return false;
+
+  AnalysisUnits Units(CG);
+  unsigned NumWorkers =
+      std::min<size_t>(Opts->AnalysisThreads, Units.Functions.size());
+  if (NumWorkers < 2)
+    return false;
+
+  Schedule = std::make_unique<ParallelAnalysis>(Units, NumWorkers,
+                                                PathConsumers,
+                                                CheckerRegistrationFns);
+  for (unsigned I = 0; I != NumWorkers; ++I)
+    Workers.push_back(
+        std::make_unique<AnalysisWorker>(CI, *Opts, *Schedule, I));
+
+  llvm::ThreadPool Pool(llvm::hardware_concurrency(NumWorkers));
+  for (std::unique_ptr<AnalysisWorker> &Worker : Workers) {
+    AnalysisWorker *W = Worker.get();
+    Pool.async([this, W] {
+      llvm::CrashRecoveryContext CRC;
+      CRC.RunSafelyOnThread([W] { W->run(); }, DesiredStackSize);
+      Schedule->finishWorker(W->getIndex());
+    });
+  }
+  Pool.wait();
+
+  // Take the reports in the order of the workers. Our consumers sort them
+  // when they are flushed, so the output is the same from run to run.
+  for (std::unique_ptr<AnalysisWorker> &Worker : Workers)
+    Worker->transferDiagnostics();
+
+  // If the workers gave up, analyze everything here. Reports that a worker
+  // produced already are uniqued by the consumers.
+  return !Schedule->isAbandoned();
+}
+
+void AnalysisConsumer::analyzeWorkerUnits(CallGraph &CG) {
+  // The worker parsed the translation unit on its own; make sure it sees
+  // the same functions as the main thread.
+  AnalysisUnits Units(CG);
+  if (Units.Functions.size() != Parallel->NumUnits ||
+      Units.Index.size() != Parallel->NumFunctions)
+    return Parallel->abandon();
+
+  for (size_t U = WorkerIndex, E = Units.Functions.size(); U < E;
+       U += Parallel->NumWorkers) {
+    if (!Parallel->waitForCallers(Units.Callers[U]))
+      return;
+
+    // Only the functions of this unit are ever looked up in the visited
+    // sets, as in HandleDeclsCallGraph.
+    SetOfConstDecls Visited;
+    SetOfConstDecls VisitedAsTopLevel;
+    for (const Decl *D : Units.Functions[U])
+      if (Parallel->isVisited(Units.Index.lookup(D)))
+        Visited.insert(D);
+
+    SmallVector<unsigned, 8> VisitedFunctions;
+    for (Decl *D : Units.Functions[U]) {
+      NumFunctionTopLevel++;
+      if (shouldSkipFunction(D, Visited, VisitedAsTopLevel))
+        continue;
+
+      SetOfConstDecls VisitedCallees;
+      HandleCode(D, AM_Path, getInliningModeForFunction(D, Visited),
+                 (Mgr->options.InliningMode == All ? nullptr
+                                                   : &VisitedCallees));
+
+      for (const Decl *Callee : VisitedCallees) {
+        const Decl *Canonical = Callee->getCanonicalDecl();
+        Visited.insert(Canonical);
+        auto I = Units.Index.find(Canonical);
+        if (I != Units.Index.end())
+          VisitedFunctions.push_back(I->second);
+      }
+      VisitedAsTopLevel.insert(D);
+    }
+    Parallel->finishUnit(U, VisitedFunctions);
+  }
 }
 
 static bool isBisonFile(ASTContext &C) {
@@ -532,6 +1297,16 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   if (Diags.hasErrorOccurred() || Diags.hasFatalErrorOccurred())
     return;
 
+  // A worker of a parallel analysis only runs the path-sensitive analysis of
+  // its units. Its reports stay in its consumers until the main thread takes
+  // them, so the analysis manager is kept as well.
+  if (Parallel) {
+    if (!isBisonFile(C) && !Opts->DisableAllCheckers &&
+        Mgr->shouldInlineCall())
+      HandleDeclsCallGraph(LocalTUDecls.size());
+    return;
+  }
+
   if (isBisonFile(C)) {
     reportAnalyzerProgress("Skipping bison-generated file\n");
   } else if (Opts->DisableAllCheckers) {
@@ -558,6 +1333,7 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   // side-effects in PathDiagnosticConsumer's destructor. This is required when
   // used with option -disable-free.
   Mgr.reset();
+  Workers.clear();
 }
 
 std::string AnalysisConsumer::getFunctionName(const Decl *D) {
@@ -712,13 +1488,119 @@ void AnalysisConsumer::RunPathSensitiveChecks(Decl *D,
     Eng.ViewGraph(Mgr->options.TrimGraph);
 
   // Display warnings.
+  BugReporter &BR = Eng.getBugReporter();
+  for (auto I = BR.EQClasses_begin(), E = BR.EQClasses_end(); I != E; ++I)
+    ++NumPathSensitiveReports;
   if (BugReporterTimer)
     BugReporterTimer->startTimer();
-  Eng.getBugReporter().FlushReports();
+  BR.FlushReports();
   if (BugReporterTimer)
     BugReporterTimer->stopTimer();
 }
 
+//===----------------------------------------------------------------------===//
+// Parallel analysis workers.
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// Parses the translation unit for a worker of a parallel analysis.
+class WorkerAnalysisAction : public ASTFrontendAction {
+  AnalysisWorker &Worker;
+
+public:
+  explicit WorkerAnalysisAction(AnalysisWorker &Worker) : Worker(Worker) {}
+
+protected:
+  std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI,
+                                                 StringRef InFile) override {
+    return Worker.createConsumer(CI);
+  }
+};
+
+} // end anonymous namespace
+
+AnalysisWorker::AnalysisWorker(CompilerInstance &Main,
+                               const AnalyzerOptions &MainOpts,
+                               ParallelAnalysis &Schedule, unsigned Index)
+    : Schedule(Schedule), Index(Index), Opts(new AnalyzerOptions(MainOpts)),
+      Input(Main.getFrontendOpts().Inputs.front()) {
+  // The reports go to the consumers of the main thread, which also prints
+  // the statistics.
+  Opts->AnalysisDiagOpt = PD_NONE;
+  Opts->PrintStats = false;
+  Opts->ShouldSerializeStats = false;
+
+  auto Invocation = std::make_shared<CompilerInvocation>(Main.getInvocation());
+  FrontendOptions &FrontendOpts = Invocation->getFrontendOpts();
+  FrontendOpts.DisableFree = false;
+  FrontendOpts.ShowStats = false;
+  FrontendOpts.ShowTimers = false;
+
+  Instance =
+      std::make_unique<CompilerInstance>(Main.getPCHContainerOperations());
+  Instance->setInvocation(std::move(Invocation));
+  // The main thread reported the diagnostics of the parse already.
+  Instance->createDiagnostics(new IgnoringDiagConsumer(),
+                              /*ShouldOwnClient=*/true);
+  // The file manager is not thread-safe, so each worker has its own.
+  Instance->createFileManager(&Main.getVirtualFileSystem());
+  Instance->setArenaPool(&Main.getArenaPool());
+
+  // BeginSourceFile expects the targets CompilerInstance::ExecuteAction sets
+  // up, and the main thread has made the language options agree with them.
+  Instance->setTarget(TargetInfo::CreateTargetInfo(
+      Instance->getDiagnostics(), Instance->getInvocation().TargetOpts));
+  if (!Instance->hasTarget())
+    return;
+  if (const TargetInfo *MainAux = Main.getAuxTarget())
+    Instance->setAuxTarget(TargetInfo::CreateTargetInfo(
+        Instance->getDiagnostics(),
+        std::make_shared<TargetOptions>(MainAux->getTargetOpts())));
+  TargetInfo &Target = Instance->getTarget();
+  Target.adjust(Instance->getLangOpts());
+  Target.adjustTargetOptions(Instance->getCodeGenOpts(),
+                             Instance->getTargetOpts());
+  if (TargetInfo *Aux = Instance->getAuxTarget())
+    Target.setAuxTarget(Aux);
+}
+
+AnalysisWorker::~AnalysisWorker() {
+  if (Started)
+    Action->EndSourceFile();
+}
+
+void AnalysisWorker::run() {
+  Action = std::make_unique<WorkerAnalysisAction>(*this);
+  if (!Instance->hasTarget() || !Action->BeginSourceFile(*Instance, Input)) {
+    Consumer = nullptr;
+    return;
+  }
+  Started = true;
+  if (llvm::Error Err = Action->Execute())
+    llvm::consumeError(std::move(Err));
+}
+
+std::unique_ptr<ASTConsumer>
+AnalysisWorker::createConsumer(CompilerInstance &CI) {
+  bool hasModelPath = Opts->Config.count("model-path") > 0;
+  auto C = std::make_unique<AnalysisConsumer>(
+      CI, CI.getFrontendOpts().OutputFile, Opts, CI.getFrontendOpts().Plugins,
+      hasModelPath ? new ModelInjector(CI) : nullptr, &Schedule, Index);
+  for (const auto &Fn : Schedule.CheckerRegistrationFns)
+    C->AddCheckerRegistrationFn(Fn);
+  Consumer = C.get();
+  return std::move(C);
+}
+
+void AnalysisWorker::transferDiagnostics() {
+  if (!Consumer)
+    return;
+  for (PathDiagnosticConsumer *Collector : Consumer->PathConsumers)
+    static_cast<CollectingDiagnosticConsumer *>(Collector)
+        ->transferDiagnostics();
+}
+
 //===----------------------------------------------------------------------===//
 // AnalysisConsumer creation.
 //===----------------------------------------------------------------------===//
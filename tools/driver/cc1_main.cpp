@@ -14,6 +14,7 @@
 
 #include "latino/Basic/Stack.h"
 #include "latino/Basic/TargetOptions.h"
+#include "latino/Basic/TimeTraceCounters.h"
 #include "latino/CodeGen/ObjectFilePCHContainerOperations.h"
 #include "latino/Config/config.h"
 #include "latino/Driver/DriverDiagnostic.h"
@@ -32,6 +33,7 @@
 #include "llvm/Option/ArgList.h"
 #include "llvm/Option/OptTable.h"
 #include "llvm/Support/BuryPointer.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
@@ -45,6 +47,8 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
 #include <cstdio>
+#include <mutex>
+#include <shared_mutex>
 
 #ifdef CLANG_HAVE_RLIMITS
 #include <sys/resource.h>
@@ -57,11 +61,37 @@ using namespace llvm::opt;
 // Main driver
 //===----------------------------------------------------------------------===//
 
+/// The diagnostics engine of the cc1 invocation running on this thread. The
+/// driver may run several cc1 invocations in-process at the same time, so
+/// they share one LLVM fatal error handler, which reports to the engine of
+/// the thread that hit the error.
+static LLVM_THREAD_LOCAL DiagnosticsEngine *ThreadDiags = nullptr;
+
+/// The number of cc1 invocations currently relying on LLVMErrorHandler.
+static std::mutex ErrorHandlerMutex;
+static unsigned ErrorHandlerUsers = 0;
+
+/// Guards the process-wide llvm::cl options. cc1 invocations may run on
+/// several threads at once, in-process jobs of the driver or requests of a
+/// compile server; they share the options, except for an invocation that
+/// parses or registers options itself, which needs them to itself.
+static std::shared_timed_mutex LLVMOptionsMutex;
+
+/// Whether an invocation parses llvm::cl options or registers new ones.
+static bool setsLLVMOptions(const CompilerInvocation &Invocation) {
+  const FrontendOptions &FrontendOpts = Invocation.getFrontendOpts();
+  const CodeGenOptions &CodeGenOpts = Invocation.getCodeGenOpts();
+  return !FrontendOpts.LLVMArgs.empty() || !FrontendOpts.Plugins.empty() ||
+         !CodeGenOpts.DebugPass.empty() ||
+         !CodeGenOpts.LimitFloatPrecision.empty();
+}
+
 static void LLVMErrorHandler(void *UserData, const std::string &Message,
                              bool GenCrashDiag) {
-  DiagnosticsEngine &Diags = *static_cast<DiagnosticsEngine*>(UserData);
-
-  Diags.Report(diag::err_fe_error_backend) << Message;
+  if (DiagnosticsEngine *Diags = ThreadDiags)
+    Diags->Report(diag::err_fe_error_backend) << Message;
+  else
+    llvm::errs() << "error: " << Message << "\n";
 
   // Run the interrupt handlers to make sure any special cleanups get done, in
   // particular that we remove files registered with RemoveFileOnSignal.
@@ -181,7 +211,8 @@ static int PrintSupportedCPUs(std::string TargetStr) {
   return 0;
 }
 
-int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
+int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr,
+             raw_ostream *DiagOS, FileManager *Files, ArenaPool *Arenas) {
   ensureSufficientStack();
 
   std::unique_ptr<CompilerInstance> Clang(new CompilerInstance());
@@ -193,10 +224,15 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
   PCHOps->registerReader(std::make_unique<ObjectFilePCHContainerReader>());
 
   // Initialize targets first, so that --version shows registered targets.
-  llvm::InitializeAllTargets();
-  llvm::InitializeAllTargetMCs();
-  llvm::InitializeAllAsmPrinters();
-  llvm::InitializeAllAsmParsers();
+  // Registration is not thread-safe, and in-process invocations may run
+  // concurrently, so only the first one does it.
+  static std::once_flag InitializeTargets;
+  std::call_once(InitializeTargets, [] {
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmPrinters();
+    llvm::InitializeAllAsmParsers();
+  });
 
   // Buffer diagnostics from argument parsing so that we can output them using a
   // well formed diagnostic object.
@@ -209,6 +245,7 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
   if (Clang->getFrontendOpts().TimeTrace) {
     llvm::timeTraceProfilerInitialize(
         Clang->getFrontendOpts().TimeTraceGranularity, Argv0);
+    timeTraceCountersInitialize(Clang->getFrontendOpts().TimeTraceGranularity);
   }
   // --print-supported-cpus takes priority over the actual compilation.
   if (Clang->getFrontendOpts().PrintSupportedCPUs)
@@ -221,19 +258,51 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
       CompilerInvocation::GetResourcesPath(Argv0, MainAddr);
 
   // Create the actual diagnostics engine.
-  Clang->createDiagnostics();
+  if (DiagOS)
+    Clang->createDiagnostics(
+        new TextDiagnosticPrinter(*DiagOS, &Clang->getDiagnosticOpts()));
+  else
+    Clang->createDiagnostics();
   if (!Clang->hasDiagnostics())
     return 1;
 
-  // Set an error handler, so that any LLVM backend diagnostics go through our
-  // error handler.
-  llvm::install_fatal_error_handler(LLVMErrorHandler,
-                                  static_cast<void*>(&Clang->getDiagnostics()));
-
   DiagsBuffer->FlushDiagnostics(Clang->getDiagnostics());
   if (!Success)
     return 1;
 
+  // Reuse the file manager of the caller, with what it already knows about
+  // the file system.
+  if (Files)
+    Clang->setFileManager(Files);
+
+  // Likewise take the allocator slabs from the caller's pool, which keeps
+  // them between compilations.
+  if (Arenas)
+    Clang->setArenaPool(Arenas);
+
+  std::shared_lock<std::shared_timed_mutex> SharedOptions(LLVMOptionsMutex,
+                                                          std::defer_lock);
+  std::unique_lock<std::shared_timed_mutex> ExclusiveOptions(LLVMOptionsMutex,
+                                                             std::defer_lock);
+  if (setsLLVMOptions(Clang->getInvocation())) {
+    ExclusiveOptions.lock();
+    // The options are global, and an earlier invocation in this process may
+    // already have parsed them; clean up their usage count so they parse
+    // again.
+    llvm::cl::ResetAllOptionOccurrences();
+  } else {
+    SharedOptions.lock();
+  }
+
+  // Set an error handler, so that any LLVM backend diagnostics go through our
+  // error handler.
+  ThreadDiags = &Clang->getDiagnostics();
+  {
+    std::lock_guard<std::mutex> Guard(ErrorHandlerMutex);
+    if (ErrorHandlerUsers++ == 0)
+      llvm::install_fatal_error_handler(LLVMErrorHandler, nullptr);
+  }
+
   // Execute the frontend actions.
   {
     llvm::TimeTraceScope TimeScope("ExecuteCompiler");
@@ -255,9 +324,10 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
                                     /*Extension=*/"json",
                                     /*useTemporary=*/false)) {
 
-      llvm::timeTraceProfilerWrite(*profilerOutput);
+      timeTraceCountersWrite(*profilerOutput);
       // FIXME(ibiryukov): make profilerOutput flush in destructor instead.
       profilerOutput->flush();
+      timeTraceCountersCleanup();
       llvm::timeTraceProfilerCleanup();
       Clang->clearOutputFiles(false);
     }
@@ -266,7 +336,12 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
   // Our error handler depends on the Diagnostics object, which we're
   // potentially about to delete. Uninstall the handler now so that any
   // later errors use the default handling behavior instead.
-  llvm::remove_fatal_error_handler();
+  ThreadDiags = nullptr;
+  {
+    std::lock_guard<std::mutex> Guard(ErrorHandlerMutex);
+    if (--ErrorHandlerUsers == 0)
+      llvm::remove_fatal_error_handler();
+  }
 
   // When running with -disable-free, don't do any destruction or shutdown.
   if (Clang->getFrontendOpts().DisableFree) {
@@ -0,0 +1,592 @@
+//===-- cc1server_main.cpp - Latino CC1 Compile Server --------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This is the entry point to the latino -cc1server functionality, a long-lived
+// local server that runs cc1 invocations on behalf of other latino processes
+// while keeping file system state warm between them, and the client side used
+// by -cc1 to hand its invocation to such a server.
+//
+// The server listens on a unix socket only its owner may connect to:
+//
+//   latino -cc1server <socket-path> [-j <threads>]
+//
+// and a -cc1 invocation is forwarded to it when the LATINO_COMPILE_SERVER
+// environment variable names that socket. If no server answers, or the
+// invocation cannot be run remotely, the client compiles locally as usual.
+//
+// Each server thread keeps one FileManager per working directory, so the stat
+// results and directory entries found by earlier invocations are reused. The
+// directories of every path looked up, found or not, are watched with a
+// DirectoryWatcher, and any change in them drops the cached state. Each
+// thread also keeps an ArenaPool, so the preprocessor and AST allocators of
+// one invocation reuse the memory slabs of the previous ones.
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/Basic/ArenaPool.h"
+#include "latino/Basic/FileManager.h"
+#include "latino/Basic/LLVM.h"
+#include "latino/Basic/Stack.h"
+#include "latino/Basic/Version.h"
+#include "latino/DirectoryWatcher/DirectoryWatcher.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/CrashRecoveryContext.h"
+#include "llvm/Support/Errno.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if LLVM_ON_UNIX
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace latino;
+
+extern int cc1_main(ArrayRef<const char *> Argv, const char *Argv0,
+                    void *MainAddr, raw_ostream *DiagOS,
+                    FileManager *Files, ArenaPool *Arenas);
+
+/// Identifies the protocol and the compiler version on both ends, so that a
+/// client never uses a server built from different sources.
+static const char *const ServerProtocol =
+    "latino-cc1server-1 " LATINO_VERSION_STRING;
+
+namespace {
+
+enum class ResponseStatus : uint32_t {
+  /// The server ran the invocation.
+  Ran = 0,
+  /// The server refused the request; the client should compile locally.
+  Rejected = 1
+};
+
+/// Reads and writes the length-prefixed messages exchanged with the server.
+class Connection {
+  int FD;
+
+public:
+  explicit Connection(int FD) : FD(FD) {}
+  Connection(const Connection &) = delete;
+  Connection &operator=(const Connection &) = delete;
+  ~Connection() {
+#if LLVM_ON_UNIX
+    if (FD >= 0)
+      ::close(FD);
+#endif
+  }
+
+  bool writeBytes(const void *Data, size_t Size) {
+#if LLVM_ON_UNIX
+    const char *Ptr = static_cast<const char *>(Data);
+    while (Size) {
+      ssize_t N = ::write(FD, Ptr, Size);
+      if (N < 0 && errno == EINTR)
+        continue;
+      if (N <= 0)
+        return false;
+      Ptr += N;
+      Size -= N;
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  bool readBytes(void *Data, size_t Size) {
+#if LLVM_ON_UNIX
+    char *Ptr = static_cast<char *>(Data);
+    while (Size) {
+      ssize_t N = ::read(FD, Ptr, Size);
+      if (N < 0 && errno == EINTR)
+        continue;
+      if (N <= 0)
+        return false;
+      Ptr += N;
+      Size -= N;
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  bool writeInt(uint32_t Value) { return writeBytes(&Value, sizeof(Value)); }
+  bool readInt(uint32_t &Value) { return readBytes(&Value, sizeof(Value)); }
+
+  bool writeString(StringRef Str) {
+    return writeInt(Str.size()) && writeBytes(Str.data(), Str.size());
+  }
+
+  bool readString(std::string &Str) {
+    uint32_t Size;
+    if (!readInt(Size))
+      return false;
+    Str.resize(Size);
+    return readBytes(&Str[0], Size);
+  }
+};
+
+/// Watches the directories of the files seen by the server, and counts the
+/// changes in them.
+class ChangeTracker {
+  std::mutex WatchersMutex;
+  llvm::StringMap<std::unique_ptr<DirectoryWatcher>> Watchers;
+
+  /// Directories whose watcher stopped working, to be watched anew.
+  std::mutex StaleMutex;
+  std::vector<std::string> StaleDirs;
+
+public:
+  /// Incremented whenever something changes in a watched directory.
+  std::atomic<uint64_t> Generation{0};
+
+  /// Start watching \p Dir, if it is not watched already. \p Added is set if
+  /// it was not.
+  ///
+  /// \returns false if the directory cannot be watched, in which case nothing
+  /// learned about it may be cached.
+  bool watch(StringRef Dir, bool &Added) {
+    std::vector<std::string> Stale;
+    {
+      std::lock_guard<std::mutex> Guard(StaleMutex);
+      Stale.swap(StaleDirs);
+    }
+
+    std::lock_guard<std::mutex> Guard(WatchersMutex);
+    for (const std::string &S : Stale)
+      Watchers.erase(S);
+
+    auto It = Watchers.find(Dir);
+    if (It != Watchers.end())
+      return true;
+    if (!llvm::sys::fs::is_directory(Dir))
+      return false;
+
+    std::string DirName = Dir.str();
+    auto Watcher = DirectoryWatcher::create(
+        Dir,
+        [this, DirName](ArrayRef<DirectoryWatcher::Event> Events,
+                        bool IsInitial) {
+          if (IsInitial)
+            return;
+          ++Generation;
+          for (const DirectoryWatcher::Event &E : Events) {
+            if (E.Kind == DirectoryWatcher::Event::EventKind::
+                              WatcherGotInvalidated ||
+                E.Kind == DirectoryWatcher::Event::EventKind::
+                              WatchedDirRemoved) {
+              std::lock_guard<std::mutex> Guard(StaleMutex);
+              StaleDirs.push_back(DirName);
+              break;
+            }
+          }
+        },
+        /*WaitForInitialSync=*/false);
+    if (!Watcher) {
+      llvm::consumeError(Watcher.takeError());
+      return false;
+    }
+    Watchers[Dir] = std::move(*Watcher);
+    Added = true;
+    return true;
+  }
+};
+
+/// The state one server thread keeps between the invocations it runs.
+class ServerWorker {
+  ChangeTracker &Changes;
+
+  /// The file managers of earlier invocations, by working directory.
+  llvm::StringMap<IntrusiveRefCntPtr<FileManager>> FileManagers;
+
+  /// The value of ChangeTracker::Generation the file managers are valid for.
+  uint64_t Generation = 0;
+
+  /// The allocator slabs released by earlier invocations.
+  IntrusiveRefCntPtr<ArenaPool> Arenas = new ArenaPool();
+
+public:
+  explicit ServerWorker(ChangeTracker &Changes) : Changes(Changes) {}
+
+  /// Run the cc1 invocation \p Args in \p WorkingDir.
+  ///
+  /// \returns false if the invocation crashed.
+  bool run(StringRef WorkingDir, ArrayRef<std::string> Args, const char *Argv0,
+           void *MainAddr, raw_ostream &DiagOS, int &ExitCode) {
+    // Capture the generation before compiling, so that a change made while
+    // the invocation runs invalidates what it cached.
+    uint64_t CurrentGeneration = Changes.Generation;
+    if (CurrentGeneration != Generation) {
+      FileManagers.clear();
+      Generation = CurrentGeneration;
+    }
+
+    IntrusiveRefCntPtr<FileManager> &Files = FileManagers[WorkingDir];
+    if (!Files) {
+      FileSystemOptions FSOpts;
+      FSOpts.WorkingDir = WorkingDir.str();
+      Files = new FileManager(FSOpts);
+    }
+
+    // The server outlives the invocation, so it has to free its memory, and
+    // relative paths have to be resolved against the client's directory.
+    std::vector<const char *> Argv;
+    bool HasWorkingDir = false;
+    for (const std::string &Arg : Args) {
+      if (Arg == "-disable-free")
+        continue;
+      HasWorkingDir |= Arg == "-working-directory";
+      Argv.push_back(Arg.c_str());
+    }
+    std::string WorkingDirStr = WorkingDir.str();
+    if (!HasWorkingDir) {
+      Argv.push_back("-working-directory");
+      Argv.push_back(WorkingDirStr.c_str());
+    }
+
+    // A crash must not take the server down. The client then compiles
+    // locally, which reports the crash the usual way. Workers may run
+    // invocations concurrently: cc1_main guards the process-wide LLVM options
+    // and resets their occurrences before an invocation parses them.
+    int Result = 0;
+    llvm::CrashRecoveryContext CRC;
+    if (!CRC.RunSafelyOnThread(
+            [&]() {
+              Result = cc1_main(Argv, Argv0, MainAddr, &DiagOS, Files.get(),
+                                Arenas.get());
+            },
+            DesiredStackSize)) {
+      FileManagers.clear();
+      return false;
+    }
+    DiagOS.flush();
+
+    // Keep the cached state only if every directory it depends on was
+    // already watched while the invocation ran. That includes the directories
+    // where a lookup found nothing, since the file may be created there
+    // later. A change made before a new watcher started would be missed, so
+    // a cache that needed one is dropped and rebuilt by the next invocation.
+    SmallVector<StringRef, 64> Paths;
+    Files->GetSeenPaths(Paths);
+    llvm::StringSet<> Dirs;
+    for (StringRef Name : Paths) {
+      SmallString<256> Path(Name);
+      Files->makeAbsolutePath(Path);
+      // A missing directory is noticed when it is created in the closest
+      // existing directory above it.
+      StringRef Dir = llvm::sys::path::parent_path(Path);
+      while (!Dir.empty() && !llvm::sys::fs::is_directory(Dir))
+        Dir = llvm::sys::path::parent_path(Dir);
+      Dirs.insert(Dir);
+    }
+    bool Added = false;
+    for (const auto &Dir : Dirs) {
+      if (!Changes.watch(Dir.getKey(), Added)) {
+        Added = true;
+        break;
+      }
+    }
+    if (Added)
+      FileManagers.erase(WorkingDir);
+    ExitCode = Result;
+    return true;
+  }
+};
+
+} // namespace
+
+/// Whether \p Arg names an output file as its separate value.
+static bool isOutputPathOption(StringRef Arg) {
+  return llvm::StringSwitch<bool>(Arg)
+      .Cases("-o", "-MF", "-dependency-file", "-dependency-dot", true)
+      .Cases("-serialize-diagnostic-file", "-header-include-file", true)
+      .Cases("-diagnostic-log-file", "-split-dwarf-output", true)
+      .Cases("-opt-record-file", "-module-dependency-dir", true)
+      .Cases("-coverage-notes-file", "-coverage-data-file", true)
+      .Default(false);
+}
+
+/// If \p Arg names an output file in its joined value, return the option's
+/// prefix.
+static StringRef getJoinedOutputPathPrefix(StringRef Arg) {
+  for (StringRef Prefix : {"-coverage-notes-file=", "-coverage-data-file=",
+                           "-stats-file=", "-MF"})
+    if (Arg.size() > Prefix.size() && Arg.startswith(Prefix))
+      return Prefix;
+  return StringRef();
+}
+
+/// Whether the invocation \p Argv can run on the server. The server does not
+/// share the client's standard output, process-wide LLVM options or virtual
+/// file system overlays.
+static bool canRunOnServer(ArrayRef<const char *> Argv) {
+  bool HasOutput = false;
+  for (size_t I = 0, E = Argv.size(); I != E; ++I) {
+    if (!Argv[I])
+      continue;
+    StringRef Arg = Argv[I];
+    if (isOutputPathOption(Arg)) {
+      if (I + 1 == E || !Argv[I + 1] || StringRef(Argv[I + 1]) == "-")
+        return false;
+      HasOutput |= Arg == "-o";
+    }
+    StringRef Prefix = getJoinedOutputPathPrefix(Arg);
+    if (!Prefix.empty() && Arg.drop_front(Prefix.size()) == "-")
+      return false;
+    if (llvm::StringSwitch<bool>(Arg)
+            .Cases("-mllvm", "-load", "-ivfsoverlay", true)
+            .Cases("-mdebug-pass", "-mlimit-float-precision", true)
+            .Default(false))
+      return false;
+  }
+  return HasOutput;
+}
+
+#if LLVM_ON_UNIX
+/// Open a connected socket to the server at \p Path, or return -1. Only a
+/// socket owned by the current user is trusted with the invocation.
+static int connectToServer(StringRef Path) {
+  sockaddr_un Addr;
+  if (Path.size() >= sizeof(Addr.sun_path))
+    return -1;
+  struct stat Status;
+  if (::lstat(Path.str().c_str(), &Status) != 0 || !S_ISSOCK(Status.st_mode) ||
+      Status.st_uid != ::getuid())
+    return -1;
+  memset(&Addr, 0, sizeof(Addr));
+  Addr.sun_family = AF_UNIX;
+  memcpy(Addr.sun_path, Path.data(), Path.size());
+
+  int FD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (FD < 0)
+    return -1;
+  if (::connect(FD, reinterpret_cast<sockaddr *>(&Addr), sizeof(Addr)) != 0) {
+    ::close(FD);
+    return -1;
+  }
+  return FD;
+}
+
+/// Serve the connection \p FD with \p Worker.
+static void serveConnection(int FD, ServerWorker &Worker, const char *Argv0,
+                            void *MainAddr) {
+  Connection Conn(FD);
+  std::string Protocol, WorkingDir;
+  uint32_t NumArgs;
+  if (!Conn.readString(Protocol) || !Conn.readString(WorkingDir) ||
+      !Conn.readInt(NumArgs))
+    return;
+  std::vector<std::string> Args(NumArgs);
+  for (std::string &Arg : Args)
+    if (!Conn.readString(Arg))
+      return;
+
+  std::vector<const char *> Argv;
+  for (const std::string &Arg : Args)
+    Argv.push_back(Arg.c_str());
+
+  std::string Diags;
+  llvm::raw_string_ostream DiagOS(Diags);
+  int Result;
+  if (Protocol != ServerProtocol || Args.empty() || Args[0] != "-cc1" ||
+      !canRunOnServer(Argv) ||
+      !Worker.run(WorkingDir, Args, Argv0, MainAddr, DiagOS, Result)) {
+    Conn.writeInt(static_cast<uint32_t>(ResponseStatus::Rejected));
+    return;
+  }
+  DiagOS.flush();
+
+  Conn.writeInt(static_cast<uint32_t>(ResponseStatus::Ran)) &&
+      Conn.writeInt(static_cast<uint32_t>(Result)) && Conn.writeString(Diags);
+}
+#endif
+
+bool cc1server_forward(ArrayRef<const char *> Argv, raw_ostream &DiagOS,
+                       int &Result) {
+#if LLVM_ON_UNIX
+  Optional<std::string> SocketPath =
+      llvm::sys::Process::GetEnv("LATINO_COMPILE_SERVER");
+  if (!SocketPath || SocketPath->empty() || !canRunOnServer(Argv))
+    return false;
+
+  SmallString<256> WorkingDir;
+  if (llvm::sys::fs::current_path(WorkingDir))
+    return false;
+
+  int FD = connectToServer(*SocketPath);
+  if (FD < 0)
+    return false;
+  Connection Conn(FD);
+
+  // Output files are opened by the server, whose working directory differs
+  // from ours.
+  std::vector<std::string> Args;
+  bool NextIsOutput = false;
+  for (const char *A : Argv) {
+    if (!A)
+      continue;
+    SmallString<256> Arg(A);
+    if (NextIsOutput) {
+      llvm::sys::fs::make_absolute(WorkingDir, Arg);
+    } else {
+      StringRef Prefix = getJoinedOutputPathPrefix(A);
+      if (!Prefix.empty()) {
+        SmallString<256> Path(StringRef(A).drop_front(Prefix.size()));
+        llvm::sys::fs::make_absolute(WorkingDir, Path);
+        Arg = Prefix;
+        Arg += Path;
+      }
+    }
+    NextIsOutput = isOutputPathOption(Arg);
+    Args.push_back(std::string(Arg.str()));
+  }
+
+  if (!Conn.writeString(ServerProtocol) || !Conn.writeString(WorkingDir) ||
+      !Conn.writeInt(Args.size()))
+    return false;
+  for (const std::string &Arg : Args)
+    if (!Conn.writeString(Arg))
+      return false;
+
+  uint32_t Status, ExitCode;
+  std::string Diags;
+  if (!Conn.readInt(Status) ||
+      Status != static_cast<uint32_t>(ResponseStatus::Ran) ||
+      !Conn.readInt(ExitCode) || !Conn.readString(Diags))
+    return false;
+
+  DiagOS << Diags;
+  DiagOS.flush();
+  Result = static_cast<int>(ExitCode);
+  return true;
+#else
+  return false;
+#endif
+}
+
+int cc1server_main(ArrayRef<const char *> Argv, const char *Argv0,
+                   void *MainAddr) {
+#if LLVM_ON_UNIX
+  StringRef SocketPath;
+  unsigned NumThreads = llvm::hardware_concurrency().compute_thread_count();
+  for (size_t I = 0, E = Argv.size(); I != E; ++I) {
+    if (!Argv[I])
+      continue;
+    StringRef Arg = Argv[I];
+    if (Arg == "-j" && I + 1 != E && Argv[I + 1]) {
+      if (StringRef(Argv[++I]).getAsInteger(10, NumThreads) || !NumThreads) {
+        llvm::errs() << "error: invalid thread count '" << Argv[I] << "'\n";
+        return 1;
+      }
+    } else if (SocketPath.empty()) {
+      SocketPath = Arg;
+    } else {
+      llvm::errs() << "error: unexpected argument '" << Arg << "'\n";
+      return 1;
+    }
+  }
+  if (SocketPath.empty()) {
+    llvm::errs() << "error: missing socket path\n";
+    return 1;
+  }
+
+  sockaddr_un Addr;
+  if (SocketPath.size() >= sizeof(Addr.sun_path)) {
+    llvm::errs() << "error: socket path '" << SocketPath << "' is too long\n";
+    return 1;
+  }
+  memset(&Addr, 0, sizeof(Addr));
+  Addr.sun_family = AF_UNIX;
+  memcpy(Addr.sun_path, SocketPath.data(), SocketPath.size());
+
+  // A socket left behind by a server that is no longer running is replaced.
+  if (llvm::sys::fs::exists(SocketPath)) {
+    int FD = connectToServer(SocketPath);
+    if (FD >= 0) {
+      ::close(FD);
+      llvm::errs() << "error: a server is already listening on '"
+                   << SocketPath << "'\n";
+      return 1;
+    }
+    llvm::sys::fs::remove(SocketPath);
+  }
+
+  // Other users must not be able to connect: they would run compilations as
+  // the server's owner. The socket is created with no permissions for them,
+  // rather than restricted after the fact.
+  int ListenFD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  bool Bound = false;
+  if (ListenFD >= 0) {
+    mode_t OldMask = ::umask(S_IRWXG | S_IRWXO);
+    Bound =
+        !::bind(ListenFD, reinterpret_cast<sockaddr *>(&Addr), sizeof(Addr));
+    ::umask(OldMask);
+  }
+  if (!Bound || ::chmod(Addr.sun_path, S_IRUSR | S_IWUSR) ||
+      ::listen(ListenFD, SOMAXCONN)) {
+    llvm::errs() << "error: cannot listen on '" << SocketPath
+                 << "': " << llvm::sys::StrError() << "\n";
+    return 1;
+  }
+  llvm::sys::RemoveFileOnSignal(SocketPath);
+
+  // Clients that go away must not kill the server, and neither may crashing
+  // invocations.
+  ::signal(SIGPIPE, SIG_IGN);
+  llvm::CrashRecoveryContext::Enable();
+
+  // Every thread accepts connections itself and keeps its own warm state, so
+  // requests never wait on each other's caches.
+  ChangeTracker Changes;
+  std::vector<std::thread> Threads;
+  for (unsigned I = 0; I != NumThreads; ++I)
+    Threads.emplace_back([&]() {
+      ServerWorker Worker(Changes);
+      while (true) {
+        int FD = ::accept(ListenFD, nullptr, nullptr);
+        if (FD < 0) {
+          if (errno == EINTR || errno == ECONNABORTED)
+            continue;
+          return;
+        }
+        serveConnection(FD, Worker, Argv0, MainAddr);
+      }
+    });
+  for (std::thread &T : Threads)
+    T.join();
+
+  ::close(ListenFD);
+  llvm::sys::fs::remove(SocketPath);
+  return 0;
+#else
+  llvm::errs() << "error: -cc1server is not supported on this platform\n";
+  return 1;
+#endif
+}
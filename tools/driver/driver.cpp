@@ -13,6 +13,8 @@
 
 #include "latino/Driver/Driver.h"
 #include "latino/Basic/DiagnosticOptions.h"
+#include "latino/Basic/ArenaPool.h"
+#include "latino/Basic/FileManager.h"
 #include "latino/Basic/Stack.h"
 #include "latino/Config/config.h"
 #include "latino/Driver/Compilation.h"
@@ -204,11 +206,17 @@ static void ApplyQAOverride(SmallVectorImpl<const char*> &Args,
 }
 
 extern int cc1_main(ArrayRef<const char *> Argv, const char *Argv0,
-                    void *MainAddr);
+                    void *MainAddr, raw_ostream *DiagOS = nullptr,
+                    FileManager *Files = nullptr,
+                    ArenaPool *Arenas = nullptr);
 extern int cc1as_main(ArrayRef<const char *> Argv, const char *Argv0,
                       void *MainAddr);
 extern int cc1gen_reproducer_main(ArrayRef<const char *> Argv,
                                   const char *Argv0, void *MainAddr);
+extern int cc1server_main(ArrayRef<const char *> Argv, const char *Argv0,
+                          void *MainAddr);
+extern bool cc1server_forward(ArrayRef<const char *> Argv, raw_ostream &DiagOS,
+                              int &Result);
 
 static void insertTargetAndModeArgs(const ParsedClangName &NameParts,
                                     SmallVectorImpl<const char *> &ArgVector,
@@ -313,30 +321,46 @@ static void SetInstallDir(SmallVectorImpl<const char *> &argv,
     TheDriver.setInstalledDir(InstalledPathParent);
 }
 
-static int ExecuteCC1Tool(SmallVectorImpl<const char *> &ArgV) {
-  // If we call the cc1 tool from the latinoDriver library (through
-  // Driver::CC1Main), we need to clean up the options usage count. The options
-  // are currently global, and they might have been used previously by the
-  // driver.
-  llvm::cl::ResetAllOptionOccurrences();
-
+static int ExecuteCC1Tool(SmallVectorImpl<const char *> &ArgV,
+                          raw_ostream *DiagOS) {
   llvm::BumpPtrAllocator A;
   llvm::StringSaver Saver(A);
   llvm::cl::ExpandResponseFiles(Saver, &llvm::cl::TokenizeGNUCommandLine, ArgV,
                                 /*MarkEOLs=*/false);
+
   StringRef Tool = ArgV[1];
   void *GetExecutablePathVP = (void *)(intptr_t)GetExecutablePath;
-  if (Tool == "-cc1")
-    return cc1_main(makeArrayRef(ArgV).slice(1), ArgV[0], GetExecutablePathVP);
+  if (Tool == "-cc1") {
+    // Hand the invocation to a compile server, if one is running.
+    int Result;
+    if (cc1server_forward(makeArrayRef(ArgV).slice(1),
+                          DiagOS ? *DiagOS : llvm::errs(), Result))
+      return Result;
+    // In-process jobs of one driver invocation share their allocator slabs.
+    // They may run concurrently, so cc1_main itself guards the llvm::cl
+    // options.
+    static IntrusiveRefCntPtr<ArenaPool> Arenas(new ArenaPool());
+    return cc1_main(makeArrayRef(ArgV).slice(1), ArgV[0], GetExecutablePathVP,
+                    DiagOS, /*Files=*/nullptr, Arenas.get());
+  }
+
+  // The other tools never run beside another job. If we call them from the
+  // latinoDriver library (through Driver::CC1Main), we need to clean up the
+  // options usage count. The options are currently global, and they might
+  // have been used previously by the driver.
+  llvm::cl::ResetAllOptionOccurrences();
   if (Tool == "-cc1as")
     return cc1as_main(makeArrayRef(ArgV).slice(2), ArgV[0],
                       GetExecutablePathVP);
   if (Tool == "-cc1gen-reproducer")
     return cc1gen_reproducer_main(makeArrayRef(ArgV).slice(2), ArgV[0],
                                   GetExecutablePathVP);
+  if (Tool == "-cc1server")
+    return cc1server_main(makeArrayRef(ArgV).slice(2), ArgV[0],
+                          GetExecutablePathVP);
   // Reject unknown tools.
   llvm::errs() << "error: unknown integrated tool '" << Tool << "'. "
-               << "Valid tools include '-cc1' and '-cc1as'.\n";
+               << "Valid tools include '-cc1', '-cc1as' and '-cc1server'.\n";
   return 1;
 }
 
@@ -404,7 +428,7 @@ int main(int argc_, const char **argv_) {
       auto newEnd = std::remove(argv.begin(), argv.end(), nullptr);
       argv.resize(newEnd - argv.begin());
     }
-    return ExecuteCC1Tool(argv);
+    return ExecuteCC1Tool(argv, /*DiagOS=*/nullptr);
   }
 
   // Handle options that need handling before the real command line parsing in
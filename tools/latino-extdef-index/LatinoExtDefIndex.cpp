@@ -0,0 +1,74 @@
+//===- LatinoExtDefIndex.cpp - Build the binary CTU definition index ------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Converts the text index of external definitions, as used by the
+// cross translation unit analysis, into the binary index, which the analyzer
+// memory maps and looks up without parsing it.  The analyzer accepts either
+// form as its -analyzer-config ctu-index-name.
+//
+// Several text indexes, for example one per translation unit, can be merged
+// into one binary index.  A lookup name defined in more than one of them is
+// an error, as it is within one text index.
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/CrossTU/CrossTUIndex.h"
+#include "latino/CrossTU/CrossTranslationUnit.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+
+using namespace latino;
+using namespace latino::cross_tu;
+using namespace llvm;
+
+static cl::list<std::string> Inputs(cl::Positional, cl::OneOrMore,
+                                    cl::desc("<text index>..."));
+
+static cl::opt<std::string> Output("o", cl::Required,
+                                   cl::desc("Write the binary index to "
+                                            "<file>"),
+                                   cl::value_desc("file"));
+
+int main(int argc, const char **argv) {
+  InitLLVM X(argc, argv);
+  cl::ParseCommandLineOptions(argc, argv,
+                              "Latino binary CTU definition index builder\n");
+
+  StringMap<std::string> Index;
+  for (const std::string &Input : Inputs) {
+    Expected<StringMap<std::string>> Parsed = parseCrossTUIndex(Input);
+    if (!Parsed) {
+      WithColor::error() << Input << ": " << toString(Parsed.takeError())
+                         << "\n";
+      return 1;
+    }
+    for (auto &Entry : *Parsed) {
+      if (!Index.try_emplace(Entry.getKey(), std::move(Entry.getValue()))
+               .second) {
+        WithColor::error() << Input << ": " << Entry.getKey()
+                           << " is already defined by another index\n";
+        return 1;
+      }
+    }
+  }
+
+  std::error_code EC;
+  ToolOutputFile Out(Output, EC, sys::fs::OF_None);
+  if (EC) {
+    WithColor::error() << Output << ": " << EC.message() << "\n";
+    return 1;
+  }
+  writeBinaryCrossTUIndex(Index, Out.os());
+  Out.keep();
+  return 0;
+}
@@ -0,0 +1,240 @@
+//===- LatinoLexBench.cpp - Lexer and preprocessor throughput benchmark ---===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Runs the raw lexer over a corpus of .lat files and reports the throughput
+// in MB/s.  Directories on the command line are searched recursively for
+// files with the .lat extension.
+//
+// With -preprocess, each file is run through the full preprocessor instead,
+// following #incluir and #importar directives, and the number of files that
+// were entered and skipped is reported.  A file that imports the same header
+// many times shows what a repeated, already-seen include costs.
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/Basic/Diagnostic.h"
+#include "latino/Basic/DiagnosticOptions.h"
+#include "latino/Basic/FileManager.h"
+#include "latino/Basic/LangOptions.h"
+#include "latino/Basic/SourceLocation.h"
+#include "latino/Basic/SourceManager.h"
+#include "latino/Basic/TargetInfo.h"
+#include "latino/Basic/TargetOptions.h"
+#include "latino/Lex/HeaderSearch.h"
+#include "latino/Lex/HeaderSearchOptions.h"
+#include "latino/Lex/Lexer.h"
+#include "latino/Lex/ModuleLoader.h"
+#include "latino/Lex/PPCallbacks.h"
+#include "latino/Lex/Preprocessor.h"
+#include "latino/Lex/PreprocessorOptions.h"
+#include "latino/Lex/Token.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace latino;
+using namespace llvm;
+
+static cl::list<std::string> Inputs(cl::Positional, cl::OneOrMore,
+                                    cl::desc("<file or directory>..."));
+
+static cl::opt<unsigned> Iterations("iterations", cl::init(10),
+                                    cl::desc("Number of passes over the "
+                                             "corpus (default: 10)"));
+
+static cl::opt<bool> Preprocess("preprocess",
+                                cl::desc("Run the full preprocessor, following "
+                                         "#incluir and #importar"));
+
+static cl::list<std::string> IncludeDirs("I", cl::Prefix,
+                                         cl::desc("Add directory to the "
+                                                  "include search path"));
+
+namespace {
+
+struct InputFile {
+  std::string Path;
+  std::unique_ptr<MemoryBuffer> Buffer;
+};
+
+/// Counts the files entered and skipped by inclusion directives.
+class IncludeCounter : public PPCallbacks {
+public:
+  void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                   SrcMgr::CharacteristicKind FileType,
+                   FileID PrevFID) override {
+    if (Reason == EnterFile)
+      ++Entered;
+  }
+
+  void FileSkipped(const FileEntryRef &SkippedFile, const Token &FilenameTok,
+                   SrcMgr::CharacteristicKind FileType) override {
+    ++Skipped;
+  }
+
+  uint64_t Entered = 0;
+  uint64_t Skipped = 0;
+};
+
+} // end anonymous namespace
+
+static void addInput(StringRef Path, std::vector<InputFile> &Corpus) {
+  auto AddFile = [&](StringRef File) {
+    auto Buf = MemoryBuffer::getFile(File);
+    if (!Buf) {
+      WithColor::error() << File << ": " << Buf.getError().message() << "\n";
+      return;
+    }
+    Corpus.push_back({File.str(), std::move(*Buf)});
+  };
+
+  if (!sys::fs::is_directory(Path)) {
+    AddFile(Path);
+    return;
+  }
+
+  std::error_code EC;
+  for (sys::fs::recursive_directory_iterator I(Path, EC), E; I != E && !EC;
+       I.increment(EC)) {
+    if (sys::path::extension(I->path()) == ".lat" &&
+        sys::fs::is_regular_file(I->path()))
+      AddFile(I->path());
+  }
+  if (EC)
+    WithColor::error() << Path << ": " << EC.message() << "\n";
+}
+
+static uint64_t rawLex(const InputFile &Input, const LangOptions &LangOpts) {
+  const MemoryBuffer &Buf = *Input.Buffer;
+  Lexer L(SourceLocation(), LangOpts, Buf.getBufferStart(),
+          Buf.getBufferStart(), Buf.getBufferEnd());
+  uint64_t Tokens = 0;
+  Token Tok;
+  do {
+    L.LexFromRawLexer(Tok);
+    ++Tokens;
+  } while (Tok.isNot(tok::eof));
+  return Tokens;
+}
+
+static uint64_t preprocess(const InputFile &Input, LangOptions &LangOpts,
+                           FileManager &FileMgr, DiagnosticsEngine &Diags,
+                           TargetInfo &Target, IncludeCounter &Counter) {
+  auto File = FileMgr.getFile(Input.Path);
+  if (!File)
+    return 0;
+
+  SourceManager SourceMgr(Diags, FileMgr);
+  SourceMgr.setMainFileID(
+      SourceMgr.createFileID(*File, SourceLocation(), SrcMgr::C_User));
+
+  HeaderSearch HeaderInfo(std::make_shared<HeaderSearchOptions>(), SourceMgr,
+                          Diags, LangOpts, &Target);
+  for (const std::string &Dir : IncludeDirs) {
+    if (auto DE = FileMgr.getOptionalDirectoryRef(Dir))
+      HeaderInfo.AddSearchPath(DirectoryLookup(*DE, SrcMgr::C_User, false),
+                               /*isAngled=*/false);
+    else
+      WithColor::warning() << Dir << ": no such directory\n";
+  }
+
+  TrivialModuleLoader ModLoader;
+  Preprocessor PP(std::make_shared<PreprocessorOptions>(), Diags, LangOpts,
+                  SourceMgr, HeaderInfo, ModLoader,
+                  /*IILookup=*/nullptr, /*OwnsHeaderSearch=*/false);
+  PP.Initialize(Target);
+  auto *Counts = new IncludeCounter;
+  PP.addPPCallbacks(std::unique_ptr<PPCallbacks>(Counts));
+  PP.EnterMainSourceFile();
+
+  uint64_t Tokens = 0;
+  Token Tok;
+  do {
+    PP.Lex(Tok);
+    ++Tokens;
+  } while (Tok.isNot(tok::eof));
+
+  Counter.Entered += Counts->Entered;
+  Counter.Skipped += Counts->Skipped;
+  return Tokens;
+}
+
+int main(int argc, const char **argv) {
+  InitLLVM X(argc, argv);
+  cl::ParseCommandLineOptions(argc, argv,
+                              "Latino lexer and preprocessor benchmark\n");
+
+  std::vector<InputFile> Corpus;
+  for (const std::string &Input : Inputs)
+    addInput(Input, Corpus);
+  if (Corpus.empty()) {
+    WithColor::error() << "no input files\n";
+    return 1;
+  }
+
+  uint64_t Bytes = 0;
+  for (const InputFile &Input : Corpus)
+    Bytes += Input.Buffer->getBufferSize();
+
+  LangOptions LangOpts;
+  FileManager FileMgr((FileSystemOptions()));
+  IntrusiveRefCntPtr<DiagnosticsEngine> Diags(new DiagnosticsEngine(
+      new DiagnosticIDs(), new DiagnosticOptions(), new IgnoringDiagConsumer()));
+  auto TargetOpts = std::make_shared<latino::TargetOptions>();
+  TargetOpts->Triple = sys::getDefaultTargetTriple();
+  IntrusiveRefCntPtr<TargetInfo> Target;
+  if (Preprocess) {
+    Target = TargetInfo::CreateTargetInfo(*Diags, TargetOpts);
+    if (!Target) {
+      WithColor::error() << "unsupported target " << TargetOpts->Triple
+                         << "\n";
+      return 1;
+    }
+  }
+
+  uint64_t Tokens = 0;
+  IncludeCounter Counter;
+  TimeRecord Start = TimeRecord::getCurrentTime(/*Start=*/true);
+  for (unsigned It = 0; It != Iterations; ++It) {
+    for (const InputFile &Input : Corpus)
+      Tokens += Preprocess ? preprocess(Input, LangOpts, FileMgr, *Diags,
+                                        *Target, Counter)
+                           : rawLex(Input, LangOpts);
+  }
+  TimeRecord Elapsed = TimeRecord::getCurrentTime(/*Start=*/false);
+  Elapsed -= Start;
+
+  double Seconds = Elapsed.getWallTime();
+  double MB = double(Bytes) * Iterations / (1024.0 * 1024.0);
+  outs() << "files:      " << Corpus.size() << "\n"
+         << "bytes:      " << Bytes << "\n"
+         << "iterations: " << Iterations << "\n"
+         << "tokens:     " << Tokens << "\n";
+  if (Preprocess)
+    outs() << "entered:    " << Counter.Entered << "\n"
+           << "skipped:    " << Counter.Skipped << "\n"
+           << "per skip:   "
+           << format("%.1f ns", Counter.Skipped
+                                    ? Seconds * 1e9 / Counter.Skipped
+                                    : 0.0)
+           << " (upper bound)\n";
+  outs() << "time:       " << format("%.3f s", Seconds) << "\n"
+         << "throughput: "
+         << format("%.1f MB/s", Seconds > 0 ? MB / Seconds : 0) << "\n";
+  return 0;
+}
@@ -0,0 +1,180 @@
+//===- LatinoRangeBench.cpp - Range constraint throughput benchmark -------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Replays the range set operations of assume-heavy code, the way the range
+// constraint manager runs them for comparisons against constants, and reports
+// how many of them run per second.
+//
+// A pool of symbols starts unconstrained.  Each step picks a symbol and a
+// constant and applies one of 'x < C', 'x > C', 'x == C', 'x != C', '-x', or
+// 'x == y' against another symbol.  A symbol constrained to the empty set is
+// reset, as a path would be sunk.  The pseudo-random sequence is fixed by
+// -seed, so runs are comparable.
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/AST/ASTContext.h"
+#include "latino/Frontend/ASTUnit.h"
+#include "latino/StaticAnalyzer/Core/PathSensitive/APSIntType.h"
+#include "latino/StaticAnalyzer/Core/PathSensitive/BasicValueFactory.h"
+#include "latino/StaticAnalyzer/Core/PathSensitive/RangedConstraintManager.h"
+#include "latino/Tooling/Tooling.h"
+#include "llvm/ADT/APSInt.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace latino;
+using namespace ento;
+using namespace llvm;
+
+static cl::opt<unsigned> Steps("steps", cl::init(1000000),
+                               cl::desc("Number of assumptions to apply "
+                                        "(default: 1000000)"));
+
+static cl::opt<unsigned> Symbols("symbols", cl::init(64),
+                                 cl::desc("Number of symbols constrained at "
+                                          "once (default: 64)"));
+
+static cl::opt<unsigned> Constants("constants", cl::init(32),
+                                   cl::desc("Number of distinct constants the "
+                                            "symbols are compared against "
+                                            "(default: 32)"));
+
+static cl::opt<unsigned> Seed("seed", cl::init(1),
+                              cl::desc("Seed of the operation sequence"));
+
+namespace {
+
+/// The counts of what a run did, for one integer type.
+struct RunStats {
+  uint64_t Operations = 0;
+  uint64_t Resets = 0;
+  uint64_t Ranges = 0;
+  double Seconds = 0;
+};
+
+} // end anonymous namespace
+
+static RunStats run(BasicValueFactory &BVF, RangeSet::Factory &F,
+                    unsigned BitWidth, bool IsUnsigned) {
+  APSIntType Ty(BitWidth, IsUnsigned);
+  const APSInt &Min = BVF.getMinValue(Ty);
+  const APSInt &Max = BVF.getMaxValue(Ty);
+  RangeSet Full(F, Min, Max);
+  APSInt One = Ty.getZeroValue();
+  ++One;
+
+  // Keep the constants away from the extremes, so 'C - 1' and 'C + 1' are
+  // always representable.
+  std::mt19937_64 Rand(Seed);
+  std::vector<const APSInt *> Values;
+  for (unsigned I = 0; I != Constants; ++I) {
+    APSInt V(APInt(BitWidth, Rand() % 4096), IsUnsigned);
+    if (!IsUnsigned)
+      V -= APSInt(APInt(BitWidth, 2048), IsUnsigned);
+    if (V == Min || V == Max)
+      V = One;
+    Values.push_back(&BVF.getValue(V));
+  }
+
+  std::vector<RangeSet> Syms(Symbols, Full);
+  RunStats Stats;
+  TimeRecord Start = TimeRecord::getCurrentTime(/*Start=*/true);
+  for (unsigned Step = 0; Step != Steps; ++Step) {
+    RangeSet &S = Syms[Rand() % Syms.size()];
+    const APSInt &C = *Values[Rand() % Values.size()];
+    const APSInt &Prev = BVF.getValue(C - One);
+    const APSInt &Next = BVF.getValue(C + One);
+    switch (Rand() % 6) {
+    case 0: // x < C
+      S = S.Intersect(BVF, F, Min, Prev);
+      break;
+    case 1: // x > C
+      S = S.Intersect(BVF, F, Next, Max);
+      break;
+    case 2: // x == C
+      S = S.Intersect(BVF, F, C, C);
+      break;
+    case 3: // x != C, as the wrapped range [C + 1, C - 1].
+      S = S.Intersect(BVF, F, Next, Prev);
+      break;
+    case 4: // -x
+      S = S.Negate(BVF, F);
+      break;
+    case 5: // x == y
+      S = S.Intersect(BVF, F, Syms[Rand() % Syms.size()]);
+      break;
+    }
+    ++Stats.Operations;
+    if (S.isEmpty()) {
+      S = Full;
+      ++Stats.Resets;
+    }
+  }
+  TimeRecord Elapsed = TimeRecord::getCurrentTime(/*Start=*/false);
+  Elapsed -= Start;
+  Stats.Seconds = Elapsed.getWallTime();
+
+  for (const RangeSet &S : Syms)
+    Stats.Ranges += std::distance(S.begin(), S.end());
+  return Stats;
+}
+
+int main(int argc, const char **argv) {
+  InitLLVM X(argc, argv);
+  cl::ParseCommandLineOptions(argc, argv,
+                              "Latino range constraint benchmark\n");
+
+  if (!Symbols || !Constants) {
+    errs() << "error: -symbols and -constants must be positive\n";
+    return 1;
+  }
+
+  // BasicValueFactory wants an ASTContext, though none of what is run here
+  // looks at it.
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCode("");
+  BumpPtrAllocator Alloc;
+  BasicValueFactory BVF(AST->getASTContext(), Alloc);
+  RangeSet::Factory F;
+
+  struct {
+    const char *Name;
+    unsigned BitWidth;
+    bool IsUnsigned;
+  } Types[] = {{"int8", 8, false},   {"uint8", 8, true},
+               {"int32", 32, false}, {"uint32", 32, true},
+               {"int64", 64, false}, {"uint64", 64, true}};
+
+  double TotalSeconds = 0;
+  uint64_t TotalOperations = 0;
+  outs() << "type       operations     resets     ranges          ops/s\n";
+  for (const auto &T : Types) {
+    RunStats Stats = run(BVF, F, T.BitWidth, T.IsUnsigned);
+    TotalSeconds += Stats.Seconds;
+    TotalOperations += Stats.Operations;
+    outs() << format("%-8s %12llu %10llu %10llu %14.0f\n", T.Name,
+                     (unsigned long long)Stats.Operations,
+                     (unsigned long long)Stats.Resets,
+                     (unsigned long long)Stats.Ranges,
+                     Stats.Seconds > 0 ? Stats.Operations / Stats.Seconds
+                                       : 0.0);
+  }
+  outs() << "time:       " << format("%.3f s", TotalSeconds) << "\n"
+         << "throughput: "
+         << format("%.0f ops/s",
+                   TotalSeconds > 0 ? TotalOperations / TotalSeconds : 0.0)
+         << "\n";
+  return 0;
+}
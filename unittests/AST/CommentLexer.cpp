@@ -39,7 +39,7 @@ protected:
   IntrusiveRefCntPtr<DiagnosticIDs> DiagID;
   DiagnosticsEngine Diags;
   SourceManager SourceMgr;
-  llvm::BumpPtrAllocator Allocator;
+  ArenaAllocator Allocator;
   CommandTraits Traits;
 
   void lexString(const char *Source, std::vector<Token> &Toks);
@@ -45,7 +45,7 @@ protected:
   IntrusiveRefCntPtr<DiagnosticIDs> DiagID;
   DiagnosticsEngine Diags;
   SourceManager SourceMgr;
-  llvm::BumpPtrAllocator Allocator;
+  ArenaAllocator Allocator;
   CommandTraits Traits;
 
   FullComment *parseString(const char *Source);
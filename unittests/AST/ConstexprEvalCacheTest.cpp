@@ -0,0 +1,307 @@
+//===- unittests/AST/ConstexprEvalCacheTest.cpp - Cache encoding tests ----===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/AST/ConstexprEvalCache.h"
+#include "latino/AST/ASTConsumer.h"
+#include "latino/AST/ASTContext.h"
+#include "latino/Basic/DiagnosticOptions.h"
+#include "latino/Frontend/CompilerInstance.h"
+#include "latino/Frontend/CompilerInvocation.h"
+#include "latino/Frontend/FrontendActions.h"
+#include "latino/Serialization/ASTReader.h"
+#include "latino/Tooling/Tooling.h"
+#include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace latino;
+using namespace llvm;
+
+namespace {
+
+APValue roundTrip(const APValue &Value) {
+  SmallString<32> Encoded;
+  ConstexprEvalCache::encodeResult(Value, Encoded);
+  APValue Decoded;
+  EXPECT_TRUE(ConstexprEvalCache::decodeResult(Encoded, Decoded));
+  return Decoded;
+}
+
+TEST(ConstexprEvalCacheTest, ResultsRoundTrip) {
+  APSInt Wide(APInt(128, -3, /*isSigned=*/true), /*isUnsigned=*/false);
+  APValue Int = roundTrip(APValue(Wide));
+  ASSERT_TRUE(Int.isInt());
+  EXPECT_EQ(128u, Int.getInt().getBitWidth());
+  EXPECT_FALSE(Int.getInt().isUnsigned());
+  EXPECT_EQ(Wide, Int.getInt());
+
+  APValue Float = roundTrip(APValue(APFloat(0.1f)));
+  ASSERT_TRUE(Float.isFloat());
+  EXPECT_EQ(&APFloat::IEEEsingle(), &Float.getFloat().getSemantics());
+  EXPECT_TRUE(Float.getFloat().bitwiseIsEqual(APFloat(0.1f)));
+}
+
+TEST(ConstexprEvalCacheTest, MalformedResultsAreRejected) {
+  SmallString<32> Encoded;
+  ConstexprEvalCache::encodeResult(APValue(APSInt::get(42)), Encoded);
+  APValue Decoded;
+  EXPECT_FALSE(ConstexprEvalCache::decodeResult(
+      StringRef(Encoded).drop_back(), Decoded));
+  Encoded.push_back(0);
+  EXPECT_FALSE(ConstexprEvalCache::decodeResult(Encoded, Decoded));
+}
+
+TEST(ConstexprEvalCacheTest, KeysDependOnTheArguments) {
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCode("");
+  ConstexprEvalCache &Cache = AST->getASTContext().getConstexprEvalCache();
+  SmallString<32> K1, K2, K3;
+  APValue One(APSInt::get(1)), Two(APSInt::get(2));
+  ASSERT_TRUE(Cache.getKey({One, Two}, 0, K1));
+  ASSERT_TRUE(Cache.getKey({Two, One}, 0, K2));
+  ASSERT_TRUE(Cache.getKey({One, Two}, 1, K3));
+  EXPECT_NE(K1, K2);
+  EXPECT_NE(K1, K3);
+
+  SmallString<32> K4;
+  EXPECT_FALSE(Cache.getKey({APValue()}, 0, K4));
+}
+
+TEST(ConstexprEvalCacheTest, StringLiteralKeysDependOnTheContents) {
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCode("");
+  ASTContext &Ctx = AST->getASTContext();
+  ConstexprEvalCache &Cache = Ctx.getConstexprEvalCache();
+  auto getPointer = [&](StringRef Str) {
+    QualType Ty = Ctx.getStringLiteralArrayType(Ctx.CharTy, Str.size());
+    const latino::StringLiteral *SL = latino::StringLiteral::Create(
+        Ctx, Str, latino::StringLiteral::Ascii, /*Pascal=*/false, Ty,
+        SourceLocation());
+    APValue::LValuePathEntry Path[] = {APValue::LValuePathEntry::ArrayIndex(1)};
+    return APValue(APValue::LValueBase(SL), CharUnits::One(), Path,
+                   /*OnePastTheEnd=*/false);
+  };
+
+  // Literals with the same contents make the same key, however long.
+  std::string Long(4096, 'x');
+  SmallString<32> K1, K2, K3;
+  ASSERT_TRUE(Cache.getKey({getPointer(Long)}, 0, K1));
+  ASSERT_TRUE(Cache.getKey({getPointer(Long)}, 0, K2));
+  ASSERT_TRUE(Cache.getKey({getPointer(Long + "y")}, 0, K3));
+  EXPECT_EQ(K1, K2);
+  EXPECT_NE(K1, K3);
+  EXPECT_LT(K1.size(), 64u);
+}
+
+/// Runs the frontend, and records the statistics of the cache and of the AST
+/// reader afterwards.
+class CacheStatsAction : public ASTFrontendAction {
+  class Consumer : public ASTConsumer {
+    CacheStatsAction &Action;
+    CompilerInstance &CI;
+
+  public:
+    Consumer(CacheStatsAction &Action, CompilerInstance &CI)
+        : Action(Action), CI(CI) {}
+
+    void HandleTranslationUnit(ASTContext &Ctx) override {
+      Action.NumHits = Ctx.getConstexprEvalCache().getNumHits();
+      Action.NumLoaded = Ctx.getConstexprEvalCache().getNumLoaded();
+      if (ASTReader *Reader = CI.getASTReader().get())
+        Action.NumBodiesRead = Reader->getNumBodiesRead();
+    }
+  };
+
+public:
+  std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI,
+                                                 StringRef InFile) override {
+    return std::make_unique<Consumer>(*this, CI);
+  }
+
+  unsigned NumHits = 0;
+  unsigned NumLoaded = 0;
+  unsigned NumBodiesRead = 0;
+};
+
+const char *const Recursion =
+    "constexpr int down(int N) { return N ? down(N - 1) : 0; }"
+    "constexpr int up(int N) { return N ? up(N - 1) : down(5); }"
+    "constexpr int sum(int N) {"
+    "  int S = 0;"
+    "  for (int I = 0; I < N; ++I)"
+    "    S += I;"
+    "  return S;"
+    "}"
+    "constexpr int twice() { return sum(1000) + sum(1000); }";
+
+TEST(ConstexprEvalCacheTest, HitsYieldTheEvaluatedValue) {
+  CacheStatsAction *Action = new CacheStatsAction;
+  ASSERT_TRUE(tooling::runToolOnCodeWithArgs(
+      std::unique_ptr<FrontendAction>(Action),
+      std::string(Recursion) +
+          "static_assert(sum(1000) == 499500, \"\");"
+          "static_assert(sum(1000) == 499500, \"\");"
+          "static_assert(up(3) == 0 && down(5) == 0, \"\");",
+      {"-std=c++14"}));
+  EXPECT_GE(Action->NumHits, 2u);
+}
+
+// Calls whose results are reused count against -fconstexpr-depth as if they
+// were evaluated again.
+TEST(ConstexprEvalCacheTest, HitsCountAgainstTheDepthLimit) {
+  // up(1) stays within 10 nested calls, while up(6) would exceed them even
+  // with the calls it makes already cached.
+  EXPECT_TRUE(tooling::runToolOnCodeWithArgs(
+      std::make_unique<SyntaxOnlyAction>(),
+      std::string(Recursion) + "static_assert(up(1) == 0, \"\");"
+                               "static_assert(up(1) == 0, \"\");",
+      {"-std=c++14", "-fconstexpr-depth=10"}));
+  EXPECT_FALSE(tooling::runToolOnCodeWithArgs(
+      std::make_unique<SyntaxOnlyAction>(),
+      std::string(Recursion) + "static_assert(up(1) == 0, \"\");"
+                               "static_assert(up(6) == 0, \"\");",
+      {"-std=c++14", "-fconstexpr-depth=10"}));
+}
+
+// Calls whose results are reused count against -fconstexpr-steps as if they
+// were evaluated again.
+TEST(ConstexprEvalCacheTest, HitsCountAgainstTheStepLimit) {
+  // sum(1000) takes a little over 1000 steps.
+  EXPECT_TRUE(tooling::runToolOnCodeWithArgs(
+      std::make_unique<SyntaxOnlyAction>(),
+      std::string(Recursion) + "static_assert(twice() == 999000, \"\");",
+      {"-std=c++14", "-fconstexpr-steps=3000"}));
+  EXPECT_FALSE(tooling::runToolOnCodeWithArgs(
+      std::make_unique<SyntaxOnlyAction>(),
+      std::string(Recursion) + "static_assert(sum(1000) == 499500, \"\");"
+                               "static_assert(twice() == 999000, \"\");",
+      {"-std=c++14", "-fconstexpr-steps=1500"}));
+}
+
+/// A directory of source files for the compilations of a test, removed
+/// after it.
+class ConstexprEvalCacheFilesTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("constexpr-eval-cache",
+                                                      Dir));
+  }
+
+  void TearDown() override { llvm::sys::fs::remove_directories(Dir); }
+
+  /// Write \p Contents to the file \p Name of the directory, and return its
+  /// path.
+  std::string addFile(StringRef Name, StringRef Contents) {
+    SmallString<128> Path(Dir);
+    llvm::sys::path::append(Path, Name);
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(Path, EC);
+    EXPECT_FALSE(EC);
+    OS << Contents;
+    return std::string(Path.str());
+  }
+
+  /// Run \p Action with the -cc1 arguments \p Args.
+  bool runCC1(FrontendAction &Action, ArrayRef<const char *> Args) {
+    auto Invocation = std::make_shared<CompilerInvocation>();
+    IntrusiveRefCntPtr<DiagnosticsEngine> Diags =
+        CompilerInstance::createDiagnostics(new DiagnosticOptions);
+    if (!CompilerInvocation::CreateFromArgs(*Invocation, Args, *Diags))
+      return false;
+    CompilerInstance Compiler;
+    Compiler.setInvocation(std::move(Invocation));
+    Compiler.createDiagnostics();
+    return Compiler.ExecuteAction(Action);
+  }
+
+  /// Build a PCH of the header \p Name with contents \p Contents, and
+  /// return its path.
+  std::string generatePCH(StringRef Name, StringRef Contents) {
+    std::string Header = addFile(Name, Contents);
+    std::string PCH = Header + ".pch";
+    GeneratePCHAction Generate;
+    EXPECT_TRUE(runCC1(Generate, {"-std=c++14", "-x", "c++-header",
+                                  "-emit-pch", "-o", PCH.c_str(),
+                                  Header.c_str()}));
+    return PCH;
+  }
+
+  SmallString<128> Dir;
+};
+
+TEST_F(ConstexprEvalCacheFilesTest, ResultsAreReadFromPCH) {
+  std::string PCH = generatePCH(
+      "header.h", std::string(Recursion) +
+                      "static_assert(sum(1000) == 499500, \"\");"
+                      "static_assert(down(5) == 0, \"\");");
+  std::string Main = addFile("main.cpp", "static_assert(sum(1000) == 499500, "
+                                         "\"\");");
+  std::string Deep = addFile("deep.cpp", "static_assert(up(6) == 0, \"\");");
+
+  // The result is loaded, and reused with the same value.
+  CacheStatsAction Read;
+  ASSERT_TRUE(runCC1(Read, {"-std=c++14", "-include-pch", PCH.c_str(),
+                            "-fsyntax-only", Main.c_str()}));
+  EXPECT_EQ(1u, Read.NumLoaded);
+  EXPECT_EQ(1u, Read.NumHits);
+
+  // The cost of a loaded result still counts against the limits.
+  SyntaxOnlyAction ReadDeep;
+  EXPECT_FALSE(runCC1(ReadDeep, {"-std=c++14", "-include-pch", PCH.c_str(),
+                                 "-fconstexpr-depth=10", "-fsyntax-only",
+                                 Deep.c_str()}));
+}
+
+TEST_F(ConstexprEvalCacheFilesTest, CachedCallsDoNotReadBodies) {
+  std::string PCH = generatePCH(
+      "header.h", std::string(Recursion) +
+                      "static_assert(sum(1000) == 499500, \"\");");
+  std::string Hit = addFile("hit.cpp", "static_assert(sum(1000) == 499500, "
+                                       "\"\");");
+  std::string Miss = addFile("miss.cpp", "static_assert(sum(10) == 45, \"\");");
+
+  CacheStatsAction ReadHit;
+  ASSERT_TRUE(runCC1(ReadHit, {"-std=c++14", "-include-pch", PCH.c_str(),
+                               "-fsyntax-only", Hit.c_str()}));
+  EXPECT_GE(ReadHit.NumHits, 1u);
+  EXPECT_EQ(0u, ReadHit.NumBodiesRead);
+
+  CacheStatsAction ReadMiss;
+  ASSERT_TRUE(runCC1(ReadMiss, {"-std=c++14", "-include-pch", PCH.c_str(),
+                                "-fsyntax-only", Miss.c_str()}));
+  EXPECT_EQ(1u, ReadMiss.NumBodiesRead);
+}
+
+TEST_F(ConstexprEvalCacheFilesTest, ResultsOfOtherDefinitionsAreDropped) {
+  addFile("module.modulemap", "module A { header \"a.h\" }\n"
+                              "module B { header \"b.h\" }\n");
+  addFile("a.h", "constexpr int f(int N) { return N + 1; }"
+                 "static_assert(f(1) == 2, \"\");");
+  addFile("b.h", "constexpr int f(int N) { return N + 2; }"
+                 "static_assert(f(1) == 3, \"\");");
+  std::string Main = addFile("main.cpp", "#include \"a.h\"\n"
+                                         "#include \"b.h\"\n"
+                                         "const int R = f(1);\n");
+  SmallString<128> Cache(Dir);
+  llvm::sys::path::append(Cache, "cache");
+  std::string CachePath = ("-fmodules-cache-path=" + Cache).str();
+  std::string Include = ("-I" + Dir).str();
+
+  // Both modules store a result for f(1), but only the one of the definition
+  // that is kept is loaded. The definitions violate the ODR, which is
+  // diagnosed, so the compilation itself fails.
+  CacheStatsAction Read;
+  runCC1(Read, {"-std=c++14", "-fmodules", "-fimplicit-module-maps",
+                CachePath.c_str(), Include.c_str(), "-fsyntax-only",
+                Main.c_str()});
+  EXPECT_EQ(1u, Read.NumLoaded);
+}
+
+} // anonymous namespace
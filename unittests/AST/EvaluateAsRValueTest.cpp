@@ -15,6 +15,7 @@
 #include "latino/AST/ASTConsumer.h"
 #include "latino/AST/ASTContext.h"
 #include "latino/AST/RecursiveASTVisitor.h"
+#include "latino/Frontend/FrontendActions.h"
 #include "latino/Tooling/Tooling.h"
 #include "gtest/gtest.h"
 #include <map>
@@ -108,3 +109,194 @@ TEST(EvaluateAsRValue, FailsGracefullyForUnknownTypes) {
         Args));
   }
 }
+
+TEST(EvaluateAsRValue, NewInterpreterRunsLoopsAndCalls) {
+  std::vector<std::string> Args = {"-std=c++14",
+                                   "-fexperimental-new-constant-interpreter"};
+  ASSERT_TRUE(runToolOnCodeWithArgs(
+      std::make_unique<latino::SyntaxOnlyAction>(),
+      "constexpr int fib(int N) { return N < 2 ? N : fib(N - 1) + fib(N - 2); }"
+      "constexpr int sum(int N) {"
+      "  int S = 0;"
+      "  for (int I = 0; I < N; ++I)"
+      "    S += I;"
+      "  while (N > 0) {"
+      "    if (N % 2)"
+      "      break;"
+      "    N /= 2;"
+      "  }"
+      "  return S + N;"
+      "}"
+      "constexpr int kind(int N) {"
+      "  switch (N & 3) {"
+      "  case 0: return 10;"
+      "  case 1: return 20;"
+      "  default: return (~N & 7) << 1;"
+      "  }"
+      "}"
+      "static_assert(fib(10) == 55, \"\");"
+      "static_assert(sum(8) == 29, \"\");"
+      "static_assert(kind(4) == 10 && kind(5) == 20, \"\");"
+      "static_assert(kind(2) == 10 && kind(3) == 8, \"\");",
+      Args));
+}
+
+TEST(EvaluateAsRValue, NewInterpreterRunsSuperinstructions) {
+  std::vector<std::string> Args = {"-std=c++14",
+                                   "-fexperimental-new-constant-interpreter"};
+  ASSERT_TRUE(runToolOnCodeWithArgs(
+      std::make_unique<latino::SyntaxOnlyAction>(),
+      "constexpr int addParam(int A) { return A + 3; }"
+      "constexpr int subParam(int A) { return A - 3; }"
+      "constexpr int addLocal(int A) { int L = A; return L + 3; }"
+      "constexpr int subLocal(int A) { int L = A; return L - 3; }"
+      "constexpr int eq(int A, int B) { if (A == B) return 1; return 0; }"
+      "constexpr int ne(int A, int B) { if (A != B) return 1; return 0; }"
+      "constexpr int lt(int A, int B) { if (A < B) return 1; return 0; }"
+      "constexpr int le(int A, int B) { if (A <= B) return 1; return 0; }"
+      "constexpr int gt(int A, int B) { if (A > B) return 1; return 0; }"
+      "constexpr int ge(int A, int B) { if (A >= B) return 1; return 0; }"
+      "static_assert(addParam(4) == 7 && subParam(4) == 1, \"\");"
+      "static_assert(addLocal(-4) == -1 && subLocal(-4) == -7, \"\");"
+      "static_assert(eq(2, 2) == 1 && eq(2, 3) == 0, \"\");"
+      "static_assert(ne(2, 3) == 1 && ne(2, 2) == 0, \"\");"
+      "static_assert(lt(2, 3) == 1 && lt(3, 3) == 0 && lt(4, 3) == 0, \"\");"
+      "static_assert(le(2, 3) == 1 && le(3, 3) == 1 && le(4, 3) == 0, \"\");"
+      "static_assert(gt(4, 3) == 1 && gt(3, 3) == 0 && gt(2, 3) == 0, \"\");"
+      "static_assert(ge(4, 3) == 1 && ge(3, 3) == 1 && ge(2, 3) == 0, \"\");",
+      Args));
+}
+
+TEST(EvaluateAsRValue, NewInterpreterJumpsAroundSuperinstructions) {
+  std::vector<std::string> Args = {"-std=c++14",
+                                   "-fexperimental-new-constant-interpreter"};
+  ASSERT_TRUE(runToolOnCodeWithArgs(
+      std::make_unique<latino::SyntaxOnlyAction>(),
+      // The label joining the branches sits between the read of B and the
+      // addition, which must not be fused.
+      "constexpr int pick(int A, int B) { return (A < B ? A : B) + 1; }"
+      // The loop jumps back to the fused comparison and forward past the
+      // fused additions of the body.
+      "constexpr int count(int N) {"
+      "  int S = 0;"
+      "  for (int I = 0; I != N; I = I + 1)"
+      "    S = S + 2;"
+      "  return S;"
+      "}"
+      // The jump of the fused comparison lands right after a fused addition.
+      "constexpr int bump(int A) {"
+      "  if (A >= 0)"
+      "    A = A + 1;"
+      "  return A;"
+      "}"
+      "static_assert(pick(1, 5) == 2 && pick(5, 1) == 2, \"\");"
+      "static_assert(count(0) == 0 && count(10) == 20, \"\");"
+      "static_assert(bump(1) == 2 && bump(-1) == -1, \"\");",
+      Args));
+}
+
+namespace {
+// For each variable name encountered, the folded value of its initializer,
+// or "failed".
+typedef std::map<std::string, std::string> FoldedValueMap;
+
+/// \brief Records the folded value of the initializers of global variables.
+class RecordFoldedValuesAction : public latino::ASTFrontendAction {
+ public:
+  explicit RecordFoldedValuesAction(FoldedValueMap &Values) : Values(Values) {}
+
+  std::unique_ptr<latino::ASTConsumer>
+  CreateASTConsumer(latino::CompilerInstance &Compiler,
+                    llvm::StringRef FilePath) override {
+    return std::make_unique<Consumer>(Values);
+  }
+
+ private:
+  class Consumer : public latino::ASTConsumer {
+   public:
+    explicit Consumer(FoldedValueMap &Values) : Values(Values) {}
+
+    void HandleTranslationUnit(latino::ASTContext &Ctx) override {
+      for (const latino::Decl *D : Ctx.getTranslationUnitDecl()->decls()) {
+        const auto *VD = llvm::dyn_cast<latino::VarDecl>(D);
+        if (!VD || !VD->getInit())
+          continue;
+        latino::Expr::EvalResult Result;
+        std::string &Value = Values[VD->getNameAsString()];
+        if (!VD->getInit()->EvaluateAsRValue(Result, Ctx)) {
+          Value = "failed";
+          continue;
+        }
+        Value = Result.Val.getAsString(Ctx, VD->getType());
+        if (Result.HasUndefinedBehavior)
+          Value += " (undefined)";
+      }
+    }
+
+   private:
+    FoldedValueMap &Values;
+  };
+
+  FoldedValueMap &Values;
+};
+}
+
+TEST(EvaluateAsRValue, NewInterpreterFailsLikeTheTreeWalker) {
+  const char *Code =
+      "constexpr int div(int A, int B) { return A / B; }"
+      "constexpr int rem(int A, int B) { return A % B; }"
+      "constexpr int shl(int A, int B) { return A << B; }"
+      "constexpr int shr(int A, int B) { return A >> B; }"
+      "const int DivByZero = div(1, 0);"
+      "const int RemByZero = rem(1, 0);"
+      "const int DivOverflow = div(-2147483647 - 1, -1);"
+      "const int RemOverflow = rem(-2147483647 - 1, -1);"
+      "const int ShlWide = shl(1, 40);"
+      "const int ShrWide = shr(-8, 40);"
+      "const int ShlNegative = shl(8, -2);"
+      "const int ShrNegative = shr(8, -2);"
+      "const int ShlOfNegative = shl(-1, 3);";
+  FoldedValueMap TreeWalker, Interpreter;
+  ASSERT_TRUE(runToolOnCodeWithArgs(
+      std::make_unique<RecordFoldedValuesAction>(TreeWalker), Code,
+      {"-std=c++14"}));
+  ASSERT_TRUE(runToolOnCodeWithArgs(
+      std::make_unique<RecordFoldedValuesAction>(Interpreter), Code,
+      {"-std=c++14", "-fexperimental-new-constant-interpreter"}));
+  EXPECT_EQ(9u, TreeWalker.size());
+  EXPECT_EQ("failed", TreeWalker["DivByZero"]);
+  EXPECT_EQ("-2147483648 (undefined)", TreeWalker["DivOverflow"]);
+  EXPECT_EQ("-2147483648", TreeWalker["ShlWide"]);
+  EXPECT_EQ("-1", TreeWalker["ShrWide"]);
+  EXPECT_EQ(TreeWalker, Interpreter);
+}
+
+TEST(EvaluateAsRValue, NewInterpreterRunsLoopHeavyFunctions) {
+  // Large enough for the cost of the evaluators to show when the two runs are
+  // timed, with the same result.
+  const char *Code =
+      "constexpr unsigned collatz(unsigned N) {"
+      "  unsigned Steps = 0;"
+      "  while (N != 1) {"
+      "    N = N % 2 ? 3 * N + 1 : N / 2;"
+      "    ++Steps;"
+      "  }"
+      "  return Steps;"
+      "}"
+      "constexpr unsigned total(unsigned Limit) {"
+      "  unsigned S = 0;"
+      "  for (unsigned I = 1; I < Limit; ++I)"
+      "    S += collatz(I);"
+      "  return S;"
+      "}"
+      "static_assert(total(3000) == 215015, \"\");";
+  for (bool NewInterpreter : {false, true}) {
+    std::vector<std::string> Args = {"-std=c++14",
+                                     "-fconstexpr-steps=100000000"};
+    if (NewInterpreter)
+      Args.push_back("-fexperimental-new-constant-interpreter");
+    EXPECT_TRUE(runToolOnCodeWithArgs(
+        std::make_unique<latino::SyntaxOnlyAction>(), Code, Args))
+        << NewInterpreter;
+  }
+}
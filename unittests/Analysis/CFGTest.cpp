@@ -9,6 +9,7 @@
 #include "CFGBuildResult.h"
 #include "latino/AST/Decl.h"
 #include "latino/ASTMatchers/ASTMatchFinder.h"
+#include "latino/Analysis/Analyses/LiveVariables.h"
 #include "latino/Analysis/AnalysisDeclContext.h"
 #include "latino/Analysis/CFG.h"
 #include "latino/Analysis/FlowSensitive/DataflowWorklist.h"
@@ -268,6 +269,108 @@ TEST(CFG, Worklists) {
   }
 }
 
+TEST(CFG, ManagerCachesCFGs) {
+  const char *Code = "int f(bool cond) {\n"
+                     "  return cond ? 1 : 2;\n"
+                     "}\n";
+  BuildResult B = BuildCFG(Code);
+  EXPECT_EQ(BuildResult::BuiltCFG, B.getStatus());
+  const FunctionDecl *Func = B.getFunc();
+  AnalysisDeclContextManager Mgr(Func->getASTContext());
+  Mgr.setCacheCFGs(true);
+
+  const CFG *Cached = Mgr.getContext(Func)->getCFG();
+  ASSERT_NE(nullptr, Cached);
+  Mgr.clear();
+  EXPECT_EQ(Cached, Mgr.getContext(Func)->getCFG());
+
+  // A context built with other options builds a CFG of its own, which
+  // replaces the cached one.
+  Mgr.clear();
+  Mgr.getCFGBuildOptions().AddLifetime = true;
+  Cached = Mgr.getContext(Func)->getCFG();
+  EXPECT_NE(nullptr, Cached);
+
+  // Contexts that force expressions into blocks do not use the cached CFG
+  // either, nor replace it.
+  Mgr.clear();
+  AnalysisDeclContext *AC = Mgr.getContext(Func);
+  AC->registerForcedBlockExpression(Func->getBody());
+  EXPECT_NE(Cached, AC->getCFG());
+  Mgr.clear();
+  EXPECT_EQ(Cached, Mgr.getContext(Func)->getCFG());
+}
+
+TEST(CFG, ManagerDropsLeastRecentlyUsedCFGs) {
+  const char *Code = "int f(int x) { return x; }\n"
+                     "int g(int x) { return -x; }\n"
+                     "int h(int x) { return x + 1; }\n";
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCode(Code);
+  ASTContext &Ctx = AST->getASTContext();
+  auto getFunc = [&](StringRef Name) {
+    return cast<FunctionDecl>(
+        Ctx.getTranslationUnitDecl()->lookup(&Ctx.Idents.get(Name)).front());
+  };
+  const FunctionDecl *F = getFunc("f"), *G = getFunc("g"), *H = getFunc("h");
+  AnalysisDeclContextManager Mgr(Ctx);
+  Mgr.setCacheCFGs(true, /*MaxCFGs=*/2);
+
+  // A context of its own keeps the first CFG of g alive, so that a CFG built
+  // for g later cannot take its address.
+  AnalysisDeclContext KeepG(&Mgr, G);
+  const CFG *CachedG = KeepG.getCFG();
+  const CFG *CachedF = Mgr.getContext(F)->getCFG();
+  ASSERT_NE(nullptr, CachedG);
+  ASSERT_NE(nullptr, CachedF);
+
+  // Building the CFG of h drops the least recently used one, of g.
+  Mgr.getContext(H)->getCFG();
+  Mgr.clear();
+  EXPECT_EQ(CachedF, Mgr.getContext(F)->getCFG());
+  EXPECT_NE(CachedG, Mgr.getContext(G)->getCFG());
+}
+
+TEST(CFG, LiveVariablesAtBlockExits) {
+  const char *Code = "int f(int n) {\n"
+                     "  int sum = 0;\n"
+                     "  int unused = 1;\n"
+                     "  for (int i = 0; i < n; ++i)\n"
+                     "    sum += i;\n"
+                     "  return sum;\n"
+                     "}\n";
+  BuildResult B = BuildCFG(Code);
+  EXPECT_EQ(BuildResult::BuiltCFG, B.getStatus());
+  const FunctionDecl *Func = B.getFunc();
+  ASTContext &Ctx = B.getAST()->getASTContext();
+  auto getVar = [&](StringRef Name) {
+    using namespace ast_matchers;
+    return selectFirst<VarDecl>("v", match(varDecl(hasName(Name)).bind("v"),
+                                           Ctx));
+  };
+  const VarDecl *Sum = getVar("sum");
+  const VarDecl *Unused = getVar("unused");
+  const VarDecl *I = getVar("i");
+  ASSERT_TRUE(Sum && Unused && I);
+
+  AnalysisDeclContext AC(nullptr, Func);
+  LiveVariables *LV = AC.getAnalysis<LiveVariables>();
+  ASSERT_NE(nullptr, LV);
+
+  // The loop body is the only block that updates 'sum'.
+  const CFGBlock *Body = nullptr;
+  for (const CFGBlock *Block : *AC.getCFG())
+    for (const CFGElement &Elem : *Block)
+      if (Optional<CFGStmt> S = Elem.getAs<CFGStmt>())
+        if (isa<CompoundAssignOperator>(S->getStmt()))
+          Body = Block;
+  ASSERT_NE(nullptr, Body);
+
+  EXPECT_TRUE(LV->isLive(Body, Sum));
+  EXPECT_TRUE(LV->isLive(Body, I));
+  for (const CFGBlock *Block : *AC.getCFG())
+    EXPECT_FALSE(LV->isLive(Block, Unused));
+}
+
 } // namespace
 } // namespace analysis
 } // namespace latino
@@ -0,0 +1,71 @@
+//===- unittests/Basic/ArenaPoolTest.cpp -- ArenaPool tests ---------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/Basic/ArenaPool.h"
+#include "gtest/gtest.h"
+
+using namespace latino;
+
+namespace {
+
+TEST(ArenaPoolTest, ReusesSlabsOfDestroyedAllocators) {
+  IntrusiveRefCntPtr<ArenaPool> Pool(new ArenaPool());
+
+  {
+    ArenaAllocator Alloc(Pool.get());
+    for (unsigned I = 0; I != 100; ++I)
+      Alloc.Allocate(1000, 8);
+    EXPECT_EQ(Alloc.getTotalMemory(), Pool->getBytesInUse());
+  }
+  uint64_t Allocated = Pool->getNumSlabsAllocated();
+  size_t Peak = Pool->getPeakBytesInUse();
+  EXPECT_EQ(0u, Pool->getBytesInUse());
+  EXPECT_EQ(Peak, Pool->getPooledBytes());
+  EXPECT_EQ(0u, Pool->getNumSlabsReused());
+
+  // A second allocator with the same usage takes all of its slabs from the
+  // pool.
+  {
+    ArenaAllocator Alloc(Pool.get());
+    for (unsigned I = 0; I != 100; ++I)
+      Alloc.Allocate(1000, 8);
+  }
+  EXPECT_EQ(Allocated, Pool->getNumSlabsAllocated());
+  EXPECT_EQ(Allocated, Pool->getNumSlabsReused());
+  EXPECT_EQ(Peak, Pool->getPeakBytesInUse());
+
+  Pool->trim();
+  EXPECT_EQ(0u, Pool->getPooledBytes());
+}
+
+TEST(ArenaPoolTest, OversizedAllocationsAreNotPooled) {
+  IntrusiveRefCntPtr<ArenaPool> Pool(new ArenaPool());
+  {
+    ArenaAllocator Alloc(Pool.get());
+    Alloc.Allocate(100000, 8);
+  }
+  EXPECT_EQ(0u, Pool->getPooledBytes());
+}
+
+TEST(ArenaPoolTest, PooledBytesAreBounded) {
+  IntrusiveRefCntPtr<ArenaPool> Pool(new ArenaPool(/*MaxPooledBytes=*/8192));
+  {
+    ArenaAllocator Alloc(Pool.get());
+    for (unsigned I = 0; I != 10; ++I)
+      Alloc.Allocate(4000, 8);
+  }
+  EXPECT_EQ(8192u, Pool->getPooledBytes());
+}
+
+TEST(ArenaPoolTest, WorksWithoutPool) {
+  ArenaAllocator Alloc;
+  EXPECT_NE(nullptr, Alloc.Allocate(1000, 8));
+  EXPECT_NE(nullptr, Alloc.Allocate(100000, 8));
+}
+
+} // anonymous namespace
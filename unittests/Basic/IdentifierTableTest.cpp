@@ -0,0 +1,56 @@
+//===- unittests/Basic/IdentifierTableTest.cpp -- IdentifierTable tests ---===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/Basic/IdentifierTable.h"
+#include "latino/Basic/LangOptions.h"
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+using namespace latino;
+
+namespace {
+
+TEST(IdentifierTableTest, KeywordLookup) {
+  LangOptions LangOpts;
+  IdentifierTable Table(LangOpts);
+
+  EXPECT_EQ(tok::kw_mientras, Table.get("mientras").getTokenID());
+  EXPECT_EQ(tok::kw_estructura, Table.get("estructura").getTokenID());
+  EXPECT_EQ(tok::kw_romper, Table.get("romper").getTokenID());
+  EXPECT_EQ(tok::identifier, Table.get("mientra").getTokenID());
+  EXPECT_EQ(tok::identifier, Table.get("mientrasx").getTokenID());
+  EXPECT_EQ(tok::identifier, Table.get("en_linea_").getTokenID());
+
+  // Every lookup, through the keyword hash or not, finds the entry that
+  // lives in the string map.
+  for (const auto &Entry : Table)
+    EXPECT_EQ(Entry.second, &Table.get(Entry.getKey()));
+}
+
+TEST(IdentifierTableTest, ReserveKeepsIdentifiers) {
+  LangOptions LangOpts;
+  IdentifierTable Table(LangOpts);
+
+  IdentifierInfo *Keyword = &Table.get("desde");
+  std::vector<IdentifierInfo *> Infos;
+  for (unsigned I = 0; I != 100; ++I)
+    Infos.push_back(&Table.get("variable_" + std::to_string(I)));
+
+  Table.reserve(100000);
+
+  EXPECT_EQ(Keyword, &Table.get("desde"));
+  EXPECT_EQ(tok::kw_desde, Keyword->getTokenID());
+  for (unsigned I = 0; I != 100; ++I) {
+    std::string Name = "variable_" + std::to_string(I);
+    EXPECT_EQ(Infos[I], &Table.get(Name));
+    EXPECT_EQ(Name, Infos[I]->getName());
+  }
+}
+
+} // end anonymous namespace
@@ -0,0 +1,82 @@
+//===- unittests/Basic/TimeTraceCountersTest.cpp - Counter tests ----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/Basic/TimeTraceCounters.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace latino;
+using namespace llvm;
+
+namespace {
+
+/// Runs \p Record under the profiler and returns the counter events of the
+/// written trace.
+template <typename Fn>
+std::vector<json::Object> recordCounters(unsigned Granularity, Fn Record) {
+  timeTraceProfilerInitialize(Granularity, "test");
+  timeTraceCountersInitialize(Granularity);
+  {
+    TimeTraceScope Scope("Test");
+    Record();
+  }
+
+  SmallString<1024> Buffer;
+  raw_svector_ostream OS(Buffer);
+  timeTraceCountersWrite(OS);
+  timeTraceCountersCleanup();
+  timeTraceProfilerCleanup();
+
+  std::vector<json::Object> Events;
+  Expected<json::Value> Trace = json::parse(Buffer);
+  EXPECT_TRUE(bool(Trace));
+  if (!Trace) {
+    consumeError(Trace.takeError());
+    return Events;
+  }
+  for (json::Value &Event : *Trace->getAsObject()->getArray("traceEvents"))
+    if (Event.getAsObject()->getString("ph") == StringRef("C"))
+      Events.push_back(std::move(*Event.getAsObject()));
+  return Events;
+}
+
+TEST(TimeTraceCountersTest, CountersAreWrittenAsCounterEvents) {
+  auto Events = recordCounters(0, [] {
+    timeTraceCounter("AST Memory", {{"Allocator", 4096}, {"Side Tables", 8}});
+  });
+
+  ASSERT_EQ(1u, Events.size());
+  EXPECT_EQ(StringRef("AST Memory"),
+            Events[0].getString("name").getValueOr(""));
+  const json::Object *Args = Events[0].getObject("args");
+  ASSERT_NE(nullptr, Args);
+  EXPECT_EQ(4096, Args->getInteger("Allocator").getValueOr(0));
+  EXPECT_EQ(8, Args->getInteger("Side Tables").getValueOr(0));
+}
+
+TEST(TimeTraceCountersTest, CloseSamplesAreMerged) {
+  auto Events = recordCounters(1000000, [] {
+    for (uint64_t I = 1; I <= 100; ++I)
+      timeTraceCounter("Nodes", {{"Nodes", I}});
+  });
+
+  // The first sample is kept and the last one holds the latest value.
+  ASSERT_EQ(2u, Events.size());
+  EXPECT_EQ(1, Events[0].getObject("args")->getInteger("Nodes").getValueOr(0));
+  EXPECT_EQ(100,
+            Events[1].getObject("args")->getInteger("Nodes").getValueOr(0));
+}
+
+TEST(TimeTraceCountersTest, NothingIsRecordedWhenDisabled) {
+  EXPECT_FALSE(timeTraceCountersEnabled());
+  timeTraceCounter("Nodes", {{"Nodes", 1}});
+}
+
+} // anonymous namespace
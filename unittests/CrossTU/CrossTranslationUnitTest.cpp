@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "latino/CrossTU/CrossTranslationUnit.h"
+#include "latino/CrossTU/CrossTUIndex.h"
 #include "latino/AST/ASTConsumer.h"
 #include "latino/AST/ParentMapContext.h"
 #include "latino/Frontend/CompilerInstance.h"
@@ -26,8 +27,10 @@ namespace {
 
 class CTUASTConsumer : public latino::ASTConsumer {
 public:
-  explicit CTUASTConsumer(latino::CompilerInstance &CI, bool *Success)
-      : CTU(CI), Success(Success) {}
+  explicit CTUASTConsumer(latino::CompilerInstance &CI, bool *Success,
+                          bool Prefetch, bool BinaryIndex)
+      : CTU(CI), Success(Success), Prefetch(Prefetch),
+        BinaryIndex(BinaryIndex) {}
 
   void HandleTranslationUnit(ASTContext &Ctx) {
     auto FindFInTU = [](const TranslationUnitDecl *TU) {
@@ -61,7 +64,13 @@ public:
     ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("index", "txt", IndexFD,
                                                     IndexFileName));
     llvm::ToolOutputFile IndexFile(IndexFileName, IndexFD);
-    IndexFile.os() << "c:@F@f#I# " << ASTFileName << "\n";
+    if (BinaryIndex) {
+      llvm::StringMap<std::string> Index;
+      Index["c:@F@f#I#"] = std::string(ASTFileName.str());
+      writeBinaryCrossTUIndex(Index, IndexFile.os());
+    } else {
+      IndexFile.os() << "c:@F@f#I# " << ASTFileName << "\n";
+    }
     IndexFile.os().flush();
     EXPECT_TRUE(llvm::sys::fs::exists(IndexFileName));
 
@@ -81,11 +90,20 @@ public:
     ASTWithDefinition->Save(ASTFileName.str());
     EXPECT_TRUE(llvm::sys::fs::exists(ASTFileName));
 
+    if (Prefetch)
+      CTU.prefetchExternalASTs({"c:@F@f#I#"}, "", IndexFileName);
+
     // Load the definition from the AST file.
     llvm::Expected<const FunctionDecl *> NewFDorError = handleExpected(
         CTU.getCrossTUDefinition(FD, "", IndexFileName, false),
         []() { return nullptr; }, [](IndexError &) {});
 
+    // A prefetched unit is used rather than loaded again.
+    if (Prefetch && NewFDorError && *NewFDorError)
+      EXPECT_EQ(1u, CTU.getNumPrefetchedASTsUsed());
+    else
+      EXPECT_EQ(0u, CTU.getNumPrefetchedASTsUsed());
+
     if (NewFDorError) {
       const FunctionDecl *NewFD = *NewFDorError;
       *Success = NewFD && NewFD->hasBody() && !OrigFDHasBody;
@@ -136,24 +154,33 @@ public:
 private:
   CrossTranslationUnitContext CTU;
   bool *Success;
+  bool Prefetch;
+  bool BinaryIndex;
 };
 
 class CTUAction : public latino::ASTFrontendAction {
 public:
-  CTUAction(bool *Success, unsigned OverrideLimit)
-      : Success(Success), OverrideLimit(OverrideLimit) {}
+  CTUAction(bool *Success, unsigned OverrideLimit, bool Prefetch = false,
+            bool BinaryIndex = false)
+      : Success(Success), OverrideLimit(OverrideLimit), Prefetch(Prefetch),
+        BinaryIndex(BinaryIndex) {}
 
 protected:
   std::unique_ptr<latino::ASTConsumer>
   CreateASTConsumer(latino::CompilerInstance &CI, StringRef) override {
     CI.getAnalyzerOpts()->CTUImportThreshold = OverrideLimit;
     CI.getAnalyzerOpts()->CTUImportCppThreshold = OverrideLimit;
-    return std::make_unique<CTUASTConsumer>(CI, Success);
+    if (Prefetch)
+      CI.getAnalyzerOpts()->CTUPrefetchThreads = 2;
+    return std::make_unique<CTUASTConsumer>(CI, Success, Prefetch,
+                                            BinaryIndex);
   }
 
 private:
   bool *Success;
   const unsigned OverrideLimit;
+  const bool Prefetch;
+  const bool BinaryIndex;
 };
 
 } // end namespace
@@ -172,6 +199,31 @@ TEST(CrossTranslationUnit, RespectsLoadThreshold) {
   EXPECT_FALSE(Success);
 }
 
+TEST(CrossTranslationUnit, CanLoadPrefetchedFunctionDefinition) {
+  bool Success = false;
+  EXPECT_TRUE(tooling::runToolOnCode(
+      std::make_unique<CTUAction>(&Success, 1u, /*Prefetch=*/true),
+      "int f(int);"));
+  EXPECT_TRUE(Success);
+}
+
+TEST(CrossTranslationUnit, PrefetchRespectsLoadThreshold) {
+  bool Success = false;
+  EXPECT_TRUE(tooling::runToolOnCode(
+      std::make_unique<CTUAction>(&Success, 0u, /*Prefetch=*/true),
+      "int f(int);"));
+  EXPECT_FALSE(Success);
+}
+
+TEST(CrossTranslationUnit, CanLoadFunctionDefinitionWithBinaryIndex) {
+  bool Success = false;
+  EXPECT_TRUE(tooling::runToolOnCode(
+      std::make_unique<CTUAction>(&Success, 1u, /*Prefetch=*/false,
+                                  /*BinaryIndex=*/true),
+      "int f(int);"));
+  EXPECT_TRUE(Success);
+}
+
 TEST(CrossTranslationUnit, IndexFormatCanBeParsed) {
   llvm::StringMap<std::string> Index;
   Index["a"] = "/b/f1";
@@ -199,6 +251,47 @@ TEST(CrossTranslationUnit, IndexFormatCanBeParsed) {
     EXPECT_TRUE(Index.count(E.getKey()));
 }
 
+TEST(CrossTranslationUnit, BinaryIndexCanBeQueried) {
+  llvm::StringMap<std::string> Index;
+  for (unsigned I = 0; I != 1000; ++I)
+    Index["c:@F@f" + std::to_string(I)] = "/d/f" + std::to_string(I % 7);
+
+  int IndexFD;
+  llvm::SmallString<256> IndexFileName;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("index", "bin", IndexFD,
+                                                  IndexFileName));
+  llvm::ToolOutputFile IndexFile(IndexFileName, IndexFD);
+  writeBinaryCrossTUIndex(Index, IndexFile.os());
+  IndexFile.os().flush();
+  EXPECT_TRUE(BinaryCrossTUIndex::isBinaryIndex(IndexFileName));
+
+  llvm::Expected<std::unique_ptr<BinaryCrossTUIndex>> BinaryIndex =
+      BinaryCrossTUIndex::create(IndexFileName);
+  ASSERT_TRUE((bool)BinaryIndex);
+  EXPECT_EQ(Index.size(), (*BinaryIndex)->size());
+  for (const auto &E : Index) {
+    llvm::Optional<StringRef> File = (*BinaryIndex)->lookup(E.getKey());
+    ASSERT_TRUE(File.hasValue());
+    EXPECT_EQ(E.getValue(), *File);
+  }
+  EXPECT_FALSE((*BinaryIndex)->lookup("c:@F@g").hasValue());
+}
+
+TEST(CrossTranslationUnit, TextIndexIsNotBinary) {
+  int IndexFD;
+  llvm::SmallString<256> IndexFileName;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("index", "txt", IndexFD,
+                                                  IndexFileName));
+  llvm::ToolOutputFile IndexFile(IndexFileName, IndexFD);
+  IndexFile.os() << "c:@F@f#I# /b/f1.ast\n";
+  IndexFile.os().flush();
+  EXPECT_FALSE(BinaryCrossTUIndex::isBinaryIndex(IndexFileName));
+  llvm::Expected<std::unique_ptr<BinaryCrossTUIndex>> BinaryIndex =
+      BinaryCrossTUIndex::create(IndexFileName);
+  EXPECT_FALSE((bool)BinaryIndex);
+  llvm::consumeError(BinaryIndex.takeError());
+}
+
 TEST(CrossTranslationUnit, EmptyInvocationListIsNotValid) {
   auto Input = "";
 
@@ -0,0 +1,182 @@
+//===- unittests/Driver/CC1MainTest.cpp --- in-process cc1 tests ----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Unit tests for running several invocations of the cc1_main of
+// tools/driver/cc1_main.cpp in one process, as the driver does with in-process
+// jobs and the compile server of tools/driver/cc1server_main.cpp does with the
+// invocations of its clients.
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/Basic/ArenaPool.h"
+#include "latino/Basic/FileManager.h"
+#include "latino/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if LLVM_ON_UNIX
+#include <stdlib.h>
+#endif
+
+using namespace latino;
+
+extern int cc1_main(ArrayRef<const char *> Argv, const char *Argv0,
+                    void *MainAddr, raw_ostream *DiagOS, FileManager *Files,
+                    ArenaPool *Arenas);
+extern int cc1server_main(ArrayRef<const char *> Argv, const char *Argv0,
+                          void *MainAddr);
+extern bool cc1server_forward(ArrayRef<const char *> Argv, raw_ostream &DiagOS,
+                              int &Result);
+
+namespace {
+
+class CC1MainTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    int FD;
+    ASSERT_FALSE(
+        llvm::sys::fs::createTemporaryFile("cc1-main", "c", FD, Input));
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << "int f(int X) { return X + 1; }\n";
+  }
+
+  void TearDown() override { llvm::sys::fs::remove(Input); }
+
+  /// Check the syntax of the input in-process with the extra arguments
+  /// \p Args, and return the exit code. The diagnostics go to \p Diags.
+  int checkSyntax(ArrayRef<const char *> Args, std::string &Diags) {
+    std::vector<const char *> Argv = {"-cc1", "-fsyntax-only"};
+    Argv.insert(Argv.end(), Args.begin(), Args.end());
+    Argv.push_back(Input.c_str());
+    llvm::raw_string_ostream DiagOS(Diags);
+    return cc1_main(Argv, "latino", nullptr, &DiagOS, /*Files=*/nullptr,
+                    /*Arenas=*/nullptr);
+  }
+
+  SmallString<128> Input;
+};
+
+TEST_F(CC1MainTest, BackToBackInvocations) {
+  for (unsigned I = 0; I != 2; ++I) {
+    std::string Diags;
+    EXPECT_EQ(0, checkSyntax({}, Diags)) << Diags;
+    EXPECT_EQ("", Diags);
+  }
+}
+
+TEST_F(CC1MainTest, BackToBackInvocationsParsingLLVMOptions) {
+  // Each invocation parses the process-wide options again, which fails unless
+  // their occurrences are reset in between.
+  for (unsigned I = 0; I != 2; ++I) {
+    std::string Diags;
+    EXPECT_EQ(0, checkSyntax({"-mllvm", "-print-after-all"}, Diags)) << Diags;
+    EXPECT_EQ("", Diags);
+  }
+}
+
+TEST_F(CC1MainTest, ConcurrentInvocations) {
+  std::string Diags[4];
+  int Results[4];
+  std::vector<std::thread> Threads;
+  for (unsigned I = 0; I != 4; ++I)
+    Threads.emplace_back([&, I] {
+      // Half of the invocations parse the options, and need them to
+      // themselves.
+      if (I % 2)
+        Results[I] = checkSyntax({"-mllvm", "-print-after-all"}, Diags[I]);
+      else
+        Results[I] = checkSyntax({}, Diags[I]);
+    });
+  for (std::thread &T : Threads)
+    T.join();
+  for (unsigned I = 0; I != 4; ++I)
+    EXPECT_EQ(0, Results[I]) << Diags[I];
+}
+
+#if LLVM_ON_UNIX
+
+class CompileServerCC1Test : public CC1MainTest {
+protected:
+  static void SetUpTestCase() {
+    ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("cc1server", TempDir));
+    SocketPath = TempDir;
+    llvm::sys::path::append(SocketPath, "sock");
+    ::setenv("LATINO_COMPILE_SERVER", SocketPath.c_str(), 1);
+
+    // The server never returns; it goes away with the test process.
+    std::thread([] {
+      const char *Argv[] = {SocketPath.c_str(), "-j", "2"};
+      cc1server_main(Argv, "latino", nullptr);
+    }).detach();
+    for (unsigned I = 0; I != 1000 && !llvm::sys::fs::exists(SocketPath); ++I)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_TRUE(llvm::sys::fs::exists(SocketPath));
+  }
+
+  static void TearDownTestCase() {
+    ::unsetenv("LATINO_COMPILE_SERVER");
+    llvm::sys::fs::remove_directories(TempDir);
+  }
+
+  /// Check the syntax of the input on the server with the extra arguments
+  /// \p Args, and return the exit code, or -1 if it was not forwarded.
+  int checkSyntaxOnServer(ArrayRef<const char *> Args, std::string &Diags) {
+    SmallString<128> Output(TempDir);
+    llvm::sys::path::append(Output, "out");
+    std::vector<const char *> Argv = {"-cc1", "-fsyntax-only", "-o",
+                                      Output.c_str()};
+    Argv.insert(Argv.end(), Args.begin(), Args.end());
+    Argv.push_back(Input.c_str());
+    llvm::raw_string_ostream DiagOS(Diags);
+    int Result;
+    if (!cc1server_forward(Argv, DiagOS, Result))
+      return -1;
+    return Result;
+  }
+
+  static SmallString<128> TempDir, SocketPath;
+};
+
+SmallString<128> CompileServerCC1Test::TempDir;
+SmallString<128> CompileServerCC1Test::SocketPath;
+
+TEST_F(CompileServerCC1Test, BackToBackInvocations) {
+  // The server would exit if the second invocation failed to parse the
+  // options, and the third one would not be forwarded.
+  for (unsigned I = 0; I != 3; ++I) {
+    std::string Diags;
+    EXPECT_EQ(0, checkSyntaxOnServer({}, Diags)) << Diags;
+    EXPECT_EQ("", Diags);
+  }
+}
+
+TEST_F(CompileServerCC1Test, ConcurrentInvocations) {
+  std::string Diags[4];
+  int Results[4];
+  std::vector<std::thread> Threads;
+  for (unsigned I = 0; I != 4; ++I)
+    Threads.emplace_back(
+        [&, I] { Results[I] = checkSyntaxOnServer({}, Diags[I]); });
+  for (std::thread &T : Threads)
+    T.join();
+  for (unsigned I = 0; I != 4; ++I)
+    EXPECT_EQ(0, Results[I]) << Diags[I];
+}
+
+#endif // LLVM_ON_UNIX
+
+} // namespace
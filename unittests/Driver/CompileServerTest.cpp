@@ -0,0 +1,191 @@
+//===- unittests/Driver/CompileServerTest.cpp --- -cc1server tests --------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Unit tests for the compile server of tools/driver/cc1server_main.cpp. The
+// server runs in a thread of the test, with a cc1_main that only reports what
+// it was given.
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/Basic/ArenaPool.h"
+#include "latino/Basic/FileManager.h"
+#include "latino/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if LLVM_ON_UNIX
+#include <stdlib.h>
+#include <sys/stat.h>
+#endif
+
+using namespace latino;
+
+extern int cc1server_main(ArrayRef<const char *> Argv, const char *Argv0,
+                          void *MainAddr);
+extern bool cc1server_forward(ArrayRef<const char *> Argv, raw_ostream &DiagOS,
+                              int &Result);
+
+static std::mutex ReceivedMutex;
+static std::vector<std::string> ReceivedArgs;
+
+/// Stands in for the compiler on the server. "-probe <path>" fails unless the
+/// server's file manager finds the file; anything else prints a diagnostic
+/// and returns 3.
+int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr,
+             raw_ostream *DiagOS, FileManager *Files, ArenaPool *Arenas) {
+  {
+    std::lock_guard<std::mutex> Guard(ReceivedMutex);
+    ReceivedArgs.assign(Argv.begin(), Argv.end());
+  }
+  for (size_t I = 0, E = Argv.size(); I + 1 < E; ++I)
+    if (StringRef(Argv[I]) == "-probe")
+      return Files->getFile(Argv[I + 1]) ? 0 : 1;
+  *DiagOS << "diagnostic from the server\n";
+  return 3;
+}
+
+#if LLVM_ON_UNIX
+
+namespace {
+
+class CompileServerTest : public ::testing::Test {
+protected:
+  static void SetUpTestCase() {
+    ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("cc1server", TempDir));
+    SocketPath = TempDir;
+    llvm::sys::path::append(SocketPath, "sock");
+    ::setenv("LATINO_COMPILE_SERVER", SocketPath.c_str(), 1);
+
+    // The server never returns; it goes away with the test process.
+    std::thread([] {
+      const char *Argv[] = {SocketPath.c_str(), "-j", "1"};
+      cc1server_main(Argv, "latino", nullptr);
+    }).detach();
+    for (unsigned I = 0; I != 1000 && !llvm::sys::fs::exists(SocketPath); ++I)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_TRUE(llvm::sys::fs::exists(SocketPath));
+  }
+
+  static void TearDownTestCase() {
+    ::unsetenv("LATINO_COMPILE_SERVER");
+    llvm::sys::fs::remove_directories(TempDir);
+  }
+
+  /// Run \p Argv on the server, and return its exit code, or -1 if it was
+  /// not forwarded.
+  int forward(ArrayRef<const char *> Argv) {
+    llvm::raw_string_ostream DiagOS(Diags);
+    int Result;
+    if (!cc1server_forward(Argv, DiagOS, Result))
+      return -1;
+    return Result;
+  }
+
+  /// The argument after \p Option in the last invocation run by the server.
+  std::string receivedValue(StringRef Option) {
+    std::lock_guard<std::mutex> Guard(ReceivedMutex);
+    for (size_t I = 0, E = ReceivedArgs.size(); I + 1 < E; ++I)
+      if (ReceivedArgs[I] == Option)
+        return ReceivedArgs[I + 1];
+    return std::string();
+  }
+
+  static SmallString<128> TempDir, SocketPath;
+  std::string Diags;
+};
+
+SmallString<128> CompileServerTest::TempDir;
+SmallString<128> CompileServerTest::SocketPath;
+
+TEST_F(CompileServerTest, ReturnsTheResultAndDiagnostics) {
+  EXPECT_EQ(3, forward({"-cc1", "-o", "out.o", "in.c"}));
+  EXPECT_EQ("diagnostic from the server\n", Diags);
+
+  SmallString<128> WorkingDir;
+  ASSERT_FALSE(llvm::sys::fs::current_path(WorkingDir));
+  EXPECT_EQ(WorkingDir.str(), receivedValue("-working-directory"));
+}
+
+TEST_F(CompileServerTest, OutputPathsAreMadeAbsolute) {
+  ASSERT_EQ(3, forward({"-cc1", "-o", "out.o", "-dependency-file", "out.d",
+                        "-split-dwarf-output", "out.dwo",
+                        "-serialize-diagnostic-file", "out.dia",
+                        "-stats-file=out.json", "in.c"}));
+  SmallString<128> Expected;
+  ASSERT_FALSE(llvm::sys::fs::current_path(Expected));
+  llvm::sys::path::append(Expected, "out.o");
+  EXPECT_EQ(Expected.str(), receivedValue("-o"));
+  for (StringRef Option :
+       {"-dependency-file", "-split-dwarf-output",
+        "-serialize-diagnostic-file"})
+    EXPECT_TRUE(llvm::sys::path::is_absolute(receivedValue(Option)))
+        << Option.str();
+
+  std::lock_guard<std::mutex> Guard(ReceivedMutex);
+  bool FoundStats = false;
+  for (const std::string &Arg : ReceivedArgs)
+    if (StringRef(Arg).startswith("-stats-file=")) {
+      FoundStats = true;
+      EXPECT_TRUE(llvm::sys::path::is_absolute(
+          StringRef(Arg).drop_front(strlen("-stats-file="))));
+    }
+  EXPECT_TRUE(FoundStats);
+}
+
+TEST_F(CompileServerTest, StandardOutputIsNotForwarded) {
+  EXPECT_EQ(-1, forward({"-cc1", "-o", "-", "in.c"}));
+  EXPECT_EQ(-1, forward({"-cc1", "-o", "out.o", "-dependency-file", "-",
+                         "in.c"}));
+  EXPECT_EQ(-1, forward({"-cc1", "-o", "out.o", "-stats-file=-", "in.c"}));
+  EXPECT_EQ(-1, forward({"-cc1", "in.c"}));
+}
+
+TEST_F(CompileServerTest, SocketIsPrivate) {
+  struct stat Status;
+  ASSERT_EQ(0, ::stat(SocketPath.c_str(), &Status));
+  EXPECT_EQ(0u, Status.st_mode & (S_IRWXG | S_IRWXO));
+}
+
+TEST_F(CompileServerTest, FilesCreatedAfterAFailedLookupAreFound) {
+  SmallString<128> Dir(TempDir), Header;
+  llvm::sys::path::append(Dir, "include");
+  Header = Dir;
+  llvm::sys::path::append(Header, "header.h");
+
+  // Run twice, so that the failed lookup is in a cache that is kept.
+  const char *Argv[] = {"-cc1", "-o", "out.o", "-probe", Header.c_str()};
+  ASSERT_EQ(1, forward(Argv));
+  ASSERT_EQ(1, forward(Argv));
+
+  ASSERT_FALSE(llvm::sys::fs::create_directory(Dir));
+  std::error_code EC;
+  { llvm::raw_fd_ostream OS(Header, EC); }
+  ASSERT_FALSE(EC);
+
+  // The server notices the change asynchronously.
+  int Result = 1;
+  for (unsigned I = 0; I != 500 && Result == 1; ++I) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    Result = forward(Argv);
+  }
+  EXPECT_EQ(0, Result);
+}
+
+} // namespace
+
+#endif // LLVM_ON_UNIX
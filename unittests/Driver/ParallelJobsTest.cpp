@@ -0,0 +1,136 @@
+//===- unittests/Driver/ParallelJobsTest.cpp --- -j scheduling tests ------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Unit tests for the ordering of the jobs run in parallel with -j.
+//
+//===----------------------------------------------------------------------===//
+
+#include "latino/Basic/Diagnostic.h"
+#include "latino/Basic/DiagnosticIDs.h"
+#include "latino/Basic/DiagnosticOptions.h"
+#include "latino/Basic/LLVM.h"
+#include "latino/Driver/Action.h"
+#include "latino/Driver/Compilation.h"
+#include "latino/Driver/Driver.h"
+#include "latino/Driver/Job.h"
+#include "latino/Driver/Tool.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "gtest/gtest.h"
+using namespace latino;
+using namespace latino::driver;
+
+#ifdef LLVM_ON_UNIX
+
+namespace {
+
+/// A tool whose commands are shell scripts built by the test.
+class ShellTool : public Tool {
+public:
+  ShellTool(const ToolChain &TC) : Tool("sh", "sh", TC) {}
+
+  bool hasIntegratedCPP() const override { return false; }
+  void ConstructJob(Compilation &C, const JobAction &JA,
+                    const InputInfo &Output, const InputInfoList &Inputs,
+                    const llvm::opt::ArgList &TCArgs,
+                    const char *LinkingOutput) const override {}
+};
+
+class ParallelJobsTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("parallel-jobs", "c",
+                                                    Input));
+    ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("parallel-jobs", "done",
+                                                    Marker));
+    llvm::sys::fs::remove(Marker);
+
+    TheDriver.NumParallelJobs = 4;
+    C.reset(TheDriver.BuildCompilation(
+        {"latino", "-fsyntax-only", Input.c_str()}));
+    ASSERT_TRUE(C);
+    ASSERT_FALSE(C->containsError());
+    ASSERT_EQ(1u, C->getActions().size());
+    Sh.reset(new ShellTool(C->getDefaultToolChain()));
+  }
+
+  void TearDown() override {
+    llvm::sys::fs::remove(Input);
+    llvm::sys::fs::remove(Marker);
+  }
+
+  /// Add a command running \p Script to \p Jobs, built for \p Source.
+  void addScript(JobList &Jobs, const Action &Source, StringRef Script) {
+    llvm::opt::ArgStringList Args;
+    Args.push_back("-c");
+    Args.push_back(C->getArgs().MakeArgString(Script));
+    Jobs.addJob(std::make_unique<Command>(Source, *Sh,
+                                          ResponseFileSupport::None(),
+                                          "/bin/sh", Args, None));
+  }
+
+  /// A script which creates the marker file late enough for a job running
+  /// at the same time not to see it.
+  std::string writeMarker() {
+    return (Twine("sleep 1; touch '") + Marker + "'").str();
+  }
+  std::string checkMarker() {
+    return (Twine("test -f '") + Marker + "'").str();
+  }
+
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID{new DiagnosticIDs()};
+  IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts{new DiagnosticOptions()};
+  DiagnosticsEngine Diags{DiagID, &*DiagOpts, new IgnoringDiagConsumer};
+  Driver TheDriver{"/bin/latino", "x86_64-unknown-linux-gnu", Diags};
+  std::unique_ptr<Compilation> C;
+  std::unique_ptr<ShellTool> Sh;
+  SmallString<128> Input, Marker;
+};
+
+TEST_F(ParallelJobsTest, CommandsOfOneActionRunInOrder) {
+  const Action &Compile = *C->getActions()[0];
+  JobList Jobs;
+  addScript(Jobs, Compile, writeMarker());
+  addScript(Jobs, Compile, checkMarker());
+
+  SmallVector<std::pair<int, const Command *>, 4> FailingCommands;
+  C->ExecuteJobs(Jobs, FailingCommands);
+  EXPECT_TRUE(FailingCommands.empty());
+}
+
+TEST_F(ParallelJobsTest, JobsWaitForTheirInputs) {
+  Action *Compile = C->getActions()[0];
+  ActionList LinkInputs = {Compile};
+  Action *Link = C->MakeAction<LinkJobAction>(LinkInputs, types::TY_Image);
+  JobList Jobs;
+  addScript(Jobs, *Compile, writeMarker());
+  addScript(Jobs, *Link, checkMarker());
+
+  SmallVector<std::pair<int, const Command *>, 4> FailingCommands;
+  C->ExecuteJobs(Jobs, FailingCommands);
+  EXPECT_TRUE(FailingCommands.empty());
+}
+
+TEST_F(ParallelJobsTest, JobsOfAFailedActionAreSkipped) {
+  const Action &Compile = *C->getActions()[0];
+  JobList Jobs;
+  addScript(Jobs, Compile, "exit 1");
+  addScript(Jobs, Compile, writeMarker());
+
+  SmallVector<std::pair<int, const Command *>, 4> FailingCommands;
+  C->ExecuteJobs(Jobs, FailingCommands);
+  ASSERT_EQ(1u, FailingCommands.size());
+  EXPECT_EQ(&*Jobs.begin(), FailingCommands[0].second);
+  EXPECT_FALSE(llvm::sys::fs::exists(Marker));
+}
+
+} // namespace
+
+#endif // LLVM_ON_UNIX
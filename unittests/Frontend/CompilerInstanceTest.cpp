@@ -9,9 +9,12 @@
 #include "latino/Frontend/CompilerInstance.h"
 #include "latino/Basic/FileManager.h"
 #include "latino/Frontend/CompilerInvocation.h"
+#include "latino/Frontend/FrontendActions.h"
 #include "latino/Frontend/TextDiagnosticPrinter.h"
+#include "latino/Lex/PreprocessorOptions.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "gtest/gtest.h"
 
@@ -92,4 +95,91 @@ TEST(CompilerInstance, AllowDiagnosticLogWithUnownedDiagnosticConsumer) {
   ASSERT_EQ(DiagnosticsOS.str(), "error: expected no crash\n");
 }
 
+class PreludeTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    ASSERT_FALSE(sys::fs::createUniqueDirectory("prelude-test", Dir));
+    Prelude = Main = CacheDir = Dir;
+    sys::path::append(Prelude, "prelude.h");
+    sys::path::append(Main, "main.cpp");
+    sys::path::append(CacheDir, "cache");
+    writeFile(Prelude, "int prelude_value();\n");
+    writeFile(Main, "int f() { return prelude_value(); }\n");
+  }
+
+  void TearDown() override { sys::fs::remove_directories(Dir); }
+
+  void writeFile(StringRef Path, StringRef Contents) {
+    std::error_code EC;
+    raw_fd_ostream OS(Path, EC);
+    ASSERT_FALSE(EC);
+    OS << Contents;
+  }
+
+  /// Check the syntax of main.cpp with the prelude, in C++ \p Std.
+  ///
+  /// \returns the path of the precompiled prelude, or an empty string if the
+  /// compilation failed.
+  std::string compile(const char *Std) {
+    std::string PreludeArg = ("-fprelude=" + Prelude).str();
+    std::string CacheArg = ("-fprelude-cache-path=" + CacheDir).str();
+    const char *Args[] = {"-fsyntax-only",    "-x",
+                          "c++",              Std,
+                          PreludeArg.c_str(), CacheArg.c_str(),
+                          Main.c_str()};
+
+    CompilerInstance Instance;
+    Instance.createDiagnostics(new DiagnosticConsumer());
+    auto Invocation = std::make_shared<CompilerInvocation>();
+    if (!CompilerInvocation::CreateFromArgs(*Invocation, Args,
+                                            Instance.getDiagnostics()))
+      return std::string();
+    Instance.setInvocation(std::move(Invocation));
+
+    SyntaxOnlyAction Action;
+    if (!Instance.ExecuteAction(Action))
+      return std::string();
+    return Instance.getPreprocessorOpts().ImplicitPCHInclude;
+  }
+
+  SmallString<128> Dir, Prelude, Main, CacheDir;
+};
+
+TEST_F(PreludeTest, CachedPreludeIsReused) {
+  std::string PCH = compile("-std=c++17");
+  ASSERT_FALSE(PCH.empty());
+  sys::fs::UniqueID Built;
+  ASSERT_FALSE(sys::fs::getUniqueID(PCH, Built));
+
+  EXPECT_EQ(PCH, compile("-std=c++17"));
+  sys::fs::UniqueID Reused;
+  ASSERT_FALSE(sys::fs::getUniqueID(PCH, Reused));
+  EXPECT_EQ(Built, Reused);
+}
+
+TEST_F(PreludeTest, MismatchedPreludeIsRebuilt) {
+  std::string PCH17 = compile("-std=c++17");
+  std::string PCH11 = compile("-std=c++11");
+  ASSERT_FALSE(PCH17.empty());
+  ASSERT_FALSE(PCH11.empty());
+  ASSERT_NE(PCH17, PCH11);
+
+  // A prelude built with other options, as if the keys had collided.
+  ASSERT_FALSE(sys::fs::copy_file(PCH17, PCH11));
+  EXPECT_EQ(PCH11, compile("-std=c++11"));
+
+  // So is a file that is not a precompiled header at all.
+  writeFile(PCH11, "garbage");
+  EXPECT_EQ(PCH11, compile("-std=c++11"));
+}
+
+TEST(PreprocessorOptions, PreludeIsNotModular) {
+  PreprocessorOptions PPOpts;
+  PPOpts.PreludeFile = "prelude.h";
+  PPOpts.PreludeCachePath = "cache";
+  PPOpts.resetNonModularOptions();
+  EXPECT_TRUE(PPOpts.PreludeFile.empty());
+  EXPECT_TRUE(PPOpts.PreludeCachePath.empty());
+}
+
 } // anonymous namespace
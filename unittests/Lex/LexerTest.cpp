@@ -378,7 +378,7 @@ TEST_F(LexerTest, DontOverallocateStringifyArgs) {
   TrivialModuleLoader ModLoader;
   auto PP = CreatePP("\"StrArg\", 5, 'C'", ModLoader);
 
-  llvm::BumpPtrAllocator Allocator;
+  ArenaAllocator Allocator;
   std::array<IdentifierInfo *, 3> ParamList;
   MacroInfo *MI = PP->AllocateMacroInfo({});
   MI->setIsFunctionLike();
@@ -557,6 +557,26 @@ TEST_F(LexerTest, FindNextToken) {
                                                 "xyz", "=", "abcd", ";"));
 }
 
+TEST_F(LexerTest, LongIdentifiersAndNumbers) {
+  // Runs longer than the vector width, split by an escaped newline, and
+  // ending at the end of the buffer.
+  std::vector<Token> toks =
+      CheckLex("una_variable_con_un_nombre_muy_largo_de_verdad = "
+               "123456789012345678901234567890123456.75e+12 + "
+               "otra_variable_partida_en_dos_\\\nlineas_distintas + "
+               "identificador_al_final_del_buffer_sin_salto",
+               {tok::identifier, tok::equal, tok::numeric_constant,
+                tok::plus, tok::identifier, tok::plus, tok::identifier});
+  EXPECT_EQ("una_variable_con_un_nombre_muy_largo_de_verdad",
+            getSourceText(toks[0], toks[0]));
+  EXPECT_EQ("123456789012345678901234567890123456.75e+12",
+            getSourceText(toks[2], toks[2]));
+  EXPECT_EQ("otra_variable_partida_en_dos_lineas_distintas",
+            Lexer::getSpelling(toks[4], SourceMgr, LangOpts));
+  EXPECT_EQ("identificador_al_final_del_buffer_sin_salto",
+            getSourceText(toks[6], toks[6]));
+}
+
 TEST_F(LexerTest, CreatedFIDCountForPredefinedBuffer) {
   TrivialModuleLoader ModLoader;
   auto PP = CreatePP("", ModLoader);
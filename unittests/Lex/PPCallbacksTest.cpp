@@ -306,7 +306,7 @@ protected:
 };
 
 TEST_F(PPCallbacksTest, UserFileCharacteristics) {
-  const char *Source = "#include \"quoted.h\"\n";
+  const char *Source = "#incluir \"quoted.h\"\n";
 
   SrcMgr::CharacteristicKind Kind =
       InclusionDirectiveCharacteristicKind(Source, "/quoted.h", false);
@@ -316,7 +316,7 @@ TEST_F(PPCallbacksTest, UserFileCharacteristics) {
 
 TEST_F(PPCallbacksTest, QuotedFilename) {
   const char* Source =
-    "#include \"quoted.h\"\n";
+    "#incluir \"quoted.h\"\n";
 
   CharSourceRange Range =
     InclusionDirectiveFilenameRange(Source, "/quoted.h", false);
@@ -326,7 +326,7 @@ TEST_F(PPCallbacksTest, QuotedFilename) {
 
 TEST_F(PPCallbacksTest, AngledFilename) {
   const char* Source =
-    "#include <angled.h>\n";
+    "#incluir <angled.h>\n";
 
   CharSourceRange Range =
     InclusionDirectiveFilenameRange(Source, "/angled.h", true);
@@ -334,6 +334,44 @@ TEST_F(PPCallbacksTest, AngledFilename) {
   ASSERT_EQ("<angled.h>", GetSourceString(Range));
 }
 
+TEST_F(PPCallbacksTest, ImportarEntersFileOnce) {
+  const char *Source = "#importar \"una_vez.lat\"\n"
+                       "#importar \"una_vez.lat\"\n"
+                       "#incluir \"siempre.lat\"\n"
+                       "#incluir \"siempre.lat\"\n";
+  InMemoryFileSystem->addFile("/una_vez.lat", 0,
+                              llvm::MemoryBuffer::getMemBuffer("una_vez\n"));
+  InMemoryFileSystem->addFile("/siempre.lat", 0,
+                              llvm::MemoryBuffer::getMemBuffer("siempre\n"));
+  SourceMgr.setMainFileID(
+      SourceMgr.createFileID(llvm::MemoryBuffer::getMemBuffer(Source)));
+
+  TrivialModuleLoader ModLoader;
+  HeaderSearch HeaderInfo(std::make_shared<HeaderSearchOptions>(), SourceMgr,
+                          Diags, LangOpts, Target.get());
+  auto DE = FileMgr.getOptionalDirectoryRef("/");
+  HeaderInfo.AddSearchPath(DirectoryLookup(*DE, SrcMgr::C_User, false),
+                           /*isAngled=*/false);
+  Preprocessor PP(std::make_shared<PreprocessorOptions>(), Diags, LangOpts,
+                  SourceMgr, HeaderInfo, ModLoader,
+                  /*IILookup =*/nullptr,
+                  /*OwnsHeaderSearch =*/false);
+  PP.Initialize(*Target);
+  PP.EnterMainSourceFile();
+
+  std::vector<std::string> Names;
+  while (true) {
+    Token Tok;
+    PP.Lex(Tok);
+    if (Tok.is(tok::eof))
+      break;
+    Names.push_back(PP.getSpelling(Tok));
+  }
+
+  std::vector<std::string> Expected = {"una_vez", "siempre", "siempre"};
+  ASSERT_EQ(Expected, Names);
+}
+
 TEST_F(PPCallbacksTest, QuotedInMacro) {
   const char* Source =
     "#define MACRO_QUOTED \"quoted.h\"\n"
@@ -381,7 +419,7 @@ TEST_F(PPCallbacksTest, ConcatenatedMacroArgument) {
 
 TEST_F(PPCallbacksTest, TrigraphFilename) {
   const char* Source =
-    "#include \"tri\?\?-graph.h\"\n";
+    "#incluir \"tri\?\?-graph.h\"\n";
 
   CharSourceRange Range =
     InclusionDirectiveFilenameRange(Source, "/tri~graph.h", false);
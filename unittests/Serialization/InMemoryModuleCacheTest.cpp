@@ -102,6 +102,29 @@ TEST(InMemoryModuleCacheTest, tryToDropPCM) {
   EXPECT_EQ(RawB2, Cache.lookupPCM("B"));
 }
 
+TEST(InMemoryModuleCacheTest, replaceBuiltPCM) {
+  auto B1 = getBuffer(1);
+  auto B2 = getBuffer(1);
+  auto *RawB2 = B2.get();
+
+  InMemoryModuleCache Cache;
+#if !defined(NDEBUG) && GTEST_HAS_DEATH_TEST
+  EXPECT_DEATH(Cache.replaceBuiltPCM("B", getBuffer(1)),
+               "PCM to replace is unknown");
+#endif
+
+  Cache.addBuiltPCM("B", std::move(B1));
+  EXPECT_EQ(RawB2, &Cache.replaceBuiltPCM("B", std::move(B2)));
+  EXPECT_EQ(RawB2, Cache.lookupPCM("B"));
+  EXPECT_TRUE(Cache.isPCMFinal("B"));
+
+#if !defined(NDEBUG) && GTEST_HAS_DEATH_TEST
+  Cache.addPCM("C", getBuffer(1));
+  EXPECT_DEATH(Cache.replaceBuiltPCM("C", getBuffer(1)),
+               "Trying to replace a PCM that was not built");
+#endif
+}
+
 TEST(InMemoryModuleCacheTest, finalizePCM) {
   auto B = getBuffer(1);
   auto *RawB = B.get();
@@ -0,0 +1,155 @@
+//===- unittests/StaticAnalyzer/ExplodedGraphTest.cpp ---------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "Reusables.h"
+
+#include "latino/Analysis/ProgramPoint.h"
+#include "latino/StaticAnalyzer/Core/PathSensitive/ExplodedGraph.h"
+#include "latino/Tooling/Tooling.h"
+#include "gtest/gtest.h"
+
+namespace latino {
+namespace ento {
+namespace {
+
+using namespace ast_matchers;
+
+// Builds paths of nodes by hand in a graph of its own, and reclaims them.
+class ReclamationTestConsumer : public ExprEngineConsumer {
+public:
+  ReclamationTestConsumer(CompilerInstance &C) : ExprEngineConsumer(C) {}
+
+  bool HandleTopLevelDecl(DeclGroupRef DG) override {
+    for (const Decl *D : DG) {
+      const auto *FD = dyn_cast<FunctionDecl>(D);
+      if (FD && FD->doesThisDeclarationHaveABody())
+        setUp(FD);
+    }
+    return true;
+  }
+
+protected:
+  // In 'g(a + 1 + 2)': 'a + 1', '(a + 1) + 2' and the call.
+  const Expr *Inner, *Outer, *Call;
+  const StackFrameContext *SFC;
+  ProgramStateRef State;
+  ExplodedGraph G;
+  ExplodedNode *Last = nullptr;
+
+  // Add a node at P after the last node added.
+  ExplodedNode *addNode(const ProgramPoint &P) {
+    ExplodedNode *N = G.getNode(P, State);
+    if (Last)
+      N->addPredecessor(Last, G);
+    else
+      G.addRoot(N);
+    return Last = N;
+  }
+
+private:
+  virtual void performTest() = 0;
+
+  void setUp(const FunctionDecl *FD) {
+    Inner = findNode<BinaryOperator>(
+        FD, binaryOperator(hasRHS(integerLiteral(equals(1)))));
+    Outer = findNode<BinaryOperator>(
+        FD, binaryOperator(hasRHS(integerLiteral(equals(2)))));
+    Call = findNode<CallExpr>(FD, callExpr());
+    SFC = Eng.getAnalysisDeclContextManager().getStackFrame(FD);
+    State = Eng.getInitialState(SFC);
+    performTest();
+  }
+};
+
+const char *const Code = "int g(int); void foo(int a) { g(a + 1 + 2); }";
+
+// The filler nodes of a path are reclaimed, while the nodes tagged by
+// checkers and the node before a call are kept. The latter is reclaimed when
+// calls are never evaluated again without inlining.
+template <bool KeepNodesBeforeCalls>
+class ReclaimPathConsumer : public ReclamationTestConsumer {
+  void performTest() override {
+    SimpleProgramPointTag CheckerTag("test", "Checker");
+    G.enableNodeReclamation(/*Interval=*/1, KeepNodesBeforeCalls);
+
+    ExplodedNode *Root = addNode(PreStmt(Inner, SFC, nullptr));
+    addNode(PostStmt(Inner, SFC));
+    addNode(PreStmtPurgeDeadSymbols(Outer, SFC, ExprEngine::cleanupNodeTag()));
+    ExplodedNode *Tagged =
+        addNode(PreStmtPurgeDeadSymbols(Outer, SFC, &CheckerTag));
+    ExplodedNode *BeforeCall = addNode(PostStmt(Outer, SFC));
+    ExplodedNode *AfterCall = addNode(PostStmt(Call, SFC));
+    ExplodedNode *Frontier =
+        addNode(PreStmtPurgeDeadSymbols(Call, SFC, &CheckerTag));
+    ASSERT_EQ(7u, G.size());
+
+    G.reclaimRecentlyAllocatedNodes();
+
+    EXPECT_EQ(Tagged, Root->getFirstSucc());
+    if (KeepNodesBeforeCalls) {
+      EXPECT_EQ(5u, G.size());
+      EXPECT_EQ(BeforeCall, Tagged->getFirstSucc());
+      EXPECT_EQ(AfterCall, BeforeCall->getFirstSucc());
+    } else {
+      EXPECT_EQ(4u, G.size());
+      EXPECT_EQ(AfterCall, Tagged->getFirstSucc());
+    }
+    EXPECT_EQ(Frontier, AfterCall->getFirstSucc());
+  }
+
+public:
+  using ReclamationTestConsumer::ReclamationTestConsumer;
+};
+
+template <class ConsumerTy> class TestAction : public ASTFrontendAction {
+public:
+  std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &Compiler,
+                                                 StringRef File) override {
+    return std::make_unique<ConsumerTy>(Compiler);
+  }
+};
+
+TEST(ExplodedGraph, ReclaimFillerNodes) {
+  EXPECT_TRUE(tooling::runToolOnCode(
+      std::make_unique<TestAction<ReclaimPathConsumer<true>>>(), Code));
+}
+
+TEST(ExplodedGraph, ReclaimNodesBeforeCalls) {
+  EXPECT_TRUE(tooling::runToolOnCode(
+      std::make_unique<TestAction<ReclaimPathConsumer<false>>>(), Code));
+}
+
+// A node without a successor at one reclamation is reclaimed at the next one
+// if it has one by then.
+class ReclaimFrontierConsumer : public ReclamationTestConsumer {
+  void performTest() override {
+    G.enableNodeReclamation(/*Interval=*/1);
+
+    ExplodedNode *Root = addNode(PreStmt(Inner, SFC, nullptr));
+    addNode(PostStmt(Inner, SFC));
+    G.reclaimRecentlyAllocatedNodes();
+    EXPECT_EQ(2u, G.size());
+
+    ExplodedNode *Next = addNode(PreStmt(Outer, SFC, nullptr));
+    G.reclaimRecentlyAllocatedNodes();
+    EXPECT_EQ(2u, G.size());
+    EXPECT_EQ(Next, Root->getFirstSucc());
+  }
+
+public:
+  using ReclamationTestConsumer::ReclamationTestConsumer;
+};
+
+TEST(ExplodedGraph, ReclaimFrontierNodesLater) {
+  EXPECT_TRUE(tooling::runToolOnCode(
+      std::make_unique<TestAction<ReclaimFrontierConsumer>>(), Code));
+}
+
+} // namespace
+} // namespace ento
+} // namespace latino
@@ -0,0 +1,66 @@
+//===- unittests/StaticAnalyzer/ExplorationStrategyTest.cpp ---------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "CheckerRegistration.h"
+#include "latino/StaticAnalyzer/Core/Checker.h"
+#include "latino/StaticAnalyzer/Core/PathSensitive/CallEvent.h"
+#include "latino/StaticAnalyzer/Core/PathSensitive/CheckerContext.h"
+#include "latino/StaticAnalyzer/Frontend/AnalysisConsumer.h"
+#include "latino/StaticAnalyzer/Frontend/CheckerRegistry.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace latino {
+namespace ento {
+namespace {
+
+/// The callees of the calls evaluated, in the order they were evaluated in.
+std::vector<std::string> Calls;
+
+class CallRecorder : public Checker<check::PreCall> {
+public:
+  void checkPreCall(const CallEvent &Call, CheckerContext &C) const {
+    if (const IdentifierInfo *II = Call.getCalleeIdentifier())
+      Calls.push_back(std::string(II->getName()));
+  }
+};
+
+void addCoverageFirstCallRecorder(AnalysisASTConsumer &AnalysisConsumer,
+                                  AnalyzerOptions &AnOpts) {
+  AnOpts.CheckersAndPackages = {{"test.CallRecorder", true}};
+  AnOpts.ExplorationStrategy = "coverage_first_queue";
+  AnalysisConsumer.AddCheckerRegistrationFn([](CheckerRegistry &Registry) {
+    Registry.addChecker<CallRecorder>("test.CallRecorder", "Description", "");
+  });
+}
+
+TEST(ExplorationStrategy, CoverageFirstEntersUncoveredBlocksFirst) {
+  Calls.clear();
+  ASSERT_TRUE(runCheckerOnCode<addCoverageFirstCallRecorder>(R"(
+    void a();
+    void b();
+    void foo(int N) {
+      for (int I = 0; I < N; ++I)
+        a();
+      b();
+    }
+  )"));
+
+  // The loop is unrolled several times, but the block after it is entered
+  // before the body runs a second time.
+  auto FirstB = std::find(Calls.begin(), Calls.end(), "b");
+  ASSERT_NE(Calls.end(), FirstB);
+  EXPECT_LE(std::count(Calls.begin(), FirstB, "a"), 1);
+  EXPECT_GT(std::count(FirstB, Calls.end(), "a"), 0);
+}
+
+} // namespace
+} // namespace ento
+} // namespace latino
@@ -0,0 +1,170 @@
+//===- unittests/StaticAnalyzer/FunctionSummaryCacheTest.cpp --------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "CheckerRegistration.h"
+#include "latino/StaticAnalyzer/Core/Checker.h"
+#include "latino/StaticAnalyzer/Core/PathSensitive/CheckerContext.h"
+#include "latino/StaticAnalyzer/Core/PathSensitive/FunctionSummaryCache.h"
+#include "latino/StaticAnalyzer/Frontend/AnalysisConsumer.h"
+#include "latino/StaticAnalyzer/Frontend/CheckerRegistry.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <set>
+#include <string>
+
+namespace latino {
+namespace ento {
+namespace {
+
+class FunctionSummaryCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    ASSERT_FALSE(
+        llvm::sys::fs::createTemporaryFile("summaries", "json", CachePath));
+  }
+  void TearDown() override { llvm::sys::fs::remove(CachePath); }
+
+  SmallString<128> CachePath;
+};
+
+TEST_F(FunctionSummaryCacheTest, SummariesAreReadBack) {
+  FunctionSummaryCache Cache(/*ConfigHash=*/42);
+  CachedFunctionSummary Summary;
+  Summary.Hash = 0xfedcba9876543210;
+  Summary.TotalBlocks = 4;
+  Summary.VisitedBlocks = {0, 1, 3};
+  Summary.InlinedCallees = {"c:@F@g", "c:@F@h"};
+  Summary.NotInlinableCallees = {"c:@F@h"};
+  Cache.insert("c:@F@f", Summary);
+  ASSERT_FALSE(llvm::errorToBool(Cache.save(CachePath)));
+
+  llvm::Expected<FunctionSummaryCache> Loaded =
+      FunctionSummaryCache::load(CachePath, 42);
+  ASSERT_TRUE(bool(Loaded));
+  EXPECT_EQ(nullptr, Loaded->lookup("c:@F@f", 0x1234));
+  const CachedFunctionSummary *Read =
+      Loaded->lookup("c:@F@f", 0xfedcba9876543210);
+  ASSERT_NE(nullptr, Read);
+  EXPECT_EQ(0u, Read->NumReports);
+  EXPECT_EQ(4u, Read->TotalBlocks);
+  EXPECT_EQ(Summary.VisitedBlocks, Read->VisitedBlocks);
+  EXPECT_EQ(Summary.InlinedCallees, Read->InlinedCallees);
+  EXPECT_EQ(Summary.NotInlinableCallees, Read->NotInlinableCallees);
+}
+
+TEST_F(FunctionSummaryCacheTest, OtherConfigurationIsIgnored) {
+  FunctionSummaryCache Cache(/*ConfigHash=*/1);
+  Cache.insert("c:@F@f", CachedFunctionSummary());
+  ASSERT_FALSE(llvm::errorToBool(Cache.save(CachePath)));
+
+  llvm::Expected<FunctionSummaryCache> Loaded =
+      FunctionSummaryCache::load(CachePath, 2);
+  ASSERT_TRUE(bool(Loaded));
+  EXPECT_EQ(0u, Loaded->size());
+}
+
+TEST_F(FunctionSummaryCacheTest, MissingFileIsEmpty) {
+  llvm::sys::fs::remove(CachePath);
+  llvm::Expected<FunctionSummaryCache> Loaded =
+      FunctionSummaryCache::load(CachePath, 1);
+  ASSERT_TRUE(bool(Loaded));
+  EXPECT_EQ(0u, Loaded->size());
+}
+
+TEST_F(FunctionSummaryCacheTest, MalformedFileIsAnError) {
+  {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(CachePath, EC);
+    ASSERT_FALSE(EC);
+    OS << "{\"version\": 1, \"config\": \"1\", \"functions\": []}";
+  }
+  llvm::Expected<FunctionSummaryCache> Loaded =
+      FunctionSummaryCache::load(CachePath, 1);
+  EXPECT_FALSE(bool(Loaded));
+  llvm::consumeError(Loaded.takeError());
+}
+
+/// The top-level functions analyzed, and the directory of the summary cache.
+std::set<std::string> Analyzed;
+std::string CacheDir;
+
+class AnalyzedRecorder : public Checker<check::BeginFunction> {
+public:
+  void checkBeginFunction(CheckerContext &C) const {
+    if (!C.inTopFrame())
+      return;
+    if (const auto *FD =
+            dyn_cast_or_null<FunctionDecl>(C.getLocationContext()->getDecl()))
+      Analyzed.insert(FD->getNameAsString());
+  }
+};
+
+void addCachedAnalyzedRecorder(AnalysisASTConsumer &AnalysisConsumer,
+                               AnalyzerOptions &AnOpts) {
+  AnOpts.CheckersAndPackages = {{"test.AnalyzedRecorder", true}};
+  AnOpts.SummaryCacheDir = CacheDir;
+  AnalysisConsumer.AddCheckerRegistrationFn([](CheckerRegistry &Registry) {
+    Registry.addChecker<AnalyzedRecorder>("test.AnalyzedRecorder",
+                                          "Description", "");
+  });
+}
+
+class SummaryCacheAnalysisTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    SmallString<128> Dir;
+    ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("summaries", Dir));
+    CacheDir = std::string(Dir.str());
+  }
+  void TearDown() override { llvm::sys::fs::remove_directories(CacheDir); }
+
+  /// Analyze \p Code, and return the top-level functions that were analyzed
+  /// rather than taken from the cache.
+  std::set<std::string> analyze(const std::string &Code) {
+    Analyzed.clear();
+    EXPECT_TRUE(runCheckerOnCode<addCachedAnalyzedRecorder>(Code));
+    return Analyzed;
+  }
+};
+
+TEST_F(SummaryCacheAnalysisTest, EditingAReferencedGlobalInvalidatesSummary) {
+  const char *Before = R"(
+    int Limit = 10;
+    int f() { return Limit; }
+    int g() { return 0; }
+  )";
+  const char *After = R"(
+    int Limit = 20;
+    int f() { return Limit; }
+    int g() { return 0; }
+  )";
+  EXPECT_EQ(std::set<std::string>({"f", "g"}), analyze(Before));
+  EXPECT_EQ(std::set<std::string>(), analyze(Before));
+  EXPECT_EQ(std::set<std::string>({"f"}), analyze(After));
+}
+
+TEST_F(SummaryCacheAnalysisTest, EditingAUsedTypeInvalidatesSummary) {
+  const char *Before = R"(
+    struct S { int X; };
+    int f(struct S *P) { return P->X; }
+    int g() { return 0; }
+  )";
+  const char *After = R"(
+    struct S { int Y; int X; };
+    int f(struct S *P) { return P->X; }
+    int g() { return 0; }
+  )";
+  EXPECT_EQ(std::set<std::string>({"f", "g"}), analyze(Before));
+  EXPECT_EQ(std::set<std::string>(), analyze(Before));
+  EXPECT_EQ(std::set<std::string>({"f"}), analyze(After));
+}
+
+} // namespace
+} // namespace ento
+} // namespace latino
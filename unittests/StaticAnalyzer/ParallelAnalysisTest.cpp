@@ -0,0 +1,79 @@
+//===- unittests/StaticAnalyzer/ParallelAnalysisTest.cpp ------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "CheckerRegistration.h"
+#include "latino/StaticAnalyzer/Core/BugReporter/BugReporter.h"
+#include "latino/StaticAnalyzer/Core/BugReporter/BugType.h"
+#include "latino/StaticAnalyzer/Core/Checker.h"
+#include "latino/StaticAnalyzer/Core/PathSensitive/CheckerContext.h"
+#include "latino/StaticAnalyzer/Frontend/AnalysisConsumer.h"
+#include "latino/StaticAnalyzer/Frontend/CheckerRegistry.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "gtest/gtest.h"
+
+namespace latino {
+namespace ento {
+namespace {
+
+/// Reports every return statement, with the name of the function analyzed.
+class ReturnReporter : public Checker<check::PreStmt<ReturnStmt>> {
+  BuiltinBug BT{this, "Return"};
+
+public:
+  void checkPreStmt(const ReturnStmt *RS, CheckerContext &C) const {
+    const auto *FD = dyn_cast<FunctionDecl>(C.getStackFrame()->getDecl());
+    ExplodedNode *N = C.generateNonFatalErrorNode();
+    if (!FD || !N)
+      return;
+    C.emitReport(std::make_unique<PathSensitiveBugReport>(
+        BT, FD->getName(), N));
+  }
+};
+
+template <unsigned NumThreads>
+void addReturnReporter(AnalysisASTConsumer &AnalysisConsumer,
+                       AnalyzerOptions &AnOpts) {
+  AnOpts.CheckersAndPackages = {{"test.ReturnReporter", true}};
+  AnOpts.AnalysisThreads = NumThreads;
+  AnalysisConsumer.AddCheckerRegistrationFn([](CheckerRegistry &Registry) {
+    Registry.addChecker<ReturnReporter>("test.ReturnReporter", "Description",
+                                        "");
+  });
+}
+
+const char *const Code = R"(
+  int f1() { return 1; }
+  int f2() { return 2; }
+  int f3() { return 3; }
+  int f4() { return 4; }
+  int f5() { return 5; }
+  int f6() { return 6; }
+  int f7() { return 7; }
+  int f8() { return 8; }
+)";
+
+SmallVector<StringRef, 8> sortedLines(StringRef Diags) {
+  SmallVector<StringRef, 8> Lines;
+  Diags.split(Lines, '\n', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  llvm::sort(Lines);
+  return Lines;
+}
+
+TEST(ParallelAnalysis, ReportsMatchTheSequentialAnalysis) {
+  std::string Sequential, Parallel;
+  ASSERT_TRUE(runCheckerOnCode<addReturnReporter<1>>(Code, Sequential));
+  ASSERT_TRUE(runCheckerOnCode<addReturnReporter<4>>(Code, Parallel));
+  EXPECT_EQ(8u, sortedLines(Sequential).size());
+  EXPECT_EQ(sortedLines(Sequential), sortedLines(Parallel));
+}
+
+} // namespace
+} // namespace ento
+} // namespace latino
@@ -62,6 +62,17 @@ protected:
   RangeSet::Factory F;
   // End init block
 
+  template <typename T>
+  RangeSet createRangeSet(const std::initializer_list<T> &List) {
+    return TestCase<T>(BVF, F, List, {}).original;
+  }
+
+  template <typename T> const llvm::APSInt &getValue(T V) {
+    llvm::APSInt Result(sizeof(T) * 8, std::is_unsigned<T>::value);
+    Result = V;
+    return BVF.getValue(Result);
+  }
+
   template <typename T> void checkNegate() {
     using type = T;
 
@@ -125,6 +136,31 @@ TEST_F(RangeSetTest, RangeSetNegateTest) {
   checkNegate<uint64_t>();
 }
 
+TEST_F(RangeSetTest, RangeSetIntersectTest) {
+  RangeSet LHS = createRangeSet<int8_t>({-10, -5, 0, 10, 20, 30});
+  RangeSet RHS = createRangeSet<int8_t>({-7, 2, 8, 25});
+  RangeSet Expected = createRangeSet<int8_t>({-7, -5, 0, 2, 8, 10, 20, 25});
+  EXPECT_EQ(Expected, LHS.Intersect(BVF, F, RHS));
+  EXPECT_EQ(Expected, RHS.Intersect(BVF, F, LHS));
+  EXPECT_EQ(LHS, LHS.Intersect(BVF, F, LHS));
+  EXPECT_TRUE(LHS.Intersect(BVF, F, F.getEmptySet()).isEmpty());
+
+  // A wrapped range [Lower, Upper] with Lower > Upper keeps both ends.
+  EXPECT_EQ(createRangeSet<int8_t>({-10, -5, 20, 30}),
+            LHS.Intersect(BVF, F, getValue<int8_t>(15), getValue<int8_t>(-1)));
+  EXPECT_EQ(createRangeSet<int8_t>({5, 10, 20, 22}),
+            LHS.Intersect(BVF, F, getValue<int8_t>(5), getValue<int8_t>(22)));
+}
+
+TEST_F(RangeSetTest, EqualRangeSetsAreUniqued) {
+  // Sets with the same ranges are the same object, however they were built.
+  RangeSet Forward = createRangeSet<int32_t>({1, 2, 5, 6, 9, 9});
+  RangeSet Backward = createRangeSet<int32_t>({9, 9, 5, 6, 1, 2});
+  EXPECT_EQ(Forward, Backward);
+  EXPECT_EQ(Forward, Forward.Negate(BVF, F).Negate(BVF, F));
+  EXPECT_NE(Forward, createRangeSet<int32_t>({1, 2, 5, 6}));
+}
+
 } // namespace
 } // namespace ento
 } // namespace latino
@@ -37,6 +37,18 @@ public:
   }
 };
 
+// Run the test of ConsumerTy on Code, with the clusters of the region store
+// kept in trees or in flat arrays.
+template <class ConsumerTy>
+bool runStoreTest(StringRef Code, bool FlatClusters,
+                  StringRef FileName = "input.cc") {
+  std::vector<std::string> Args = {"-Xclang", "-analyzer-config", "-Xclang"};
+  Args.push_back(std::string("region-store-flat-clusters=") +
+                 (FlatClusters ? "true" : "false"));
+  return tooling::runToolOnCodeWithArgs(
+      std::make_unique<TestAction<ConsumerTy>>(), Code, Args, FileName);
+}
+
 // Test that we can put a value into an int-type variable and load it
 // back from that variable. Test what happens if default bindings are used.
 class VariableBindConsumer : public StoreTestConsumer {
@@ -102,9 +114,9 @@ public:
 };
 
 TEST(Store, VariableBind) {
-  EXPECT_TRUE(tooling::runToolOnCode(
-      std::make_unique<TestAction<VariableBindConsumer>>(),
-      "void foo() { int x0, y0, z0, x1, y1; }"));
+  for (bool FlatClusters : {false, true})
+    EXPECT_TRUE(runStoreTest<VariableBindConsumer>(
+        "void foo() { int x0, y0, z0, x1, y1; }", FlatClusters));
 }
 
 class LiteralCompoundConsumer : public StoreTestConsumer {
@@ -145,9 +157,95 @@ public:
 };
 
 TEST(Store, LiteralCompound) {
-  EXPECT_TRUE(tooling::runToolOnCode(
-      std::make_unique<TestAction<LiteralCompoundConsumer>>(),
-      "void foo() { int *test = (int[]){ 1, 2, 3 }; }", "input.c"));
+  for (bool FlatClusters : {false, true})
+    EXPECT_TRUE(runStoreTest<LiteralCompoundConsumer>(
+        "void foo() { int *test = (int[]){ 1, 2, 3 }; }", FlatClusters,
+        "input.c"));
+}
+
+// Test the updates and lookups of a cluster with more bindings than a flat
+// cluster keeps, and copies of the struct it belongs to.
+class LargeClusterConsumer : public StoreTestConsumer {
+  void performTest(const Decl *D) override {
+    if (!isa<FunctionDecl>(D))
+      return;
+
+    StoreManager &SManager = Eng.getStoreManager();
+    SValBuilder &Builder = Eng.getSValBuilder();
+    MemRegionManager &MRManager = SManager.getRegionManager();
+    ASTContext &ASTCtxt = Eng.getContext();
+    QualType Int = ASTCtxt.IntTy;
+
+    const auto *VDS1 = findDeclByName<VarDecl>(D, "s1");
+    const auto *VDS2 = findDeclByName<VarDecl>(D, "s2");
+    const RecordDecl *RD = VDS1->getType()->getAsRecordDecl();
+    ASSERT_TRUE(RD);
+    auto FI = RD->field_begin();
+    const FieldDecl *FDX = *FI++;
+    const FieldDecl *FDY = *FI;
+
+    const StackFrameContext *SFC =
+        Eng.getAnalysisDeclContextManager().getStackFrame(D);
+    const VarRegion *S1 = MRManager.getVarRegion(VDS1, SFC);
+    const VarRegion *S2 = MRManager.getVarRegion(VDS2, SFC);
+    const FieldRegion *X1 = MRManager.getFieldRegion(FDX, S1);
+    const FieldRegion *X2 = MRManager.getFieldRegion(FDX, S2);
+    Loc LY1 = loc::MemRegionVal(MRManager.getFieldRegion(FDY, S1));
+    Loc LY2 = loc::MemRegionVal(MRManager.getFieldRegion(FDY, S2));
+    auto Element = [&](const SubRegion *Array, unsigned I) -> Loc {
+      return loc::MemRegionVal(MRManager.getElementRegion(
+          Int, Builder.makeArrayIndex(I), Array, ASTCtxt));
+    };
+    auto Value = [&](unsigned I) { return Builder.makeIntVal(I, Int); };
+
+    const unsigned N = 200;
+    Store St = SManager.getInitialStore(SFC).getStore();
+    for (unsigned I = 0; I != N; ++I)
+      St = SManager.Bind(St, Element(X1, I), Value(I)).getStore();
+    St = SManager.Bind(St, LY1, Value(N)).getStore();
+    for (unsigned I = 0; I != N; ++I)
+      EXPECT_EQ(Value(I), SManager.getBinding(St, Element(X1, I), Int));
+    EXPECT_EQ(Value(N), SManager.getBinding(St, LY1, Int));
+
+    // Overwrite every other element.
+    for (unsigned I = 0; I < N; I += 2)
+      St = SManager.Bind(St, Element(X1, I), Value(N + I)).getStore();
+    for (unsigned I = 0; I != N; ++I)
+      EXPECT_EQ(Value(I % 2 ? I : N + I),
+                SManager.getBinding(St, Element(X1, I), Int));
+
+    // Remove one binding.
+    Store StKilled = SManager.killBinding(St, Element(X1, 5)).getStore();
+    EXPECT_TRUE(SManager.getBinding(StKilled, Element(X1, 5), Int).isUndef());
+    EXPECT_EQ(Value(3), SManager.getBinding(StKilled, Element(X1, 3), Int));
+    EXPECT_EQ(Value(7), SManager.getBinding(StKilled, Element(X1, 7), Int));
+
+    // Remove the bindings of the whole array at once.
+    Store StZero = SManager.BindDefaultZero(St, X1).getStore();
+    SVal Zero = Builder.makeZeroVal(Int);
+    for (unsigned I = 0; I != N; ++I)
+      EXPECT_EQ(Zero, SManager.getBinding(StZero, Element(X1, I), Int));
+    EXPECT_EQ(Value(N), SManager.getBinding(StZero, LY1, Int));
+
+    // Copy the struct.
+    SVal Copy = SManager.getBinding(St, loc::MemRegionVal(S1), VDS1->getType());
+    Store StCopy = SManager.Bind(St, loc::MemRegionVal(S2), Copy).getStore();
+    for (unsigned I = 0; I != N; ++I)
+      EXPECT_EQ(SManager.getBinding(St, Element(X1, I), Int),
+                SManager.getBinding(StCopy, Element(X2, I), Int));
+    EXPECT_EQ(Value(N), SManager.getBinding(StCopy, LY2, Int));
+  }
+
+public:
+  using StoreTestConsumer::StoreTestConsumer;
+};
+
+TEST(Store, LargeCluster) {
+  for (bool FlatClusters : {false, true})
+    EXPECT_TRUE(runStoreTest<LargeClusterConsumer>(
+        "struct S { int x[200]; int y; };"
+        "void foo() { struct S s1, s2; }",
+        FlatClusters, "input.c"));
 }
 
 } // namespace
@@ -11,10 +11,12 @@
 //===----------------------------------------------------------------------===//
 
 #include "TableGenBackends.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/TableGen/Error.h"
 #include "llvm/TableGen/Record.h"
 #include "llvm/TableGen/StringMatcher.h"
 #include "llvm/TableGen/TableGenBackend.h"
+#include <map>
 
 using namespace llvm;
 
@@ -24,6 +26,16 @@ class ClangOpcodesEmitter {
   Record Root;
   unsigned NumTypes;
 
+  /// Opcode record and types of each enumerated opcode, by name.
+  llvm::StringMap<std::pair<Record *, std::vector<Record *>>> OpcodesByID;
+
+  /// A component of a superinstruction, instantiated for some types.
+  struct Component {
+    Record *R;
+    std::vector<Record *> Types;
+    std::string ID;
+  };
+
 public:
   ClangOpcodesEmitter(RecordKeeper &R)
     : Records(R), Root("Opcode", SMLoc(), R),
@@ -54,9 +66,28 @@ private:
   /// Emits the evaluator method.
   void EmitEval(raw_ostream &OS, StringRef N, Record *R);
 
+  /// Emits the matcher which finds the superinstruction ending an
+  /// instruction sequence.
+  void EmitFuse(raw_ostream &OS, ArrayRef<Record *> Fused);
+
   void PrintTypes(raw_ostream &OS, ArrayRef<Record *> Types);
+
+  /// Returns the opcodes run by a superinstruction instantiated for \p TS.
+  std::vector<Component> getComponents(Record *R, ArrayRef<Record *> TS);
+
+  /// Returns the arguments of an opcode instantiated for \p TS. Those of a
+  /// superinstruction are the arguments of its components, in order.
+  std::vector<Record *> getArgs(Record *R, ArrayRef<Record *> TS);
 };
 
+bool isFused(const Record *R) { return R->isSubClassOf("FusedOpcode"); }
+
+StringRef getName(const Record *R) {
+  // The name is the record name, unless overriden.
+  StringRef N = R->getValueAsString("Name");
+  return N.empty() ? R->getName() : N;
+}
+
 void Enumerate(const Record *R,
                StringRef N,
                std::function<void(ArrayRef<Record *>, Twine)> &&F) {
@@ -86,20 +117,79 @@ void Enumerate(const Record *R,
 } // namespace
 
 void ClangOpcodesEmitter::run(raw_ostream &OS) {
-  for (auto *Opcode : Records.getAllDerivedDefinitions(Root.getName())) {
-    // The name is the record name, unless overriden.
-    StringRef N = Opcode->getValueAsString("Name");
-    if (N.empty())
-      N = Opcode->getName();
+  auto Opcodes = Records.getAllDerivedDefinitions(Root.getName());
+  for (auto *Opcode : Opcodes) {
+    if (isFused(Opcode))
+      continue;
+    Enumerate(Opcode, getName(Opcode),
+              [this, Opcode](ArrayRef<Record *> TS, const Twine &ID) {
+                OpcodesByID[ID.str()] = {Opcode, TS.vec()};
+              });
+  }
+
+  std::vector<Record *> Fused;
+  for (auto *Opcode : Opcodes) {
+    StringRef N = getName(Opcode);
 
     EmitEnum(OS, N, Opcode);
     EmitInterp(OS, N, Opcode);
     EmitDisasm(OS, N, Opcode);
+
+    // Superinstructions are only created by fusing other opcodes.
+    if (isFused(Opcode)) {
+      Fused.push_back(Opcode);
+      continue;
+    }
+
     EmitProto(OS, N, Opcode);
     EmitGroup(OS, N, Opcode);
     EmitEmitter(OS, N, Opcode);
     EmitEval(OS, N, Opcode);
   }
+
+  EmitFuse(OS, Fused);
+}
+
+std::vector<ClangOpcodesEmitter::Component>
+ClangOpcodesEmitter::getComponents(Record *R, ArrayRef<Record *> TS) {
+  std::vector<Component> Components;
+  auto Ops = R->getValueAsListOfStrings("Ops");
+  for (size_t I = 0, N = Ops.size(); I < N; ++I) {
+    // Components are instantiated for the types of the superinstruction,
+    // unless they do not take any types.
+    std::string ID = Ops[I].str();
+    for (auto *T : TS)
+      ID += T->getName();
+    auto It = OpcodesByID.find(ID);
+    if (It == OpcodesByID.end() || It->second.second.size() != TS.size()) {
+      It = OpcodesByID.find(Ops[I]);
+      if (It != OpcodesByID.end() && !It->second.second.empty())
+        It = OpcodesByID.end();
+    }
+    if (It == OpcodesByID.end())
+      PrintFatalError(R->getLoc(), "No opcode " + ID + " to fuse");
+
+    Record *C = It->second.first;
+    if (C->getValueAsBit("CanReturn"))
+      PrintFatalError(R->getLoc(), "Cannot fuse returning opcode " + ID);
+    if (C->getValueAsBit("ChangesPC") && I + 1 != N)
+      PrintFatalError(R->getLoc(), "Only the last fused opcode can jump");
+    Components.push_back({C, It->second.second, It->first().str()});
+  }
+  return Components;
+}
+
+std::vector<Record *> ClangOpcodesEmitter::getArgs(Record *R,
+                                                   ArrayRef<Record *> TS) {
+  if (!isFused(R))
+    return R->getValueAsListOfDefs("Args");
+
+  std::vector<Record *> Args;
+  for (const Component &C : getComponents(R, TS)) {
+    auto CArgs = C.R->getValueAsListOfDefs("Args");
+    Args.insert(Args.end(), CArgs.begin(), CArgs.end());
+  }
+  return Args;
 }
 
 void ClangOpcodesEmitter::EmitEnum(raw_ostream &OS, StringRef N, Record *R) {
@@ -108,17 +198,28 @@ void ClangOpcodesEmitter::EmitEnum(raw_ostream &OS, StringRef N, Record *R) {
     OS << "OP_" << ID << ",\n";
   });
   OS << "#endif\n";
+
+  OS << "#ifdef GET_OPCODE_STRINGS\n";
+  Enumerate(R, N, [&OS](ArrayRef<Record *>, const Twine &ID) {
+    OS << "\"" << ID << "\",\n";
+  });
+  OS << "#endif\n";
 }
 
 void ClangOpcodesEmitter::EmitInterp(raw_ostream &OS, StringRef N, Record *R) {
+  OS << "#ifdef GET_INTERP_LABELS\n";
+  Enumerate(R, N, [&OS](ArrayRef<Record *>, const Twine &ID) {
+    OS << "&&INTERP_LABEL(OP_" << ID << "),\n";
+  });
+  OS << "#endif\n";
+
   OS << "#ifdef GET_INTERP\n";
 
   Enumerate(R, N, [this, R, &OS, &N](ArrayRef<Record *> TS, const Twine &ID) {
     bool CanReturn = R->getValueAsBit("CanReturn");
-    bool ChangesPC = R->getValueAsBit("ChangesPC");
-    auto Args = R->getValueAsListOfDefs("Args");
+    auto Args = getArgs(R, TS);
 
-    OS << "case OP_" << ID << ": {\n";
+    OS << "INTERP_CASE(OP_" << ID << ") {\n";
 
     // Emit calls to read arguments.
     for (size_t I = 0, N = Args.size(); I < N; ++I) {
@@ -128,19 +229,35 @@ void ClangOpcodesEmitter::EmitInterp(raw_ostream &OS, StringRef N, Record *R) {
     }
 
     // Emit a call to the template method and pass arguments.
-    OS << "\tif (!" << N;
-    PrintTypes(OS, TS);
-    OS << "(S";
-    if (ChangesPC)
-      OS << ", PC";
-    else
-      OS << ", OpPC";
-    if (CanReturn)
-      OS << ", Result";
-    for (size_t I = 0, N = Args.size(); I < N; ++I)
-      OS << ", V" << I;
-    OS << "))\n";
-    OS << "\t\treturn false;\n";
+    auto EmitCall = [this, &OS](StringRef Name, Record *Op,
+                                ArrayRef<Record *> Types, size_t FirstArg) {
+      OS << "\tif (!" << Name;
+      PrintTypes(OS, Types);
+      OS << "(S";
+      if (Op->getValueAsBit("ChangesPC"))
+        OS << ", PC";
+      else
+        OS << ", OpPC";
+      if (Op->getValueAsBit("CanReturn"))
+        OS << ", Result";
+      for (size_t I = 0, N = Op->getValueAsListOfDefs("Args").size(); I < N;
+           ++I)
+        OS << ", V" << (FirstArg + I);
+      OS << "))\n";
+      OS << "\t\treturn false;\n";
+    };
+
+    // Superinstructions run their components in order, all of them at the
+    // location of the superinstruction.
+    if (isFused(R)) {
+      size_t FirstArg = 0;
+      for (const Component &C : getComponents(R, TS)) {
+        EmitCall(getName(C.R), C.R, C.Types, FirstArg);
+        FirstArg += C.R->getValueAsListOfDefs("Args").size();
+      }
+    } else {
+      EmitCall(N, R, TS, 0);
+    }
 
     // Bail out if interpreter returned.
     if (CanReturn) {
@@ -148,7 +265,7 @@ void ClangOpcodesEmitter::EmitInterp(raw_ostream &OS, StringRef N, Record *R) {
       OS << "\t\treturn true;\n";
     }
 
-    OS << "\tcontinue;\n";
+    OS << "\tINTERP_NEXT();\n";
     OS << "}\n";
   });
   OS << "#endif\n";
@@ -156,12 +273,12 @@ void ClangOpcodesEmitter::EmitInterp(raw_ostream &OS, StringRef N, Record *R) {
 
 void ClangOpcodesEmitter::EmitDisasm(raw_ostream &OS, StringRef N, Record *R) {
   OS << "#ifdef GET_DISASM\n";
-  Enumerate(R, N, [R, &OS](ArrayRef<Record *>, const Twine &ID) {
+  Enumerate(R, N, [this, R, &OS](ArrayRef<Record *> TS, const Twine &ID) {
     OS << "case OP_" << ID << ":\n";
     OS << "\tPrintName(\"" << ID << "\");\n";
     OS << "\tOS << \"\\t\"";
 
-    for (auto *Arg : R->getValueAsListOfDefs("Args"))
+    for (auto *Arg : getArgs(R, TS))
       OS << " << PC.read<" << Arg->getValueAsString("Name") << ">() << \" \"";
 
     OS << "<< \"\\n\";\n";
@@ -340,6 +457,49 @@ void ClangOpcodesEmitter::EmitEval(raw_ostream &OS, StringRef N, Record *R) {
   OS << "#endif\n";
 }
 
+void ClangOpcodesEmitter::EmitFuse(raw_ostream &OS, ArrayRef<Record *> Fused) {
+  // Group the superinstructions by their last opcode, which is the one whose
+  // emission completes them.
+  std::map<std::string,
+           std::vector<std::pair<std::string, std::vector<Component>>>>
+      ByLast;
+  for (auto *R : Fused) {
+    Enumerate(R, getName(R),
+              [this, R, &ByLast](ArrayRef<Record *> TS, const Twine &ID) {
+                auto Components = getComponents(R, TS);
+                ByLast[Components.back().ID].emplace_back(ID.str(),
+                                                          Components);
+              });
+  }
+
+  OS << "#ifdef GET_FUSE\n";
+  OS << "switch (Op) {\n";
+  for (auto &Last : ByLast) {
+    OS << "case OP_" << Last.first << ":\n";
+
+    // Prefer the longest sequence.
+    std::stable_sort(Last.second.begin(), Last.second.end(),
+                     [](const auto &A, const auto &B) {
+                       return A.second.size() > B.second.size();
+                     });
+    for (auto &Fused : Last.second) {
+      size_t NumPrev = Fused.second.size() - 1;
+      OS << "\tif (Prev.size() >= " << NumPrev;
+      for (size_t I = 0; I < NumPrev; ++I) {
+        OS << " && Prev[Prev.size() - " << (NumPrev - I) << "] == OP_"
+           << Fused.second[I].ID;
+      }
+      OS << ")\n";
+      OS << "\t\treturn {OP_" << Fused.first << ", " << NumPrev << "};\n";
+    }
+    OS << "\tbreak;\n";
+  }
+  OS << "default:\n";
+  OS << "\tbreak;\n";
+  OS << "}\n";
+  OS << "#endif\n";
+}
+
 void ClangOpcodesEmitter::PrintTypes(raw_ostream &OS, ArrayRef<Record *> Types) {
   if (Types.empty())
     return;